@@ -0,0 +1,285 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__ 1
+
+// Minimal Google Benchmark style harness, so the benchmarks build with
+// nothing but the compiler. Register functions with BENCHMARK(fn)->Arg(n),
+// call Benchmark::Main from main(). Supported flags:
+//
+//   --benchmark_filter=<substring>
+//   --benchmark_min_time=<seconds>
+//   --benchmark_format=<console|json>
+//   --benchmark_out=<file>                (always JSON)
+//   --benchmark_simd=<scalar|sse4.1|avx2+fma>
+//
+// The JSON layout follows Google Benchmark's, so its compare.py works on it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "../include/simd.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+class Benchmark {
+public:
+	class State {
+	public:
+		State(size_t max_iterations, size_t range);
+
+		// Starts the timer on the first call and stops it on the last.
+		bool KeepRunning();
+		size_t range() const;
+		size_t iterations() const;
+		void SetItemsProcessed(size_t items);
+
+	private:
+		friend class Benchmark;
+
+		size_t iteration_;
+		size_t max_iterations_;
+		size_t range_;
+		size_t items_;
+		double real_seconds_;
+		double cpu_seconds_;
+		std::chrono::steady_clock::time_point real_start_;
+		clock_t cpu_start_;
+	};
+
+	typedef void (*Function)(State& state);
+
+	// Adds one run of the benchmark with state.range() == range.
+	Benchmark* Arg(size_t range);
+
+	static Benchmark* Register(const char* name, Function function);
+	static int Main(int argc, char** argv);
+
+	template<class T>
+	static void DoNotOptimize(const T& value);
+	// Forces every pending store to memory.
+	static void ClobberMemory();
+
+private:
+	struct Result {
+		std::string name;
+		size_t iterations;
+		double real_ns;
+		double cpu_ns;
+		double items_per_second;
+	};
+
+	Benchmark(const char* name, Function function);
+
+	static std::vector<Benchmark*>& Registry();
+	static Result Run(const Benchmark& benchmark, size_t range, double min_time);
+	static void WriteJson(FILE* file, const std::vector<Result>& results);
+
+	std::string name_;
+	Function function_;
+	std::vector<size_t> ranges_;
+};
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+#define BENCHMARK(function) \
+	static Benchmark* BENCHMARK_CONCAT(benchmark_registered_, __LINE__) = \
+		Benchmark::Register(#function, function)
+
+inline Benchmark::State::State(size_t max_iterations, size_t range)
+	: iteration_(0), max_iterations_(max_iterations), range_(range), items_(0),
+	real_seconds_(0.0), cpu_seconds_(0.0), cpu_start_(0) {}
+
+inline bool Benchmark::State::KeepRunning() {
+	if (iteration_ == 0) {
+		cpu_start_ = clock();
+		real_start_ = std::chrono::steady_clock::now();
+	}
+	if (iteration_ < max_iterations_) {
+		iteration_++;
+		return true;
+	}
+	real_seconds_ = std::chrono::duration<double>(std::chrono::steady_clock::now() - real_start_).count();
+	cpu_seconds_ = (double)(clock() - cpu_start_) / CLOCKS_PER_SEC;
+	return false;
+}
+
+inline size_t Benchmark::State::range() const {
+	return range_;
+}
+
+inline size_t Benchmark::State::iterations() const {
+	return iteration_;
+}
+
+inline void Benchmark::State::SetItemsProcessed(size_t items) {
+	items_ = items;
+}
+
+inline Benchmark::Benchmark(const char* name, Function function) : name_(name), function_(function) {}
+
+inline Benchmark* Benchmark::Arg(size_t range) {
+	ranges_.push_back(range);
+	return this;
+}
+
+inline std::vector<Benchmark*>& Benchmark::Registry() {
+	static std::vector<Benchmark*> registry;
+	return registry;
+}
+
+inline Benchmark* Benchmark::Register(const char* name, Function function) {
+	Benchmark* benchmark = new Benchmark(name, function);
+	Registry().push_back(benchmark);
+	return benchmark;
+}
+
+template<class T>
+inline void Benchmark::DoNotOptimize(const T& value) {
+#if defined(_MSC_VER)
+	static const T* volatile sink;
+	sink = &value;
+	_ReadWriteBarrier();
+#else
+	__asm__ __volatile__("" : : "r,m"(value) : "memory");
+#endif
+}
+
+inline void Benchmark::ClobberMemory() {
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+#else
+	__asm__ __volatile__("" : : : "memory");
+#endif
+}
+
+inline Benchmark::Result Benchmark::Run(const Benchmark& benchmark, size_t range, double min_time) {
+	// Same policy as Google Benchmark: grow the iteration count until a run
+	// takes min_time, then report that run.
+	size_t iterations = 1;
+	for (;;) {
+		State state(iterations, range);
+		benchmark.function_(state);
+		if (state.real_seconds_ >= min_time || iterations >= ((size_t)1 << 40)) {
+			Result result;
+			char name[256];
+			snprintf(name, sizeof(name), "%s/%zu", benchmark.name_.c_str(), range);
+			result.name = name;
+			result.iterations = state.iteration_;
+			result.real_ns = state.real_seconds_ * 1e9 / state.iteration_;
+			result.cpu_ns = state.cpu_seconds_ * 1e9 / state.iteration_;
+			result.items_per_second = state.items_ > 0 && state.real_seconds_ > 0.0 ?
+				state.items_ / state.real_seconds_ : 0.0;
+			return result;
+		}
+		double scale = state.real_seconds_ > 0.0 ? min_time * 1.4 / state.real_seconds_ : 10.0;
+		if (scale > 10.0) { scale = 10.0; }
+		if (scale < 2.0) { scale = 2.0; }
+		iterations = (size_t)(iterations * scale);
+	}
+}
+
+inline void Benchmark::WriteJson(FILE* file, const std::vector<Result>& results) {
+	char date[64];
+	time_t now = time(0);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+	fprintf(file, "{\n  \"context\": {\n");
+	fprintf(file, "    \"date\": \"%s\",\n", date);
+	fprintf(file, "    \"simd\": \"%s\",\n", Simd::Name(Simd::Active()));
+#if defined(NDEBUG)
+	fprintf(file, "    \"library_build_type\": \"release\"\n");
+#else
+	fprintf(file, "    \"library_build_type\": \"debug\"\n");
+#endif
+	fprintf(file, "  },\n  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); i++) {
+		const Result& result = results[i];
+		fprintf(file, "    {\n");
+		fprintf(file, "      \"name\": \"%s\",\n", result.name.c_str());
+		fprintf(file, "      \"run_type\": \"iteration\",\n");
+		fprintf(file, "      \"iterations\": %zu,\n", result.iterations);
+		fprintf(file, "      \"real_time\": %.6f,\n", result.real_ns);
+		fprintf(file, "      \"cpu_time\": %.6f,\n", result.cpu_ns);
+		fprintf(file, "      \"time_unit\": \"ns\",\n");
+		fprintf(file, "      \"items_per_second\": %.6f\n", result.items_per_second);
+		fprintf(file, "    }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+inline int Benchmark::Main(int argc, char** argv) {
+	const char* filter = "";
+	const char* out_path = 0;
+	double min_time = 0.5;
+	bool json = false;
+	for (int i = 1; i < argc; i++) {
+		const char* arg = argv[i];
+		if (strncmp(arg, "--benchmark_filter=", 19) == 0) {
+			filter = arg + 19;
+		} else if (strncmp(arg, "--benchmark_min_time=", 21) == 0) {
+			min_time = atof(arg + 21);
+		} else if (strcmp(arg, "--benchmark_format=json") == 0) {
+			json = true;
+		} else if (strcmp(arg, "--benchmark_format=console") == 0) {
+			json = false;
+		} else if (strncmp(arg, "--benchmark_out=", 16) == 0) {
+			out_path = arg + 16;
+		} else if (strncmp(arg, "--benchmark_simd=", 17) == 0) {
+			int level = Simd::kScalar;
+			for (; level <= Simd::kAVX2; level++) {
+				if (strcmp(arg + 17, Simd::Name((Simd::Level)level)) == 0) {
+					break;
+				}
+			}
+			if (level > Simd::kAVX2) {
+				fprintf(stderr, "unknown simd level %s\n", arg + 17);
+				return 1;
+			}
+			Simd::SetActive((Simd::Level)level);
+		} else {
+			fprintf(stderr, "unknown flag %s\n", arg);
+			return 1;
+		}
+	}
+
+	if (!json) {
+		printf("simd: %s\n", Simd::Name(Simd::Active()));
+		printf("%-48s %14s %14s %12s %16s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations", "Items/s");
+	}
+	std::vector<Result> results;
+	const std::vector<Benchmark*>& registry = Registry();
+	for (size_t i = 0; i < registry.size(); i++) {
+		const Benchmark& benchmark = *registry[i];
+		if (strstr(benchmark.name_.c_str(), filter) == 0) {
+			continue;
+		}
+		for (size_t r = 0; r < benchmark.ranges_.size(); r++) {
+			Result result = Run(benchmark, benchmark.ranges_[r], min_time);
+			if (!json) {
+				printf("%-48s %14.2f %14.2f %12zu %16.4g\n", result.name.c_str(), result.real_ns,
+					result.cpu_ns, result.iterations, result.items_per_second);
+				fflush(stdout);
+			}
+			results.push_back(result);
+		}
+	}
+	if (json) {
+		WriteJson(stdout, results);
+	}
+	if (out_path != 0) {
+		FILE* file = fopen(out_path, "w");
+		if (file == 0) {
+			fprintf(stderr, "cannot open %s\n", out_path);
+			return 1;
+		}
+		WriteJson(file, results);
+		fclose(file);
+	}
+	return 0;
+}
+
+#endif
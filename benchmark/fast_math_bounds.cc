@@ -0,0 +1,173 @@
+// Checks the error bounds documented in fast_math.h and times the FastMath
+// functions against libm.
+//
+//   g++ -O2 -DNDEBUG -std=c++17 -Iinclude benchmark/fast_math_bounds.cc -o fast_math_bounds
+//   ./fast_math_bounds [stride]
+//
+// Every stride-th float of each domain is compared to the double precision
+// libm result; stride 1 tests every float and takes several minutes. The
+// exit status is 1 if any bound is exceeded.
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "../include/vector_3.h"
+
+struct Bound {
+	const char* name;
+	float (*fast)(float);
+	float (*exact)(float);
+	double (*reference)(double);
+	float low;
+	float high;
+	// Documented max error in ulp.
+	double ulp;
+};
+
+static float FastRsqrt(float x) { return FastMath::Rsqrt(x); }
+static float FastSqrt(float x) { return FastMath::Sqrt(x); }
+static float FastAcos(float x) { return FastMath::Acos(x); }
+static float FastSin(float x) { return FastMath::Sin(x); }
+static float FastCos(float x) { return FastMath::Cos(x); }
+static float FastTan(float x) { return FastMath::Tan(x); }
+
+static float ExactRsqrt(float x) { return 1 / sqrtf(x); }
+static float ExactSqrt(float x) { return sqrtf(x); }
+static float ExactAcos(float x) { return acosf(x); }
+static float ExactSin(float x) { return sinf(x); }
+static float ExactCos(float x) { return cosf(x); }
+static float ExactTan(float x) { return tanf(x); }
+
+static double ReferenceRsqrt(double x) { return 1 / sqrt(x); }
+static double ReferenceSqrt(double x) { return sqrt(x); }
+static double ReferenceAcos(double x) { return acos(x); }
+static double ReferenceSin(double x) { return sin(x); }
+static double ReferenceCos(double x) { return cos(x); }
+static double ReferenceTan(double x) { return tan(x); }
+
+static const Bound kBounds[] = {
+	{ "Rsqrt", FastRsqrt, ExactRsqrt, ReferenceRsqrt, FLT_MIN, FLT_MAX, 5.0 },
+	{ "Sqrt", FastSqrt, ExactSqrt, ReferenceSqrt, FLT_MIN, FLT_MAX, 4.0 },
+	{ "Acos", FastAcos, ExactAcos, ReferenceAcos, -1.0f, 1.0f, 3.0 },
+	{ "Sin", FastSin, ExactSin, ReferenceSin, -FastMath::kTrigRange, FastMath::kTrigRange, 3.0 },
+	{ "Cos", FastCos, ExactCos, ReferenceCos, -FastMath::kTrigRange, FastMath::kTrigRange, 3.0 },
+	{ "Tan", FastTan, ExactTan, ReferenceTan, -FastMath::kTrigRange, FastMath::kTrigRange, 4.0 },
+};
+
+// Floats in order as integers: consecutive floats map to consecutive
+// integers across zero.
+static int64_t Ordinal(float x) {
+	int32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	return bits < 0 ? -(int64_t)(bits & 0x7fffffff) : bits;
+}
+
+static float FromOrdinal(int64_t ordinal) {
+	const int32_t bits = ordinal < 0 ? (int32_t)(-ordinal | 0x80000000) : (int32_t)ordinal;
+	float x;
+	memcpy(&x, &bits, sizeof(x));
+	return x;
+}
+
+// Error of value in units of the last place of the float nearest reference.
+static double Ulp(float value, double reference) {
+	const float rounded = fabsf((float)reference);
+	const double ulp = rounded < FLT_MAX ? (double)nextafterf(rounded, INFINITY) - rounded : ldexp(1.0, 104);
+	return fabs(value - reference) / ulp;
+}
+
+// Seconds per call of function, best of a few runs of at least 0.2s each.
+template<class F>
+static double Time(const F& function) {
+	double best = 1e30;
+	for (int run = 0; run < 3; run++) {
+		int calls = 0;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double seconds = 0.0;
+		do {
+			function();
+			calls++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < 0.2);
+		if (seconds / calls < best) {
+			best = seconds / calls;
+		}
+	}
+	return best;
+}
+
+// Nanoseconds per element of function over values.
+static double Nanoseconds(float (*function)(float), const std::vector<float>& values) {
+	std::vector<float> out(values.size());
+	const double seconds = Time([&]() {
+		for (size_t i = 0; i < values.size(); i++) {
+			out[i] = function(values[i]);
+		}
+		__asm__ __volatile__("" : : "r"(&out[0]) : "memory");
+	});
+	return seconds / values.size() * 1e9;
+}
+
+static float RandomFloat(float low, float high) {
+	return low + (float)rand() / RAND_MAX * (high - low);
+}
+
+int main(int argc, char** argv) {
+	const int64_t stride = argc > 1 ? atol(argv[1]) : 101;
+	bool failed = false;
+
+	printf("%-8s %-22s %10s %10s %14s %9s %9s\n", "function", "domain", "bound", "max ulp", "at", "fast ns", "libm ns");
+	for (size_t b = 0; b < sizeof(kBounds) / sizeof(kBounds[0]); b++) {
+		const Bound& bound = kBounds[b];
+		double max_ulp = 0.0;
+		float worst = bound.low;
+		const int64_t last = Ordinal(bound.high);
+		for (int64_t ordinal = Ordinal(bound.low); ordinal <= last; ordinal += stride) {
+			const float x = FromOrdinal(ordinal);
+			const double reference = bound.reference(x);
+			const float value = bound.fast(x);
+			const double ulp = Ulp(value, reference);
+			if (!(ulp <= max_ulp)) {
+				max_ulp = ulp;
+				worst = x;
+			}
+		}
+		const bool pass = max_ulp <= bound.ulp;
+		failed = failed || !pass;
+
+		std::vector<float> values(4096);
+		srand(1234);
+		for (size_t i = 0; i < values.size(); i++) {
+			values[i] = bound.low > 0.0f ? RandomFloat(1e-3f, 1e3f) : RandomFloat(bound.low, bound.high);
+		}
+		char domain[32];
+		snprintf(domain, sizeof(domain), "[%g, %g]", bound.low, bound.high);
+		printf("%-8s %-22s %10g %10.3f %14.8g %9.2f %9.2f %s\n", bound.name, domain, bound.ulp, max_ulp, worst,
+			Nanoseconds(bound.fast, values), Nanoseconds(bound.exact, values), pass ? "" : "FAILED");
+	}
+
+	// The composed Vector3 paths, on random vectors of mixed scale.
+	srand(1234);
+	double normalized_ulp = 0.0;
+	for (int i = 0; i < 1 << 22; i++) {
+		const float scale = ldexpf(1.0f, rand() % 64 - 32);
+		const Vector3 v(RandomFloat(-1, 1) * scale, RandomFloat(-1, 1) * scale, RandomFloat(-1, 1) * scale);
+		if (v.SqrMagnitude() < FLT_MIN) {
+			continue;
+		}
+		const Vector3 unit = v.Normalized(FastMath::kFast);
+		const double magnitude = sqrt((double)v.x * v.x + (double)v.y * v.y + (double)v.z * v.z);
+		normalized_ulp = fmax(normalized_ulp, Ulp(unit.x, v.x / magnitude));
+		normalized_ulp = fmax(normalized_ulp, Ulp(unit.y, v.y / magnitude));
+		normalized_ulp = fmax(normalized_ulp, Ulp(unit.z, v.z / magnitude));
+	}
+	const bool normalized_pass = normalized_ulp <= 3.0;
+	failed = failed || !normalized_pass;
+	printf("%-8s %-22s %10s %10.3f %s\n", "Normalized", "random vectors", "3", normalized_ulp, normalized_pass ? "" : "FAILED");
+
+	return failed ? 1 : 0;
+}
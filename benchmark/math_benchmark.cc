@@ -0,0 +1,973 @@
+// Benchmarks for every vector and matrix operation, as a single call and
+// over a large batch.
+//
+//   g++ -O2 -DNDEBUG -std=c++17 -Iinclude benchmark/math_benchmark.cc -o math_benchmark
+//   ./math_benchmark --benchmark_out=results.json
+//
+// Each benchmark runs with range 1 (one call per iteration) and with a
+// batch size; items_per_second is operations per second in both cases.
+
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "benchmark.h"
+#include "../include/math_utils.h"
+#include "../include/vector_2.h"
+#include "../include/vector_3.h"
+#include "../include/vector_4.h"
+#include "../include/vector_3_stream.h"
+#include "../include/matrix_2.h"
+#include "../include/matrix_3.h"
+#include "../include/matrix_4.h"
+#include "../include/quaternion.h"
+#include "../include/affine_3x4.h"
+#include "../include/expression.h"
+#include "../include/matrix.h"
+#include "../include/frustum.h"
+#include "../include/aabb_3_stream.h"
+#include "../include/bvh.h"
+#include "../include/intersection.h"
+#include "../include/frame_arena.h"
+#include "../include/camera_relative.h"
+#include "../include/skinning.h"
+
+// Template shapes, named so they fit the benchmark macro.
+typedef Vector<3, float> Vector3f;
+typedef Vector<4, float> Vector4f;
+typedef Vector<4, Half> Vector4h;
+typedef Matrix<4, 4, float> Matrix4f;
+
+static const size_t kSingle = 1;
+static const size_t kVectorBatch = 1 << 20;
+static const size_t kMatrixBatch = 1 << 16;
+static const size_t kSceneSize = 1 << 16;
+
+static float RandomFloat() {
+	return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// Angles in [-pi, pi].
+static void Randomize(float& value) {
+	value = RandomFloat() * 3.14159265f;
+}
+
+static void Randomize(Vector2& value) {
+	value = Vector2(RandomFloat(), RandomFloat());
+}
+
+static void Randomize(Vector3& value) {
+	value = Vector3(RandomFloat(), RandomFloat(), RandomFloat());
+}
+
+static void Randomize(Vector4& value) {
+	value = Vector4(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat());
+}
+
+static void Randomize(Matrix2x2& value) {
+	for (int i = 0; i < 4; i++) {
+		value.m[i] = RandomFloat();
+	}
+}
+
+static void Randomize(Matrix3x3& value) {
+	for (int i = 0; i < 9; i++) {
+		value.m[i] = RandomFloat();
+	}
+}
+
+static void Randomize(Matix4x4& value) {
+	for (int i = 0; i < 16; i++) {
+		value.m[i] = RandomFloat();
+	}
+}
+
+static void Randomize(Quaternion& value) {
+	value = Quaternion::Euler(RandomFloat() * 3.0f, RandomFloat() * 3.0f, RandomFloat() * 3.0f);
+}
+
+static void Randomize(Affine3x4& value) {
+	for (int i = 0; i < 12; i++) {
+		value.m[i] = RandomFloat();
+	}
+}
+
+template<int N, class T>
+static void Randomize(Vector<N, T>& value) {
+	for (int i = 0; i < N; i++) {
+		value.v[i] = T(RandomFloat());
+	}
+}
+
+template<int R, int C, class T>
+static void Randomize(Matrix<R, C, T>& value) {
+	for (int i = 0; i < R * C; i++) {
+		value.m[i] = T(RandomFloat());
+	}
+}
+
+static void Randomize(AABB3& value) {
+	value = AABB3::FromCenterExtent(Vector3(RandomFloat(), RandomFloat(), RandomFloat()),
+		Vector3(fabsf(RandomFloat()), fabsf(RandomFloat()), fabsf(RandomFloat())));
+}
+
+static Matrix3x3 Inverted(const Matrix3x3& value) {
+	Matrix3x3 out;
+	value.GetInverse(out);
+	return out;
+}
+
+static Matix4x4 Inverted(const Matix4x4& value) {
+	Matix4x4 out;
+	value.GetInverse(out);
+	return out;
+}
+
+static Affine3x4 Inverted(const Affine3x4& value) {
+	Affine3x4 out;
+	value.GetInverse(out);
+	return out;
+}
+
+static Matix4x4 InvertedAffine(const Matix4x4& value) {
+	Matix4x4 out;
+	value.GetInverseAffine(out);
+	return out;
+}
+
+static Matrix4d InvertedAffine(const Matrix4d& value) {
+	Matrix4d out;
+	GetInverseAffine(value, out);
+	return out;
+}
+
+template<class T>
+static std::vector<T> RandomArray(size_t n) {
+	// Fixed seed so every run sees the same inputs.
+	srand((unsigned int)n);
+	std::vector<T> values(n);
+	for (size_t i = 0; i < n; i++) {
+		Randomize(values[i]);
+	}
+	return values;
+}
+
+// out[i] = expression over a[i] and b[i], for state.range() elements.
+#define MATH_BENCHMARK(name, Type, Result, expression, batch) \
+	static void name(Benchmark::State& state) { \
+		const size_t n = state.range(); \
+		const std::vector<Type> a = RandomArray<Type>(n); \
+		const std::vector<Type> b = RandomArray<Type>(n + 1); \
+		std::vector<Result> out(n); \
+		while (state.KeepRunning()) { \
+			for (size_t i = 0; i < n; i++) { \
+				out[i] = (expression); \
+			} \
+			Benchmark::ClobberMemory(); \
+		} \
+		state.SetItemsProcessed(state.iterations() * n); \
+	} \
+	BENCHMARK(name)->Arg(kSingle)->Arg(batch)
+
+MATH_BENCHMARK(BM_Vector2_Add, Vector2, Vector2, a[i] + b[i], kVectorBatch);
+MATH_BENCHMARK(BM_Vector2_Magnitude, Vector2, float, a[i].Magnitude(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector2_Normalized, Vector2, Vector2, a[i].Normalized(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector2_DotProduct, Vector2, float, Vector2::DotProduct(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector2_Distance, Vector2, float, Vector2::Distance(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector2_Lerp, Vector2, Vector2, Vector2::Lerp(a[i], b[i], 0.25f), kVectorBatch);
+
+MATH_BENCHMARK(BM_Vector3_Add, Vector3, Vector3, a[i] + b[i], kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Magnitude, Vector3, float, a[i].Magnitude(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Normalized, Vector3, Vector3, a[i].Normalized(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_DotProduct, Vector3, float, Vector3::DotProduct(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_CrossProduct, Vector3, Vector3, Vector3::CrossProduct(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Angle, Vector3, float, Vector3::Angle(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Distance, Vector3, float, Vector3::Distance(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Lerp, Vector3, Vector3, Vector3::Lerp(a[i], b[i], 0.25f), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Reflect, Vector3, Vector3, Vector3::Reflect(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_MagnitudeFast, Vector3, float, a[i].Magnitude(FastMath::kFast), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_NormalizedFast, Vector3, Vector3, a[i].Normalized(FastMath::kFast), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_AngleFast, Vector3, float, Vector3::Angle(a[i], b[i], FastMath::kFast), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_DistanceFast, Vector3, float, Vector3::Distance(a[i], b[i], FastMath::kFast), kVectorBatch);
+// Over many independent values, where FastMath::Rsqrt beats the division.
+MATH_BENCHMARK(BM_FastMath_Rsqrt, float, float, FastMath::Rsqrt(1.0f + fabsf(a[i])), kVectorBatch);
+MATH_BENCHMARK(BM_FastMath_RsqrtExact, float, float, 1 / sqrtf(1.0f + fabsf(a[i])), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_Integrate, Vector3, Vector3, a[i] + b[i] * 0.25f - b[i + 1] / 3.0f, kVectorBatch);
+MATH_BENCHMARK(BM_Vector3_IntegrateLazy, Vector3, Vector3,
+	Lazy(a[i]) + Lazy(b[i]) * 0.25f - Lazy(b[i + 1]) / 3.0f, kVectorBatch);
+
+MATH_BENCHMARK(BM_Vector4_Add, Vector4, Vector4, a[i] + b[i], kVectorBatch);
+MATH_BENCHMARK(BM_Vector4_Magnitude, Vector4, float, a[i].Magnitude(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector4_Normalized, Vector4, Vector4, a[i].Normalized(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector4_DotProduct, Vector4, float, Vector4::DotProduct(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector4_Distance, Vector4, float, Vector4::Distance(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Vector4_Lerp, Vector4, Vector4, Vector4::Lerp(a[i], b[i], 0.25f), kVectorBatch);
+
+MATH_BENCHMARK(BM_Matrix2x2_Multiply, Matrix2x2, Matrix2x2, a[i].Multiply(b[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix2x2_Determinant, Matrix2x2, float, a[i].Determinant(), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix2x2_Inverse, Matrix2x2, Matrix2x2, a[i].Inverse(), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix2x2_Transpose, Matrix2x2, Matrix2x2, a[i].Transpose(), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix2x2_Blend, Matrix2x2, Matrix2x2, a[i] * 0.75f + b[i] * 0.25f - b[i + 1], kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix2x2_BlendLazy, Matrix2x2, Matrix2x2,
+	Lazy(a[i]) * 0.75f + Lazy(b[i]) * 0.25f - b[i + 1], kMatrixBatch);
+
+MATH_BENCHMARK(BM_Matrix3x3_Multiply, Matrix3x3, Matrix3x3, a[i].Multiply(b[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix3x3_Determinant, Matrix3x3, float, a[i].Determinant(), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix3x3_GetInverse, Matrix3x3, Matrix3x3, Inverted(a[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix3x3_Transpose, Matrix3x3, Matrix3x3, a[i].Transpose(), kMatrixBatch);
+
+MATH_BENCHMARK(BM_Matix4x4_Multiply, Matix4x4, Matix4x4, a[i].Multiply(b[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_Determinant, Matix4x4, float, a[i].Determinant(), kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_GetInverse, Matix4x4, Matix4x4, Inverted(a[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_GetInverseAffine, Matix4x4, Matix4x4, InvertedAffine(a[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_Transpose, Matix4x4, Matix4x4, a[i].Transpose(), kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_Blend, Matix4x4, Matix4x4, a[i] * 0.75f + b[i] * 0.25f - b[i + 1], kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_BlendLazy, Matix4x4, Matix4x4,
+	Lazy(a[i]) * 0.75f + Lazy(b[i]) * 0.25f - b[i + 1], kMatrixBatch);
+MATH_BENCHMARK(BM_Matix4x4_GetTransform, Vector3, Matix4x4,
+	Matix4x4::GetTransform(a[i], b[i] + 2.0f, b[i].x, b[i].y, b[i].z), kMatrixBatch);
+
+MATH_BENCHMARK(BM_Affine3x4_Multiply, Affine3x4, Affine3x4, a[i].Multiply(b[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Affine3x4_GetInverse, Affine3x4, Affine3x4, Inverted(a[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Affine3x4_TransformPoint, Affine3x4, Vector3,
+	a[i].TransformPoint(Vector3(b[i].m[0], b[i].m[1], b[i].m[2])), kMatrixBatch);
+
+MATH_BENCHMARK(BM_Quaternion_Multiply, Quaternion, Quaternion, a[i] * b[i], kMatrixBatch);
+MATH_BENCHMARK(BM_Quaternion_Rotate, Quaternion, Vector3, a[i].Rotate(Vector3(b[i].x, b[i].y, b[i].z)), kMatrixBatch);
+MATH_BENCHMARK(BM_Quaternion_Nlerp, Quaternion, Quaternion, Quaternion::Nlerp(a[i], b[i], 0.25f), kMatrixBatch);
+MATH_BENCHMARK(BM_Quaternion_Slerp, Quaternion, Quaternion, Quaternion::Slerp(a[i], b[i], 0.25f), kMatrixBatch);
+MATH_BENCHMARK(BM_Quaternion_ToMatrix, Quaternion, Matix4x4, a[i].ToMatrix(), kMatrixBatch);
+MATH_BENCHMARK(BM_Quaternion_FromMatrix, Matix4x4, Quaternion, Quaternion::FromMatrix(a[i]), kMatrixBatch);
+
+MATH_BENCHMARK(BM_Vector3f_Add, Vector3f, Vector3f, a[i] + b[i], kVectorBatch);
+MATH_BENCHMARK(BM_Vector3f_Normalized, Vector3f, Vector3f, a[i].Normalized(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector3d_Add, Vector3d, Vector3d, a[i] + b[i], kVectorBatch);
+MATH_BENCHMARK(BM_Vector3d_Normalized, Vector3d, Vector3d, a[i].Normalized(), kVectorBatch);
+MATH_BENCHMARK(BM_Vector4f_Blend, Vector4f, Vector4f, a[i] * 0.75f + b[i] * 0.25f - b[i + 1], kVectorBatch);
+MATH_BENCHMARK(BM_Vector4h_Add, Vector4h, Vector4h, a[i] + b[i], kVectorBatch);
+MATH_BENCHMARK(BM_Vector4h_DotProduct, Vector4h, float, Vector4h::DotProduct(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_Matrix4f_Multiply, Matrix4f, Matrix4f, a[i].Multiply(b[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix4d_Multiply, Matrix4d, Matrix4d, a[i].Multiply(b[i]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix4d_GetTransform, Vector3d, Matrix4d,
+	GetTransform(a[i], b[i] + 2.0, b[i].v[0], b[i].v[1], b[i].v[2]), kMatrixBatch);
+MATH_BENCHMARK(BM_Matrix4d_GetInverseAffine, Matrix4d, Matrix4d, InvertedAffine(a[i]), kMatrixBatch);
+
+MATH_BENCHMARK(BM_AABB3_Union, AABB3, AABB3, AABB3::Union(a[i], b[i]), kVectorBatch);
+MATH_BENCHMARK(BM_AABB3_Transform, AABB3, AABB3,
+	a[i].Transform(Matix4x4::Translate(b[i].min)), kVectorBatch);
+
+static void BM_AABB3Stream_Union(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<AABB3> a = RandomArray<AABB3>(n);
+	const std::vector<AABB3> b = RandomArray<AABB3>(n + 1);
+	const AABB3Stream sa(&a[0], n);
+	const AABB3Stream sb(&b[0], n);
+	AABB3Stream out(n);
+	while (state.KeepRunning()) {
+		AABB3Stream::Union(sa, sb, out);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_AABB3Stream_Union)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_AABB3Stream_Transform(Benchmark::State& state) {
+	const size_t n = state.range();
+	const Matix4x4 transform = Matix4x4::GetTransform(1.0f, 2.0f, 3.0f, 1.0f, 1.0f, 1.0f, 0.1f, 0.2f, 0.3f);
+	const std::vector<AABB3> boxes = RandomArray<AABB3>(n);
+	const AABB3Stream in(&boxes[0], n);
+	AABB3Stream out(n);
+	while (state.KeepRunning()) {
+		AABB3Stream::Transform(in, transform, out);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_AABB3Stream_Transform)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_AABB3Stream_Bounds(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<AABB3> boxes = RandomArray<AABB3>(n);
+	const AABB3Stream in(&boxes[0], n);
+	AABB3 out;
+	while (state.KeepRunning()) {
+		out = in.Bounds();
+		Benchmark::DoNotOptimize(out);
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_AABB3Stream_Bounds)->Arg(kSingle)->Arg(kVectorBatch);
+
+// Small boxes spread over a 100 x 100 x 10 volume.
+static std::vector<AABB3> SceneBoxes(size_t n) {
+	std::vector<AABB3> boxes = RandomArray<AABB3>(n);
+	for (size_t i = 0; i < n; i++) {
+		const Vector3 center = boxes[i].Center();
+		boxes[i] = AABB3::FromCenterExtent(Vector3(center.x * 50.0f, center.y * 50.0f, center.z * 5.0f),
+			boxes[i].Extent() * 0.2f);
+	}
+	return boxes;
+}
+
+static void BM_BVH_Build(Benchmark::State& state) {
+	const std::vector<AABB3> boxes = SceneBoxes(state.range());
+	BVH bvh;
+	while (state.KeepRunning()) {
+		bvh.Build(&boxes[0], boxes.size());
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_BVH_Build)->Arg(kSceneSize);
+
+static void BM_BVH_BuildParallel(Benchmark::State& state) {
+	const std::vector<AABB3> boxes = SceneBoxes(state.range());
+	ThreadPool pool;
+	BVH bvh;
+	while (state.KeepRunning()) {
+		bvh.Build(&boxes[0], boxes.size(), pool);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_BVH_BuildParallel)->Arg(kSceneSize);
+
+static void BM_BVH_Refit(Benchmark::State& state) {
+	const std::vector<AABB3> boxes = SceneBoxes(state.range());
+	BVH bvh;
+	bvh.Build(&boxes[0], boxes.size());
+	while (state.KeepRunning()) {
+		bvh.Refit(&boxes[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * boxes.size());
+}
+BENCHMARK(BM_BVH_Refit)->Arg(kSceneSize);
+
+// Rays from a camera above the scene through a grid over it, row by row,
+// so that neighbouring rays take similar paths as in rendering.
+static void SceneRays(size_t n, std::vector<Vector3>& origins, std::vector<Vector3>& directions) {
+	size_t width = 1;
+	while (width * width < n) {
+		width++;
+	}
+	origins.assign(n, Vector3(0.0f, 0.0f, 60.0f));
+	directions.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		const float u = (float)(i % width) / width * 2.0f - 1.0f;
+		const float v = (float)(i / width) / width * 2.0f - 1.0f;
+		directions[i] = (Vector3(u * 50.0f, v * 50.0f, 0.0f) - origins[i]).Normalized();
+	}
+}
+
+static void BM_BVH_Raycast(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<AABB3> boxes = SceneBoxes(kSceneSize);
+	BVH bvh;
+	bvh.Build(&boxes[0], boxes.size());
+	std::vector<Vector3> origins, directions;
+	SceneRays(n, origins, directions);
+	std::vector<float> t(n);
+	while (state.KeepRunning()) {
+		for (size_t i = 0; i < n; i++) {
+			t[i] = 100.0f;
+			bvh.Raycast(origins[i], directions[i], t[i], [&](int primitive, float& t_max) {
+				const Vector3 inverse(1.0f / directions[i].x, 1.0f / directions[i].y, 1.0f / directions[i].z);
+				float hit;
+				if (boxes[primitive].IntersectRay(origins[i], inverse, 0.0f, t_max, hit)) {
+					t_max = hit;
+				}
+			});
+		}
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_BVH_Raycast)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_BVH_RaycastPacket(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<AABB3> boxes = SceneBoxes(kSceneSize);
+	BVH bvh;
+	bvh.Build(&boxes[0], boxes.size());
+	std::vector<Vector3> origins, directions;
+	SceneRays(n, origins, directions);
+	const Vector3Stream origin_stream(&origins[0], n);
+	const Vector3Stream direction_stream(&directions[0], n);
+	std::vector<float> t(n);
+	while (state.KeepRunning()) {
+		std::fill(t.begin(), t.end(), 100.0f);
+		bvh.Raycast(origin_stream, direction_stream, &t[0], [&](int primitive, size_t ray, float& t_max) {
+			const Vector3 inverse(1.0f / directions[ray].x, 1.0f / directions[ray].y, 1.0f / directions[ray].z);
+			float hit;
+			if (boxes[primitive].IntersectRay(origins[ray], inverse, 0.0f, t_max, hit)) {
+				t_max = hit;
+			}
+		});
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_BVH_RaycastPacket)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_BVH_OverlapSphere(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<AABB3> boxes = SceneBoxes(kSceneSize);
+	BVH bvh;
+	bvh.Build(&boxes[0], boxes.size());
+	const std::vector<AABB3> queries = SceneBoxes(n);
+	std::vector<int> found(n);
+	while (state.KeepRunning()) {
+		for (size_t i = 0; i < n; i++) {
+			found[i] = 0;
+			bvh.Overlap(queries[i].Center(), 1.0f, [&](int) { found[i]++; });
+		}
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_BVH_OverlapSphere)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Intersection_RayTriangles(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> a = RandomArray<Vector3>(n);
+	const std::vector<Vector3> b = RandomArray<Vector3>(n + 1);
+	const std::vector<Vector3> c = RandomArray<Vector3>(n + 2);
+	const Vector3Stream sa(&a[0], n), sb(&b[0], n), sc(&c[0], n);
+	const Vector3 origin(0.1f, 0.2f, 3.0f);
+	const Vector3 direction = Vector3(0.05f, -0.02f, -1.0f).Normalized();
+	std::vector<uint32_t> hit((n + 31) / 32);
+	std::vector<float> t(n), u(n), v(n);
+	while (state.KeepRunning()) {
+		Intersection::RayTriangles(origin, direction, sa, sb, sc, 100.0f, &hit[0], &t[0], &u[0], &v[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Intersection_RayTriangles)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Intersection_RaysTriangle(Benchmark::State& state) {
+	const size_t n = state.range();
+	std::vector<Vector3> origins, directions;
+	SceneRays(n, origins, directions);
+	const Vector3Stream so(&origins[0], n), sd(&directions[0], n);
+	const Vector3 a(-40.0f, -40.0f, 0.0f), b(40.0f, -40.0f, 1.0f), c(0.0f, 40.0f, -1.0f);
+	const std::vector<float> t_max(n, 100.0f);
+	std::vector<uint32_t> hit((n + 31) / 32);
+	std::vector<float> t(n), u(n), v(n);
+	while (state.KeepRunning()) {
+		Intersection::RaysTriangle(so, sd, a, b, c, &t_max[0], &hit[0], &t[0], &u[0], &v[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Intersection_RaysTriangle)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Intersection_RayBoxes(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<AABB3> values = RandomArray<AABB3>(n);
+	const AABB3Stream boxes(&values[0], n);
+	const Vector3 origin(0.1f, 0.2f, 3.0f);
+	const Vector3 direction = Vector3(0.05f, -0.02f, -1.0f).Normalized();
+	std::vector<uint32_t> hit((n + 31) / 32);
+	std::vector<float> t(n);
+	while (state.KeepRunning()) {
+		Intersection::RayBoxes(origin, direction, boxes, 100.0f, &hit[0], &t[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Intersection_RayBoxes)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Intersection_RaysBox(Benchmark::State& state) {
+	const size_t n = state.range();
+	std::vector<Vector3> origins, directions;
+	SceneRays(n, origins, directions);
+	const Vector3Stream so(&origins[0], n), sd(&directions[0], n);
+	const AABB3 box(Vector3(-20.0f, -20.0f, -1.0f), Vector3(20.0f, 20.0f, 1.0f));
+	const std::vector<float> t_max(n, 100.0f);
+	std::vector<uint32_t> hit((n + 31) / 32);
+	std::vector<float> t(n);
+	while (state.KeepRunning()) {
+		Intersection::RaysBox(so, sd, box, &t_max[0], &hit[0], &t[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Intersection_RaysBox)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Quaternion_ToMatrices(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Quaternion> in = RandomArray<Quaternion>(n);
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		Quaternion::ToMatrices(&in[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Quaternion_ToMatrices)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matix4x4_MultiplyBatch(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matix4x4> a = RandomArray<Matix4x4>(n);
+	const std::vector<Matix4x4> b = RandomArray<Matix4x4>(n + 1);
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		Matix4x4::Multiply(&a[0], &b[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_MultiplyBatch)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matrix2x2_MultiplyBatch(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matrix2x2> a = RandomArray<Matrix2x2>(n);
+	const std::vector<Matrix2x2> b = RandomArray<Matrix2x2>(n + 1);
+	std::vector<Matrix2x2> out(n);
+	while (state.KeepRunning()) {
+		Matrix2x2::Multiply(&a[0], &b[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matrix2x2_MultiplyBatch)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matrix2x2_InverseBatch(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matrix2x2> a = RandomArray<Matrix2x2>(n);
+	std::vector<Matrix2x2> out(n);
+	while (state.KeepRunning()) {
+		Matrix2x2::Inverse(&a[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matrix2x2_InverseBatch)->Arg(kSingle)->Arg(kMatrixBatch);
+
+// One Jacobian per body applied to that body's vector.
+static void BM_Matrix2x2_TransformBatch(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matrix2x2> m = RandomArray<Matrix2x2>(n);
+	const std::vector<Vector2> in = RandomArray<Vector2>(n);
+	std::vector<Vector2> out(n);
+	while (state.KeepRunning()) {
+		Matrix2x2::Transform(&m[0], &in[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matrix2x2_TransformBatch)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matix4x4_TransformPoints(Benchmark::State& state) {
+	const size_t n = state.range();
+	const Matix4x4 transform = Matix4x4::GetTransform(1.0f, 2.0f, 3.0f, 1.0f, 1.0f, 1.0f, 0.1f, 0.2f, 0.3f);
+	const std::vector<Vector3> in = RandomArray<Vector3>(n);
+	std::vector<Vector3> out(n);
+	while (state.KeepRunning()) {
+		transform.TransformPoints(&in[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_TransformPoints)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Matix4x4_TransformVectors(Benchmark::State& state) {
+	const size_t n = state.range();
+	const Matix4x4 transform = Matix4x4::GetTransform(1.0f, 2.0f, 3.0f, 1.0f, 1.0f, 1.0f, 0.1f, 0.2f, 0.3f);
+	const std::vector<Vector4> in = RandomArray<Vector4>(n);
+	std::vector<Vector4> out(n);
+	while (state.KeepRunning()) {
+		transform.TransformVectors(&in[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_TransformVectors)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Matix4x4_GetTransforms(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream translate(&values[0], n);
+	Vector3Stream scale(&values[0], n);
+	Vector3Stream rotate(&values[0], n);
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		Matix4x4::GetTransforms(translate, scale, rotate, &out[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_GetTransforms)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matix4x4_GetTransformsFast(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream translate(&values[0], n);
+	Vector3Stream scale(&values[0], n);
+	Vector3Stream rotate(&values[0], n);
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		Matix4x4::GetTransforms(translate, scale, rotate, &out[0], FastMath::kFast);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_GetTransformsFast)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matix4x4_GetRotations(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream rotate(&values[0], n);
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		Matix4x4::GetRotations(rotate, &out[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_GetRotations)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Matix4x4_GetRotationsFast(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream rotate(&values[0], n);
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		Matix4x4::GetRotations(rotate, &out[0], FastMath::kFast);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Matix4x4_GetRotationsFast)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_CameraRelative_Rebase(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matrix4d> world = RandomArray<Matrix4d>(n);
+	const Vector3d origin({ 4.0e6, 1.0e3, -2.0e6 });
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		CameraRelative::Rebase(&world[0], origin, &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_CameraRelative_Rebase)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_CameraRelative_RebaseFrames(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matix4x4> frames = RandomArray<Matix4x4>(n);
+	const std::vector<Vector3d> positions = RandomArray<Vector3d>(n);
+	const Vector3d origin({ 4.0e6, 1.0e3, -2.0e6 });
+	std::vector<Matix4x4> out(n);
+	while (state.KeepRunning()) {
+		CameraRelative::Rebase(&frames[0], &positions[0], origin, &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_CameraRelative_RebaseFrames)->Arg(kSingle)->Arg(kMatrixBatch);
+
+// Curve parameters around [0, 1], a quarter of them outside it.
+static std::vector<float> RandomParameters(size_t n) {
+	std::vector<float> t(n);
+	for (size_t i = 0; i < n; i++) {
+		t[i] = RandomFloat() * 0.75f + 0.5f;
+	}
+	return t;
+}
+
+static void BM_MathUtils_Lerp(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<float> a = RandomArray<float>(n);
+	const std::vector<float> b = RandomArray<float>(n);
+	const std::vector<float> t = RandomParameters(n);
+	std::vector<float> out(n);
+	while (state.KeepRunning()) {
+		MathUtils::Lerp(&a[0], &b[0], &t[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MathUtils_Lerp)->Arg(kSingle)->Arg(kVectorBatch);
+
+// BM_MathUtils_Lerp clamping t the way Vector3::Lerp used to.
+static void BM_MathUtils_LerpBranchBaseline(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<float> a = RandomArray<float>(n);
+	const std::vector<float> b = RandomArray<float>(n);
+	const std::vector<float> t = RandomParameters(n);
+	std::vector<float> out(n);
+	while (state.KeepRunning()) {
+		for (size_t i = 0; i < n; i++) {
+			float clamped = t[i];
+			if (clamped > 1) { clamped = 1; }
+			if (clamped < 0) { clamped = 0; }
+			out[i] = a[i] + (b[i] - a[i]) * clamped;
+		}
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MathUtils_LerpBranchBaseline)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_MathUtils_SmoothStep(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<float> x = RandomParameters(n);
+	std::vector<float> out(n);
+	while (state.KeepRunning()) {
+		MathUtils::SmoothStep(0.25f, 0.75f, &x[0], &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MathUtils_SmoothStep)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_MathUtils_Remap(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<float> x = RandomParameters(n);
+	std::vector<float> out(n);
+	while (state.KeepRunning()) {
+		MathUtils::Remap(&x[0], 0.0f, 1.0f, -10.0f, 10.0f, &out[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_MathUtils_Remap)->Arg(kSingle)->Arg(kVectorBatch);
+
+static const size_t kBones = 64;
+
+// kInfluences bone indices and weights per vertex, the weights summing to 1.
+static void RandomInfluences(size_t n, std::vector<uint16_t>& indices, std::vector<float>& weights) {
+	indices.resize(Skinning::kInfluences * n);
+	weights.resize(Skinning::kInfluences * n);
+	for (size_t i = 0; i < n; i++) {
+		float sum = 0.0f;
+		for (int k = 0; k < Skinning::kInfluences; k++) {
+			indices[Skinning::kInfluences * i + k] = (uint16_t)(rand() % kBones);
+			weights[Skinning::kInfluences * i + k] = (float)rand() / RAND_MAX + 1e-3f;
+			sum += weights[Skinning::kInfluences * i + k];
+		}
+		for (int k = 0; k < Skinning::kInfluences; k++) {
+			weights[Skinning::kInfluences * i + k] /= sum;
+		}
+	}
+}
+
+static void BM_Skinning_Skin(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matix4x4> palette = RandomArray<Matix4x4>(kBones);
+	std::vector<uint16_t> indices;
+	std::vector<float> weights;
+	RandomInfluences(n, indices, weights);
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	const Vector3Stream positions(&values[0], n);
+	const Vector3Stream normals(&values[0], n);
+	Vector3Stream positions_out(n);
+	Vector3Stream normals_out(n);
+	while (state.KeepRunning()) {
+		Skinning::Skin(&palette[0], kBones, &indices[0], &weights[0], positions, normals, positions_out, normals_out);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Skinning_Skin)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_Skinning_SkinParallel(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matix4x4> palette = RandomArray<Matix4x4>(kBones);
+	std::vector<uint16_t> indices;
+	std::vector<float> weights;
+	RandomInfluences(n, indices, weights);
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	const Vector3Stream positions(&values[0], n);
+	const Vector3Stream normals(&values[0], n);
+	Vector3Stream positions_out(n);
+	Vector3Stream normals_out(n);
+	ThreadPool pool;
+	while (state.KeepRunning()) {
+		Skinning::Skin(&palette[0], kBones, &indices[0], &weights[0], positions, normals, positions_out, normals_out,
+			pool);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Skinning_SkinParallel)->Arg(kMatrixBatch);
+
+// BM_Skinning_Skin as a loop over Vector3 and Matix4x4 operators.
+static void BM_Skinning_VectorBaseline(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Matix4x4> palette = RandomArray<Matix4x4>(kBones);
+	std::vector<uint16_t> indices;
+	std::vector<float> weights;
+	RandomInfluences(n, indices, weights);
+	const std::vector<Vector3> positions = RandomArray<Vector3>(n);
+	const std::vector<Vector3> normals = RandomArray<Vector3>(n);
+	std::vector<Vector3> positions_out(n);
+	std::vector<Vector3> normals_out(n);
+	while (state.KeepRunning()) {
+		for (size_t i = 0; i < n; i++) {
+			const uint16_t* index = &indices[Skinning::kInfluences * i];
+			const float* weight = &weights[Skinning::kInfluences * i];
+			Matix4x4 blended = palette[index[0]] * weight[0];
+			for (int k = 1; k < Skinning::kInfluences; k++) {
+				blended += palette[index[k]] * weight[k];
+			}
+			positions_out[i] = blended.TransformPoint(positions[i]);
+			normals_out[i] = blended.TransformDirection(normals[i]);
+		}
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Skinning_VectorBaseline)->Arg(kSingle)->Arg(kMatrixBatch);
+
+// The temporary buffers of one frame for n nodes: world matrices, a
+// visibility mask and sort keys, written once each and then dropped.
+static void BM_FrameArena_Allocate(Benchmark::State& state) {
+	const size_t n = state.range();
+	FrameArena arena(n * (sizeof(Matix4x4) + sizeof(float)) + n / 8 + 4 * FrameArena::kMaxAlignment);
+	while (state.KeepRunning()) {
+		Matix4x4* world = arena.Allocate<Matix4x4>(n);
+		uint32_t* visible = arena.Allocate<uint32_t>((n + 31) / 32);
+		float* keys = arena.Allocate<float>(n);
+		world[n - 1].m[0] = 1.0f;
+		visible[0] = 1;
+		keys[n - 1] = 1.0f;
+		Benchmark::DoNotOptimize(world);
+		Benchmark::DoNotOptimize(visible);
+		Benchmark::DoNotOptimize(keys);
+		Benchmark::ClobberMemory();
+		arena.Reset();
+	}
+	state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_FrameArena_Allocate)->Arg(kSingle)->Arg(kMatrixBatch);
+
+// BM_FrameArena_Allocate with new[] and delete[].
+static void BM_FrameArena_NewBaseline(Benchmark::State& state) {
+	const size_t n = state.range();
+	while (state.KeepRunning()) {
+		Matix4x4* world = new Matix4x4[n];
+		uint32_t* visible = new uint32_t[(n + 31) / 32];
+		float* keys = new float[n];
+		world[n - 1].m[0] = 1.0f;
+		visible[0] = 1;
+		keys[n - 1] = 1.0f;
+		Benchmark::DoNotOptimize(world);
+		Benchmark::DoNotOptimize(visible);
+		Benchmark::DoNotOptimize(keys);
+		Benchmark::ClobberMemory();
+		delete[] keys;
+		delete[] visible;
+		delete[] world;
+	}
+	state.SetItemsProcessed(state.iterations() * 3);
+}
+BENCHMARK(BM_FrameArena_NewBaseline)->Arg(kSingle)->Arg(kMatrixBatch);
+
+static void BM_FastMath_SinCos(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<float> angles = RandomArray<float>(n);
+	std::vector<float> sin(n), cos(n);
+	while (state.KeepRunning()) {
+		FastMath::SinCos(&angles[0], &sin[0], &cos[0], n);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_FastMath_SinCos)->Arg(kSingle)->Arg(kVectorBatch);
+
+static Frustum CameraFrustum() {
+	const Matix4x4 projection = Matix4x4().PerspectiveMatrix(1.2f, 1.5f, 0.1f, 2.0f);
+	return Frustum(Matix4x4::Translate(0.0f, 0.0f, -1.0f).Multiply(projection.Transpose()));
+}
+
+static void BM_Frustum_CullBoxes(Benchmark::State& state) {
+	const size_t n = state.range();
+	const Frustum frustum = CameraFrustum();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream centers(&values[0], n);
+	Vector3Stream extents(n);
+	for (size_t i = 0; i < n; i++) {
+		extents.Set(i, Vector3(0.02f, 0.01f, 0.03f));
+	}
+	std::vector<uint32_t> visible((n + 31) / 32);
+	while (state.KeepRunning()) {
+		frustum.CullBoxes(centers, extents, &visible[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Frustum_CullBoxes)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Frustum_CullSpheres(Benchmark::State& state) {
+	const size_t n = state.range();
+	const Frustum frustum = CameraFrustum();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream centers(&values[0], n);
+	std::vector<float> radii(n, 0.02f);
+	std::vector<uint32_t> visible((n + 31) / 32);
+	while (state.KeepRunning()) {
+		frustum.CullSpheres(centers, &radii[0], &visible[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Frustum_CullSpheres)->Arg(kSingle)->Arg(kVectorBatch);
+
+static void BM_Vector3Stream_DotProduct(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream a(&values[0], n);
+	Vector3Stream b(&values[0], n);
+	std::vector<float> out(n);
+	while (state.KeepRunning()) {
+		Vector3Stream::DotProduct(a, b, &out[0]);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Vector3Stream_DotProduct)->Arg(kVectorBatch);
+
+static void BM_Vector3Stream_CrossProduct(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream a(&values[0], n);
+	Vector3Stream b(&values[0], n);
+	Vector3Stream out(n);
+	while (state.KeepRunning()) {
+		Vector3Stream::CrossProduct(a, b, out);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Vector3Stream_CrossProduct)->Arg(kVectorBatch);
+
+static void BM_Vector3Stream_Normalize(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream stream(&values[0], n);
+	while (state.KeepRunning()) {
+		stream.Normalize();
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Vector3Stream_Normalize)->Arg(kVectorBatch);
+
+static void BM_Vector3Stream_NormalizeFast(Benchmark::State& state) {
+	const size_t n = state.range();
+	const std::vector<Vector3> values = RandomArray<Vector3>(n);
+	Vector3Stream stream(&values[0], n);
+	while (state.KeepRunning()) {
+		stream.Normalize(FastMath::kFast);
+		Benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * n);
+}
+BENCHMARK(BM_Vector3Stream_NormalizeFast)->Arg(kVectorBatch);
+
+int main(int argc, char** argv) {
+	return Benchmark::Main(argc, argv);
+}
@@ -0,0 +1,1845 @@
+// Checks the math types against long double references on random inputs
+// and times them, max error and throughput side by side.
+//
+//   g++ -O2 -DNDEBUG -std=c++17 -pthread -Iinclude benchmark/math_regression.cc -o math_regression
+//   ./math_regression [count]
+//
+// Every check runs on count random inputs, 2^21 by default, a quarter of
+// that for 4x4 matrices and the BVH scene, which a sixteenth as many rays
+// trace. Operations with SIMD paths run once per level the CPU supports; a
+// level fails if it exceeds the error bound, or if it has a kernel of its
+// own and runs at less than kSlowest times the scalar throughput, measured
+// twice. The exit status is 1 if any check fails.
+//
+// Errors are in units in the last place of the magnitude of the terms
+// rather than of the result, so a sum that cancels is judged against the
+// rounding of its terms; see Real. A sum of n rounded products stays within
+// n such ulp, which sets most bounds.
+//
+// Kernels documented to give the same bits at every SIMD level run as
+// SameBits rows, which also require the bits of the scalar level, and the
+// batches documented to match their single form are compared to it bit for
+// bit; a mismatch shows as an infinite error. A bound of 0 with no long
+// double reference means the row checks bits only.
+//
+// The elementwise operators are compared to the same operations per element
+// in float, the Lazy() expressions to the eager operators and the pooled
+// Skinning::Skin to the single threaded form.
+//
+// Not checked bit for bit: the Matrix2x2, Vector3Stream, MathUtils array and
+// Quaternion::ToMatrices kernels, which only have their error bounds here.
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "../include/math_utils.h"
+#include "../include/vector_2.h"
+#include "../include/vector_3.h"
+#include "../include/vector_4.h"
+#include "../include/vector_3_stream.h"
+#include "../include/matrix_2.h"
+#include "../include/matrix_3.h"
+#include "../include/matrix_4.h"
+#include "../include/quaternion.h"
+#include "../include/skinning.h"
+#include "../include/affine_3x4.h"
+#include "../include/aabb_3.h"
+#include "../include/aabb_3_stream.h"
+#include "../include/frustum.h"
+#include "../include/intersection.h"
+#include "../include/bvh.h"
+#include "../include/half.h"
+#include "../include/matrix.h"
+#include "../include/camera_relative.h"
+#include "../include/expression.h"
+
+typedef Vector<4, float> Vector4f;
+typedef Matrix<4, 4, float> Matrix4f;
+
+// A SIMD level may be this much slower than the scalar path before it
+// fails, which leaves room for timing noise on levels without a kernel of
+// their own.
+static const double kSlowest = 0.75;
+
+// A long double value and the magnitude its float evaluation rounds
+// against: the sum of the magnitudes of the terms for sums and products,
+// first order error propagation for quotients and square roots.
+struct Real {
+	long double value;
+	long double scale;
+};
+
+static Real Exact(float x) {
+	const Real r = { x, fabsl(x) };
+	return r;
+}
+
+// A correctly rounded long double, such as sinl of a float.
+static Real Precise(long double x) {
+	const Real r = { x, fabsl(x) };
+	return r;
+}
+
+static Real operator+(const Real& a, const Real& b) {
+	const Real r = { a.value + b.value, a.scale + b.scale };
+	return r;
+}
+
+static Real operator-(const Real& a, const Real& b) {
+	const Real r = { a.value - b.value, a.scale + b.scale };
+	return r;
+}
+
+static Real operator-(const Real& a) {
+	const Real r = { -a.value, a.scale };
+	return r;
+}
+
+static Real operator*(const Real& a, const Real& b) {
+	const Real r = { a.value * b.value, a.scale * b.scale };
+	return r;
+}
+
+static Real operator/(const Real& a, const Real& b) {
+	const long double value = a.value / b.value;
+	const Real r = { value, (a.scale + fabsl(value) * b.scale) / fabsl(b.value) };
+	return r;
+}
+
+static Real Sqrt(const Real& a) {
+	const long double value = sqrtl(a.value);
+	const Real r = { value, value > 0.0L ? fmaxl(sqrtl(a.scale), a.scale / (2.0L * value)) : sqrtl(a.scale) };
+	return r;
+}
+
+// t limited to [0, 1]; the limits are exact.
+static Real Saturate(const Real& t) {
+	if (t.value < 0.0L || t.value > 1.0L) {
+		return Exact(t.value < 0.0L ? 0.0f : 1.0f);
+	}
+	return t;
+}
+
+// Error of value in ulp of the float nearest reference.scale. A zero scale
+// means the result must be exact.
+static double Ulp(float value, const Real& reference) {
+	const double error = fabsl((long double)value - reference.value);
+	const float scale = (float)reference.scale;
+	if (scale == 0.0f) {
+		return error == 0.0 ? 0.0 : INFINITY;
+	}
+	const double ulp = scale < FLT_MAX ? (double)nextafterf(scale, INFINITY) - scale : ldexp(1.0, 104);
+	return isnan(value) ? INFINITY : error / ulp;
+}
+
+// Seconds per call of function, best of a few runs of at least 0.1s each.
+template<class F>
+static double Time(const F& function) {
+	double best = 1e30;
+	for (int run = 0; run < 3; run++) {
+		int calls = 0;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double seconds = 0.0;
+		do {
+			function();
+			__asm__ __volatile__("" : : : "memory");
+			calls++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < 0.1);
+		if (seconds / calls < best) {
+			best = seconds / calls;
+		}
+	}
+	return best;
+}
+
+// One row of the report: the largest error against the references and the
+// throughput of one operation.
+class Check {
+public:
+	Check(const char* name, double bound) : name_(name), bound_(bound), max_ulp_(0.0), ops_per_second_(0.0), slow_(false) {}
+
+	void Compare(float value, const Real& reference) {
+		const double ulp = Ulp(value, reference);
+		if (!(ulp <= max_ulp_)) {
+			max_ulp_ = ulp;
+		}
+	}
+	void Compare(const float* values, const Real* references, int n) {
+		for (int i = 0; i < n; i++) {
+			Compare(values[i], references[i]);
+		}
+	}
+	// Bit for bit, so NaNs and signed zeros must match too. Any mismatch
+	// fails the row whatever its bound.
+	void CompareBits(const std::vector<float>& values, const std::vector<float>& expected) {
+		if (values.size() != expected.size() ||
+			(!values.empty() && memcmp(&values[0], &expected[0], values.size() * sizeof(float)) != 0)) {
+			max_ulp_ = INFINITY;
+		}
+	}
+
+	// body runs ops operations.
+	template<class F>
+	void Time(size_t ops, const F& body) {
+		ops_per_second_ = ops / ::Time(body);
+	}
+
+	double OpsPerSecond() const { return ops_per_second_; }
+	void SetSlow() { slow_ = true; }
+
+	// Prints the row and returns whether it passed.
+	bool Finish(const char* level) const {
+		const bool pass = max_ulp_ <= bound_ && !slow_;
+		printf("%-32s %-8s %8g %10.3f %12.2f %s\n", name_, level, bound_, max_ulp_, ops_per_second_ / 1e6,
+			pass ? "" : (slow_ ? "SLOW" : "FAILED"));
+		return pass;
+	}
+
+private:
+	const char* name_;
+	double bound_;
+	double max_ulp_;
+	double ops_per_second_;
+	bool slow_;
+};
+
+// Whether level keeps kSlowest of the scalar throughput when the two run
+// again back to back, so that one noisy timing does not fail a row.
+template<class F>
+static bool KeepsUp(const char* name, Simd::Level level, const F& test) {
+	Simd::SetActive(Simd::kScalar);
+	Check scalar(name, INFINITY);
+	test(scalar);
+	Simd::SetActive(level);
+	Check simd(name, INFINITY);
+	test(simd);
+	return simd.OpsPerSecond() >= kSlowest * scalar.OpsPerSecond();
+}
+
+// test(check) at every SIMD level the CPU supports, gated on the bound.
+// kernel is the lowest level that dispatches to a kernel of its own; the
+// levels below it run the scalar code, so only the levels from kernel up are
+// also gated on the scalar throughput.
+template<class F>
+static bool EveryLevel(const char* name, double bound, Simd::Level kernel, const F& test) {
+	bool pass = true;
+	double scalar = 0.0;
+	for (int level = Simd::kScalar; level <= Simd::Supported(); level++) {
+		Simd::SetActive((Simd::Level)level);
+		Check check(name, bound);
+		test(check);
+		if (level == Simd::kScalar) {
+			scalar = check.OpsPerSecond();
+		} else if (level >= kernel && check.OpsPerSecond() < kSlowest * scalar &&
+			!KeepsUp(name, (Simd::Level)level, test)) {
+			check.SetSlow();
+		}
+		pass = check.Finish(Simd::Name((Simd::Level)level)) && pass;
+	}
+	Simd::SetActive(Simd::Supported());
+	return pass;
+}
+
+// test(check) once, for operations without SIMD paths.
+template<class F>
+static bool Once(const char* name, double bound, const F& test) {
+	Check check(name, bound);
+	test(check);
+	return check.Finish("-");
+}
+
+// test(check, out) at every level as in EveryLevel, where the outputs the
+// test appends to out must also have the bits of the scalar level. For the
+// batch kernels documented to give the same bits at every level.
+template<class F>
+static bool SameBits(const char* name, double bound, Simd::Level kernel, const F& test) {
+	std::vector<float> scalar;
+	return EveryLevel(name, bound, kernel, [&](Check& check) {
+		std::vector<float> out;
+		test(check, out);
+		if (Simd::Active() == Simd::kScalar) {
+			scalar = out;
+		}
+		check.CompareBits(out, scalar);
+	});
+}
+
+// Appends the bits of n values of T to out, as floats for CompareBits.
+template<class T>
+static void AppendBits(const T* values, size_t n, std::vector<float>& out) {
+	static_assert(sizeof(T) % sizeof(float) == 0, "T must be made of 32-bit words");
+	const size_t first = out.size();
+	out.resize(first + n * sizeof(T) / sizeof(float));
+	if (n > 0) {
+		memcpy(&out[first], values, n * sizeof(T));
+	}
+}
+
+static void AppendBits(const Vector3Stream& values, std::vector<float>& out) {
+	AppendBits(values.x, values.Size(), out);
+	AppendBits(values.y, values.Size(), out);
+	AppendBits(values.z, values.Size(), out);
+}
+
+static void AppendBits(const AABB3Stream& boxes, std::vector<float>& out) {
+	AppendBits(boxes.min, out);
+	AppendBits(boxes.max, out);
+}
+
+static float RandomFloat() {
+	return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// Random floats of mixed sign with some exact repeats, so comparisons see
+// equal elements too.
+static std::vector<float> RandomFloats(size_t n) {
+	std::vector<float> values(n);
+	for (size_t i = 0; i < n; i++) {
+		values[i] = rand() % 8 == 0 && i > 0 ? values[i - 1] : RandomFloat();
+	}
+	return values;
+}
+
+template<class T>
+static std::vector<T> RandomArray(size_t n) {
+	static_assert(sizeof(T) % sizeof(float) == 0, "T must be made of floats");
+	const size_t floats = sizeof(T) / sizeof(float);
+	const std::vector<float> values = RandomFloats(n * floats);
+	std::vector<T> out(n);
+	memcpy((void*)&out[0], &values[0], n * sizeof(T));
+	return out;
+}
+
+// Matrices with a dominant diagonal, far from singular, so the inverse
+// checks measure rounding and not conditioning.
+template<class T>
+static std::vector<T> RandomInvertible(size_t n, int size) {
+	std::vector<T> out = RandomArray<T>(n);
+	for (size_t i = 0; i < n; i++) {
+		float* m = (float*)&out[i];
+		for (int d = 0; d < size; d++) {
+			m[d * size + d] += m[d * size + d] < 0.0f ? -(float)size : (float)size;
+		}
+	}
+	return out;
+}
+
+// RandomInvertible 4x4 matrices with the last colum set to (0, 0, 0, 1).
+static std::vector<Matix4x4> RandomAffine(size_t n) {
+	std::vector<Matix4x4> out = RandomInvertible<Matix4x4>(n, 4);
+	for (size_t i = 0; i < n; i++) {
+		out[i].m[3] = 0.0f;
+		out[i].m[7] = 0.0f;
+		out[i].m[11] = 0.0f;
+		out[i].m[15] = 1.0f;
+	}
+	return out;
+}
+
+// Boxes with centers in [-1, 1]^3 and half sizes up to 1.
+static std::vector<AABB3> RandomBoxes(size_t n) {
+	const std::vector<Vector3> values = RandomArray<Vector3>(2 * n);
+	std::vector<AABB3> out(n);
+	for (size_t i = 0; i < n; i++) {
+		const Vector3& extent = values[n + i];
+		out[i] = AABB3::FromCenterExtent(values[i], Vector3(fabsf(extent.x), fabsf(extent.y), fabsf(extent.z)));
+	}
+	return out;
+}
+
+// Reference matrix algebra on size x size line-major matrices.
+static void ReferenceMultiply(const float* a, const float* b, int size, Real* out) {
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			Real sum = Exact(a[i * size]) * Exact(b[j]);
+			for (int k = 1; k < size; k++) {
+				sum = sum + Exact(a[i * size + k]) * Exact(b[k * size + j]);
+			}
+			out[i * size + j] = sum;
+		}
+	}
+}
+
+// Laplace expansion along the first line of the lines and colums whose
+// bits are set in the masks.
+static Real Minor(const float* m, int size, int lines, int colums) {
+	int line = 0;
+	while (!(lines & (1 << line))) {
+		line++;
+	}
+	Real sum = { 0.0L, 0.0L };
+	bool first = true;
+	bool negative = false;
+	for (int colum = 0; colum < size; colum++) {
+		if (!(colums & (1 << colum))) {
+			continue;
+		}
+		Real term = Exact(m[line * size + colum]);
+		if ((lines & ~(1 << line)) != 0) {
+			term = term * Minor(m, size, lines & ~(1 << line), colums & ~(1 << colum));
+		}
+		sum = first ? (negative ? -term : term) : (negative ? sum - term : sum + term);
+		first = false;
+		negative = !negative;
+	}
+	return sum;
+}
+
+static Real ReferenceDeterminant(const float* m, int size) {
+	return Minor(m, size, (1 << size) - 1, (1 << size) - 1);
+}
+
+static void ReferenceInverse(const float* m, int size, Real* out) {
+	const int all = (1 << size) - 1;
+	const Real determinant = ReferenceDeterminant(m, size);
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < size; j++) {
+			const Real cofactor = Minor(m, size, all & ~(1 << j), all & ~(1 << i));
+			out[i * size + j] = ((i + j) & 1 ? -cofactor : cofactor) / determinant;
+		}
+	}
+}
+
+static Real ReferenceDot(const float* a, const float* b, int size) {
+	Real sum = Exact(a[0]) * Exact(b[0]);
+	for (int i = 1; i < size; i++) {
+		sum = sum + Exact(a[i]) * Exact(b[i]);
+	}
+	return sum;
+}
+
+static void ReferenceCross(const float* a, const float* b, Real* out) {
+	out[0] = Exact(a[1]) * Exact(b[2]) - Exact(a[2]) * Exact(b[1]);
+	out[1] = Exact(a[2]) * Exact(b[0]) - Exact(a[0]) * Exact(b[2]);
+	out[2] = Exact(a[0]) * Exact(b[1]) - Exact(a[1]) * Exact(b[0]);
+}
+
+static void ReferenceNormalized(const float* a, int size, Real* out) {
+	const Real magnitude = Sqrt(ReferenceDot(a, a, size));
+	for (int i = 0; i < size; i++) {
+		out[i] = Exact(a[i]) / magnitude;
+	}
+}
+
+// point * m with w = 1.
+static void ReferenceTransformPoint(const float* m, const float* point, Real* out) {
+	for (int j = 0; j < 3; j++) {
+		out[j] = Exact(point[0]) * Exact(m[j]) + Exact(point[1]) * Exact(m[4 + j]) + Exact(point[2]) * Exact(m[8 + j])
+			+ Exact(m[12 + j]);
+	}
+}
+
+// direction * m with w = 0.
+static void ReferenceTransformDirection(const float* m, const float* direction, Real* out) {
+	for (int j = 0; j < 3; j++) {
+		out[j] = Exact(direction[0]) * Exact(m[j]) + Exact(direction[1]) * Exact(m[4 + j])
+			+ Exact(direction[2]) * Exact(m[8 + j]);
+	}
+}
+
+// vector * m for a 4-element vector.
+static void ReferenceTransformVector(const float* m, const float* vector, Real* out) {
+	for (int j = 0; j < 4; j++) {
+		out[j] = Exact(vector[0]) * Exact(m[j]);
+		for (int k = 1; k < 4; k++) {
+			out[j] = out[j] + Exact(vector[k]) * Exact(m[k * 4 + j]);
+		}
+	}
+}
+
+static bool CheckMathUtils(size_t count) {
+	bool pass = true;
+	pass = Once("MathUtils::Clamp", 0.0, [&](Check& check) {
+		const std::vector<float> values = RandomFloats(3 * count);
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = MathUtils::Clamp(2.0f * values[3 * i], -fabsf(values[3 * i + 1]), fabsf(values[3 * i + 2]));
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			const long double value = 2.0f * values[3 * i];
+			const long double low = -fabsf(values[3 * i + 1]);
+			const long double high = fabsf(values[3 * i + 2]);
+			const Real reference = { value < low ? low : (value > high ? high : value), 0.0L };
+			check.Compare(out[i], reference);
+		}
+	}) && pass;
+
+	// Curve parameters around [0, 1], a quarter of them outside it.
+	std::vector<float> t = RandomFloats(count);
+	for (size_t i = 0; i < count; i++) {
+		t[i] = t[i] * 0.75f + 0.5f;
+	}
+	const std::vector<float> a = RandomFloats(count);
+	const std::vector<float> b = RandomFloats(count);
+
+	pass = EveryLevel("MathUtils::Saturate", 0.0, Simd::kAVX2, [&](Check& check) {
+		std::vector<float> out(count);
+		check.Time(count, [&]() { MathUtils::Saturate(&t[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			const Real reference = { Saturate(Exact(t[i])).value, 0.0L };
+			check.Compare(out[i], reference);
+		}
+	}) && pass;
+
+	pass = EveryLevel("MathUtils::Lerp", 2.0, Simd::kAVX2, [&](Check& check) {
+		std::vector<float> out(count);
+		check.Time(count, [&]() { MathUtils::Lerp(&a[0], &b[0], &t[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			check.Compare(out[i], Exact(a[i]) + (Exact(b[i]) - Exact(a[i])) * Saturate(Exact(t[i])));
+		}
+	}) && pass;
+
+	pass = EveryLevel("MathUtils::SmoothStep", 4.0, Simd::kAVX2, [&](Check& check) {
+		const float edge0 = -0.25f;
+		const float edge1 = 0.75f;
+		std::vector<float> out(count);
+		check.Time(count, [&]() { MathUtils::SmoothStep(edge0, edge1, &a[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			const Real x = Saturate((Exact(a[i]) - Exact(edge0)) / (Exact(edge1) - Exact(edge0)));
+			check.Compare(out[i], x * x * (Exact(3.0f) - Exact(2.0f) * x));
+		}
+	}) && pass;
+
+	pass = EveryLevel("MathUtils::Remap", 3.0, Simd::kAVX2, [&](Check& check) {
+		const float from_min = -1.0f, from_max = 1.0f, to_min = 10.0f, to_max = 30.0f;
+		std::vector<float> out(count);
+		check.Time(count, [&]() { MathUtils::Remap(&a[0], from_min, from_max, to_min, to_max, &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			const Real scale = (Exact(to_max) - Exact(to_min)) / (Exact(from_max) - Exact(from_min));
+			check.Compare(out[i], Exact(to_min) + (Exact(a[i]) - Exact(from_min)) * scale);
+		}
+	}) && pass;
+	return pass;
+}
+
+// == and != of a vector type, as 0 or 1 against an element by element
+// comparison.
+template<class T, int N>
+static bool CheckEquality(const char* name, size_t count) {
+	return Once(name, 0.0, [&](Check& check) {
+		const std::vector<T> a = RandomArray<T>(count);
+		std::vector<T> b = RandomArray<T>(count);
+		for (size_t i = 0; i < count; i++) {
+			// Equal in all, some or none of the elements.
+			for (int e = 0; e < N; e++) {
+				if (i % 3 == 0 || (i % 3 == 1 && rand() % 2 == 0)) {
+					((float*)&b[i])[e] = ((const float*)&a[i])[e];
+				}
+			}
+		}
+		std::vector<float> out(2 * count);
+		check.Time(2 * count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[2 * i] = a[i] == b[i] ? 1.0f : 0.0f;
+				out[2 * i + 1] = a[i] != b[i] ? 1.0f : 0.0f;
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			bool equal = true;
+			for (int e = 0; e < N; e++) {
+				equal = equal && ((const float*)&a[i])[e] == ((const float*)&b[i])[e];
+			}
+			const Real is_equal = { equal ? 1.0L : 0.0L, 0.0L };
+			const Real is_different = { equal ? 0.0L : 1.0L, 0.0L };
+			check.Compare(out[2 * i], is_equal);
+			check.Compare(out[2 * i + 1], is_different);
+		}
+	});
+}
+
+static bool CheckVectors(size_t count) {
+	bool pass = true;
+	pass = CheckEquality<Vector2, 2>("Vector2 == !=", count) && pass;
+	pass = CheckEquality<Vector3, 3>("Vector3 == !=", count) && pass;
+	pass = CheckEquality<Vector4, 4>("Vector4 == !=", count) && pass;
+
+	pass = Once("Vector2::Normalized", 3.0, [&](Check& check) {
+		const std::vector<Vector2> a = RandomArray<Vector2>(count);
+		std::vector<Vector2> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Normalized();
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[2];
+			ReferenceNormalized(&a[i].x, 2, reference);
+			check.Compare(&out[i].x, reference, 2);
+		}
+	}) && pass;
+
+	pass = Once("Vector3::DotProduct", 3.0, [&](Check& check) {
+		const std::vector<Vector3> a = RandomArray<Vector3>(count);
+		const std::vector<Vector3> b = RandomArray<Vector3>(count);
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = Vector3::DotProduct(a[i], b[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			check.Compare(out[i], ReferenceDot(&a[i].x, &b[i].x, 3));
+		}
+	}) && pass;
+
+	pass = Once("Vector3::CrossProduct", 2.0, [&](Check& check) {
+		const std::vector<Vector3> a = RandomArray<Vector3>(count);
+		const std::vector<Vector3> b = RandomArray<Vector3>(count);
+		std::vector<Vector3> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = Vector3::CrossProduct(a[i], b[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceCross(&a[i].x, &b[i].x, reference);
+			check.Compare(&out[i].x, reference, 3);
+		}
+	}) && pass;
+
+	pass = Once("Vector3::Distance", 3.0, [&](Check& check) {
+		const std::vector<Vector3> a = RandomArray<Vector3>(count);
+		const std::vector<Vector3> b = RandomArray<Vector3>(count);
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = Vector3::Distance(a[i], b[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real sum = { 0.0L, 0.0L };
+			for (int e = 0; e < 3; e++) {
+				const Real d = Exact((&a[i].x)[e]) - Exact((&b[i].x)[e]);
+				sum = sum + d * d;
+			}
+			check.Compare(out[i], Sqrt(sum));
+		}
+	}) && pass;
+
+	pass = Once("Vector3::Normalized", 3.0, [&](Check& check) {
+		const std::vector<Vector3> a = RandomArray<Vector3>(count);
+		std::vector<Vector3> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Normalized(FastMath::kExact);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceNormalized(&a[i].x, 3, reference);
+			check.Compare(&out[i].x, reference, 3);
+		}
+	}) && pass;
+
+	pass = Once("Vector3::Normalized kFast", 3.0, [&](Check& check) {
+		const std::vector<Vector3> a = RandomArray<Vector3>(count);
+		std::vector<Vector3> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Normalized(FastMath::kFast);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceNormalized(&a[i].x, 3, reference);
+			check.Compare(&out[i].x, reference, 3);
+		}
+	}) && pass;
+
+	pass = Once("Vector4::DotProduct", 4.0, [&](Check& check) {
+		const std::vector<Vector4> a = RandomArray<Vector4>(count);
+		const std::vector<Vector4> b = RandomArray<Vector4>(count);
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = Vector4::DotProduct(a[i], b[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			check.Compare(out[i], ReferenceDot(&a[i].x, &b[i].x, 4));
+		}
+	}) && pass;
+
+	pass = Once("Vector4::Normalized", 3.0, [&](Check& check) {
+		const std::vector<Vector4> a = RandomArray<Vector4>(count);
+		std::vector<Vector4> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Normalized();
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceNormalized(&a[i].x, 4, reference);
+			check.Compare(&out[i].x, reference, 4);
+		}
+	}) && pass;
+	return pass;
+}
+
+static bool CheckVector3Stream(size_t count) {
+	const std::vector<Vector3> a = RandomArray<Vector3>(count);
+	const std::vector<Vector3> b = RandomArray<Vector3>(count);
+	const Vector3Stream sa(&a[0], count);
+	const Vector3Stream sb(&b[0], count);
+	bool pass = true;
+
+	pass = EveryLevel("Vector3Stream::DotProduct", 3.0, Simd::kAVX2, [&](Check& check) {
+		std::vector<float> out(count);
+		check.Time(count, [&]() { Vector3Stream::DotProduct(sa, sb, &out[0]); });
+		for (size_t i = 0; i < count; i++) {
+			check.Compare(out[i], ReferenceDot(&a[i].x, &b[i].x, 3));
+		}
+	}) && pass;
+
+	pass = EveryLevel("Vector3Stream::CrossProduct", 2.0, Simd::kAVX2, [&](Check& check) {
+		Vector3Stream out(count);
+		check.Time(count, [&]() { Vector3Stream::CrossProduct(sa, sb, out); });
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceCross(&a[i].x, &b[i].x, reference);
+			const Vector3 value = out.Get(i);
+			check.Compare(&value.x, reference, 3);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Vector3Stream::Normalize kFast", 5.0, Simd::kAVX2, [&](Check& check) {
+		Vector3Stream out(count);
+		check.Time(count, [&]() {
+			out = sa;
+			out.Normalize(FastMath::kFast);
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceNormalized(&a[i].x, 3, reference);
+			const Vector3 value = out.Get(i);
+			check.Compare(&value.x, reference, 3);
+		}
+	}) && pass;
+	return pass;
+}
+
+static bool CheckMatrices(size_t count) {
+	bool pass = true;
+
+	pass = Once("Matrix2x2::Multiply", 2.0, [&](Check& check) {
+		const std::vector<Matrix2x2> a = RandomArray<Matrix2x2>(count);
+		const std::vector<Matrix2x2> b = RandomArray<Matrix2x2>(count);
+		std::vector<Matrix2x2> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Multiply(b[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceMultiply(a[i].m, b[i].m, 2, reference);
+			check.Compare(out[i].m, reference, 4);
+		}
+	}) && pass;
+
+	pass = Once("Matrix2x2::Determinant", 2.0, [&](Check& check) {
+		const std::vector<Matrix2x2> a = RandomArray<Matrix2x2>(count);
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Determinant();
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			check.Compare(out[i], ReferenceDeterminant(a[i].m, 2));
+		}
+	}) && pass;
+
+	pass = Once("Matrix2x2::Inverse", 3.0, [&](Check& check) {
+		const std::vector<Matrix2x2> a = RandomInvertible<Matrix2x2>(count, 2);
+		std::vector<Matrix2x2> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Inverse();
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceInverse(a[i].m, 2, reference);
+			check.Compare(out[i].m, reference, 4);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matrix2x2::Multiply batch", 2.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Matrix2x2> a = RandomArray<Matrix2x2>(count);
+		const std::vector<Matrix2x2> b = RandomArray<Matrix2x2>(count);
+		std::vector<Matrix2x2> out(count);
+		check.Time(count, [&]() { Matrix2x2::Multiply(&a[0], &b[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceMultiply(a[i].m, b[i].m, 2, reference);
+			check.Compare(out[i].m, reference, 4);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matrix2x2::Inverse batch", 3.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Matrix2x2> a = RandomInvertible<Matrix2x2>(count, 2);
+		std::vector<Matrix2x2> out(count);
+		check.Time(count, [&]() { Matrix2x2::Inverse(&a[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceInverse(a[i].m, 2, reference);
+			check.Compare(out[i].m, reference, 4);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matrix2x2::Transform batch", 2.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Matrix2x2> m = RandomArray<Matrix2x2>(count);
+		const std::vector<Vector2> in = RandomArray<Vector2>(count);
+		std::vector<Vector2> out(count);
+		check.Time(count, [&]() { Matrix2x2::Transform(&m[0], &in[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			const float* matrix = m[i].m;
+			const Real reference[2] = {
+				Exact(in[i].x) * Exact(matrix[0]) + Exact(in[i].y) * Exact(matrix[2]),
+				Exact(in[i].x) * Exact(matrix[1]) + Exact(in[i].y) * Exact(matrix[3])
+			};
+			check.Compare(&out[i].x, reference, 2);
+		}
+	}) && pass;
+
+	pass = Once("Matrix3x3::Identity", 0.0, [&](Check& check) {
+		Matrix3x3 out;
+		check.Time(1, [&]() { out = Matrix3x3::Identity(); });
+		for (int i = 0; i < 9; i++) {
+			const Real reference = { i % 4 == 0 ? 1.0L : 0.0L, 0.0L };
+			check.Compare(out.m[i], reference);
+		}
+	}) && pass;
+
+	pass = Once("Matrix3x3::Multiply", 3.0, [&](Check& check) {
+		const std::vector<Matrix3x3> a = RandomArray<Matrix3x3>(count);
+		const std::vector<Matrix3x3> b = RandomArray<Matrix3x3>(count);
+		std::vector<Matrix3x3> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Multiply(b[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[9];
+			ReferenceMultiply(a[i].m, b[i].m, 3, reference);
+			check.Compare(out[i].m, reference, 9);
+		}
+	}) && pass;
+
+	pass = Once("Matrix3x3::Determinant", 3.0, [&](Check& check) {
+		const std::vector<Matrix3x3> a = RandomArray<Matrix3x3>(count);
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = a[i].Determinant();
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			check.Compare(out[i], ReferenceDeterminant(a[i].m, 3));
+		}
+	}) && pass;
+
+	pass = Once("Matrix3x3::GetInverse", 4.0, [&](Check& check) {
+		const std::vector<Matrix3x3> a = RandomInvertible<Matrix3x3>(count, 3);
+		std::vector<Matrix3x3> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				a[i].GetInverse(out[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			Real reference[9];
+			ReferenceInverse(a[i].m, 3, reference);
+			check.Compare(out[i].m, reference, 9);
+		}
+	}) && pass;
+
+	const size_t matrices = count / 4;
+	const std::vector<Matix4x4> a = RandomArray<Matix4x4>(matrices);
+	const std::vector<Matix4x4> b = RandomArray<Matix4x4>(matrices);
+
+	pass = EveryLevel("Matix4x4::Multiply batch", 4.0, Simd::kSSE41, [&](Check& check) {
+		std::vector<Matix4x4> out(matrices);
+		check.Time(matrices, [&]() { Matix4x4::Multiply(&a[0], &b[0], &out[0], matrices); });
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[16];
+			ReferenceMultiply(a[i].m, b[i].m, 4, reference);
+			check.Compare(out[i].m, reference, 16);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matix4x4::GetInverse", 8.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Matix4x4> invertible = RandomInvertible<Matix4x4>(matrices, 4);
+		std::vector<Matix4x4> out(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				invertible[i].GetInverse(out[i]);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[16];
+			ReferenceInverse(invertible[i].m, 4, reference);
+			check.Compare(out[i].m, reference, 16);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matix4x4::TransformPoints", 4.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Vector3> points = RandomArray<Vector3>(count);
+		std::vector<Vector3> out(count);
+		check.Time(count, [&]() { a[0].TransformPoints(&points[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceTransformPoint(a[0].m, &points[i].x, reference);
+			check.Compare(&out[i].x, reference, 3);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matix4x4::TransformDirections", 3.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Vector3> directions = RandomArray<Vector3>(count);
+		std::vector<Vector3> out(count);
+		check.Time(count, [&]() { a[0].TransformDirections(&directions[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			Real reference[3];
+			ReferenceTransformDirection(a[0].m, &directions[i].x, reference);
+			check.Compare(&out[i].x, reference, 3);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Matix4x4::TransformVectors", 4.0, Simd::kSSE41, [&](Check& check) {
+		const std::vector<Vector4> vectors = RandomArray<Vector4>(count);
+		std::vector<Vector4> out(count);
+		check.Time(count, [&]() { a[0].TransformVectors(&vectors[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceTransformVector(a[0].m, &vectors[i].x, reference);
+			check.Compare(&out[i].x, reference, 4);
+		}
+	}) && pass;
+
+	const std::vector<Matix4x4> affine = RandomAffine(matrices);
+
+	pass = Once("Matix4x4::GetInverseAffine", 8.0, [&](Check& check) {
+		std::vector<Matix4x4> out(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				affine[i].GetInverseAffine(out[i]);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[16];
+			ReferenceInverse(affine[i].m, 4, reference);
+			check.Compare(out[i].m, reference, 16);
+		}
+	}) && pass;
+
+	pass = Once("Matix4x4::GetInverseRigid", 3.0, [&](Check& check) {
+		// Rotations of unit quaternions with a random translation. The
+		// transpose is exact, so only the translation rounds.
+		std::vector<Quaternion> q = RandomArray<Quaternion>(matrices);
+		std::vector<Matix4x4> rigid(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			q[i].Normalize();
+			rigid[i] = q[i].ToMatrix();
+			rigid[i].m[12] = a[i].m[12];
+			rigid[i].m[13] = a[i].m[13];
+			rigid[i].m[14] = a[i].m[14];
+		}
+		std::vector<Matix4x4> out(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				rigid[i].GetInverseRigid(out[i]);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			const float* m = rigid[i].m;
+			Real reference[16];
+			for (int line = 0; line < 3; line++) {
+				for (int colum = 0; colum < 3; colum++) {
+					reference[line * 4 + colum] = Exact(m[colum * 4 + line]);
+				}
+				reference[line * 4 + 3] = Exact(0.0f);
+				reference[12 + line] = -(Exact(m[12]) * Exact(m[line * 4]) + Exact(m[13]) * Exact(m[line * 4 + 1])
+					+ Exact(m[14]) * Exact(m[line * 4 + 2]));
+			}
+			reference[15] = Exact(1.0f);
+			check.Compare(out[i].m, reference, 16);
+		}
+	}) && pass;
+
+	const std::vector<Vector3> nodes = RandomArray<Vector3>(3 * matrices);
+	const Vector3Stream translate(&nodes[0], matrices);
+	const Vector3Stream scale(&nodes[matrices], matrices);
+	const Vector3Stream rotate(&nodes[2 * matrices], matrices);
+
+	pass = SameBits("Matix4x4::GetTransforms kFast", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<Matix4x4> transforms(matrices);
+		check.Time(matrices, [&]() {
+			Matix4x4::GetTransforms(translate, scale, rotate, &transforms[0], FastMath::kFast);
+		});
+		std::vector<Matix4x4> single(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			const Vector3 angles = rotate.Get(i);
+			single[i] = Matix4x4::GetTransform(translate.Get(i), scale.Get(i), angles.x, angles.y, angles.z,
+				FastMath::kFast);
+		}
+		std::vector<float> expected;
+		AppendBits(&single[0], matrices, expected);
+		AppendBits(&transforms[0], matrices, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	pass = SameBits("Matix4x4::GetRotations kFast", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<Matix4x4> rotations(matrices);
+		check.Time(matrices, [&]() { Matix4x4::GetRotations(rotate, &rotations[0], FastMath::kFast); });
+		std::vector<Matix4x4> single(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			const Vector3 angles = rotate.Get(i);
+			single[i] = Matix4x4::GetTransform(Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 1.0f, 1.0f),
+				angles.x, angles.y, angles.z, FastMath::kFast);
+		}
+		std::vector<float> expected;
+		AppendBits(&single[0], matrices, expected);
+		AppendBits(&rotations[0], matrices, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	typedef void (*RotateBatch)(const float*, Matix4x4*, size_t, FastMath::Precision);
+	typedef Matix4x4 (*RotateSingle)(float, FastMath::Precision);
+	const char* const rotate_names[] = {
+		"Matix4x4::RotateX batch kFast", "Matix4x4::RotateY batch kFast", "Matix4x4::RotateZ batch kFast" };
+	const RotateBatch rotate_batch[] = { &Matix4x4::RotateX, &Matix4x4::RotateY, &Matix4x4::RotateZ };
+	const RotateSingle rotate_single[] = { &Matix4x4::RotateX, &Matix4x4::RotateY, &Matix4x4::RotateZ };
+	for (int axis = 0; axis < 3; axis++) {
+		pass = SameBits(rotate_names[axis], 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+			std::vector<Matix4x4> rotations(matrices);
+			check.Time(matrices, [&]() { rotate_batch[axis](rotate.x, &rotations[0], matrices, FastMath::kFast); });
+			std::vector<Matix4x4> single(matrices);
+			for (size_t i = 0; i < matrices; i++) {
+				single[i] = rotate_single[axis](rotate.x[i], FastMath::kFast);
+			}
+			std::vector<float> expected;
+			AppendBits(&single[0], matrices, expected);
+			AppendBits(&rotations[0], matrices, out);
+			check.CompareBits(out, expected);
+		}) && pass;
+	}
+
+	const std::vector<Affine3x4> affine_a = RandomArray<Affine3x4>(matrices);
+	const std::vector<Affine3x4> affine_b = RandomArray<Affine3x4>(matrices);
+
+	pass = SameBits("Affine3x4::Multiply", 4.0, Simd::kSSE41, [&](Check& check, std::vector<float>& out) {
+		std::vector<Affine3x4> products(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				products[i] = affine_a[i].Multiply(affine_b[i]);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[16];
+			ReferenceMultiply(affine_a[i].ToMatrix().m, affine_b[i].ToMatrix().m, 4, reference);
+			check.Compare(products[i].ToMatrix().m, reference, 16);
+		}
+		AppendBits(&products[0], matrices, out);
+	}) && pass;
+
+	pass = Once("Affine3x4::GetInverse", 8.0, [&](Check& check) {
+		std::vector<Affine3x4> in(matrices), out(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			in[i] = Affine3x4(affine[i]);
+		}
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				in[i].GetInverse(out[i]);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[16];
+			ReferenceInverse(affine[i].m, 4, reference);
+			check.Compare(out[i].ToMatrix().m, reference, 16);
+		}
+	}) && pass;
+	return pass;
+}
+
+// The quaternion formulas evaluated in long double, so the checks measure
+// rounding on unit quaternions.
+static bool CheckQuaternions(size_t count) {
+	std::vector<Quaternion> q = RandomArray<Quaternion>(count);
+	for (size_t i = 0; i < count; i++) {
+		q[i].Normalize();
+	}
+	bool pass = true;
+
+	pass = Once("Quaternion::Multiply", 4.0, [&](Check& check) {
+		std::vector<Quaternion> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = q[i].Multiply(q[count - 1 - i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			const Quaternion& a = q[i];
+			const Quaternion& b = q[count - 1 - i];
+			const Real x = Exact(a.w) * Exact(b.x) + Exact(a.x) * Exact(b.w) + Exact(a.y) * Exact(b.z) - Exact(a.z) * Exact(b.y);
+			const Real y = Exact(a.w) * Exact(b.y) - Exact(a.x) * Exact(b.z) + Exact(a.y) * Exact(b.w) + Exact(a.z) * Exact(b.x);
+			const Real z = Exact(a.w) * Exact(b.z) + Exact(a.x) * Exact(b.y) - Exact(a.y) * Exact(b.x) + Exact(a.z) * Exact(b.w);
+			const Real w = Exact(a.w) * Exact(b.w) - Exact(a.x) * Exact(b.x) - Exact(a.y) * Exact(b.y) - Exact(a.z) * Exact(b.z);
+			const Real reference[4] = { x, y, z, w };
+			check.Compare(&out[i].x, reference, 4);
+		}
+	}) && pass;
+
+	pass = Once("Quaternion::Rotate", 4.0, [&](Check& check) {
+		const std::vector<Vector3> v = RandomArray<Vector3>(count);
+		std::vector<Vector3> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = q[i].Rotate(v[i]);
+			}
+		});
+		for (size_t i = 0; i < count; i++) {
+			// v + w t + t x u with t = 2 (v x u).
+			const float u[3] = { q[i].x, q[i].y, q[i].z };
+			Real t[3];
+			ReferenceCross(&v[i].x, u, t);
+			const Real two = Exact(2.0f);
+			Real reference[3];
+			for (int e = 0; e < 3; e++) {
+				t[e] = two * t[e];
+			}
+			const Real cross[3] = {
+				t[1] * Exact(u[2]) - t[2] * Exact(u[1]),
+				t[2] * Exact(u[0]) - t[0] * Exact(u[2]),
+				t[0] * Exact(u[1]) - t[1] * Exact(u[0]) };
+			for (int e = 0; e < 3; e++) {
+				reference[e] = Exact((&v[i].x)[e]) + t[e] * Exact(q[i].w) + cross[e];
+			}
+			check.Compare(&out[i].x, reference, 3);
+		}
+	}) && pass;
+
+	pass = EveryLevel("Quaternion::ToMatrices", 3.0, Simd::kSSE41, [&](Check& check) {
+		std::vector<Matix4x4> out(count);
+		check.Time(count, [&]() { Quaternion::ToMatrices(&q[0], &out[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			const Real x = Exact(q[i].x), y = Exact(q[i].y), z = Exact(q[i].z), w = Exact(q[i].w);
+			const Real one = Exact(1.0f), two = Exact(2.0f), zero = Exact(0.0f);
+			const Real reference[16] = {
+				one - two * (y * y + z * z), two * (x * y - w * z), two * (x * z + w * y), zero,
+				two * (x * y + w * z), one - two * (x * x + z * z), two * (y * z - w * x), zero,
+				two * (x * z - w * y), two * (y * z + w * x), one - two * (x * x + y * y), zero,
+				zero, zero, zero, one };
+			check.Compare(out[i].m, reference, 16);
+		}
+	}) && pass;
+	return pass;
+}
+
+static bool CheckFastMath(size_t count) {
+	std::vector<float> angles(count);
+	for (size_t i = 0; i < count; i++) {
+		angles[i] = RandomFloat() * 100.0f;
+	}
+	return EveryLevel("FastMath::SinCos batch", 3.0, Simd::kAVX2, [&](Check& check) {
+		std::vector<float> sin(count), cos(count);
+		check.Time(count, [&]() { FastMath::SinCos(&angles[0], &sin[0], &cos[0], count); });
+		for (size_t i = 0; i < count; i++) {
+			// Against the correctly rounded result, as in fast_math_bounds.
+			const long double s = sinl(angles[i]);
+			const long double c = cosl(angles[i]);
+			const Real sin_reference = { s, fabsl(s) };
+			const Real cos_reference = { c, fabsl(c) };
+			check.Compare(sin[i], sin_reference);
+			check.Compare(cos[i], cos_reference);
+		}
+	});
+}
+
+static bool CheckSkinning(size_t count) {
+	const size_t bones = 64;
+	const std::vector<Matix4x4> palette = RandomArray<Matix4x4>(bones);
+	std::vector<uint16_t> indices(Skinning::kInfluences * count);
+	std::vector<float> weights(Skinning::kInfluences * count);
+	for (size_t i = 0; i < indices.size(); i++) {
+		indices[i] = (uint16_t)(rand() % bones);
+		weights[i] = (float)rand() / RAND_MAX;
+	}
+	const std::vector<Vector3> values = RandomArray<Vector3>(2 * count);
+	const Vector3Stream positions(&values[0], count);
+	const Vector3Stream normals(&values[count], count);
+
+	bool pass = EveryLevel("Skinning::Skin", 5.0, Simd::kAVX2, [&](Check& check) {
+		Vector3Stream positions_out, normals_out;
+		check.Time(count, [&]() {
+			Skinning::Skin(&palette[0], bones, &indices[0], &weights[0], positions, normals, positions_out, normals_out);
+		});
+		for (size_t i = 0; i < count; i++) {
+			const uint16_t* index = &indices[Skinning::kInfluences * i];
+			const float* weight = &weights[Skinning::kInfluences * i];
+			Real m[16];
+			for (int j = 0; j < 16; j++) {
+				m[j] = Exact(weight[0]) * Exact(palette[index[0]].m[j]);
+				for (int k = 1; k < Skinning::kInfluences; k++) {
+					m[j] = m[j] + Exact(weight[k]) * Exact(palette[index[k]].m[j]);
+				}
+			}
+			const Vector3 point = positions.Get(i);
+			const Vector3 normal = normals.Get(i);
+			Real point_reference[3], normal_reference[3];
+			for (int j = 0; j < 3; j++) {
+				normal_reference[j] = Exact(normal.x) * m[j] + Exact(normal.y) * m[4 + j] + Exact(normal.z) * m[8 + j];
+				point_reference[j] = Exact(point.x) * m[j] + Exact(point.y) * m[4 + j] + Exact(point.z) * m[8 + j] + m[12 + j];
+			}
+			const Vector3 point_out = positions_out.Get(i);
+			const Vector3 normal_out = normals_out.Get(i);
+			check.Compare(&point_out.x, point_reference, 3);
+			check.Compare(&normal_out.x, normal_reference, 3);
+		}
+	});
+
+	// Against the single threaded form at the same level, which is not the
+	// same at every level.
+	ThreadPool pool(4);
+	pass = EveryLevel("Skinning::Skin pooled", 0.0, Simd::kAVX2, [&](Check& check) {
+		Vector3Stream positions_out, normals_out;
+		check.Time(count, [&]() {
+			Skinning::Skin(&palette[0], bones, &indices[0], &weights[0], positions, normals, positions_out, normals_out,
+				pool);
+		});
+		Vector3Stream single_positions, single_normals;
+		Skinning::Skin(&palette[0], bones, &indices[0], &weights[0], positions, normals, single_positions,
+			single_normals);
+		std::vector<float> out, expected;
+		AppendBits(single_positions, expected);
+		AppendBits(single_normals, expected);
+		AppendBits(positions_out, out);
+		AppendBits(normals_out, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+	return pass;
+}
+
+// The elements of value, appended to out.
+template<class T>
+static void AppendElements(const T& value, std::vector<float>& out) {
+	for (int i = 0; i < ElementTraits<T>::kSize; i++) {
+		out.push_back(ElementTraits<T>::Get(value, i));
+	}
+}
+
+// The elementwise operators, which must give the bits of the same operations
+// on each element in float: on SSE registers for the packed types of a
+// multiple of 4 floats, and unrolled per element for the others.
+template<class T>
+static bool CheckOperators(const char* name, size_t count) {
+	const std::vector<T> a = RandomArray<T>(count);
+	const std::vector<T> b = RandomArray<T>(count);
+	const std::vector<float> scalars = RandomFloats(count);
+	const int kOperators = 7;
+	return Once(name, 0.0, [&](Check& check) {
+		std::vector<T> results(kOperators * count);
+		check.Time(kOperators * count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				T* result = &results[kOperators * i];
+				result[0] = a[i] + b[i];
+				result[1] = a[i] - b[i];
+				result[2] = a[i] + scalars[i];
+				result[3] = a[i] - scalars[i];
+				result[4] = a[i] * scalars[i];
+				result[5] = a[i] / scalars[i];
+				result[6] = Elementwise<T>::Negate(a[i]);
+			}
+		});
+		std::vector<float> out, expected;
+		for (size_t i = 0; i < count; i++) {
+			for (int j = 0; j < kOperators; j++) {
+				AppendElements(results[kOperators * i + j], out);
+			}
+			for (int j = 0; j < kOperators; j++) {
+				for (int k = 0; k < ElementTraits<T>::kSize; k++) {
+					const float x = ElementTraits<T>::Get(a[i], k);
+					const float y = ElementTraits<T>::Get(b[i], k);
+					const float s = scalars[i];
+					const float element[] = { x + y, x - y, x + s, x - s, x * s, x / s, -x };
+					expected.push_back(element[j]);
+				}
+			}
+		}
+		check.CompareBits(out, expected);
+	});
+}
+
+// Lazy() expressions, which must give the bits of the eager operators.
+template<class T>
+static bool CheckExpression(const char* name, size_t count) {
+	const std::vector<T> a = RandomArray<T>(count);
+	const std::vector<T> b = RandomArray<T>(count);
+	const std::vector<T> c = RandomArray<T>(count);
+	return Once(name, 0.0, [&](Check& check) {
+		std::vector<T> lazy(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				lazy[i] = Lazy(a[i]) * 0.75f + 0.25f * Lazy(b[i]) - Lazy(c[i]) / 3.0f + 1.0f;
+			}
+		});
+		std::vector<float> out, expected;
+		for (size_t i = 0; i < count; i++) {
+			AppendElements(lazy[i], out);
+			AppendElements(a[i] * 0.75f + b[i] * 0.25f - c[i] / 3.0f + 1.0f, expected);
+		}
+		check.CompareBits(out, expected);
+	});
+}
+
+// Matrix<4, 4, float> on the Matix4x4 kernels, which must give the bits of
+// the Matix4x4 forms at the same level, and the double precision Matrix4d
+// helpers, which must round to within an ulp of float once their result is
+// rounded to float.
+static bool CheckMatrixTemplates(size_t count) {
+	const size_t matrices = count / 4;
+	const std::vector<Matix4x4> a = RandomArray<Matix4x4>(matrices);
+	const std::vector<Matix4x4> b = RandomArray<Matix4x4>(matrices);
+	bool pass = true;
+
+	pass = EveryLevel("Matrix4f::Multiply", 4.0, Simd::kSSE41, [&](Check& check) {
+		std::vector<Matrix4f> out(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				out[i] = ToMatrix(a[i]).Multiply(ToMatrix(b[i]));
+			}
+		});
+		std::vector<Matix4x4> fixed(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			fixed[i] = a[i].Multiply(b[i]);
+			Real reference[16];
+			ReferenceMultiply(a[i].m, b[i].m, 4, reference);
+			check.Compare(out[i].m, reference, 16);
+		}
+		std::vector<float> values, expected;
+		AppendBits(&out[0], matrices, values);
+		AppendBits(&fixed[0], matrices, expected);
+		check.CompareBits(values, expected);
+	}) && pass;
+
+	pass = EveryLevel("Matrix4f::Transform batch", 4.0, Simd::kSSE41, [&](Check& check) {
+		const Matrix4f m = ToMatrix(a[0]);
+		const std::vector<Vector4> vectors = RandomArray<Vector4>(count);
+		std::vector<Vector4f> in(count), out(count);
+		for (size_t i = 0; i < count; i++) {
+			in[i] = Vector4f(&vectors[i].x);
+		}
+		check.Time(count, [&]() { m.Transform(&in[0], &out[0], count); });
+		std::vector<Vector4> fixed(count);
+		a[0].TransformVectors(&vectors[0], &fixed[0], count);
+		for (size_t i = 0; i < count; i++) {
+			Real reference[4];
+			ReferenceTransformVector(a[0].m, &vectors[i].x, reference);
+			check.Compare(out[i].v, reference, 4);
+		}
+		std::vector<float> values, expected;
+		AppendBits(&out[0], count, values);
+		AppendBits(&fixed[0], count, expected);
+		check.CompareBits(values, expected);
+	}) && pass;
+
+	pass = Once("Matrix4d GetTransform", 1.0, [&](Check& check) {
+		const std::vector<Vector3> nodes = RandomArray<Vector3>(3 * matrices);
+		std::vector<Matrix4d> out(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				const Vector3& t = nodes[i];
+				const Vector3& s = nodes[matrices + i];
+				const Vector3& r = nodes[2 * matrices + i];
+				out[i] = GetTransform(Vector3d({ t.x, t.y, t.z }), Vector3d({ s.x, s.y, s.z }), r.x, r.y, r.z);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			const Vector3& t = nodes[i];
+			const Vector3& s = nodes[matrices + i];
+			const Vector3& r = nodes[2 * matrices + i];
+			const Real sin_x = Precise(sinl(r.x)), cos_x = Precise(cosl(r.x));
+			const Real sin_y = Precise(sinl(r.y)), cos_y = Precise(cosl(r.y));
+			const Real sin_z = Precise(sinl(r.z)), cos_z = Precise(cosl(r.z));
+			const Real rotation[9] = {
+				cos_y * cos_z * Exact(s.x), -(cos_y * sin_z) * Exact(s.y), sin_y * Exact(s.z),
+				(sin_x * sin_y * cos_z + cos_x * sin_z) * Exact(s.x), (cos_x * cos_z - sin_x * sin_y * sin_z) * Exact(s.y),
+				-(sin_x * cos_y) * Exact(s.z),
+				(sin_x * sin_z - cos_x * sin_y * cos_z) * Exact(s.x), (cos_x * sin_y * sin_z + sin_x * cos_z) * Exact(s.y),
+				cos_x * cos_y * Exact(s.z) };
+			Real reference[16];
+			for (int line = 0; line < 3; line++) {
+				for (int colum = 0; colum < 3; colum++) {
+					reference[line * 4 + colum] = rotation[line * 3 + colum];
+				}
+				reference[line * 4 + 3] = Exact(0.0f);
+				reference[12 + line] = Exact(t.x) * rotation[line] + Exact(t.y) * rotation[3 + line]
+					+ Exact(t.z) * rotation[6 + line];
+			}
+			reference[15] = Exact(1.0f);
+			for (int j = 0; j < 16; j++) {
+				check.Compare((float)out[i].m[j], reference[j]);
+			}
+		}
+	}) && pass;
+
+	pass = Once("Matrix4d GetInverseAffine", 1.0, [&](Check& check) {
+		const std::vector<Matix4x4> affine = RandomAffine(matrices);
+		std::vector<Matrix4d> in(matrices), out(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			in[i] = Matrix4d(ToMatrix(affine[i]));
+		}
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				GetInverseAffine(in[i], out[i]);
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[16];
+			ReferenceInverse(affine[i].m, 4, reference);
+			for (int j = 0; j < 16; j++) {
+				check.Compare((float)out[i].m[j], reference[j]);
+			}
+		}
+	}) && pass;
+
+	pass = Once("Matrix4d TransformPoint", 1.0, [&](Check& check) {
+		const std::vector<Vector3> points = RandomArray<Vector3>(matrices);
+		std::vector<Matrix4d> in(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			in[i] = Matrix4d(ToMatrix(a[i]));
+		}
+		std::vector<Vector3d> out(matrices);
+		check.Time(matrices, [&]() {
+			for (size_t i = 0; i < matrices; i++) {
+				out[i] = TransformPoint(in[i], Vector3d({ points[i].x, points[i].y, points[i].z }));
+			}
+		});
+		for (size_t i = 0; i < matrices; i++) {
+			Real reference[3];
+			ReferenceTransformPoint(a[i].m, &points[i].x, reference);
+			for (int j = 0; j < 3; j++) {
+				check.Compare((float)out[i].v[j], reference[j]);
+			}
+		}
+	}) && pass;
+
+	pass = SameBits("CameraRelative::Rebase", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		// Translations around origin with more bits than a float keeps.
+		const Vector3d origin({ 4.0e6, 1.0e3, -2.0e6 });
+		std::vector<Matrix4d> world(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			world[i] = Matrix4d(ToMatrix(a[i]));
+			for (int j = 0; j < 3; j++) {
+				world[i].m[12 + j] = origin.v[j] + 1.0e4 * a[i].m[12 + j] + 1.0e-3 * b[i].m[j];
+			}
+		}
+		std::vector<Matix4x4> rebased(matrices);
+		check.Time(matrices, [&]() { CameraRelative::Rebase(&world[0], origin, &rebased[0], matrices); });
+		std::vector<Matix4x4> single(matrices);
+		for (size_t i = 0; i < matrices; i++) {
+			single[i] = CameraRelative::Rebase(world[i], origin);
+		}
+		std::vector<float> expected;
+		AppendBits(&single[0], matrices, expected);
+		AppendBits(&rebased[0], matrices, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+	return pass;
+}
+
+// x rounded to nearest even with mantissa bits after the point, as if its
+// exponent were at least min_exponent, and to infinity from overflow up.
+static long double RoundTo(long double x, int mantissa, int min_exponent, long double overflow) {
+	if (x == 0.0L) {
+		return x;
+	}
+	int exponent = 0;
+	frexpl(x, &exponent);
+	exponent = exponent - 1 < min_exponent ? min_exponent : exponent - 1;
+	const long double ulp = ldexpl(1.0L, exponent - mantissa);
+	const long double rounded = nearbyintl(x / ulp) * ulp;
+	return fabsl(rounded) >= overflow ? copysignl(INFINITY, x) : rounded;
+}
+
+// float to Half and BFloat16 and back, bit for bit against the rounding of
+// the formats, from below their subnormals to past their largest finite
+// values.
+static bool CheckHalf(size_t count) {
+	std::vector<float> half_inputs(count), bfloat_inputs(count);
+	for (size_t i = 0; i < count; i++) {
+		// Every other value has a few bits more than the type keeps, so ties
+		// are common; the rest have a full float mantissa.
+		const float half_mantissa = i % 2 ? (float)(rand() % 8192 - 4096) / 4096.0f : RandomFloat();
+		half_inputs[i] = half_mantissa * ldexpf(1.0f, rand() % 48 - 28);
+		const float bfloat_mantissa = i % 2 ? (float)(rand() % 1024 - 512) / 512.0f : RandomFloat();
+		bfloat_inputs[i] = bfloat_mantissa * ldexpf(1.0f, rand() % 272 - 144);
+	}
+	bool pass = true;
+
+	pass = Once("Half rounding", 0.0, [&](Check& check) {
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = (float)Half(half_inputs[i]);
+			}
+		});
+		std::vector<float> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = (float)RoundTo(half_inputs[i], 10, -14, 65536.0L);
+		}
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	pass = Once("BFloat16 rounding", 0.0, [&](Check& check) {
+		std::vector<float> out(count);
+		check.Time(count, [&]() {
+			for (size_t i = 0; i < count; i++) {
+				out[i] = (float)BFloat16(bfloat_inputs[i]);
+			}
+		});
+		std::vector<float> expected(count);
+		for (size_t i = 0; i < count; i++) {
+			expected[i] = (float)RoundTo(bfloat_inputs[i], 7, -126, ldexpl(1.0L, 128));
+		}
+		check.CompareBits(out, expected);
+	}) && pass;
+	return pass;
+}
+
+// The frustum of the benchmarks: a perspective camera one unit behind the
+// origin.
+static Frustum CameraFrustum() {
+	const Matix4x4 projection = Matix4x4().PerspectiveMatrix(1.2f, 1.5f, 0.1f, 2.0f);
+	return Frustum(Matix4x4::Translate(0.0f, 0.0f, -1.0f).Multiply(projection.Transpose()));
+}
+
+// Bit i % 32 of out[i / 32] set when hit[i].
+static std::vector<uint32_t> Mask(const std::vector<bool>& hit) {
+	std::vector<uint32_t> out((hit.size() + 31) / 32, 0);
+	for (size_t i = 0; i < hit.size(); i++) {
+		if (hit[i]) {
+			out[i / 32] |= 1u << (i % 32);
+		}
+	}
+	return out;
+}
+
+// The AABB3Stream and Frustum batches against the AABB3 and Frustum tests
+// they run on many boxes.
+static bool CheckBoxes(size_t count) {
+	const std::vector<AABB3> a = RandomBoxes(count);
+	const std::vector<AABB3> b = RandomBoxes(count);
+	const AABB3Stream sa(&a[0], count);
+	const AABB3Stream sb(&b[0], count);
+	bool pass = true;
+
+	pass = EveryLevel("AABB3Stream::Bounds", 0.0, Simd::kAVX2, [&](Check& check) {
+		AABB3 out;
+		check.Time(count, [&]() { out = sa.Bounds(); });
+		// The lanes merge in another order than a serial Grow, which only
+		// the sign of a zero may show.
+		AABB3 serial = AABB3::Empty();
+		for (size_t i = 0; i < count; i++) {
+			serial.Grow(a[i]);
+		}
+		const Real min[3] = { { serial.min.x, 0.0L }, { serial.min.y, 0.0L }, { serial.min.z, 0.0L } };
+		const Real max[3] = { { serial.max.x, 0.0L }, { serial.max.y, 0.0L }, { serial.max.z, 0.0L } };
+		check.Compare(&out.min.x, min, 3);
+		check.Compare(&out.max.x, max, 3);
+	}) && pass;
+
+	pass = SameBits("AABB3Stream::Union", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		AABB3Stream unions(count);
+		check.Time(count, [&]() { AABB3Stream::Union(sa, sb, unions); });
+		std::vector<AABB3> single(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = AABB3::Union(a[i], b[i]);
+		}
+		std::vector<float> expected;
+		AppendBits(AABB3Stream(&single[0], count), expected);
+		AppendBits(unions, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	const std::vector<Matix4x4> matrices = RandomArray<Matix4x4>(count / 4);
+
+	pass = SameBits("AABB3Stream::Transform", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		AABB3Stream moved(count);
+		check.Time(count, [&]() { AABB3Stream::Transform(sa, matrices[0], moved); });
+		std::vector<AABB3> single(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = a[i].Transform(matrices[0]);
+		}
+		std::vector<float> expected;
+		AppendBits(AABB3Stream(&single[0], count), expected);
+		AppendBits(moved, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	// No SIMD path: with a matrix per box there is nothing to broadcast.
+	pass = Once("AABB3Stream::Transform matrices", 0.0, [&](Check& check) {
+		const size_t n = matrices.size();
+		const AABB3Stream in(&a[0], n);
+		AABB3Stream moved(n);
+		check.Time(n, [&]() { AABB3Stream::Transform(in, &matrices[0], moved); });
+		std::vector<AABB3> single(n);
+		for (size_t i = 0; i < n; i++) {
+			single[i] = a[i].Transform(matrices[i]);
+		}
+		std::vector<float> expected;
+		AppendBits(AABB3Stream(&single[0], n), expected);
+		std::vector<float> out;
+		AppendBits(moved, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	const Frustum frustum = CameraFrustum();
+	const std::vector<Vector3> values = RandomArray<Vector3>(2 * count);
+	const Vector3Stream centers(&values[0], count);
+	Vector3Stream extents(count);
+	std::vector<float> radii(count);
+	for (size_t i = 0; i < count; i++) {
+		const Vector3 size = values[count + i];
+		extents.Set(i, Vector3(fabsf(size.x), fabsf(size.y), fabsf(size.z)) * 0.05f);
+		radii[i] = fabsf(size.x) * 0.05f;
+	}
+
+	pass = SameBits("Frustum::CullBoxes", 0.0, Simd::kSSE41, [&](Check& check, std::vector<float>& out) {
+		std::vector<uint32_t> visible((count + 31) / 32);
+		check.Time(count, [&]() { frustum.CullBoxes(centers, extents, &visible[0]); });
+		std::vector<bool> single(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = frustum.IntersectsBox(centers.Get(i), extents.Get(i));
+		}
+		const std::vector<uint32_t> mask = Mask(single);
+		std::vector<float> expected;
+		AppendBits(&mask[0], mask.size(), expected);
+		AppendBits(&visible[0], visible.size(), out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	pass = SameBits("Frustum::CullSpheres", 0.0, Simd::kSSE41, [&](Check& check, std::vector<float>& out) {
+		std::vector<uint32_t> visible((count + 31) / 32);
+		check.Time(count, [&]() { frustum.CullSpheres(centers, &radii[0], &visible[0]); });
+		std::vector<bool> single(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = frustum.IntersectsSphere(centers.Get(i), radii[i]);
+		}
+		const std::vector<uint32_t> mask = Mask(single);
+		std::vector<float> expected;
+		AppendBits(&mask[0], mask.size(), expected);
+		AppendBits(&visible[0], visible.size(), out);
+		check.CompareBits(out, expected);
+	}) && pass;
+	return pass;
+}
+
+// The Intersection batches against the single tests, every output included,
+// and the BVH packet traversal against the traversal of one ray at a time.
+static bool CheckIntersection(size_t count) {
+	const size_t words = (count + 31) / 32;
+	const std::vector<Vector3> values = RandomArray<Vector3>(5 * count);
+	// Triangles and boxes in [-1, 1]^3 in front of the rays, which start at
+	// z = -3 and head along +z; the zero x component of direction gives the
+	// box tests infinite slabs.
+	const Vector3Stream a(&values[0], count);
+	const Vector3Stream b(&values[count], count);
+	const Vector3Stream c(&values[2 * count], count);
+	const Vector3 origin(0.1f, -0.2f, -3.0f);
+	const Vector3 direction(0.0f, 0.1f, 1.0f);
+	const float t_max = 4.0f;
+	Vector3Stream origins(count), directions(count);
+	std::vector<float> ray_t_max(count);
+	for (size_t i = 0; i < count; i++) {
+		const Vector3 start = values[3 * count + i];
+		const Vector3 offset = values[4 * count + i];
+		origins.Set(i, Vector3(start.x, start.y, start.z - 3.0f));
+		directions.Set(i, Vector3(offset.x * 0.25f, offset.y * 0.25f, 1.0f));
+		ray_t_max[i] = fabsf(offset.z) * 5.0f;
+	}
+	const Vector3 ta(-1.0f, -1.0f, 0.0f), tb(1.0f, -1.0f, 0.2f), tc(0.0f, 1.0f, -0.1f);
+	const AABB3 box(Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, 0.5f));
+	const std::vector<AABB3> boxes = RandomBoxes(count);
+	const AABB3Stream box_stream(&boxes[0], count);
+	bool pass = true;
+
+	pass = SameBits("Intersection::RayTriangles", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<uint32_t> hit(words);
+		std::vector<float> t(count), u(count), v(count);
+		check.Time(count, [&]() {
+			Intersection::RayTriangles(origin, direction, a, b, c, t_max, &hit[0], &t[0], &u[0], &v[0]);
+		});
+		std::vector<bool> single(count);
+		std::vector<float> single_t(count), single_u(count), single_v(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = Intersection::RayTriangle(origin, direction, a.Get(i), b.Get(i), c.Get(i), t_max,
+				single_t[i], single_u[i], single_v[i]);
+		}
+		const std::vector<uint32_t> mask = Mask(single);
+		std::vector<float> expected;
+		AppendBits(&mask[0], words, expected);
+		AppendBits(&single_t[0], count, expected);
+		AppendBits(&single_u[0], count, expected);
+		AppendBits(&single_v[0], count, expected);
+		AppendBits(&hit[0], words, out);
+		AppendBits(&t[0], count, out);
+		AppendBits(&u[0], count, out);
+		AppendBits(&v[0], count, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	pass = SameBits("Intersection::RaysTriangle", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<uint32_t> hit(words);
+		std::vector<float> t(count), u(count), v(count);
+		check.Time(count, [&]() {
+			Intersection::RaysTriangle(origins, directions, ta, tb, tc, &ray_t_max[0], &hit[0], &t[0], &u[0], &v[0]);
+		});
+		std::vector<bool> single(count);
+		std::vector<float> single_t(count), single_u(count), single_v(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = Intersection::RayTriangle(origins.Get(i), directions.Get(i), ta, tb, tc, ray_t_max[i],
+				single_t[i], single_u[i], single_v[i]);
+		}
+		const std::vector<uint32_t> mask = Mask(single);
+		std::vector<float> expected;
+		AppendBits(&mask[0], words, expected);
+		AppendBits(&single_t[0], count, expected);
+		AppendBits(&single_u[0], count, expected);
+		AppendBits(&single_v[0], count, expected);
+		AppendBits(&hit[0], words, out);
+		AppendBits(&t[0], count, out);
+		AppendBits(&u[0], count, out);
+		AppendBits(&v[0], count, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	pass = SameBits("Intersection::RayBoxes", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<uint32_t> hit(words);
+		std::vector<float> t(count);
+		check.Time(count, [&]() { Intersection::RayBoxes(origin, direction, box_stream, t_max, &hit[0], &t[0]); });
+		std::vector<bool> single(count);
+		std::vector<float> single_t(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = Intersection::RayBox(origin, direction, boxes[i], t_max, single_t[i]);
+		}
+		const std::vector<uint32_t> mask = Mask(single);
+		std::vector<float> expected;
+		AppendBits(&mask[0], words, expected);
+		AppendBits(&single_t[0], count, expected);
+		AppendBits(&hit[0], words, out);
+		AppendBits(&t[0], count, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	pass = SameBits("Intersection::RaysBox", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<uint32_t> hit(words);
+		std::vector<float> t(count);
+		check.Time(count, [&]() { Intersection::RaysBox(origins, directions, box, &ray_t_max[0], &hit[0], &t[0]); });
+		std::vector<bool> single(count);
+		std::vector<float> single_t(count);
+		for (size_t i = 0; i < count; i++) {
+			single[i] = Intersection::RayBox(origins.Get(i), directions.Get(i), box, ray_t_max[i], single_t[i]);
+		}
+		const std::vector<uint32_t> mask = Mask(single);
+		std::vector<float> expected;
+		AppendBits(&mask[0], words, expected);
+		AppendBits(&single_t[0], count, expected);
+		AppendBits(&hit[0], words, out);
+		AppendBits(&t[0], count, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+
+	// Small boxes over a 100 x 100 x 10 scene, hit by rays from above it
+	// toward random points on the ground, as in the benchmarks.
+	const size_t scene_size = count / 4;
+	std::vector<AABB3> scene = RandomBoxes(scene_size);
+	for (size_t i = 0; i < scene_size; i++) {
+		const Vector3 center = scene[i].Center();
+		scene[i] = AABB3::FromCenterExtent(Vector3(center.x * 50.0f, center.y * 50.0f, center.z * 5.0f),
+			scene[i].Extent() * 0.2f);
+	}
+	BVH bvh;
+	bvh.Build(&scene[0], scene_size);
+	const size_t rays = count / 16;
+	std::vector<Vector3> scene_origins(rays, Vector3(0.0f, 0.0f, 60.0f)), scene_directions(rays), inverses(rays);
+	for (size_t i = 0; i < rays; i++) {
+		const Vector3 target = values[i];
+		scene_directions[i] = (Vector3(target.x * 50.0f, target.y * 50.0f, 0.0f) - scene_origins[i]).Normalized();
+		inverses[i] = Vector3(1.0f / scene_directions[i].x, 1.0f / scene_directions[i].y, 1.0f / scene_directions[i].z);
+	}
+	const Vector3Stream origin_stream(&scene_origins[0], rays);
+	const Vector3Stream direction_stream(&scene_directions[0], rays);
+
+	pass = SameBits("BVH::Raycast packets", 0.0, Simd::kAVX2, [&](Check& check, std::vector<float>& out) {
+		std::vector<float> t(rays);
+		check.Time(rays, [&]() {
+			for (size_t i = 0; i < rays; i++) {
+				t[i] = 100.0f;
+			}
+			bvh.Raycast(origin_stream, direction_stream, &t[0], [&](int primitive, size_t ray, float& t_hit) {
+				float enter;
+				if (scene[primitive].IntersectRay(scene_origins[ray], inverses[ray], 0.0f, t_hit, enter)) {
+					t_hit = enter;
+				}
+			});
+		});
+		std::vector<float> single(rays, 100.0f);
+		for (size_t i = 0; i < rays; i++) {
+			bvh.Raycast(scene_origins[i], scene_directions[i], single[i], [&](int primitive, float& t_hit) {
+				float enter;
+				if (scene[primitive].IntersectRay(scene_origins[i], inverses[i], 0.0f, t_hit, enter)) {
+					t_hit = enter;
+				}
+			});
+		}
+		std::vector<float> expected;
+		AppendBits(&single[0], rays, expected);
+		AppendBits(&t[0], rays, out);
+		check.CompareBits(out, expected);
+	}) && pass;
+	return pass;
+}
+
+int main(int argc, char** argv) {
+	const size_t count = argc > 1 ? (size_t)atol(argv[1]) : (size_t)1 << 21;
+	srand(1234);
+
+	printf("%-32s %-8s %8s %10s %12s\n", "operation", "simd", "bound", "max ulp", "Mops/s");
+	bool pass = true;
+	pass = CheckMathUtils(count) && pass;
+	pass = CheckVectors(count) && pass;
+	pass = CheckVector3Stream(count) && pass;
+	pass = CheckMatrices(count) && pass;
+	pass = CheckQuaternions(count) && pass;
+	pass = CheckFastMath(count) && pass;
+	pass = CheckSkinning(count) && pass;
+	pass = CheckOperators<Vector2>("Vector2 operators", count) && pass;
+	pass = CheckOperators<Vector3>("Vector3 operators", count) && pass;
+	pass = CheckOperators<Vector4>("Vector4 operators", count) && pass;
+	pass = CheckOperators<Vector4f>("Vector4f operators", count) && pass;
+	pass = CheckOperators<Vector<8, float> >("Vector<8, float> operators", count / 2) && pass;
+	pass = CheckOperators<Matrix2x2>("Matrix2x2 operators", count) && pass;
+	pass = CheckOperators<Matrix3x3>("Matrix3x3 operators", count / 2) && pass;
+	pass = CheckOperators<Matix4x4>("Matix4x4 operators", count / 4) && pass;
+	pass = CheckOperators<Matrix4f>("Matrix4f operators", count / 4) && pass;
+	pass = CheckExpression<Vector3>("Vector3 Lazy", count) && pass;
+	pass = CheckExpression<Vector4>("Vector4 Lazy", count) && pass;
+	pass = CheckExpression<Matrix2x2>("Matrix2x2 Lazy", count) && pass;
+	pass = CheckExpression<Matix4x4>("Matix4x4 Lazy", count / 4) && pass;
+	pass = CheckMatrixTemplates(count) && pass;
+	pass = CheckHalf(count) && pass;
+	pass = CheckBoxes(count) && pass;
+	pass = CheckIntersection(count) && pass;
+	return pass ? 0 : 1;
+}
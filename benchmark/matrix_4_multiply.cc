@@ -0,0 +1,83 @@
+// Matix4x4::Multiply throughput for every SIMD level the CPU supports.
+//
+//   g++ -O2 -std=c++17 -Iinclude benchmark/matrix_4_multiply.cc -o matrix_4_multiply
+//
+// Prints matrices per second and the largest distance from the scalar kernel
+// over the whole input set, both in ULP of the result and in ULP of the sum
+// of the absolute products (the latter stays small under cancellation).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "../include/matrix_4.h"
+
+static int UlpDistance(float a, float b) {
+	int ia, ib;
+	memcpy(&ia, &a, sizeof(float));
+	memcpy(&ib, &b, sizeof(float));
+	if (ia < 0) { ia = 0x80000000 - ia; }
+	if (ib < 0) { ib = 0x80000000 - ib; }
+	return ia > ib ? ia - ib : ib - ia;
+}
+
+static float RelativeUlp(const Matix4x4& a, const Matix4x4& b, int index, float value, float reference) {
+	int line = index / 4;
+	int colum = index % 4;
+	float scale = 0.0f;
+	for (int k = 0; k < 4; k++) {
+		scale += fabsf(a.m[line * 4 + k] * b.m[k * 4 + colum]);
+	}
+	return fabsf(value - reference) / (nextafterf(scale, 2.0f * scale + 1.0f) - scale);
+}
+
+int main() {
+	const int kCount = 1024;
+	const double kSeconds = 0.5;
+
+	std::vector<Matix4x4> a(kCount), b(kCount), out(kCount), reference(kCount);
+	srand(1234);
+	for (int i = 0; i < kCount; i++) {
+		for (int j = 0; j < 16; j++) {
+			a[i].m[j] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+			b[i].m[j] = (float)rand() / RAND_MAX * 2.0f - 1.0f;
+		}
+		Matix4x4::MultiplyScalar(a[i].m, b[i].m, reference[i].m);
+	}
+
+	const Simd::Level supported = Simd::Supported();
+	for (int level = Simd::kScalar; level <= supported; level++) {
+		Simd::SetActive((Simd::Level)level);
+
+		int max_ulp = 0;
+		float max_relative_ulp = 0.0f;
+		for (int i = 0; i < kCount; i++) {
+			out[i] = a[i].Multiply(b[i]);
+			for (int j = 0; j < 16; j++) {
+				int ulp = UlpDistance(out[i].m[j], reference[i].m[j]);
+				if (ulp > max_ulp) { max_ulp = ulp; }
+				float relative = RelativeUlp(a[i], b[i], j, out[i].m[j], reference[i].m[j]);
+				if (relative > max_relative_ulp) { max_relative_ulp = relative; }
+			}
+		}
+
+		long long multiplies = 0;
+		float checksum = 0.0f;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double elapsed = 0.0;
+		do {
+			for (int i = 0; i < kCount; i++) {
+				out[i] = a[i].Multiply(b[i]);
+			}
+			checksum += out[multiplies % kCount].m[0];
+			multiplies += kCount;
+			elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (elapsed < kSeconds);
+
+		printf("%-10s %12.0f matrices/s   max %d ULP, %.2f ULP of sum|a*b| vs scalar   (checksum %g)\n",
+			Simd::Name((Simd::Level)level), multiplies / elapsed, max_ulp, max_relative_ulp, checksum);
+	}
+	return 0;
+}
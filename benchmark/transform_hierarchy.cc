@@ -0,0 +1,93 @@
+// TransformHierarchy::Resolve and the batch Multiply on 1, 2, 4, ... threads
+// up to the hardware thread count, with the speedup over one thread.
+//
+//   g++ -O2 -DNDEBUG -std=c++17 -pthread -Iinclude benchmark/transform_hierarchy.cc -o transform_hierarchy
+//   ./transform_hierarchy [nodes] [max threads]
+//
+// The hierarchy is a random tree of 2^20 nodes by default, node i parented
+// to one of the first i / 8 nodes, which gives a few wide levels like a
+// large scene graph. Both paths are checked against the serial result.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "../include/transform_hierarchy.h"
+
+static float RandomFloat() {
+	return (float)rand() / RAND_MAX * 2.0f - 1.0f;
+}
+
+// Seconds per call of function, best of a few runs of at least 0.2s each.
+template<class F>
+static double Time(const F& function) {
+	double best = 1e30;
+	for (int run = 0; run < 3; run++) {
+		int calls = 0;
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		double seconds = 0.0;
+		do {
+			function();
+			calls++;
+			seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		} while (seconds < 0.2);
+		if (seconds / calls < best) {
+			best = seconds / calls;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char** argv) {
+	const size_t n = argc > 1 ? (size_t)atol(argv[1]) : (size_t)1 << 20;
+
+	srand(1234);
+	std::vector<int> parent(n);
+	std::vector<Matix4x4> local(n), other(n);
+	for (size_t i = 0; i < n; i++) {
+		parent[i] = i == 0 ? -1 : (int)(rand() % ((i + 7) / 8));
+		local[i] = Matix4x4::GetTransform(RandomFloat(), RandomFloat(), RandomFloat(), 1.0f, 1.0f, 1.0f,
+			RandomFloat(), RandomFloat(), RandomFloat());
+		for (int j = 0; j < 16; j++) {
+			other[i].m[j] = RandomFloat();
+		}
+	}
+	const TransformHierarchy hierarchy(&parent[0], n);
+
+	std::vector<Matix4x4> reference(n), world(n);
+	hierarchy.Resolve(&local[0], &reference[0]);
+	std::vector<Matix4x4> product_reference(n), product(n);
+	Matix4x4::Multiply(&local[0], &other[0], &product_reference[0], n);
+
+	printf("simd: %s, %zu nodes, %zu levels\n", Simd::Name(Simd::Active()), n, hierarchy.LevelCount());
+	printf("%8s  %14s  %8s  %14s  %8s\n", "threads", "resolve (ms)", "speedup", "multiply (ms)", "speedup");
+
+	const int hardware = argc > 2 ? atoi(argv[2]) : (int)std::thread::hardware_concurrency();
+	const int max_threads = hardware > 1 ? hardware : 1;
+	double resolve_one = 0.0;
+	double multiply_one = 0.0;
+	for (int threads = 1; ; threads *= 2) {
+		if (threads > max_threads) {
+			threads = max_threads;
+		}
+		ThreadPool pool(threads);
+		const double resolve = Time([&] { hierarchy.Resolve(&local[0], &world[0], pool); });
+		const double multiply = Time([&] { TransformHierarchy::Multiply(&local[0], &other[0], &product[0], n, pool); });
+		if (memcmp(&world[0], &reference[0], n * sizeof(Matix4x4)) != 0 ||
+			memcmp(&product[0], &product_reference[0], n * sizeof(Matix4x4)) != 0) {
+			printf("%d threads: result differs from the serial one\n", threads);
+			return 1;
+		}
+		if (threads == 1) {
+			resolve_one = resolve;
+			multiply_one = multiply;
+		}
+		printf("%8d  %14.3f  %7.2fx  %14.3f  %7.2fx\n", threads, resolve * 1e3, resolve_one / resolve,
+			multiply * 1e3, multiply_one / multiply);
+		if (threads == max_threads) {
+			break;
+		}
+	}
+	return 0;
+}
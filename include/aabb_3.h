@@ -0,0 +1,210 @@
+#ifndef __AABB3_H__
+#define __AABB3_H__ 1
+
+#include <stddef.h>
+#include <limits>
+#include <type_traits>
+#include "vector_3.h"
+#include "matrix_4.h"
+
+// Axis-aligned box from min to max, both inclusive. A box with min > max on
+// any axis is empty; Empty() is the identity of Union and Grow.
+class AABB3 {
+public:
+	AABB3();
+	constexpr AABB3(const Vector3& min, const Vector3& max);
+
+	static constexpr AABB3 Empty();
+	static constexpr AABB3 FromCenterExtent(const Vector3& center, const Vector3& extent);
+	static constexpr AABB3 FromPoints(const Vector3* points, size_t n);
+
+	constexpr bool IsEmpty() const;
+	constexpr Vector3 Center() const;
+	// Half size.
+	constexpr Vector3 Extent() const;
+	constexpr Vector3 Size() const;
+	constexpr float SurfaceArea() const;
+
+	constexpr bool Contains(const Vector3& point) const;
+	constexpr bool Contains(const AABB3& other) const;
+	constexpr bool Intersects(const AABB3& other) const;
+
+	constexpr void Grow(const Vector3& point);
+	constexpr void Grow(const AABB3& other);
+	static constexpr AABB3 Union(const AABB3& a, const AABB3& b);
+	// Empty when a and b do not overlap.
+	static constexpr AABB3 Intersection(const AABB3& a, const AABB3& b);
+
+	// Slab test of origin + t * direction for t in [t_min, t_max], with
+	// inverse_direction = 1 / direction per axis (infinite for a zero
+	// component). On a hit t_hit is the entry distance, clamped to t_min.
+	// A ray parallel to a face that starts exactly in its plane gives
+	// 0 * infinity on that axis and may be reported as a miss.
+	constexpr bool IntersectRay(const Vector3& origin, const Vector3& inverse_direction,
+		float t_min, float t_max, float& t_hit) const;
+	// The slabs of IntersectRay: the ray is inside the box for t in
+	// [enter, exit], and misses when enter > exit. Both are always written.
+	constexpr void RayInterval(const Vector3& origin, const Vector3& inverse_direction,
+		float t_min, float t_max, float& enter, float& exit) const;
+
+	// Bounds of the box moved by the affine part of matrix (v * M), from the
+	// extremes of every matrix element times min and max (Arvo) instead of
+	// transforming the 8 corners. The box must not be empty.
+	constexpr AABB3 Transform(const Matix4x4& matrix) const;
+
+	constexpr bool operator==(const AABB3& other) const;
+	constexpr bool operator!=(const AABB3& other) const;
+
+	// Same results as the min/max instructions, also for NaN and signed
+	// zeros, so the batch kernels in AABB3Stream keep the same bits.
+	static constexpr float Min(float a, float b);
+	static constexpr float Max(float a, float b);
+
+	Vector3 min;
+	Vector3 max;
+};
+
+static_assert(std::is_trivially_copyable<AABB3>::value, "AABB3 must be trivially copyable");
+static_assert(std::is_standard_layout<AABB3>::value, "AABB3 must be standard layout");
+
+inline AABB3::AABB3() {}
+
+constexpr AABB3::AABB3(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+
+constexpr AABB3 AABB3::Empty() {
+	const float infinity = std::numeric_limits<float>::infinity();
+	return AABB3(Vector3(infinity, infinity, infinity), Vector3(-infinity, -infinity, -infinity));
+}
+
+constexpr AABB3 AABB3::FromCenterExtent(const Vector3& center, const Vector3& extent) {
+	return AABB3(center - extent, center + extent);
+}
+
+constexpr AABB3 AABB3::FromPoints(const Vector3* points, size_t n) {
+	AABB3 out = Empty();
+	for (size_t i = 0; i < n; i++) {
+		out.Grow(points[i]);
+	}
+	return out;
+}
+
+constexpr bool AABB3::IsEmpty() const {
+	return min.x > max.x || min.y > max.y || min.z > max.z;
+}
+
+constexpr Vector3 AABB3::Center() const {
+	return (min + max) * 0.5f;
+}
+
+constexpr Vector3 AABB3::Extent() const {
+	return (max - min) * 0.5f;
+}
+
+constexpr Vector3 AABB3::Size() const {
+	return max - min;
+}
+
+constexpr float AABB3::SurfaceArea() const {
+	const Vector3 size = max - min;
+	return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+constexpr bool AABB3::Contains(const Vector3& point) const {
+	return point.x >= min.x && point.x <= max.x &&
+		point.y >= min.y && point.y <= max.y &&
+		point.z >= min.z && point.z <= max.z;
+}
+
+constexpr bool AABB3::Contains(const AABB3& other) const {
+	return other.min.x >= min.x && other.max.x <= max.x &&
+		other.min.y >= min.y && other.max.y <= max.y &&
+		other.min.z >= min.z && other.max.z <= max.z;
+}
+
+constexpr bool AABB3::Intersects(const AABB3& other) const {
+	return min.x <= other.max.x && max.x >= other.min.x &&
+		min.y <= other.max.y && max.y >= other.min.y &&
+		min.z <= other.max.z && max.z >= other.min.z;
+}
+
+constexpr void AABB3::Grow(const Vector3& point) {
+	min = Vector3(Min(min.x, point.x), Min(min.y, point.y), Min(min.z, point.z));
+	max = Vector3(Max(max.x, point.x), Max(max.y, point.y), Max(max.z, point.z));
+}
+
+constexpr void AABB3::Grow(const AABB3& other) {
+	*this = Union(*this, other);
+}
+
+constexpr AABB3 AABB3::Union(const AABB3& a, const AABB3& b) {
+	return AABB3(Vector3(Min(a.min.x, b.min.x), Min(a.min.y, b.min.y), Min(a.min.z, b.min.z)),
+		Vector3(Max(a.max.x, b.max.x), Max(a.max.y, b.max.y), Max(a.max.z, b.max.z)));
+}
+
+constexpr AABB3 AABB3::Intersection(const AABB3& a, const AABB3& b) {
+	return AABB3(Vector3(Max(a.min.x, b.min.x), Max(a.min.y, b.min.y), Max(a.min.z, b.min.z)),
+		Vector3(Min(a.max.x, b.max.x), Min(a.max.y, b.max.y), Min(a.max.z, b.max.z)));
+}
+
+constexpr bool AABB3::IntersectRay(const Vector3& origin, const Vector3& inverse_direction,
+	float t_min, float t_max, float& t_hit) const {
+	float enter = 0.0f;
+	float exit = 0.0f;
+	RayInterval(origin, inverse_direction, t_min, t_max, enter, exit);
+	if (enter > exit) {
+		return false;
+	}
+	t_hit = enter;
+	return true;
+}
+
+constexpr void AABB3::RayInterval(const Vector3& origin, const Vector3& inverse_direction,
+	float t_min, float t_max, float& enter, float& exit) const {
+	const float near_x = (min.x - origin.x) * inverse_direction.x;
+	const float far_x = (max.x - origin.x) * inverse_direction.x;
+	const float near_y = (min.y - origin.y) * inverse_direction.y;
+	const float far_y = (max.y - origin.y) * inverse_direction.y;
+	const float near_z = (min.z - origin.z) * inverse_direction.z;
+	const float far_z = (max.z - origin.z) * inverse_direction.z;
+	enter = Max(Min(near_x, far_x), t_min);
+	exit = Min(Max(near_x, far_x), t_max);
+	enter = Max(Min(near_y, far_y), enter);
+	exit = Min(Max(near_y, far_y), exit);
+	enter = Max(Min(near_z, far_z), enter);
+	exit = Min(Max(near_z, far_z), exit);
+}
+
+constexpr AABB3 AABB3::Transform(const Matix4x4& matrix) const {
+	const float* m = matrix.m;
+	const float low[3] = { min.x, min.y, min.z };
+	const float high[3] = { max.x, max.y, max.z };
+	float out_min[3] = { m[12], m[13], m[14] };
+	float out_max[3] = { m[12], m[13], m[14] };
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			const float a = m[4 * i + j] * low[i];
+			const float b = m[4 * i + j] * high[i];
+			out_min[j] += Min(a, b);
+			out_max[j] += Max(a, b);
+		}
+	}
+	return AABB3(Vector3(out_min[0], out_min[1], out_min[2]), Vector3(out_max[0], out_max[1], out_max[2]));
+}
+
+constexpr bool AABB3::operator==(const AABB3& other) const {
+	return min == other.min && max == other.max;
+}
+
+constexpr bool AABB3::operator!=(const AABB3& other) const {
+	return !(*this == other);
+}
+
+constexpr float AABB3::Min(float a, float b) {
+	return a < b ? a : b;
+}
+
+constexpr float AABB3::Max(float a, float b) {
+	return a > b ? a : b;
+}
+
+#endif
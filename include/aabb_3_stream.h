@@ -0,0 +1,202 @@
+#ifndef __AABB3_STREAM_H__
+#define __AABB3_STREAM_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include "aabb_3.h"
+#include "matrix_4.h"
+#include "vector_3_stream.h"
+#include "simd.h"
+
+// Structure-of-arrays storage for many AABB3: min and max are Vector3Streams,
+// so every lane is 32-byte aligned and padded to 8 floats. The batch
+// operations give the same bits as the AABB3 ones.
+class AABB3Stream {
+public:
+	AABB3Stream();
+	AABB3Stream(size_t size);
+	AABB3Stream(const AABB3* boxes, size_t size);
+
+	size_t Size() const;
+	void Resize(size_t size);
+
+	AABB3 Get(size_t index) const;
+	void Set(size_t index, const AABB3& box);
+
+	// Union of all boxes, AABB3::Empty() for none. Lanes are merged in a
+	// different order than a serial Grow, so only the sign of a zero can
+	// differ from it.
+	AABB3 Bounds() const;
+
+	// out[i] = AABB3::Union(a[i], b[i]). out may be a or b.
+	static void Union(const AABB3Stream& a, const AABB3Stream& b, AABB3Stream& out);
+	// out[i] = in[i].Transform(matrix). out may be in.
+	static void Transform(const AABB3Stream& in, const Matix4x4& matrix, AABB3Stream& out);
+	// out[i] = in[i].Transform(matrices[i]), for refitting moved objects.
+	static void Transform(const AABB3Stream& in, const Matix4x4* matrices, AABB3Stream& out);
+
+	Vector3Stream min;
+	Vector3Stream max;
+
+private:
+	static const size_t kBlock = 8;
+
+#ifdef MATH_SIMD_X86
+	// Whole blocks only; count is a multiple of kBlock.
+	MATH_TARGET_AVX static AABB3 BoundsAVX(const AABB3Stream& stream, size_t count);
+	MATH_TARGET_AVX static void UnionAVX(const AABB3Stream& a, const AABB3Stream& b, AABB3Stream& out, size_t count);
+	MATH_TARGET_AVX static void TransformAVX(const AABB3Stream& in, const float* m, AABB3Stream& out, size_t count);
+#endif
+};
+
+inline AABB3Stream::AABB3Stream() {}
+
+inline AABB3Stream::AABB3Stream(size_t size) : min(size), max(size) {}
+
+inline AABB3Stream::AABB3Stream(const AABB3* boxes, size_t size) : min(size), max(size) {
+	for (size_t i = 0; i < size; i++) {
+		Set(i, boxes[i]);
+	}
+}
+
+inline size_t AABB3Stream::Size() const {
+	return min.Size();
+}
+
+inline void AABB3Stream::Resize(size_t size) {
+	min.Resize(size);
+	max.Resize(size);
+}
+
+inline AABB3 AABB3Stream::Get(size_t index) const {
+	return AABB3(min.Get(index), max.Get(index));
+}
+
+inline void AABB3Stream::Set(size_t index, const AABB3& box) {
+	min.Set(index, box.min);
+	max.Set(index, box.max);
+}
+
+inline AABB3 AABB3Stream::Bounds() const {
+	const size_t n = Size();
+	AABB3 out = AABB3::Empty();
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		out = BoundsAVX(*this, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out.Grow(Get(i));
+	}
+	return out;
+}
+
+inline void AABB3Stream::Union(const AABB3Stream& a, const AABB3Stream& b, AABB3Stream& out) {
+	assert(a.Size() == b.Size() && "Streams differ in size");
+	const size_t n = a.Size();
+	out.Resize(n);
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		UnionAVX(a, b, out, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out.Set(i, AABB3::Union(a.Get(i), b.Get(i)));
+	}
+}
+
+inline void AABB3Stream::Transform(const AABB3Stream& in, const Matix4x4& matrix, AABB3Stream& out) {
+	const size_t n = in.Size();
+	out.Resize(n);
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		TransformAVX(in, matrix.m, out, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out.Set(i, in.Get(i).Transform(matrix));
+	}
+}
+
+inline void AABB3Stream::Transform(const AABB3Stream& in, const Matix4x4* matrices, AABB3Stream& out) {
+	// A different matrix per box leaves nothing to broadcast; the scalar
+	// form already keeps all 18 products independent.
+	const size_t n = in.Size();
+	out.Resize(n);
+	for (size_t i = 0; i < n; i++) {
+		out.Set(i, in.Get(i).Transform(matrices[i]));
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline AABB3 AABB3Stream::BoundsAVX(const AABB3Stream& stream, size_t count) {
+	const float infinity = std::numeric_limits<float>::infinity();
+	__m256 min_x = _mm256_set1_ps(infinity), min_y = min_x, min_z = min_x;
+	__m256 max_x = _mm256_set1_ps(-infinity), max_y = max_x, max_z = max_x;
+	for (size_t i = 0; i < count; i += kBlock) {
+		min_x = _mm256_min_ps(min_x, _mm256_load_ps(stream.min.x + i));
+		min_y = _mm256_min_ps(min_y, _mm256_load_ps(stream.min.y + i));
+		min_z = _mm256_min_ps(min_z, _mm256_load_ps(stream.min.z + i));
+		max_x = _mm256_max_ps(max_x, _mm256_load_ps(stream.max.x + i));
+		max_y = _mm256_max_ps(max_y, _mm256_load_ps(stream.max.y + i));
+		max_z = _mm256_max_ps(max_z, _mm256_load_ps(stream.max.z + i));
+	}
+	float lanes[6][kBlock];
+	_mm256_storeu_ps(lanes[0], min_x);
+	_mm256_storeu_ps(lanes[1], min_y);
+	_mm256_storeu_ps(lanes[2], min_z);
+	_mm256_storeu_ps(lanes[3], max_x);
+	_mm256_storeu_ps(lanes[4], max_y);
+	_mm256_storeu_ps(lanes[5], max_z);
+	AABB3 out = AABB3::Empty();
+	for (size_t k = 0; k < kBlock; k++) {
+		out.Grow(AABB3(Vector3(lanes[0][k], lanes[1][k], lanes[2][k]), Vector3(lanes[3][k], lanes[4][k], lanes[5][k])));
+	}
+	return out;
+}
+
+MATH_TARGET_AVX inline void AABB3Stream::UnionAVX(const AABB3Stream& a, const AABB3Stream& b, AABB3Stream& out, size_t count) {
+	// AABB3::Min(a, b) is a < b ? a : b, which is exactly _mm256_min_ps(a, b).
+	for (size_t i = 0; i < count; i += kBlock) {
+		_mm256_store_ps(out.min.x + i, _mm256_min_ps(_mm256_load_ps(a.min.x + i), _mm256_load_ps(b.min.x + i)));
+		_mm256_store_ps(out.min.y + i, _mm256_min_ps(_mm256_load_ps(a.min.y + i), _mm256_load_ps(b.min.y + i)));
+		_mm256_store_ps(out.min.z + i, _mm256_min_ps(_mm256_load_ps(a.min.z + i), _mm256_load_ps(b.min.z + i)));
+		_mm256_store_ps(out.max.x + i, _mm256_max_ps(_mm256_load_ps(a.max.x + i), _mm256_load_ps(b.max.x + i)));
+		_mm256_store_ps(out.max.y + i, _mm256_max_ps(_mm256_load_ps(a.max.y + i), _mm256_load_ps(b.max.y + i)));
+		_mm256_store_ps(out.max.z + i, _mm256_max_ps(_mm256_load_ps(a.max.z + i), _mm256_load_ps(b.max.z + i)));
+	}
+}
+
+MATH_TARGET_AVX inline void AABB3Stream::TransformAVX(const AABB3Stream& in, const float* m, AABB3Stream& out, size_t count) {
+	const float* low[3] = { in.min.x, in.min.y, in.min.z };
+	const float* high[3] = { in.max.x, in.max.y, in.max.z };
+	float* out_low[3] = { out.min.x, out.min.y, out.min.z };
+	float* out_high[3] = { out.max.x, out.max.y, out.max.z };
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 l[3] = { _mm256_load_ps(low[0] + i), _mm256_load_ps(low[1] + i), _mm256_load_ps(low[2] + i) };
+		const __m256 h[3] = { _mm256_load_ps(high[0] + i), _mm256_load_ps(high[1] + i), _mm256_load_ps(high[2] + i) };
+		for (int j = 0; j < 3; j++) {
+			// Same order as AABB3::Transform: translation, then rows 0 to 2.
+			__m256 result_low = _mm256_set1_ps(m[12 + j]);
+			__m256 result_high = result_low;
+			for (int k = 0; k < 3; k++) {
+				const __m256 element = _mm256_set1_ps(m[4 * k + j]);
+				const __m256 a = _mm256_mul_ps(element, l[k]);
+				const __m256 b = _mm256_mul_ps(element, h[k]);
+				result_low = _mm256_add_ps(result_low, _mm256_min_ps(a, b));
+				result_high = _mm256_add_ps(result_high, _mm256_max_ps(a, b));
+			}
+			_mm256_store_ps(out_low[j] + i, result_low);
+			_mm256_store_ps(out_high[j] + i, result_high);
+		}
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef __AFFINE3X4_H__
+#define __AFFINE3X4_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <type_traits>
+#include "vector_3.h"
+#include "matrix_4.h"
+#include "simd.h"
+
+// Matix4x4 whose last colum is (0, 0, 0, 1), in 48 bytes. m holds the
+// transpose of the first three colums, so every line is one 16-byte
+// register and the translation is the last element of each line:
+//
+//   Matix4x4                      Affine3x4
+//   |r00  r01  r02  0|            |r00  r10  r20  tx|  m[0..3]
+//   |r10  r11  r12  0|   --->     |r01  r11  r21  ty|  m[4..7]
+//   |r20  r21  r22  0|            |r02  r12  r22  tz|  m[8..11]
+//   |tx   ty   tz   1|
+//
+// The operations do the same float math as their Matix4x4 counterparts.
+// Multiply skips the products with the constant colum and so only differs
+// from Matix4x4::Multiply in the sign of zeros.
+class Affine3x4 {
+public:
+	Affine3x4();
+	constexpr Affine3x4(float value);
+	constexpr Affine3x4(const Matix4x4& matrix);
+
+	static constexpr Affine3x4 Identity();
+	constexpr Matix4x4 ToMatrix() const;
+
+	// Same order as Matix4x4::Multiply: v * (a * b) applies a first.
+	constexpr Affine3x4 Multiply(const Affine3x4& other) const;
+
+	// out = a * b on packed float[12]. out must not alias a or b for the
+	// scalar kernel. The SSE4.1 kernel gives the scalar bits.
+	static constexpr void MultiplyScalar(const float* a, const float* b, float* out);
+#ifdef MATH_SIMD_X86
+	MATH_TARGET_SSE41 static void MultiplySSE41(const float* a, const float* b, float* out);
+#endif
+
+	// Same contract as Matix4x4::GetInverseAffine and GetInverseRigid.
+	constexpr bool GetInverse(Affine3x4& out) const;
+	constexpr bool Inverse();
+	constexpr void GetInverseRigid(Affine3x4& out) const;
+	constexpr void InverseRigid();
+
+	constexpr Vector3 TransformPoint(const Vector3& point) const;
+	constexpr Vector3 TransformDirection(const Vector3& direction) const;
+	// in and out may be the same array.
+	void TransformPoints(const Vector3* in, Vector3* out, size_t n) const;
+	void TransformDirections(const Vector3* in, Vector3* out, size_t n) const;
+
+	constexpr bool operator==(const Affine3x4& other) const;
+	constexpr bool operator!=(const Affine3x4& other) const;
+
+	float m[12];
+};
+
+static_assert(std::is_trivially_copyable<Affine3x4>::value, "Affine3x4 must be trivially copyable");
+static_assert(std::is_standard_layout<Affine3x4>::value, "Affine3x4 must be standard layout");
+
+inline Affine3x4::Affine3x4() {}
+
+constexpr Affine3x4::Affine3x4(float value) : m() {
+	for (int i = 0; i < 12; i++) {
+		m[i] = value;
+	}
+}
+
+constexpr Affine3x4::Affine3x4(const Matix4x4& matrix) : m() {
+	assert(matrix.m[3] == 0.0f && matrix.m[7] == 0.0f && matrix.m[11] == 0.0f &&
+		matrix.m[15] == 1.0f && "Last colum is not (0, 0, 0, 1)");
+	for (int i = 0; i < 3; i++) {
+		m[4 * i + 0] = matrix.m[i + 0];
+		m[4 * i + 1] = matrix.m[i + 4];
+		m[4 * i + 2] = matrix.m[i + 8];
+		m[4 * i + 3] = matrix.m[i + 12];
+	}
+}
+
+constexpr Affine3x4 Affine3x4::Identity() {
+	Affine3x4 out(0.0f);
+	out.m[0] = 1.0f; out.m[1] = 0.0f; out.m[2] = 0.0f; out.m[3] = 0.0f;
+	out.m[4] = 0.0f; out.m[5] = 1.0f; out.m[6] = 0.0f; out.m[7] = 0.0f;
+	out.m[8] = 0.0f; out.m[9] = 0.0f; out.m[10] = 1.0f; out.m[11] = 0.0f;
+	return out;
+}
+
+constexpr Matix4x4 Affine3x4::ToMatrix() const {
+	Matix4x4 out(0.0f);
+	for (int i = 0; i < 3; i++) {
+		out.m[i + 0] = m[4 * i + 0];
+		out.m[i + 4] = m[4 * i + 1];
+		out.m[i + 8] = m[4 * i + 2];
+		out.m[i + 12] = m[4 * i + 3];
+	}
+	out.m[3] = 0.0f;
+	out.m[7] = 0.0f;
+	out.m[11] = 0.0f;
+	out.m[15] = 1.0f;
+	return out;
+}
+
+constexpr Affine3x4 Affine3x4::Multiply(const Affine3x4& other) const {
+#ifdef MATH_SIMD_X86
+	if (!MATH_CONSTANT_EVALUATED() && Simd::Active() >= Simd::kSSE41) {
+		Affine3x4 out;
+		MultiplySSE41(m, other.m, out.m);
+		return out;
+	}
+#endif
+	Affine3x4 out(0.0f);
+	MultiplyScalar(m, other.m, out.m);
+	return out;
+}
+
+constexpr void Affine3x4::MultiplyScalar(const float* a, const float* b, float* out) {
+	// Transposed, a * b is b * a with an implicit (0, 0, 0, 1) fourth line:
+	// every line of out combines the lines of a, plus b's translation.
+	for (int i = 0; i < 12; i += 4) {
+		out[i + 0] = b[i + 0] * a[0] + b[i + 1] * a[4] + b[i + 2] * a[8];
+		out[i + 1] = b[i + 0] * a[1] + b[i + 1] * a[5] + b[i + 2] * a[9];
+		out[i + 2] = b[i + 0] * a[2] + b[i + 1] * a[6] + b[i + 2] * a[10];
+		out[i + 3] = b[i + 0] * a[3] + b[i + 1] * a[7] + b[i + 2] * a[11] + b[i + 3];
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Affine3x4::MultiplySSE41(const float* a, const float* b, float* out) {
+	const __m128 line0 = _mm_loadu_ps(a + 0);
+	const __m128 line1 = _mm_loadu_ps(a + 4);
+	const __m128 line2 = _mm_loadu_ps(a + 8);
+	for (int i = 0; i < 12; i += 4) {
+		const __m128 coefficients = _mm_loadu_ps(b + i);
+		__m128 res = _mm_mul_ps(_mm_shuffle_ps(coefficients, coefficients, 0x00), line0);
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(coefficients, coefficients, 0x55), line1));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(coefficients, coefficients, 0xAA), line2));
+		// b[i + 3] only goes into the last element.
+		res = _mm_blend_ps(res, _mm_add_ps(res, coefficients), 0x8);
+		_mm_storeu_ps(out + i, res);
+	}
+}
+#endif
+
+constexpr bool Affine3x4::Inverse() {
+	return GetInverse(*this);
+}
+
+constexpr bool Affine3x4::GetInverse(Affine3x4& out) const {
+	// Matix4x4::GetInverseAffine read through the transposed layout.
+	const float r00 = m[0], r01 = m[4], r02 = m[8];
+	const float r10 = m[1], r11 = m[5], r12 = m[9];
+	const float r20 = m[2], r21 = m[6], r22 = m[10];
+	const float tx = m[3], ty = m[7], tz = m[11];
+
+	const float c00 = r11 * r22 - r21 * r12;
+	const float c01 = r21 * r02 - r01 * r22;
+	const float c02 = r01 * r12 - r11 * r02;
+	const float determinant = r00 * c00 + r10 * c01 + r20 * c02;
+	if (determinant == 0.0f) {
+		return false;
+	}
+	const float inverse = 1.0f / determinant;
+
+	const float i00 = c00 * inverse;
+	const float i01 = c01 * inverse;
+	const float i02 = c02 * inverse;
+	const float i10 = (r20 * r12 - r10 * r22) * inverse;
+	const float i11 = (r00 * r22 - r20 * r02) * inverse;
+	const float i12 = (r10 * r02 - r00 * r12) * inverse;
+	const float i20 = (r10 * r21 - r20 * r11) * inverse;
+	const float i21 = (r20 * r01 - r00 * r21) * inverse;
+	const float i22 = (r00 * r11 - r10 * r01) * inverse;
+
+	out.m[0] = i00; out.m[1] = i10; out.m[2] = i20;
+	out.m[3] = -(tx * i00 + ty * i10 + tz * i20);
+	out.m[4] = i01; out.m[5] = i11; out.m[6] = i21;
+	out.m[7] = -(tx * i01 + ty * i11 + tz * i21);
+	out.m[8] = i02; out.m[9] = i12; out.m[10] = i22;
+	out.m[11] = -(tx * i02 + ty * i12 + tz * i22);
+	return true;
+}
+
+constexpr void Affine3x4::InverseRigid() {
+	GetInverseRigid(*this);
+}
+
+constexpr void Affine3x4::GetInverseRigid(Affine3x4& out) const {
+	const float r00 = m[0], r01 = m[4], r02 = m[8];
+	const float r10 = m[1], r11 = m[5], r12 = m[9];
+	const float r20 = m[2], r21 = m[6], r22 = m[10];
+	const float tx = m[3], ty = m[7], tz = m[11];
+
+	out.m[0] = r00; out.m[1] = r01; out.m[2] = r02;
+	out.m[3] = -(tx * r00 + ty * r01 + tz * r02);
+	out.m[4] = r10; out.m[5] = r11; out.m[6] = r12;
+	out.m[7] = -(tx * r10 + ty * r11 + tz * r12);
+	out.m[8] = r20; out.m[9] = r21; out.m[10] = r22;
+	out.m[11] = -(tx * r20 + ty * r21 + tz * r22);
+}
+
+constexpr Vector3 Affine3x4::TransformPoint(const Vector3& point) const {
+	return Vector3(point.x * m[0] + point.y * m[1] + point.z * m[2] + m[3],
+		point.x * m[4] + point.y * m[5] + point.z * m[6] + m[7],
+		point.x * m[8] + point.y * m[9] + point.z * m[10] + m[11]);
+}
+
+constexpr Vector3 Affine3x4::TransformDirection(const Vector3& direction) const {
+	return Vector3(direction.x * m[0] + direction.y * m[1] + direction.z * m[2],
+		direction.x * m[4] + direction.y * m[5] + direction.z * m[6],
+		direction.x * m[8] + direction.y * m[9] + direction.z * m[10]);
+}
+
+inline void Affine3x4::TransformPoints(const Vector3* in, Vector3* out, size_t n) const {
+	// The Matix4x4 batch kernels already read only the affine part.
+	ToMatrix().TransformPoints(in, out, n);
+}
+
+inline void Affine3x4::TransformDirections(const Vector3* in, Vector3* out, size_t n) const {
+	ToMatrix().TransformDirections(in, out, n);
+}
+
+constexpr bool Affine3x4::operator==(const Affine3x4& other) const {
+	for (int i = 0; i < 12; i++) {
+		if (m[i] != other.m[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+constexpr bool Affine3x4::operator!=(const Affine3x4& other) const {
+	return !(*this == other);
+}
+
+#endif
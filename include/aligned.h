@@ -0,0 +1,104 @@
+#ifndef __ALIGNED_H__
+#define __ALIGNED_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <new>
+
+// Heap blocks at a chosen power of two alignment. The block is aligned by
+// hand inside a malloc one, with the malloc pointer stored just before it,
+// so no platform specific aligned allocator is needed.
+class AlignedMemory {
+public:
+	// size bytes at a multiple of alignment. Throws std::bad_alloc when out
+	// of memory or when size plus the alignment does not fit a size_t.
+	static void* Allocate(size_t size, size_t alignment);
+	// Takes a pointer from Allocate, or 0.
+	static void Free(void* memory);
+
+private:
+	AlignedMemory();
+	AlignedMemory(const AlignedMemory& copy);
+	~AlignedMemory();
+};
+
+// T over-aligned to Alignment bytes, for arrays the SIMD kernels load with
+// aligned loads or that must not straddle cache lines. It converts to and
+// from T, so every T operation works on it; the size is rounded up to
+// Alignment. new[] honours the alignment (C++17 aligned new), as do the
+// AlignedAllocator and FrameArena.
+template<class T, size_t Alignment>
+struct alignas(Alignment) Aligned : public T {
+	using T::T;
+	Aligned() = default;
+	constexpr Aligned(const T& value) : T(value) {}
+};
+
+// std::allocator replacement for containers of math types, e.g.
+// std::vector<Matix4x4, AlignedAllocator<Matix4x4, 64> >. The default of 32
+// fits one AVX register.
+template<class T, size_t Alignment = 32>
+class AlignedAllocator {
+public:
+	static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0,
+		"Alignment must be a power of two of at least alignof(T)");
+
+	typedef T value_type;
+	template<class U>
+	struct rebind {
+		typedef AlignedAllocator<U, Alignment> other;
+	};
+
+	AlignedAllocator() {}
+	template<class U>
+	AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+	T* allocate(size_t n);
+	void deallocate(T* memory, size_t);
+
+	template<class U>
+	bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+	template<class U>
+	bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+inline AlignedMemory::AlignedMemory() {}
+inline AlignedMemory::AlignedMemory(const AlignedMemory&) {}
+inline AlignedMemory::~AlignedMemory() {}
+
+inline void* AlignedMemory::Allocate(size_t size, size_t alignment) {
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+	if (size > (size_t)-1 - alignment - sizeof(void*)) {
+		throw std::bad_alloc();
+	}
+	void* raw = malloc(size + alignment + sizeof(void*));
+	if (raw == 0) {
+		throw std::bad_alloc();
+	}
+	size_t address = (size_t)raw + sizeof(void*);
+	address = (address + alignment - 1) & ~(alignment - 1);
+	((void**)address)[-1] = raw;
+	return (void*)address;
+}
+
+inline void AlignedMemory::Free(void* memory) {
+	if (memory != 0) {
+		free(((void**)memory)[-1]);
+	}
+}
+
+template<class T, size_t Alignment>
+inline T* AlignedAllocator<T, Alignment>::allocate(size_t n) {
+	if (n > (size_t)-1 / sizeof(T)) {
+		throw std::bad_alloc();
+	}
+	return (T*)AlignedMemory::Allocate(n * sizeof(T), Alignment);
+}
+
+template<class T, size_t Alignment>
+inline void AlignedAllocator<T, Alignment>::deallocate(T* memory, size_t) {
+	AlignedMemory::Free(memory);
+}
+
+#endif
@@ -0,0 +1,653 @@
+#ifndef __BVH_H__
+#define __BVH_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "vector_3.h"
+#include "aabb_3.h"
+#include "vector_3_stream.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+// Bounding volume hierarchy over boxes, built with the binned surface area
+// heuristic. Nodes are 32 bytes, two to a cache line, in one array where
+// the two children of a node sit next to each other after it.
+//
+// The tree only knows the box of every primitive. Queries call back with
+// the primitive's index in the array given to Build for every primitive
+// whose box passes the test; the caller does the exact test.
+class BVH {
+public:
+	struct Node {
+		Vector3 min;
+		// First child of an interior node, first of Primitives() for a leaf.
+		uint32_t index;
+		Vector3 max;
+		// Primitives in a leaf, 0 for an interior node.
+		uint16_t count;
+		// Axis the children were split on; the left one has the smaller centers.
+		uint16_t axis;
+	};
+
+	BVH();
+
+	void Build(const AABB3* boxes, size_t n);
+	// Same tree as Build with the subtrees built on the pool; only the order
+	// of the nodes in the array can differ.
+	void Build(const AABB3* boxes, size_t n, ThreadPool& pool);
+	// New boxes for the same primitives, keeping the tree. Much cheaper than
+	// Build, but queries slow down as the boxes drift from where they were.
+	void Refit(const AABB3* boxes);
+
+	size_t Size() const;
+	size_t NodeCount() const;
+	const Node* Nodes() const;
+	// Primitive indices in leaf order.
+	const int* Primitives() const;
+	AABB3 Bounds() const;
+
+	// Closest-first traversal of origin + t * direction for t in [0, t_max].
+	// hit(int primitive, float& t_max) is called for every primitive whose
+	// box the ray enters before t_max; it tests the primitive and lowers
+	// t_max on a hit, which prunes the rest of the traversal.
+	template<class F>
+	void Raycast(const Vector3& origin, const Vector3& direction, float& t_max, const F& hit) const;
+	// The same for many rays, traced in packets of 8 that share one
+	// traversal. t_max holds a float per ray, and hit(int primitive,
+	// size_t ray, float& t_max) is called as above.
+	template<class F>
+	void Raycast(const Vector3Stream& origins, const Vector3Stream& directions, float* t_max, const F& hit) const;
+
+	// found(int primitive) for every primitive whose box intersects box.
+	template<class F>
+	void Overlap(const AABB3& box, const F& found) const;
+	// found(int primitive) for every primitive whose box intersects the sphere.
+	template<class F>
+	void Overlap(const Vector3& center, float radius, const F& found) const;
+
+private:
+	static const int kBins = 16;
+	static const uint32_t kMaxLeafSize = 8;
+	// Cost of visiting a node relative to testing a primitive.
+	static constexpr float kTraversalCost = 1.0f;
+	// Deeper nodes are split at the median, which halves them, so no tree
+	// gets deeper than kSahDepth + 32 and the traversal stack can be fixed.
+	static const int kSahDepth = 32;
+	static const int kStackSize = kSahDepth + 40;
+	// The parallel build splits the top of the tree until there are this
+	// many subtrees per thread, but none smaller than kMinTaskSize.
+	static const size_t kTasksPerThread = 4;
+	static const uint32_t kMinTaskSize = 1024;
+	static const int kPacket = 8;
+
+	// Primitives [first, first + count) of indices_ under node, still to be
+	// split.
+	struct Range {
+		uint32_t node;
+		uint32_t first;
+		uint32_t count;
+		int depth;
+	};
+
+	// A primitive while the tree is built. The build partitions these
+	// rather than indices, so that every pass reads memory in order.
+	struct Reference {
+		AABB3 box;
+		int index;
+	};
+
+	struct Bin {
+		AABB3 bounds;
+		uint32_t count;
+	};
+
+	// Rays [0, kPacket) of a packet; unused lanes have t_max < 0.
+	struct Packet {
+		alignas(32) float origin[3][kPacket];
+		alignas(32) float inverse[3][kPacket];
+		alignas(32) float t_max[kPacket];
+	};
+
+	// Bit i is set when ray i enters the box before its t_max.
+	typedef int (*PacketKernel)(const Vector3& min, const Vector3& max, const Packet& packet);
+
+	static float Axis(const Vector3& value, int axis);
+	static int BinIndex(float center, float low, float scale, int bins);
+	static bool IntersectsSphere(const Vector3& min, const Vector3& max, const Vector3& center, float radius);
+
+	void Prepare(const AABB3* boxes, size_t n, std::vector<Reference>& references);
+	void Finish(const std::vector<Reference>& references);
+	// Makes range a leaf and returns false, or appends its two children to
+	// nodes and returns their ranges.
+	static bool Split(Reference* references, std::vector<Node>& nodes, const Range& range, Range& left, Range& right);
+	static void BuildSubtree(Reference* references, std::vector<Node>& nodes, const Range& root);
+
+	static PacketKernel ActivePacketKernel();
+	static int PacketTestScalar(const Vector3& min, const Vector3& max, const Packet& packet);
+#ifdef MATH_SIMD_X86
+	MATH_TARGET_AVX static int PacketTestAVX(const Vector3& min, const Vector3& max, const Packet& packet);
+#endif
+
+	std::vector<Node> nodes_;
+	std::vector<int> indices_;
+	// Boxes of the primitives in leaf order, for the tests inside a leaf.
+	std::vector<AABB3> boxes_;
+};
+
+static_assert(sizeof(BVH::Node) == 32, "BVH::Node must be 32 bytes");
+
+inline BVH::BVH() {}
+
+inline size_t BVH::Size() const {
+	return indices_.size();
+}
+
+inline size_t BVH::NodeCount() const {
+	return nodes_.size();
+}
+
+inline const BVH::Node* BVH::Nodes() const {
+	return nodes_.empty() ? 0 : &nodes_[0];
+}
+
+inline const int* BVH::Primitives() const {
+	return indices_.empty() ? 0 : &indices_[0];
+}
+
+inline AABB3 BVH::Bounds() const {
+	return nodes_.empty() ? AABB3::Empty() : AABB3(nodes_[0].min, nodes_[0].max);
+}
+
+inline float BVH::Axis(const Vector3& value, int axis) {
+	return axis == 0 ? value.x : axis == 1 ? value.y : value.z;
+}
+
+inline int BVH::BinIndex(float center, float low, float scale, int bins) {
+	// Clamped before the conversion, which also sends a NaN to the last bin.
+	const float bin = (center - low) * scale;
+	return bin < bins - 1 ? (int)bin : bins - 1;
+}
+
+inline bool BVH::IntersectsSphere(const Vector3& min, const Vector3& max, const Vector3& center, float radius) {
+	// Distance from the center to the closest point of the box.
+	const float x = center.x - AABB3::Max(min.x, AABB3::Min(center.x, max.x));
+	const float y = center.y - AABB3::Max(min.y, AABB3::Min(center.y, max.y));
+	const float z = center.z - AABB3::Max(min.z, AABB3::Min(center.z, max.z));
+	return x * x + y * y + z * z <= radius * radius;
+}
+
+inline void BVH::Prepare(const AABB3* boxes, size_t n, std::vector<Reference>& references) {
+	assert(n <= 0x7fffffff && "Too many primitives");
+	nodes_.clear();
+	references.resize(n);
+	AABB3 bounds = AABB3::Empty();
+	for (size_t i = 0; i < n; i++) {
+		references[i].box = boxes[i];
+		references[i].index = (int)i;
+		bounds.Grow(boxes[i]);
+	}
+	if (n > 0) {
+		Node root;
+		root.min = bounds.min;
+		root.max = bounds.max;
+		root.index = 0;
+		root.count = 0;
+		root.axis = 0;
+		nodes_.push_back(root);
+	}
+}
+
+inline void BVH::Finish(const std::vector<Reference>& references) {
+	indices_.resize(references.size());
+	boxes_.resize(references.size());
+	for (size_t i = 0; i < references.size(); i++) {
+		indices_[i] = references[i].index;
+		boxes_[i] = references[i].box;
+	}
+}
+
+inline bool BVH::Split(Reference* references, std::vector<Node>& nodes, const Range& range, Range& left, Range& right) {
+	Reference* first = references + range.first;
+	Reference* last = first + range.count;
+	if (range.count <= 1) {
+		nodes[range.node].index = range.first;
+		nodes[range.node].count = (uint16_t)range.count;
+		return false;
+	}
+
+	AABB3 center_bounds = AABB3::Empty();
+	for (Reference* i = first; i < last; i++) {
+		center_bounds.Grow(i->box.Center());
+	}
+
+	// Best binned split over all three axes: bins [0, best_bin] go left.
+	// Small nodes get one bin per primitive, which is plenty and keeps the
+	// many nodes near the leaves cheap.
+	const int bin_count = range.count < (uint32_t)kBins ? (int)range.count : kBins;
+	const AABB3 bounds(nodes[range.node].min, nodes[range.node].max);
+	const float area = bounds.SurfaceArea();
+	const float inverse_area = area > 0.0f ? 1.0f / area : 0.0f;
+	float best_cost = (float)range.count;
+	int best_axis = -1;
+	int best_bin = 0;
+	float low[3];
+	float scale[3];
+	Bin bins[3][kBins];
+	if (range.depth < kSahDepth) {
+		for (int axis = 0; axis < 3; axis++) {
+			low[axis] = Axis(center_bounds.min, axis);
+			const float extent = Axis(center_bounds.max, axis) - low[axis];
+			// A flat axis puts everything in one bin and never wins.
+			scale[axis] = extent > 0.0f ? bin_count / extent : 0.0f;
+			for (int b = 0; b < bin_count; b++) {
+				bins[axis][b].bounds = AABB3::Empty();
+				bins[axis][b].count = 0;
+			}
+		}
+		// One pass for all three axes, so every box is loaded once.
+		for (Reference* i = first; i < last; i++) {
+			const AABB3& box = i->box;
+			const Vector3 center = box.Center();
+			Bin& x = bins[0][BinIndex(center.x, low[0], scale[0], bin_count)];
+			Bin& y = bins[1][BinIndex(center.y, low[1], scale[1], bin_count)];
+			Bin& z = bins[2][BinIndex(center.z, low[2], scale[2], bin_count)];
+			x.bounds.Grow(box);
+			x.count++;
+			y.bounds.Grow(box);
+			y.count++;
+			z.bounds.Grow(box);
+			z.count++;
+		}
+
+		for (int axis = 0; axis < 3; axis++) {
+			// Right side areas and counts for every split, then a sweep from the left.
+			float right_area[kBins];
+			uint32_t right_count[kBins];
+			AABB3 grow = AABB3::Empty();
+			uint32_t count = 0;
+			for (int b = bin_count - 1; b > 0; b--) {
+				grow.Grow(bins[axis][b].bounds);
+				count += bins[axis][b].count;
+				right_area[b] = count > 0 ? grow.SurfaceArea() : 0.0f;
+				right_count[b] = count;
+			}
+			grow = AABB3::Empty();
+			count = 0;
+			for (int b = 0; b < bin_count - 1; b++) {
+				grow.Grow(bins[axis][b].bounds);
+				count += bins[axis][b].count;
+				if (count == 0 || right_count[b + 1] == 0) {
+					continue;
+				}
+				const float cost = kTraversalCost +
+					(grow.SurfaceArea() * count + right_area[b + 1] * right_count[b + 1]) * inverse_area;
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_axis = axis;
+					best_bin = b;
+				}
+			}
+		}
+	}
+
+	Reference* middle;
+	AABB3 halves[2] = { AABB3::Empty(), AABB3::Empty() };
+	if (best_axis >= 0) {
+		const float axis_low = low[best_axis];
+		const float axis_scale = scale[best_axis];
+		middle = std::partition(first, last, [=](const Reference& reference) {
+			return BinIndex(Axis(reference.box.Center(), best_axis), axis_low, axis_scale, bin_count) <= best_bin;
+		});
+		for (int b = 0; b < bin_count; b++) {
+			halves[b <= best_bin ? 0 : 1].Grow(bins[best_axis][b].bounds);
+		}
+	} else if (range.count <= kMaxLeafSize) {
+		nodes[range.node].index = range.first;
+		nodes[range.node].count = (uint16_t)range.count;
+		return false;
+	} else {
+		// No split beats a leaf, but the leaf would be too big, or the node
+		// is too deep: split at the median on the widest axis of the centers.
+		const Vector3 extent = center_bounds.Size();
+		best_axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+		middle = first + range.count / 2;
+		const int axis = best_axis;
+		std::nth_element(first, middle, last, [=](const Reference& a, const Reference& b) {
+			return Axis(a.box.Center(), axis) < Axis(b.box.Center(), axis);
+		});
+		for (Reference* i = first; i < last; i++) {
+			halves[i < middle ? 0 : 1].Grow(i->box);
+		}
+	}
+
+	const uint32_t child = (uint32_t)nodes.size();
+	nodes[range.node].index = child;
+	nodes[range.node].count = 0;
+	nodes[range.node].axis = (uint16_t)best_axis;
+
+	left.node = child;
+	left.first = range.first;
+	left.count = (uint32_t)(middle - first);
+	left.depth = range.depth + 1;
+	right.node = child + 1;
+	right.first = left.first + left.count;
+	right.count = range.count - left.count;
+	right.depth = left.depth;
+
+	for (int h = 0; h < 2; h++) {
+		Node node;
+		node.min = halves[h].min;
+		node.max = halves[h].max;
+		node.index = 0;
+		node.count = 0;
+		node.axis = 0;
+		nodes.push_back(node);
+	}
+	return true;
+}
+
+inline void BVH::BuildSubtree(Reference* references, std::vector<Node>& nodes, const Range& root) {
+	std::vector<Range> stack(1, root);
+	while (!stack.empty()) {
+		const Range range = stack.back();
+		stack.pop_back();
+		Range left, right;
+		if (Split(references, nodes, range, left, right)) {
+			stack.push_back(right);
+			stack.push_back(left);
+		}
+	}
+}
+
+inline void BVH::Build(const AABB3* boxes, size_t n) {
+	std::vector<Reference> references;
+	Prepare(boxes, n, references);
+	if (n > 0) {
+		const Range root = { 0, 0, (uint32_t)n, 0 };
+		BuildSubtree(&references[0], nodes_, root);
+	}
+	Finish(references);
+}
+
+inline void BVH::Build(const AABB3* boxes, size_t n, ThreadPool& pool) {
+	std::vector<Reference> references;
+	Prepare(boxes, n, references);
+	if (n == 0) {
+		Finish(references);
+		return;
+	}
+
+	// Split the biggest range until there are enough to keep every thread
+	// busy. The children of a node come right after it in both builds, so
+	// the subtrees can be built on their own and appended afterwards.
+	const Range root = { 0, 0, (uint32_t)n, 0 };
+	std::vector<Range> tasks(1, root);
+	const size_t wanted = pool.Size() * kTasksPerThread;
+	while (tasks.size() < wanted) {
+		size_t biggest = 0;
+		for (size_t t = 1; t < tasks.size(); t++) {
+			if (tasks[t].count > tasks[biggest].count) {
+				biggest = t;
+			}
+		}
+		if (tasks[biggest].count < kMinTaskSize) {
+			break;
+		}
+		Range left, right;
+		if (!Split(&references[0], nodes_, tasks[biggest], left, right)) {
+			tasks.erase(tasks.begin() + biggest);
+			continue;
+		}
+		tasks[biggest] = left;
+		tasks.push_back(right);
+	}
+
+	// Every subtree starts from a copy of its root and owns its range of
+	// references, so the tasks share nothing they write.
+	std::vector<std::vector<Node> > subtrees(tasks.size());
+	Reference* reference = &references[0];
+	const std::vector<Node>& top = nodes_;
+	pool.ParallelFor(tasks.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t t = begin; t < end; t++) {
+			subtrees[t].push_back(top[tasks[t].node]);
+			Range range = tasks[t];
+			range.node = 0;
+			BuildSubtree(reference, subtrees[t], range);
+		}
+	});
+
+	// Node k > 0 of a subtree goes to base + k - 1, its root replaces the
+	// node it was built from.
+	for (size_t t = 0; t < tasks.size(); t++) {
+		const std::vector<Node>& subtree = subtrees[t];
+		const uint32_t base = (uint32_t)nodes_.size();
+		for (size_t k = 0; k < subtree.size(); k++) {
+			Node node = subtree[k];
+			if (node.count == 0) {
+				node.index += base - 1;
+			}
+			if (k == 0) {
+				nodes_[tasks[t].node] = node;
+			} else {
+				nodes_.push_back(node);
+			}
+		}
+	}
+	Finish(references);
+}
+
+inline void BVH::Refit(const AABB3* boxes) {
+	for (size_t i = 0; i < indices_.size(); i++) {
+		boxes_[i] = boxes[indices_[i]];
+	}
+	// Children always come after their parent.
+	for (size_t i = nodes_.size(); i > 0; i--) {
+		Node& node = nodes_[i - 1];
+		AABB3 box;
+		if (node.count > 0) {
+			box = AABB3::Empty();
+			for (uint32_t k = node.index; k < node.index + node.count; k++) {
+				box.Grow(boxes_[k]);
+			}
+		} else {
+			const Node& left = nodes_[node.index];
+			const Node& right = nodes_[node.index + 1];
+			box = AABB3::Union(AABB3(left.min, left.max), AABB3(right.min, right.max));
+		}
+		node.min = box.min;
+		node.max = box.max;
+	}
+}
+
+template<class F>
+inline void BVH::Raycast(const Vector3& origin, const Vector3& direction, float& t_max, const F& hit) const {
+	if (nodes_.empty()) {
+		return;
+	}
+	const Vector3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	const uint32_t negative[3] = { inverse.x < 0.0f, inverse.y < 0.0f, inverse.z < 0.0f };
+	uint32_t stack[kStackSize];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = nodes_[stack[--top]];
+		float t;
+		if (!AABB3(node.min, node.max).IntersectRay(origin, inverse, 0.0f, t_max, t)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.index; i < node.index + node.count; i++) {
+				if (boxes_[i].IntersectRay(origin, inverse, 0.0f, t_max, t)) {
+					hit(indices_[i], t_max);
+				}
+			}
+		} else {
+			// Far child first, so that the near one is popped next.
+			assert(top + 2 <= kStackSize && "BVH too deep");
+			stack[top++] = node.index + 1 - negative[node.axis];
+			stack[top++] = node.index + negative[node.axis];
+		}
+	}
+}
+
+template<class F>
+inline void BVH::Raycast(const Vector3Stream& origins, const Vector3Stream& directions, float* t_max, const F& hit) const {
+	assert(origins.Size() == directions.Size() && "Streams differ in size");
+	if (nodes_.empty()) {
+		return;
+	}
+	const PacketKernel test = ActivePacketKernel();
+	const size_t n = origins.Size();
+	Packet packet;
+	for (size_t first = 0; first < n; first += kPacket) {
+		const int lanes = n - first < (size_t)kPacket ? (int)(n - first) : kPacket;
+		for (int lane = 0; lane < kPacket; lane++) {
+			const bool used = lane < lanes;
+			const Vector3 origin = used ? origins.Get(first + lane) : Vector3(0.0f, 0.0f, 0.0f);
+			const Vector3 direction = used ? directions.Get(first + lane) : Vector3(1.0f, 1.0f, 1.0f);
+			packet.origin[0][lane] = origin.x;
+			packet.origin[1][lane] = origin.y;
+			packet.origin[2][lane] = origin.z;
+			packet.inverse[0][lane] = 1.0f / direction.x;
+			packet.inverse[1][lane] = 1.0f / direction.y;
+			packet.inverse[2][lane] = 1.0f / direction.z;
+			packet.t_max[lane] = used ? t_max[first + lane] : -1.0f;
+		}
+
+		uint32_t stack[kStackSize];
+		int top = 0;
+		stack[top++] = 0;
+		while (top > 0) {
+			const Node& node = nodes_[stack[--top]];
+			const int mask = test(node.min, node.max, packet);
+			if (mask == 0) {
+				continue;
+			}
+			if (node.count > 0) {
+				for (uint32_t i = node.index; i < node.index + node.count; i++) {
+					const int rays = test(boxes_[i].min, boxes_[i].max, packet);
+					for (int lane = 0; lane < lanes; lane++) {
+						if (rays >> lane & 1) {
+							hit(indices_[i], first + lane, packet.t_max[lane]);
+						}
+					}
+				}
+			} else {
+				// Near child by the direction of the first ray still in the box.
+				int lead = 0;
+				while (!(mask >> lead & 1)) {
+					lead++;
+				}
+				const uint32_t negative = packet.inverse[node.axis][lead] < 0.0f;
+				assert(top + 2 <= kStackSize && "BVH too deep");
+				stack[top++] = node.index + 1 - negative;
+				stack[top++] = node.index + negative;
+			}
+		}
+
+		for (int lane = 0; lane < lanes; lane++) {
+			t_max[first + lane] = packet.t_max[lane];
+		}
+	}
+}
+
+template<class F>
+inline void BVH::Overlap(const AABB3& box, const F& found) const {
+	if (nodes_.empty()) {
+		return;
+	}
+	uint32_t stack[kStackSize];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = nodes_[stack[--top]];
+		if (!box.Intersects(AABB3(node.min, node.max))) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.index; i < node.index + node.count; i++) {
+				if (box.Intersects(boxes_[i])) {
+					found(indices_[i]);
+				}
+			}
+		} else {
+			assert(top + 2 <= kStackSize && "BVH too deep");
+			stack[top++] = node.index + 1;
+			stack[top++] = node.index;
+		}
+	}
+}
+
+template<class F>
+inline void BVH::Overlap(const Vector3& center, float radius, const F& found) const {
+	if (nodes_.empty()) {
+		return;
+	}
+	uint32_t stack[kStackSize];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = nodes_[stack[--top]];
+		if (!IntersectsSphere(node.min, node.max, center, radius)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.index; i < node.index + node.count; i++) {
+				if (IntersectsSphere(boxes_[i].min, boxes_[i].max, center, radius)) {
+					found(indices_[i]);
+				}
+			}
+		} else {
+			assert(top + 2 <= kStackSize && "BVH too deep");
+			stack[top++] = node.index + 1;
+			stack[top++] = node.index;
+		}
+	}
+}
+
+inline BVH::PacketKernel BVH::ActivePacketKernel() {
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		return &PacketTestAVX;
+	}
+#endif
+	return &PacketTestScalar;
+}
+
+inline int BVH::PacketTestScalar(const Vector3& min, const Vector3& max, const Packet& packet) {
+	const AABB3 box(min, max);
+	int mask = 0;
+	for (int lane = 0; lane < kPacket; lane++) {
+		const Vector3 origin(packet.origin[0][lane], packet.origin[1][lane], packet.origin[2][lane]);
+		const Vector3 inverse(packet.inverse[0][lane], packet.inverse[1][lane], packet.inverse[2][lane]);
+		float t;
+		if (box.IntersectRay(origin, inverse, 0.0f, packet.t_max[lane], t)) {
+			mask |= 1 << lane;
+		}
+	}
+	return mask;
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline int BVH::PacketTestAVX(const Vector3& min, const Vector3& max, const Packet& packet) {
+	// AABB3::IntersectRay on 8 rays; AABB3::Min and Max are minps and maxps.
+	const float low[3] = { min.x, min.y, min.z };
+	const float high[3] = { max.x, max.y, max.z };
+	__m256 enter = _mm256_setzero_ps();
+	__m256 exit = _mm256_load_ps(packet.t_max);
+	for (int axis = 0; axis < 3; axis++) {
+		const __m256 origin = _mm256_load_ps(packet.origin[axis]);
+		const __m256 inverse = _mm256_load_ps(packet.inverse[axis]);
+		const __m256 a = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(low[axis]), origin), inverse);
+		const __m256 b = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(high[axis]), origin), inverse);
+		enter = _mm256_max_ps(_mm256_min_ps(a, b), enter);
+		exit = _mm256_min_ps(_mm256_max_ps(a, b), exit);
+	}
+	return _mm256_movemask_ps(_mm256_cmp_ps(enter, exit, _CMP_NGT_UQ));
+}
+#endif
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef __CAMERA_RELATIVE_H__
+#define __CAMERA_RELATIVE_H__ 1
+
+#include <stddef.h>
+#include "vector.h"
+#include "matrix.h"
+#include "matrix_4.h"
+#include "simd.h"
+
+// Camera-relative rendering: world positions stay in double, and each frame
+// every transform is rebased to an origin near the camera and rounded to a
+// float Matix4x4 once, so the float SIMD paths see small translations and
+// keep their precision far from the world origin. Translate() in float
+// already steps by 1.6 cm at 131 km; rebased, the step is that of the
+// distance to the camera.
+//
+// Pick the origin once per frame, usually the camera position, and rebase
+// the camera's own transform with the rest before inverting it for the view.
+// The translation is position - origin in double, rounded to float, so it
+// is within half a float ulp of the exact relative position.
+class CameraRelative {
+public:
+	static Vector3 Rebase(const Vector3d& position, const Vector3d& origin);
+	// world with its translation line moved by -origin, every element
+	// rounded to float.
+	static Matix4x4 Rebase(const Matrix4d& world, const Vector3d& origin);
+	// out[i] = Rebase(world[i], origin), 4 doubles at a time with AVX. Same
+	// bits as the single form.
+	static void Rebase(const Matrix4d* world, const Vector3d& origin, Matix4x4* out, size_t n);
+	// Compact form for float orientation and scale with double positions:
+	// out[i] is frames[i] with the translation Rebase(positions[i], origin).
+	// out may be frames.
+	static void Rebase(const Matix4x4* frames, const Vector3d* positions, const Vector3d& origin,
+		Matix4x4* out, size_t n);
+
+private:
+	CameraRelative();
+	CameraRelative(const CameraRelative& copy);
+	~CameraRelative();
+
+#ifdef MATH_SIMD_X86
+	MATH_TARGET_AVX static void RebaseAVX(const Matrix4d* world, const Vector3d& origin, Matix4x4* out, size_t n);
+#endif
+};
+
+inline CameraRelative::CameraRelative() {}
+inline CameraRelative::CameraRelative(const CameraRelative&) {}
+inline CameraRelative::~CameraRelative() {}
+
+inline Vector3 CameraRelative::Rebase(const Vector3d& position, const Vector3d& origin) {
+	return Vector3((float)(position.v[0] - origin.v[0]), (float)(position.v[1] - origin.v[1]),
+		(float)(position.v[2] - origin.v[2]));
+}
+
+inline Matix4x4 CameraRelative::Rebase(const Matrix4d& world, const Vector3d& origin) {
+	Matix4x4 out;
+	for (int i = 0; i < 12; i++) {
+		out.m[i] = (float)world.m[i];
+	}
+	out.m[12] = (float)(world.m[12] - origin.v[0]);
+	out.m[13] = (float)(world.m[13] - origin.v[1]);
+	out.m[14] = (float)(world.m[14] - origin.v[2]);
+	out.m[15] = (float)world.m[15];
+	return out;
+}
+
+inline void CameraRelative::Rebase(const Matrix4d* world, const Vector3d& origin, Matix4x4* out, size_t n) {
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		RebaseAVX(world, origin, out, n);
+		return;
+	}
+#endif
+	for (size_t i = 0; i < n; i++) {
+		out[i] = Rebase(world[i], origin);
+	}
+}
+
+inline void CameraRelative::Rebase(const Matix4x4* frames, const Vector3d* positions, const Vector3d& origin,
+	Matix4x4* out, size_t n) {
+	// Mostly a copy, which the scalar loop already runs at memory speed.
+	for (size_t i = 0; i < n; i++) {
+		const Vector3 translation = Rebase(positions[i], origin);
+		if (out != frames) {
+			out[i] = frames[i];
+		}
+		out[i].m[12] = translation.x;
+		out[i].m[13] = translation.y;
+		out[i].m[14] = translation.z;
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline void CameraRelative::RebaseAVX(const Matrix4d* world, const Vector3d& origin, Matix4x4* out, size_t n) {
+	// x - 0 is x for every double, the sign of zero included, so the w
+	// element goes through the same subtraction.
+	const __m256d offset = _mm256_setr_pd(origin.v[0], origin.v[1], origin.v[2], 0.0);
+	for (size_t i = 0; i < n; i++) {
+		const double* m = world[i].m;
+		float* o = out[i].m;
+		_mm_storeu_ps(o, _mm256_cvtpd_ps(_mm256_loadu_pd(m)));
+		_mm_storeu_ps(o + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(m + 4)));
+		_mm_storeu_ps(o + 8, _mm256_cvtpd_ps(_mm256_loadu_pd(m + 8)));
+		_mm_storeu_ps(o + 12, _mm256_cvtpd_ps(_mm256_sub_pd(_mm256_loadu_pd(m + 12), offset)));
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef __ELEMENTWISE_H__
+#define __ELEMENTWISE_H__ 1
+
+#include <type_traits>
+#include <utility>
+#include "simd.h"
+
+// The elementwise operators of every vector and matrix type, defined once.
+// A type opts in with an ElementTraits specialization next to its class:
+//
+//   Element   the stored type, e.g. Half for Vector<4, Half>.
+//   Scalar    the type the operations run in, float for the 16-bit types.
+//   kSize     the number of elements.
+//   kPacked   true when the elements are kSize floats stored contiguously
+//             from the start of the object.
+//   Get       element i as a Scalar.
+//   Make      the value from kSize Scalars, rounding each into Element.
+//
+// The scalar forms expand per element with constant indices, so named
+// members such as Vector3::y fold away. Packed types of a multiple of 4
+// floats run on SSE registers at run time instead; SSE2 is part of every
+// x86-64 target, so there is no dispatch. Both forms give the same bits.
+template<class T> struct ElementTraits;
+
+#if defined(MATH_SIMD_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MATH_ELEMENTWISE_SSE 1
+#endif
+
+struct ElementAdd {
+	template<class S>
+	static constexpr S Apply(S a, S b) { return a + b; }
+#ifdef MATH_ELEMENTWISE_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+#endif
+};
+
+struct ElementSubtract {
+	template<class S>
+	static constexpr S Apply(S a, S b) { return a - b; }
+#ifdef MATH_ELEMENTWISE_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+#endif
+};
+
+struct ElementMultiply {
+	template<class S>
+	static constexpr S Apply(S a, S b) { return a * b; }
+#ifdef MATH_ELEMENTWISE_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+#endif
+};
+
+struct ElementDivide {
+	template<class S>
+	static constexpr S Apply(S a, S b) { return a / b; }
+#ifdef MATH_ELEMENTWISE_SSE
+	static __m128 Apply(__m128 a, __m128 b) { return _mm_div_ps(a, b); }
+#endif
+};
+
+// -a, applied as a unary operation that ignores its second operand.
+struct ElementNegate {
+	template<class S>
+	static constexpr S Apply(S a, S) { return -a; }
+#ifdef MATH_ELEMENTWISE_SSE
+	static __m128 Apply(__m128 a, __m128) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+#endif
+};
+
+template<class T>
+class Elementwise {
+public:
+	typedef ElementTraits<T> Traits;
+	typedef typename Traits::Scalar Scalar;
+
+	static constexpr T Add(const T& a, const T& b);
+	static constexpr T Add(const T& a, Scalar value);
+	static constexpr T Subtract(const T& a, const T& b);
+	static constexpr T Subtract(const T& a, Scalar value);
+	static constexpr T Negate(const T& a);
+	// a[i] * b[i], the Scale of the vector types.
+	static constexpr T Multiply(const T& a, const T& b);
+	static constexpr T Multiply(const T& a, Scalar value);
+	static constexpr T Divide(const T& a, Scalar value);
+	static constexpr bool Equal(const T& a, const T& b);
+
+	// Operation applied to every pair a[i], b[i] or a[i], value.
+	template<class Operation>
+	static constexpr T Apply(const T& a, const T& b);
+	template<class Operation>
+	static constexpr T Apply(const T& a, Scalar value);
+
+private:
+	Elementwise();
+	Elementwise(const Elementwise& copy);
+	~Elementwise();
+
+	typedef std::make_integer_sequence<int, Traits::kSize> Indices;
+	static constexpr bool kSSE = Traits::kPacked && Traits::kSize % 4 == 0;
+
+	template<class Operation, int... I>
+	static constexpr T Apply(const T& a, const T& b, std::integer_sequence<int, I...>);
+	template<class Operation, int... I>
+	static constexpr T Apply(const T& a, Scalar value, std::integer_sequence<int, I...>);
+	template<int... I>
+	static constexpr bool Equal(const T& a, const T& b, std::integer_sequence<int, I...>);
+
+#ifdef MATH_ELEMENTWISE_SSE
+	static __m128 Load(const T& value, int i);
+	template<class Operation>
+	static T ApplySSE(const T& a, const T& b);
+	template<class Operation>
+	static T ApplySSE(const T& a, float value);
+	static bool EqualSSE(const T& a, const T& b);
+#endif
+};
+
+template<class T>
+constexpr T Elementwise<T>::Add(const T& a, const T& b) {
+	return Apply<ElementAdd>(a, b);
+}
+
+template<class T>
+constexpr T Elementwise<T>::Add(const T& a, Scalar value) {
+	return Apply<ElementAdd>(a, value);
+}
+
+template<class T>
+constexpr T Elementwise<T>::Subtract(const T& a, const T& b) {
+	return Apply<ElementSubtract>(a, b);
+}
+
+template<class T>
+constexpr T Elementwise<T>::Subtract(const T& a, Scalar value) {
+	return Apply<ElementSubtract>(a, value);
+}
+
+template<class T>
+constexpr T Elementwise<T>::Negate(const T& a) {
+	return Apply<ElementNegate>(a, Scalar(0));
+}
+
+template<class T>
+constexpr T Elementwise<T>::Multiply(const T& a, const T& b) {
+	return Apply<ElementMultiply>(a, b);
+}
+
+template<class T>
+constexpr T Elementwise<T>::Multiply(const T& a, Scalar value) {
+	return Apply<ElementMultiply>(a, value);
+}
+
+template<class T>
+constexpr T Elementwise<T>::Divide(const T& a, Scalar value) {
+	return Apply<ElementDivide>(a, value);
+}
+
+template<class T>
+constexpr bool Elementwise<T>::Equal(const T& a, const T& b) {
+#ifdef MATH_ELEMENTWISE_SSE
+	if constexpr (kSSE) {
+		if (!MATH_CONSTANT_EVALUATED()) {
+			return EqualSSE(a, b);
+		}
+	}
+#endif
+	return Equal(a, b, Indices());
+}
+
+template<class T>
+template<class Operation>
+constexpr T Elementwise<T>::Apply(const T& a, const T& b) {
+#ifdef MATH_ELEMENTWISE_SSE
+	if constexpr (kSSE) {
+		if (!MATH_CONSTANT_EVALUATED()) {
+			return ApplySSE<Operation>(a, b);
+		}
+	}
+#endif
+	return Apply<Operation>(a, b, Indices());
+}
+
+template<class T>
+template<class Operation>
+constexpr T Elementwise<T>::Apply(const T& a, Scalar value) {
+#ifdef MATH_ELEMENTWISE_SSE
+	if constexpr (kSSE) {
+		if (!MATH_CONSTANT_EVALUATED()) {
+			return ApplySSE<Operation>(a, value);
+		}
+	}
+#endif
+	return Apply<Operation>(a, value, Indices());
+}
+
+template<class T>
+template<class Operation, int... I>
+constexpr T Elementwise<T>::Apply(const T& a, const T& b, std::integer_sequence<int, I...>) {
+	const Scalar values[] = { Operation::Apply(Traits::Get(a, I), Traits::Get(b, I))... };
+	return Traits::Make(values);
+}
+
+template<class T>
+template<class Operation, int... I>
+constexpr T Elementwise<T>::Apply(const T& a, Scalar value, std::integer_sequence<int, I...>) {
+	const Scalar values[] = { Operation::Apply(Traits::Get(a, I), value)... };
+	return Traits::Make(values);
+}
+
+template<class T>
+template<int... I>
+constexpr bool Elementwise<T>::Equal(const T& a, const T& b, std::integer_sequence<int, I...>) {
+	return (... && (Traits::Get(a, I) == Traits::Get(b, I)));
+}
+
+#ifdef MATH_ELEMENTWISE_SSE
+template<class T>
+inline __m128 Elementwise<T>::Load(const T& value, int i) {
+	return _mm_loadu_ps(reinterpret_cast<const float*>(&value) + i);
+}
+
+template<class T>
+template<class Operation>
+inline T Elementwise<T>::ApplySSE(const T& a, const T& b) {
+	T out;
+	float* result = reinterpret_cast<float*>(&out);
+	for (int i = 0; i < Traits::kSize; i += 4) {
+		_mm_storeu_ps(result + i, Operation::Apply(Load(a, i), Load(b, i)));
+	}
+	return out;
+}
+
+template<class T>
+template<class Operation>
+inline T Elementwise<T>::ApplySSE(const T& a, float value) {
+	const __m128 broadcast = _mm_set1_ps(value);
+	T out;
+	float* result = reinterpret_cast<float*>(&out);
+	for (int i = 0; i < Traits::kSize; i += 4) {
+		_mm_storeu_ps(result + i, Operation::Apply(Load(a, i), broadcast));
+	}
+	return out;
+}
+
+template<class T>
+inline bool Elementwise<T>::EqualSSE(const T& a, const T& b) {
+	// Ordered compares, so NaN is unequal and -0 equals +0 as with ==.
+	int mask = 0xF;
+	for (int i = 0; i < Traits::kSize; i += 4) {
+		mask &= _mm_movemask_ps(_mm_cmpeq_ps(Load(a, i), Load(b, i)));
+	}
+	return mask == 0xF;
+}
+#endif
+
+#endif
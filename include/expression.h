@@ -0,0 +1,150 @@
+#ifndef __EXPRESSION_H__
+#define __EXPRESSION_H__ 1
+
+#include <type_traits>
+#include <utility>
+#include "elementwise.h"
+#include "vector_2.h"
+#include "vector_3.h"
+#include "vector_4.h"
+#include "matrix_2.h"
+#include "matrix_3.h"
+#include "matrix_4.h"
+
+// Opt-in expression templates for the elementwise operators of Vector2/3/4,
+// Matrix2x2, Matrix3x3 and Matix4x4. Wrap the operands in Lazy() and the operators
+// build a tree instead of temporaries; converting it to the result type
+// evaluates every element in one pass:
+//
+//   position = Lazy(position) + Lazy(velocity) * dt - drag;
+//
+// Every element goes through the same float operations, in the same order,
+// as the eager operators, so the result has the same bits. The tree keeps
+// references to its operands: evaluate it in the full expression that
+// builds it rather than storing it in an auto variable.
+//
+// The element types and operations are the ElementTraits and operation
+// structs of elementwise.h, shared with the eager operators.
+
+// Tree nodes. Each one has a Result type and returns element i with Get(i).
+template<class T>
+class ExpressionLeaf {
+public:
+	typedef T Result;
+	static_assert(std::is_same<typename ElementTraits<T>::Element, float>::value,
+		"Lazy evaluates in float and so needs float elements");
+	constexpr explicit ExpressionLeaf(const T& value) : value_(value) {}
+	constexpr float Get(int i) const { return ElementTraits<T>::Get(value_, i); }
+
+private:
+	const T& value_;
+};
+
+template<class Left, class Right, class Operation>
+class ExpressionBinary {
+public:
+	typedef typename Left::Result Result;
+	static_assert(std::is_same<Result, typename Right::Result>::value, "Operands of different types");
+	constexpr ExpressionBinary(const Left& left, const Right& right) : left_(left), right_(right) {}
+	constexpr float Get(int i) const { return Operation::Apply(left_.Get(i), right_.Get(i)); }
+
+private:
+	Left left_;
+	Right right_;
+};
+
+// Element op scalar, or scalar op element when ScalarFirst is true.
+template<class Node, class Operation, bool ScalarFirst>
+class ExpressionScalar {
+public:
+	typedef typename Node::Result Result;
+	constexpr ExpressionScalar(const Node& node, float scalar) : node_(node), scalar_(scalar) {}
+	constexpr float Get(int i) const {
+		return ScalarFirst ? Operation::Apply(scalar_, node_.Get(i)) : Operation::Apply(node_.Get(i), scalar_);
+	}
+
+private:
+	Node node_;
+	float scalar_;
+};
+
+template<class Node>
+class Expression {
+public:
+	typedef typename Node::Result Result;
+
+	constexpr explicit Expression(const Node& node) : node_(node) {}
+
+	constexpr float Get(int i) const { return node_.Get(i); }
+	constexpr const Node& GetNode() const { return node_; }
+
+	constexpr Result Evaluate() const {
+		return Evaluate(std::make_integer_sequence<int, ElementTraits<Result>::kSize>());
+	}
+
+	constexpr operator Result() const { return Evaluate(); }
+
+private:
+	// Expanded per element so that Get(i) sees a constant index and the
+	// component selection folds away.
+	template<int... I>
+	constexpr Result Evaluate(std::integer_sequence<int, I...>) const {
+		const float values[] = { node_.Get(I)... };
+		return ElementTraits<Result>::Make(values);
+	}
+
+	Node node_;
+};
+
+template<class T>
+constexpr Expression<ExpressionLeaf<T> > Lazy(const T& value) {
+	return Expression<ExpressionLeaf<T> >(ExpressionLeaf<T>(value));
+}
+
+// expression op expression, expression op value and value op expression.
+#define MATH_EXPRESSION_BINARY(symbol, Operation) \
+	template<class Left, class Right> \
+	constexpr Expression<ExpressionBinary<Left, Right, Operation> > operator symbol( \
+		const Expression<Left>& left, const Expression<Right>& right) { \
+		return Expression<ExpressionBinary<Left, Right, Operation> >( \
+			ExpressionBinary<Left, Right, Operation>(left.GetNode(), right.GetNode())); \
+	} \
+	template<class Left> \
+	constexpr Expression<ExpressionBinary<Left, ExpressionLeaf<typename Left::Result>, Operation> > operator symbol( \
+		const Expression<Left>& left, const typename Left::Result& right) { \
+		return left symbol Lazy(right); \
+	} \
+	template<class Right> \
+	constexpr Expression<ExpressionBinary<ExpressionLeaf<typename Right::Result>, Right, Operation> > operator symbol( \
+		const typename Right::Result& left, const Expression<Right>& right) { \
+		return Lazy(left) symbol right; \
+	}
+
+// expression op scalar, and scalar op expression where the eager types
+// have it (float * vector is the same product as vector * float).
+#define MATH_EXPRESSION_SCALAR(symbol, Operation) \
+	template<class Node> \
+	constexpr Expression<ExpressionScalar<Node, Operation, false> > operator symbol( \
+		const Expression<Node>& node, float scalar) { \
+		return Expression<ExpressionScalar<Node, Operation, false> >( \
+			ExpressionScalar<Node, Operation, false>(node.GetNode(), scalar)); \
+	}
+
+MATH_EXPRESSION_BINARY(+, ElementAdd)
+MATH_EXPRESSION_BINARY(-, ElementSubtract)
+MATH_EXPRESSION_SCALAR(+, ElementAdd)
+MATH_EXPRESSION_SCALAR(-, ElementSubtract)
+MATH_EXPRESSION_SCALAR(*, ElementMultiply)
+MATH_EXPRESSION_SCALAR(/, ElementDivide)
+
+#undef MATH_EXPRESSION_BINARY
+#undef MATH_EXPRESSION_SCALAR
+
+template<class Node>
+constexpr Expression<ExpressionScalar<Node, ElementMultiply, true> > operator*(
+	float scalar, const Expression<Node>& node) {
+	return Expression<ExpressionScalar<Node, ElementMultiply, true> >(
+		ExpressionScalar<Node, ElementMultiply, true>(node.GetNode(), scalar));
+}
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef __FAST_MATH_H__
+#define __FAST_MATH_H__ 1
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "simd.h"
+
+// Approximations of the libm functions on the hot paths, and the precision
+// policy that picks between them and libm.
+//
+// Every function that takes a FastMath::Precision defaults to kDefault,
+// which is kExact unless MATH_FAST_MATH is defined, so a build can switch
+// wholesale and a single call can still ask for either.
+//
+// The error bounds are in units in the last place of the correctly rounded
+// result, measured over the whole stated domain by
+// benchmark/fast_math_bounds.cc. The x86 paths start from the rsqrtss
+// estimate, which differs between CPU vendors, so results are only
+// reproducible on one kind of CPU; the bounds hold on all of them.
+class FastMath {
+public:
+	enum Precision {
+		kExact = 0,
+		kFast = 1
+	};
+
+#ifdef MATH_FAST_MATH
+	static constexpr Precision kDefault = kFast;
+#else
+	static constexpr Precision kDefault = kExact;
+#endif
+
+	// 1 / sqrt(x) for positive normal x, rsqrt estimate plus one Newton
+	// step, or the bit trick plus three without SSE. Max error 5 ulp.
+	// Only faster than 1 / sqrtf over many independent values, where the
+	// divider is the bottleneck (BM_FastMath_Rsqrt, 2.1 against 2.9 ns a
+	// value), and 8 lanes at a time in Vector3Stream::Normalize on a stream
+	// that fits in cache. In one dependent chain the Newton step costs what
+	// the division saves.
+	static float Rsqrt(float x);
+	// sqrt(x) for x = 0 or positive normal x. sqrtss on x86, which is
+	// correctly rounded and no slower than Rsqrt, otherwise x * Rsqrt(x).
+	// Max error 4 ulp.
+	static float Sqrt(float x);
+	// acos(x) for x in [-1, 1], Abramowitz and Stegun 4.4.46. Max error
+	// 3 ulp.
+	static float Acos(float x);
+	// For |x| <= kTrigRange: reduction by pi / 2, then minimax polynomials
+	// on [-pi / 4, pi / 4]. Max error 3 ulp for sin and cos, 4 ulp for tan.
+	// Past kTrigRange the reduction loses accuracy.
+	static float Sin(float x);
+	static float Cos(float x);
+	static void SinCos(float x, float& sin, float& cos);
+	static float Tan(float x);
+	// SinCos over n angles; sin and cos need n elements. Same bits as the
+	// scalar SinCos, 8 angles at a time with AVX.
+	static void SinCos(const float* x, float* sin, float* cos, size_t n);
+
+	static constexpr float kTrigRange = 8192.0f;
+
+private:
+	FastMath();
+	FastMath(const FastMath& copy);
+	~FastMath();
+
+	// x - k * pi / 2 with k the nearest integer to x * 2 / pi. pi / 2 is
+	// split in four; the first three have at most 11 significant bits, so
+	// their products with k are exact for |k| < 2^13.
+	static float Reduce(float x, int& quadrant);
+	// sin and cos of a reduced angle.
+	static float SinPolynomial(float r);
+	static float CosPolynomial(float r);
+
+	static constexpr float kTwoOverPi = 0.636619772f;
+	static constexpr float kRound = 12582912.0f;
+	static constexpr float kPiHalf1 = 1.5703125f;
+	static constexpr float kPiHalf2 = 4.83751296997070312e-4f;
+	static constexpr float kPiHalf3 = 7.54953362e-8f;
+	static constexpr float kPiHalf4 = 2.56334407e-12f;
+	// Cephes sinf and cosf coefficients, highest power first.
+	static constexpr float kSin[3] = { -1.9515295891e-4f, 8.3321608736e-3f, -1.6666654611e-1f };
+	static constexpr float kCos[3] = { 2.443315711809948e-5f, -1.388731625493765e-3f, 4.166664568298827e-2f };
+
+#ifdef MATH_SIMD_X86
+	// Whole blocks of 8 only; count is a multiple of 8.
+	MATH_TARGET_AVX static void SinCosAVX(const float* x, float* sin, float* cos, size_t count);
+#endif
+};
+
+inline FastMath::FastMath() {}
+inline FastMath::FastMath(const FastMath&) {}
+inline FastMath::~FastMath() {}
+
+inline float FastMath::Rsqrt(float x) {
+#ifdef MATH_SIMD_X86
+	// rsqrtss is SSE, part of every x86-64 target.
+	float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	bits = 0x5f375a86 - (bits >> 1);
+	float y;
+	memcpy(&y, &bits, sizeof(y));
+	// The bit trick is good to 3.5e-2 relative, the estimate is 12 bits.
+	y = y * (1.5f - 0.5f * x * y * y);
+	y = y * (1.5f - 0.5f * x * y * y);
+#endif
+	// y * (1.5 - x / 2 * y * y) as y plus a small correction, which rounds
+	// better.
+	const float half = 0.5f * x;
+	return y + y * (0.5f - half * y * y);
+}
+
+inline float FastMath::Sqrt(float x) {
+#ifdef MATH_SIMD_X86
+	// Unlike sqrtf, no check for a negative x to set errno.
+	return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+#else
+	return x > 0.0f ? x * Rsqrt(x) : 0.0f;
+#endif
+}
+
+inline float FastMath::Acos(float x) {
+	const float a = fabsf(x);
+	float p = -0.0012624911f;
+	p = p * a + 0.0066700901f;
+	p = p * a - 0.0170881256f;
+	p = p * a + 0.0308918810f;
+	p = p * a - 0.0501743046f;
+	p = p * a + 0.0889789874f;
+	p = p * a - 0.2145988016f;
+	p = p * a + 1.5707963050f;
+	const float result = sqrtf(1.0f - a) * p;
+	return x < 0.0f ? 3.14159265f - result : result;
+}
+
+inline float FastMath::Reduce(float x, int& quadrant) {
+	// Adding and subtracting 1.5 * 2^23 rounds to the nearest integer like
+	// nearbyintf, which is a libm call without SSE4.1.
+	const float k = (x * kTwoOverPi + kRound) - kRound;
+	quadrant = (int)k & 3;
+	return (((x - k * kPiHalf1) - k * kPiHalf2) - k * kPiHalf3) - k * kPiHalf4;
+}
+
+inline float FastMath::SinPolynomial(float r) {
+	const float z = r * r;
+	return ((kSin[0] * z + kSin[1]) * z + kSin[2]) * z * r + r;
+}
+
+inline float FastMath::CosPolynomial(float r) {
+	const float z = r * r;
+	return ((kCos[0] * z + kCos[1]) * z + kCos[2]) * z * z - 0.5f * z + 1.0f;
+}
+
+inline void FastMath::SinCos(float x, float& sin, float& cos) {
+	int quadrant;
+	const float r = Reduce(x, quadrant);
+	const float s = SinPolynomial(r);
+	const float c = CosPolynomial(r);
+	// Quadrants 0 to 3 give (s, c), (c, -s), (-s, -c) and (-c, s); selects
+	// rather than a switch, since the quadrant is unpredictable.
+	const float sin_r = quadrant & 1 ? c : s;
+	const float cos_r = quadrant & 1 ? s : c;
+	sin = quadrant & 2 ? -sin_r : sin_r;
+	cos = (quadrant + 1) & 2 ? -cos_r : cos_r;
+}
+
+inline float FastMath::Sin(float x) {
+	float sin, cos;
+	SinCos(x, sin, cos);
+	return sin;
+}
+
+inline float FastMath::Cos(float x) {
+	float sin, cos;
+	SinCos(x, sin, cos);
+	return cos;
+}
+
+inline void FastMath::SinCos(const float* x, float* sin, float* cos, size_t n) {
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / 8 * 8;
+		SinCosAVX(x, sin, cos, i);
+	}
+#endif
+	for (; i < n; i++) {
+		SinCos(x[i], sin[i], cos[i]);
+	}
+}
+
+inline float FastMath::Tan(float x) {
+	int quadrant;
+	const float r = Reduce(x, quadrant);
+	const float s = SinPolynomial(r);
+	const float c = CosPolynomial(r);
+	return quadrant & 1 ? -c / s : s / c;
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline void FastMath::SinCosAVX(const float* x, float* sin, float* cos, size_t count) {
+	const __m256 two_over_pi = _mm256_set1_ps(kTwoOverPi);
+	const __m256 round = _mm256_set1_ps(kRound);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	for (size_t i = 0; i < count; i += 8) {
+		const __m256 v = _mm256_loadu_ps(x + i);
+		const __m256 k = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(v, two_over_pi), round), round);
+		__m256 r = _mm256_sub_ps(v, _mm256_mul_ps(k, _mm256_set1_ps(kPiHalf1)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(kPiHalf2)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(kPiHalf3)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(k, _mm256_set1_ps(kPiHalf4)));
+
+		// Bits 0 and 1 of the quadrant without AVX2 integer ops: k is a small
+		// integer, so the floors and differences are exact, and they follow
+		// (int)k & 3 for negative k too.
+		const __m256 k_half = _mm256_floor_ps(_mm256_mul_ps(k, half));
+		const __m256 bit0 = _mm256_sub_ps(k, _mm256_mul_ps(k_half, two));
+		const __m256 bit1 = _mm256_sub_ps(k_half, _mm256_mul_ps(_mm256_floor_ps(_mm256_mul_ps(k, quarter)), two));
+		const __m256 odd = _mm256_cmp_ps(bit0, one, _CMP_EQ_OQ);
+		const __m256 high = _mm256_cmp_ps(bit1, one, _CMP_EQ_OQ);
+
+		const __m256 z = _mm256_mul_ps(r, r);
+		__m256 s = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kSin[0]), z), _mm256_set1_ps(kSin[1]));
+		s = _mm256_add_ps(_mm256_mul_ps(s, z), _mm256_set1_ps(kSin[2]));
+		s = _mm256_add_ps(_mm256_mul_ps(_mm256_mul_ps(s, z), r), r);
+		__m256 c = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(kCos[0]), z), _mm256_set1_ps(kCos[1]));
+		c = _mm256_add_ps(_mm256_mul_ps(c, z), _mm256_set1_ps(kCos[2]));
+		c = _mm256_sub_ps(_mm256_mul_ps(_mm256_mul_ps(c, z), z), _mm256_mul_ps(half, z));
+		c = _mm256_add_ps(c, one);
+
+		// Masks rather than blendv, which GCC splits into lanes here.
+		const __m256 sin_r = _mm256_or_ps(_mm256_and_ps(odd, c), _mm256_andnot_ps(odd, s));
+		const __m256 cos_r = _mm256_or_ps(_mm256_and_ps(odd, s), _mm256_andnot_ps(odd, c));
+		_mm256_storeu_ps(sin + i, _mm256_xor_ps(sin_r, _mm256_and_ps(high, sign)));
+		_mm256_storeu_ps(cos + i, _mm256_xor_ps(cos_r, _mm256_and_ps(_mm256_xor_ps(high, odd), sign)));
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef __FRAME_ARENA_H__
+#define __FRAME_ARENA_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <type_traits>
+#include "aligned.h"
+
+// Bump allocator for the temporary arrays of one frame: transform and
+// culling buffers, hit masks, sorted indices. Allocate moves an offset into
+// one block that is allocated up front, and Reset frees everything at once
+// in O(1), so nothing in the frame touches malloc. Not thread safe; give
+// each thread its own arena.
+class FrameArena {
+public:
+	// Largest alignment Allocate takes, a cache line.
+	static const size_t kMaxAlignment = 64;
+	// Alignment of the typed Allocate unless T needs more: one AVX register.
+	static const size_t kArrayAlignment = 32;
+
+	explicit FrameArena(size_t capacity);
+	~FrameArena();
+
+	// size bytes at a multiple of alignment, a power of two up to
+	// kMaxAlignment. Asserts and returns 0 when the arena is full; size it
+	// from Peak().
+	void* Allocate(size_t size, size_t alignment = kArrayAlignment);
+	// Uninitialized storage for n T. Reset runs no destructors, so T must be
+	// trivially destructible.
+	template<class T>
+	T* Allocate(size_t n);
+
+	// Releases every allocation. Pointers from before are invalid after it.
+	void Reset();
+
+	size_t Capacity() const;
+	size_t Used() const;
+	// Most bytes in use at once since construction.
+	size_t Peak() const;
+
+private:
+	FrameArena(const FrameArena& copy);
+	FrameArena& operator=(const FrameArena& copy);
+
+	char* buffer_;
+	size_t capacity_;
+	size_t used_;
+	size_t peak_;
+};
+
+inline FrameArena::FrameArena(size_t capacity)
+	: buffer_((char*)AlignedMemory::Allocate(capacity, kMaxAlignment)), capacity_(capacity), used_(0), peak_(0) {}
+
+inline FrameArena::~FrameArena() {
+	AlignedMemory::Free(buffer_);
+}
+
+inline void* FrameArena::Allocate(size_t size, size_t alignment) {
+	assert(alignment != 0 && (alignment & (alignment - 1)) == 0 && alignment <= kMaxAlignment && "Bad alignment");
+	const size_t begin = (used_ + alignment - 1) & ~(alignment - 1);
+	if (begin > capacity_ || size > capacity_ - begin) {
+		assert(false && "Arena out of memory");
+		return 0;
+	}
+	used_ = begin + size;
+	if (used_ > peak_) {
+		peak_ = used_;
+	}
+	return buffer_ + begin;
+}
+
+template<class T>
+inline T* FrameArena::Allocate(size_t n) {
+	static_assert(std::is_trivially_destructible<T>::value, "T must be trivially destructible");
+	static_assert(alignof(T) <= kMaxAlignment, "T is aligned past kMaxAlignment");
+	assert(n <= (size_t)-1 / sizeof(T) && "Allocation too large");
+	const size_t alignment = alignof(T) > kArrayAlignment ? alignof(T) : kArrayAlignment;
+	return (T*)Allocate(n * sizeof(T), alignment);
+}
+
+inline void FrameArena::Reset() {
+	used_ = 0;
+}
+
+inline size_t FrameArena::Capacity() const {
+	return capacity_;
+}
+
+inline size_t FrameArena::Used() const {
+	return used_;
+}
+
+inline size_t FrameArena::Peak() const {
+	return peak_;
+}
+
+#endif
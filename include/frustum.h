@@ -0,0 +1,279 @@
+#ifndef __FRUSTUM_H__
+#define __FRUSTUM_H__ 1
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "vector_3.h"
+#include "vector_4.h"
+#include "matrix_4.h"
+#include "vector_3_stream.h"
+#include "simd.h"
+
+// The six planes of a view volume, extracted from a view-projection matrix
+// (Gribb and Hartmann). Every plane is (normal, distance) in a Vector4 with
+// a unit normal pointing inside, so a point p is inside when
+// DotProduct(normal, p) + distance >= 0 for all six.
+//
+// The matrix maps row vectors to OpenGL clip space, clip = v * M with
+// -w <= x, y, z <= w, like the rest of the library. PerspectiveMatrix and
+// OrthoMatrix build the transposed, column-vector form, so a camera is
+//
+//   Frustum frustum(view.Multiply(projection.Transpose()));
+//
+// The tests are conservative: a box or sphere that crosses the corner of
+// two planes outside the volume can still be reported visible.
+class Frustum {
+public:
+	enum Plane {
+		kLeft = 0,
+		kRight = 1,
+		kBottom = 2,
+		kTop = 3,
+		kNear = 4,
+		kFar = 5,
+		kPlaneCount = 6
+	};
+
+	Frustum();
+	explicit Frustum(const Matix4x4& view_projection);
+
+	bool ContainsPoint(const Vector3& point) const;
+	bool IntersectsSphere(const Vector3& center, float radius) const;
+	// Box given by its center and half size.
+	bool IntersectsBox(const Vector3& center, const Vector3& extent) const;
+
+	// Bit i % 32 of visible[i / 32] is set when object i passes the single
+	// test above. visible needs (Size() + 31) / 32 words; bits past the
+	// last object are cleared. Every SIMD level gives the same bits.
+	void CullBoxes(const Vector3Stream& centers, const Vector3Stream& extents, uint32_t* visible) const;
+	// radii holds centers.Size() floats.
+	void CullSpheres(const Vector3Stream& centers, const float* radii, uint32_t* visible) const;
+
+	Vector4 planes[kPlaneCount];
+
+private:
+	static const size_t kBlock = 8;
+
+	// Objects [begin, end) on the 24 plane floats; they OR their bits into
+	// visible, which the callers clear first. The SIMD kernels take whole
+	// blocks of 4 (SSE4.1) or 8 (AVX).
+	static void CullBoxesScalar(const float* planes, const Vector3Stream& centers, const Vector3Stream& extents,
+		size_t begin, size_t end, uint32_t* visible);
+	static void CullSpheresScalar(const float* planes, const Vector3Stream& centers, const float* radii,
+		size_t begin, size_t end, uint32_t* visible);
+#ifdef MATH_SIMD_X86
+	MATH_TARGET_SSE41 static void CullBoxesSSE41(const float* planes, const Vector3Stream& centers,
+		const Vector3Stream& extents, size_t count, uint32_t* visible);
+	MATH_TARGET_SSE41 static void CullSpheresSSE41(const float* planes, const Vector3Stream& centers,
+		const float* radii, size_t count, uint32_t* visible);
+	MATH_TARGET_AVX static void CullBoxesAVX(const float* planes, const Vector3Stream& centers,
+		const Vector3Stream& extents, size_t count, uint32_t* visible);
+	MATH_TARGET_AVX static void CullSpheresAVX(const float* planes, const Vector3Stream& centers,
+		const float* radii, size_t count, uint32_t* visible);
+#endif
+};
+
+inline Frustum::Frustum() {}
+
+inline Frustum::Frustum(const Matix4x4& view_projection) {
+	const float* m = view_projection.m;
+	// Colum j of M gives clip coordinate j; w is colum 3. Left and right
+	// come from x, bottom and top from y, near and far from z.
+	const Vector4 w(m[3], m[7], m[11], m[15]);
+	for (int i = 0; i < 3; i++) {
+		const Vector4 colum(m[i], m[i + 4], m[i + 8], m[i + 12]);
+		planes[2 * i + 0] = w + colum;
+		planes[2 * i + 1] = w - colum;
+	}
+	for (int i = 0; i < kPlaneCount; i++) {
+		const float length = sqrtf(planes[i].x * planes[i].x + planes[i].y * planes[i].y + planes[i].z * planes[i].z);
+		assert(length != 0 && "Degenerate view-projection matrix");
+		planes[i] /= length;
+	}
+}
+
+inline bool Frustum::ContainsPoint(const Vector3& point) const {
+	for (int i = 0; i < kPlaneCount; i++) {
+		const Vector4& p = planes[i];
+		if (p.x * point.x + p.y * point.y + p.z * point.z + p.w < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool Frustum::IntersectsSphere(const Vector3& center, float radius) const {
+	for (int i = 0; i < kPlaneCount; i++) {
+		const Vector4& p = planes[i];
+		if (p.x * center.x + p.y * center.y + p.z * center.z + p.w + radius < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+inline bool Frustum::IntersectsBox(const Vector3& center, const Vector3& extent) const {
+	for (int i = 0; i < kPlaneCount; i++) {
+		const Vector4& p = planes[i];
+		// Distance of the center plus the box's projected half size.
+		const float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		const float radius = fabsf(p.x) * extent.x + fabsf(p.y) * extent.y + fabsf(p.z) * extent.z;
+		if (distance + radius < 0.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+inline void Frustum::CullBoxes(const Vector3Stream& centers, const Vector3Stream& extents, uint32_t* visible) const {
+	assert(centers.Size() == extents.Size() && "Streams differ in size");
+	const size_t n = centers.Size();
+	memset(visible, 0, (n + 31) / 32 * sizeof(uint32_t));
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			i = n / kBlock * kBlock;
+			CullBoxesAVX(&planes[0].x, centers, extents, i, visible);
+			break;
+		case Simd::kSSE41:
+			i = n / 4 * 4;
+			CullBoxesSSE41(&planes[0].x, centers, extents, i, visible);
+			break;
+		default:
+			break;
+	}
+#endif
+	CullBoxesScalar(&planes[0].x, centers, extents, i, n, visible);
+}
+
+inline void Frustum::CullSpheres(const Vector3Stream& centers, const float* radii, uint32_t* visible) const {
+	const size_t n = centers.Size();
+	memset(visible, 0, (n + 31) / 32 * sizeof(uint32_t));
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			i = n / kBlock * kBlock;
+			CullSpheresAVX(&planes[0].x, centers, radii, i, visible);
+			break;
+		case Simd::kSSE41:
+			i = n / 4 * 4;
+			CullSpheresSSE41(&planes[0].x, centers, radii, i, visible);
+			break;
+		default:
+			break;
+	}
+#endif
+	CullSpheresScalar(&planes[0].x, centers, radii, i, n, visible);
+}
+
+inline void Frustum::CullBoxesScalar(const float* planes, const Vector3Stream& centers, const Vector3Stream& extents,
+	size_t begin, size_t end, uint32_t* visible) {
+	for (size_t i = begin; i < end; i++) {
+		bool inside = true;
+		for (int k = 0; k < 4 * kPlaneCount; k += 4) {
+			const float distance = planes[k] * centers.x[i] + planes[k + 1] * centers.y[i] + planes[k + 2] * centers.z[i] + planes[k + 3];
+			const float radius = fabsf(planes[k]) * extents.x[i] + fabsf(planes[k + 1]) * extents.y[i] + fabsf(planes[k + 2]) * extents.z[i];
+			inside = inside && !(distance + radius < 0.0f);
+		}
+		visible[i / 32] |= (uint32_t)inside << (i % 32);
+	}
+}
+
+inline void Frustum::CullSpheresScalar(const float* planes, const Vector3Stream& centers, const float* radii,
+	size_t begin, size_t end, uint32_t* visible) {
+	for (size_t i = begin; i < end; i++) {
+		bool inside = true;
+		for (int k = 0; k < 4 * kPlaneCount; k += 4) {
+			const float distance = planes[k] * centers.x[i] + planes[k + 1] * centers.y[i] + planes[k + 2] * centers.z[i] + planes[k + 3];
+			inside = inside && !(distance + radii[i] < 0.0f);
+		}
+		visible[i / 32] |= (uint32_t)inside << (i % 32);
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Frustum::CullBoxesSSE41(const float* planes, const Vector3Stream& centers,
+	const Vector3Stream& extents, size_t count, uint32_t* visible) {
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	for (size_t i = 0; i < count; i += 4) {
+		const __m128 cx = _mm_load_ps(centers.x + i), cy = _mm_load_ps(centers.y + i), cz = _mm_load_ps(centers.z + i);
+		const __m128 ex = _mm_load_ps(extents.x + i), ey = _mm_load_ps(extents.y + i), ez = _mm_load_ps(extents.z + i);
+		__m128 outside = zero;
+		for (int k = 0; k < 4 * kPlaneCount; k += 4) {
+			const __m128 px = _mm_set1_ps(planes[k]), py = _mm_set1_ps(planes[k + 1]);
+			const __m128 pz = _mm_set1_ps(planes[k + 2]), pw = _mm_set1_ps(planes[k + 3]);
+			__m128 distance = _mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy));
+			distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(pz, cz)), pw);
+			__m128 radius = _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, px), ex), _mm_mul_ps(_mm_andnot_ps(sign, py), ey));
+			radius = _mm_add_ps(radius, _mm_mul_ps(_mm_andnot_ps(sign, pz), ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+		}
+		visible[i / 32] |= (uint32_t)(~_mm_movemask_ps(outside) & 0xF) << (i % 32);
+	}
+}
+
+MATH_TARGET_SSE41 inline void Frustum::CullSpheresSSE41(const float* planes, const Vector3Stream& centers,
+	const float* radii, size_t count, uint32_t* visible) {
+	const __m128 zero = _mm_setzero_ps();
+	for (size_t i = 0; i < count; i += 4) {
+		const __m128 cx = _mm_load_ps(centers.x + i), cy = _mm_load_ps(centers.y + i), cz = _mm_load_ps(centers.z + i);
+		const __m128 r = _mm_loadu_ps(radii + i);
+		__m128 outside = zero;
+		for (int k = 0; k < 4 * kPlaneCount; k += 4) {
+			const __m128 px = _mm_set1_ps(planes[k]), py = _mm_set1_ps(planes[k + 1]);
+			const __m128 pz = _mm_set1_ps(planes[k + 2]), pw = _mm_set1_ps(planes[k + 3]);
+			__m128 distance = _mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy));
+			distance = _mm_add_ps(_mm_add_ps(distance, _mm_mul_ps(pz, cz)), pw);
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, r), zero));
+		}
+		visible[i / 32] |= (uint32_t)(~_mm_movemask_ps(outside) & 0xF) << (i % 32);
+	}
+}
+
+MATH_TARGET_AVX inline void Frustum::CullBoxesAVX(const float* planes, const Vector3Stream& centers,
+	const Vector3Stream& extents, size_t count, uint32_t* visible) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 cx = _mm256_load_ps(centers.x + i), cy = _mm256_load_ps(centers.y + i), cz = _mm256_load_ps(centers.z + i);
+		const __m256 ex = _mm256_load_ps(extents.x + i), ey = _mm256_load_ps(extents.y + i), ez = _mm256_load_ps(extents.z + i);
+		__m256 outside = zero;
+		for (int k = 0; k < 4 * kPlaneCount; k += 4) {
+			const __m256 px = _mm256_set1_ps(planes[k]), py = _mm256_set1_ps(planes[k + 1]);
+			const __m256 pz = _mm256_set1_ps(planes[k + 2]), pw = _mm256_set1_ps(planes[k + 3]);
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(px, cx), _mm256_mul_ps(py, cy));
+			distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(pz, cz)), pw);
+			__m256 radius = _mm256_add_ps(_mm256_mul_ps(_mm256_andnot_ps(sign, px), ex), _mm256_mul_ps(_mm256_andnot_ps(sign, py), ey));
+			radius = _mm256_add_ps(radius, _mm256_mul_ps(_mm256_andnot_ps(sign, pz), ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_LT_OQ));
+		}
+		visible[i / 32] |= (uint32_t)(~_mm256_movemask_ps(outside) & 0xFF) << (i % 32);
+	}
+}
+
+MATH_TARGET_AVX inline void Frustum::CullSpheresAVX(const float* planes, const Vector3Stream& centers,
+	const float* radii, size_t count, uint32_t* visible) {
+	const __m256 zero = _mm256_setzero_ps();
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 cx = _mm256_load_ps(centers.x + i), cy = _mm256_load_ps(centers.y + i), cz = _mm256_load_ps(centers.z + i);
+		const __m256 r = _mm256_loadu_ps(radii + i);
+		__m256 outside = zero;
+		for (int k = 0; k < 4 * kPlaneCount; k += 4) {
+			const __m256 px = _mm256_set1_ps(planes[k]), py = _mm256_set1_ps(planes[k + 1]);
+			const __m256 pz = _mm256_set1_ps(planes[k + 2]), pw = _mm256_set1_ps(planes[k + 3]);
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(px, cx), _mm256_mul_ps(py, cy));
+			distance = _mm256_add_ps(_mm256_add_ps(distance, _mm256_mul_ps(pz, cz)), pw);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, r), zero, _CMP_LT_OQ));
+		}
+		visible[i / 32] |= (uint32_t)(~_mm256_movemask_ps(outside) & 0xFF) << (i % 32);
+	}
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef __HALF_H__
+#define __HALF_H__ 1
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+// 16-bit storage types for memory-bound streams. They convert to float for
+// arithmetic and round back to nearest even when stored, so Vector<N, Half>
+// and Matrix<R, C, Half> compute in float.
+
+// IEEE 754 binary16: 1 sign, 5 exponent and 10 mantissa bits. Keeps
+// subnormals, infinities and NaNs; finite values above 65504 round to
+// infinity.
+class Half {
+public:
+	Half();
+	Half(float value);
+
+	operator float() const;
+
+	static Half FromBits(uint16_t bits);
+
+	uint16_t bits;
+};
+
+// bfloat16: the upper half of a float. Same range as float with 8 bits of
+// precision.
+class BFloat16 {
+public:
+	BFloat16();
+	BFloat16(float value);
+
+	operator float() const;
+
+	static BFloat16 FromBits(uint16_t bits);
+
+	uint16_t bits;
+};
+
+static_assert(std::is_trivially_copyable<Half>::value, "Half must be trivially copyable");
+static_assert(std::is_standard_layout<Half>::value, "Half must be standard layout");
+static_assert(sizeof(Half) == 2, "Half must be 2 bytes");
+static_assert(std::is_trivially_copyable<BFloat16>::value, "BFloat16 must be trivially copyable");
+static_assert(std::is_standard_layout<BFloat16>::value, "BFloat16 must be standard layout");
+static_assert(sizeof(BFloat16) == 2, "BFloat16 must be 2 bytes");
+
+inline Half::Half() {}
+
+inline Half::Half(float value) {
+	uint32_t f;
+	memcpy(&f, &value, sizeof(f));
+	const uint32_t sign = (f >> 16) & 0x8000;
+	const uint32_t magnitude = f & 0x7FFFFFFF;
+
+	if (magnitude >= 0x7F800000) {
+		// Infinity, or NaN with its payload truncated and kept quiet.
+		bits = (uint16_t)(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 | ((magnitude >> 13) & 0x3FF) : 0));
+		return;
+	}
+	if (magnitude >= 0x477FF000) {
+		// 65520 and above round to infinity.
+		bits = (uint16_t)(sign | 0x7C00);
+		return;
+	}
+
+	uint32_t result;
+	uint32_t remainder;
+	uint32_t halfway;
+	if (magnitude >= 0x38800000) {
+		// Normal half: rebias the exponent, drop 13 mantissa bits.
+		result = (magnitude >> 13) - ((127 - 15) << 10);
+		remainder = magnitude & 0x1FFF;
+		halfway = 0x1000;
+	} else {
+		// Subnormal half in units of 2^-24.
+		const int shift = 126 - (int)(magnitude >> 23);
+		if (shift > 25) {
+			bits = (uint16_t)sign;
+			return;
+		}
+		const uint32_t mantissa = (magnitude & 0x7FFFFF) | 0x800000;
+		result = mantissa >> shift;
+		remainder = mantissa & ((1u << shift) - 1);
+		halfway = 1u << (shift - 1);
+	}
+	// Round to nearest even; a carry moves into the exponent on its own.
+	if (remainder > halfway || (remainder == halfway && (result & 1))) {
+		result++;
+	}
+	bits = (uint16_t)(sign | result);
+}
+
+inline Half::operator float() const {
+	const uint32_t sign = (uint32_t)(bits & 0x8000) << 16;
+	const uint32_t exponent = (bits >> 10) & 0x1F;
+	const uint32_t mantissa = bits & 0x3FF;
+	uint32_t f;
+	if (exponent == 0x1F) {
+		f = sign | 0x7F800000 | (mantissa << 13) | (mantissa != 0 ? 0x400000 : 0);
+	} else if (exponent != 0) {
+		f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+	} else {
+		// Zero or subnormal: mantissa * 2^-24 is exact in float.
+		const float value = (float)mantissa * (1.0f / 16777216.0f);
+		return sign ? -value : value;
+	}
+	float value;
+	memcpy(&value, &f, sizeof(value));
+	return value;
+}
+
+inline Half Half::FromBits(uint16_t bits) {
+	Half out;
+	out.bits = bits;
+	return out;
+}
+
+inline BFloat16::BFloat16() {}
+
+inline BFloat16::BFloat16(float value) {
+	uint32_t f;
+	memcpy(&f, &value, sizeof(f));
+	if ((f & 0x7FFFFFFF) > 0x7F800000) {
+		bits = (uint16_t)((f >> 16) | 0x40);
+		return;
+	}
+	// Round to nearest even on the dropped 16 bits.
+	f += 0x7FFF + ((f >> 16) & 1);
+	bits = (uint16_t)(f >> 16);
+}
+
+inline BFloat16::operator float() const {
+	const uint32_t f = (uint32_t)bits << 16;
+	float value;
+	memcpy(&value, &f, sizeof(value));
+	return value;
+}
+
+inline BFloat16 BFloat16::FromBits(uint16_t bits) {
+	BFloat16 out;
+	out.bits = bits;
+	return out;
+}
+
+#endif
@@ -0,0 +1,332 @@
+#ifndef __INTERSECTION_H__
+#define __INTERSECTION_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "vector_3.h"
+#include "aabb_3.h"
+#include "vector_3_stream.h"
+#include "aabb_3_stream.h"
+#include "simd.h"
+
+// Ray against triangle and ray against box tests, one at a time and in
+// batches over structure-of-arrays streams: one ray against many
+// primitives, or many rays against one primitive.
+//
+// The batches set bit i % 32 of hit[i / 32] when test i hits, like
+// Frustum::CullBoxes; hit needs (n + 31) / 32 words and bits past the last
+// test are cleared. The float outputs need n elements and are written for
+// every test, but only hold the hit where its bit is set. Every SIMD level
+// gives the same bits as the single tests.
+class Intersection {
+public:
+	// Moller-Trumbore, hitting both sides. On a hit t is in [0, t_max] and
+	// the point is origin + t * direction = (1 - u - v) * a + u * b + v * c.
+	// A ray in the plane of the triangle misses.
+	static bool RayTriangle(const Vector3& origin, const Vector3& direction,
+		const Vector3& a, const Vector3& b, const Vector3& c, float t_max, float& t, float& u, float& v);
+	// One ray against triangles (a[i], b[i], c[i]).
+	static void RayTriangles(const Vector3& origin, const Vector3& direction,
+		const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream& c, float t_max,
+		uint32_t* hit, float* t, float* u, float* v);
+	// Rays (origins[i], directions[i]) up to t_max[i] against one triangle.
+	static void RaysTriangle(const Vector3Stream& origins, const Vector3Stream& directions,
+		const Vector3& a, const Vector3& b, const Vector3& c, const float* t_max,
+		uint32_t* hit, float* t, float* u, float* v);
+
+	// AABB3::IntersectRay for t in [0, t_max], taking the direction itself.
+	// t is the entry distance, 0 for a ray starting inside. Like the
+	// triangle test, t is written on a miss too.
+	static bool RayBox(const Vector3& origin, const Vector3& direction, const AABB3& box, float t_max, float& t);
+	static void RayBoxes(const Vector3& origin, const Vector3& direction, const AABB3Stream& boxes, float t_max,
+		uint32_t* hit, float* t);
+	static void RaysBox(const Vector3Stream& origins, const Vector3Stream& directions, const AABB3& box,
+		const float* t_max, uint32_t* hit, float* t);
+
+private:
+	Intersection();
+	Intersection(const Intersection& copy);
+	~Intersection();
+
+	static const size_t kBlock = 8;
+
+	// Tests [begin, end) one at a time; they OR their bits into hit, which
+	// the callers clear first.
+	static void RayTrianglesScalar(const Vector3& origin, const Vector3& direction,
+		const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream& c, float t_max,
+		size_t begin, size_t end, uint32_t* hit, float* t, float* u, float* v);
+	static void RaysTriangleScalar(const Vector3Stream& origins, const Vector3Stream& directions,
+		const Vector3& a, const Vector3& b, const Vector3& c, const float* t_max,
+		size_t begin, size_t end, uint32_t* hit, float* t, float* u, float* v);
+	static void RayBoxesScalar(const Vector3& origin, const Vector3& direction, const AABB3Stream& boxes,
+		float t_max, size_t begin, size_t end, uint32_t* hit, float* t);
+	static void RaysBoxScalar(const Vector3Stream& origins, const Vector3Stream& directions, const AABB3& box,
+		const float* t_max, size_t begin, size_t end, uint32_t* hit, float* t);
+#ifdef MATH_SIMD_X86
+	// RayTriangle and RayBox on 8 lanes, returning the hit mask.
+	MATH_TARGET_AVX static int TriangleAVX(const __m256* origin, const __m256* direction,
+		const __m256* a, const __m256* b, const __m256* c, __m256 t_max, __m256& t, __m256& u, __m256& v);
+	MATH_TARGET_AVX static int BoxAVX(const __m256* origin, const __m256* inverse,
+		const __m256* min, const __m256* max, __m256 t_max, __m256& t);
+	// Whole blocks only; count is a multiple of kBlock.
+	MATH_TARGET_AVX static void RayTrianglesAVX(const Vector3& origin, const Vector3& direction,
+		const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream& c, float t_max,
+		size_t count, uint32_t* hit, float* t, float* u, float* v);
+	MATH_TARGET_AVX static void RaysTriangleAVX(const Vector3Stream& origins, const Vector3Stream& directions,
+		const Vector3& a, const Vector3& b, const Vector3& c, const float* t_max,
+		size_t count, uint32_t* hit, float* t, float* u, float* v);
+	MATH_TARGET_AVX static void RayBoxesAVX(const Vector3& origin, const Vector3& direction, const AABB3Stream& boxes,
+		float t_max, size_t count, uint32_t* hit, float* t);
+	MATH_TARGET_AVX static void RaysBoxAVX(const Vector3Stream& origins, const Vector3Stream& directions, const AABB3& box,
+		const float* t_max, size_t count, uint32_t* hit, float* t);
+#endif
+};
+
+inline Intersection::Intersection() {}
+inline Intersection::Intersection(const Intersection&) {}
+inline Intersection::~Intersection() {}
+
+inline bool Intersection::RayTriangle(const Vector3& origin, const Vector3& direction,
+	const Vector3& a, const Vector3& b, const Vector3& c, float t_max, float& t, float& u, float& v) {
+	const float e1x = b.x - a.x, e1y = b.y - a.y, e1z = b.z - a.z;
+	const float e2x = c.x - a.x, e2y = c.y - a.y, e2z = c.z - a.z;
+	// p = direction x e2, q = s x e1.
+	const float px = direction.y * e2z - direction.z * e2y;
+	const float py = direction.z * e2x - direction.x * e2z;
+	const float pz = direction.x * e2y - direction.y * e2x;
+	const float det = e1x * px + e1y * py + e1z * pz;
+	const float inverse = 1.0f / det;
+	const float sx = origin.x - a.x, sy = origin.y - a.y, sz = origin.z - a.z;
+	const float qx = sy * e1z - sz * e1y;
+	const float qy = sz * e1x - sx * e1z;
+	const float qz = sx * e1y - sy * e1x;
+	u = (sx * px + sy * py + sz * pz) * inverse;
+	v = (direction.x * qx + direction.y * qy + direction.z * qz) * inverse;
+	t = (e2x * qx + e2y * qy + e2z * qz) * inverse;
+	return det != 0.0f && u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t >= 0.0f && t <= t_max;
+}
+
+inline bool Intersection::RayBox(const Vector3& origin, const Vector3& direction, const AABB3& box, float t_max, float& t) {
+	const Vector3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	float exit = 0.0f;
+	box.RayInterval(origin, inverse, 0.0f, t_max, t, exit);
+	// Not enter > exit, as in IntersectRay.
+	return !(t > exit);
+}
+
+inline void Intersection::RayTriangles(const Vector3& origin, const Vector3& direction,
+	const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream& c, float t_max,
+	uint32_t* hit, float* t, float* u, float* v) {
+	assert(a.Size() == b.Size() && a.Size() == c.Size() && "Streams differ in size");
+	const size_t n = a.Size();
+	memset(hit, 0, (n + 31) / 32 * sizeof(uint32_t));
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		RayTrianglesAVX(origin, direction, a, b, c, t_max, i, hit, t, u, v);
+	}
+#endif
+	RayTrianglesScalar(origin, direction, a, b, c, t_max, i, n, hit, t, u, v);
+}
+
+inline void Intersection::RaysTriangle(const Vector3Stream& origins, const Vector3Stream& directions,
+	const Vector3& a, const Vector3& b, const Vector3& c, const float* t_max,
+	uint32_t* hit, float* t, float* u, float* v) {
+	assert(origins.Size() == directions.Size() && "Streams differ in size");
+	const size_t n = origins.Size();
+	memset(hit, 0, (n + 31) / 32 * sizeof(uint32_t));
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		RaysTriangleAVX(origins, directions, a, b, c, t_max, i, hit, t, u, v);
+	}
+#endif
+	RaysTriangleScalar(origins, directions, a, b, c, t_max, i, n, hit, t, u, v);
+}
+
+inline void Intersection::RayBoxes(const Vector3& origin, const Vector3& direction, const AABB3Stream& boxes,
+	float t_max, uint32_t* hit, float* t) {
+	const size_t n = boxes.Size();
+	memset(hit, 0, (n + 31) / 32 * sizeof(uint32_t));
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		RayBoxesAVX(origin, direction, boxes, t_max, i, hit, t);
+	}
+#endif
+	RayBoxesScalar(origin, direction, boxes, t_max, i, n, hit, t);
+}
+
+inline void Intersection::RaysBox(const Vector3Stream& origins, const Vector3Stream& directions, const AABB3& box,
+	const float* t_max, uint32_t* hit, float* t) {
+	assert(origins.Size() == directions.Size() && "Streams differ in size");
+	const size_t n = origins.Size();
+	memset(hit, 0, (n + 31) / 32 * sizeof(uint32_t));
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / kBlock * kBlock;
+		RaysBoxAVX(origins, directions, box, t_max, i, hit, t);
+	}
+#endif
+	RaysBoxScalar(origins, directions, box, t_max, i, n, hit, t);
+}
+
+inline void Intersection::RayTrianglesScalar(const Vector3& origin, const Vector3& direction,
+	const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream& c, float t_max,
+	size_t begin, size_t end, uint32_t* hit, float* t, float* u, float* v) {
+	for (size_t i = begin; i < end; i++) {
+		const bool inside = RayTriangle(origin, direction, a.Get(i), b.Get(i), c.Get(i), t_max, t[i], u[i], v[i]);
+		hit[i / 32] |= (uint32_t)inside << (i % 32);
+	}
+}
+
+inline void Intersection::RaysTriangleScalar(const Vector3Stream& origins, const Vector3Stream& directions,
+	const Vector3& a, const Vector3& b, const Vector3& c, const float* t_max,
+	size_t begin, size_t end, uint32_t* hit, float* t, float* u, float* v) {
+	for (size_t i = begin; i < end; i++) {
+		const bool inside = RayTriangle(origins.Get(i), directions.Get(i), a, b, c, t_max[i], t[i], u[i], v[i]);
+		hit[i / 32] |= (uint32_t)inside << (i % 32);
+	}
+}
+
+inline void Intersection::RayBoxesScalar(const Vector3& origin, const Vector3& direction, const AABB3Stream& boxes,
+	float t_max, size_t begin, size_t end, uint32_t* hit, float* t) {
+	for (size_t i = begin; i < end; i++) {
+		const bool inside = RayBox(origin, direction, boxes.Get(i), t_max, t[i]);
+		hit[i / 32] |= (uint32_t)inside << (i % 32);
+	}
+}
+
+inline void Intersection::RaysBoxScalar(const Vector3Stream& origins, const Vector3Stream& directions, const AABB3& box,
+	const float* t_max, size_t begin, size_t end, uint32_t* hit, float* t) {
+	for (size_t i = begin; i < end; i++) {
+		const bool inside = RayBox(origins.Get(i), directions.Get(i), box, t_max[i], t[i]);
+		hit[i / 32] |= (uint32_t)inside << (i % 32);
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline int Intersection::TriangleAVX(const __m256* origin, const __m256* direction,
+	const __m256* a, const __m256* b, const __m256* c, __m256 t_max, __m256& t, __m256& u, __m256& v) {
+	// Same operations in the same order as RayTriangle.
+	const __m256 e1x = _mm256_sub_ps(b[0], a[0]), e1y = _mm256_sub_ps(b[1], a[1]), e1z = _mm256_sub_ps(b[2], a[2]);
+	const __m256 e2x = _mm256_sub_ps(c[0], a[0]), e2y = _mm256_sub_ps(c[1], a[1]), e2z = _mm256_sub_ps(c[2], a[2]);
+	const __m256 px = _mm256_sub_ps(_mm256_mul_ps(direction[1], e2z), _mm256_mul_ps(direction[2], e2y));
+	const __m256 py = _mm256_sub_ps(_mm256_mul_ps(direction[2], e2x), _mm256_mul_ps(direction[0], e2z));
+	const __m256 pz = _mm256_sub_ps(_mm256_mul_ps(direction[0], e2y), _mm256_mul_ps(direction[1], e2x));
+	const __m256 det = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+	const __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), det);
+	const __m256 sx = _mm256_sub_ps(origin[0], a[0]), sy = _mm256_sub_ps(origin[1], a[1]), sz = _mm256_sub_ps(origin[2], a[2]);
+	const __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+	const __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+	const __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+	u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inverse);
+	v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(direction[0], qx), _mm256_mul_ps(direction[1], qy)),
+		_mm256_mul_ps(direction[2], qz)), inverse);
+	t = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inverse);
+	const __m256 zero = _mm256_setzero_ps();
+	__m256 inside = _mm256_cmp_ps(det, zero, _CMP_NEQ_OQ);
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(u, zero, _CMP_GE_OQ));
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(v, zero, _CMP_GE_OQ));
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(u, v), _mm256_set1_ps(1.0f), _CMP_LE_OQ));
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(t, zero, _CMP_GE_OQ));
+	inside = _mm256_and_ps(inside, _mm256_cmp_ps(t, t_max, _CMP_LE_OQ));
+	return _mm256_movemask_ps(inside);
+}
+
+MATH_TARGET_AVX inline int Intersection::BoxAVX(const __m256* origin, const __m256* inverse,
+	const __m256* min, const __m256* max, __m256 t_max, __m256& t) {
+	// RayBox, with AABB3::Min and Max as minps and maxps.
+	__m256 enter = _mm256_setzero_ps();
+	__m256 exit = t_max;
+	for (int axis = 0; axis < 3; axis++) {
+		const __m256 near_t = _mm256_mul_ps(_mm256_sub_ps(min[axis], origin[axis]), inverse[axis]);
+		const __m256 far_t = _mm256_mul_ps(_mm256_sub_ps(max[axis], origin[axis]), inverse[axis]);
+		enter = _mm256_max_ps(_mm256_min_ps(near_t, far_t), enter);
+		exit = _mm256_min_ps(_mm256_max_ps(near_t, far_t), exit);
+	}
+	t = enter;
+	return _mm256_movemask_ps(_mm256_cmp_ps(enter, exit, _CMP_NGT_UQ));
+}
+
+MATH_TARGET_AVX inline void Intersection::RayTrianglesAVX(const Vector3& origin, const Vector3& direction,
+	const Vector3Stream& a, const Vector3Stream& b, const Vector3Stream& c, float t_max,
+	size_t count, uint32_t* hit, float* t, float* u, float* v) {
+	const __m256 o[3] = { _mm256_set1_ps(origin.x), _mm256_set1_ps(origin.y), _mm256_set1_ps(origin.z) };
+	const __m256 d[3] = { _mm256_set1_ps(direction.x), _mm256_set1_ps(direction.y), _mm256_set1_ps(direction.z) };
+	const __m256 limit = _mm256_set1_ps(t_max);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 va[3] = { _mm256_load_ps(a.x + i), _mm256_load_ps(a.y + i), _mm256_load_ps(a.z + i) };
+		const __m256 vb[3] = { _mm256_load_ps(b.x + i), _mm256_load_ps(b.y + i), _mm256_load_ps(b.z + i) };
+		const __m256 vc[3] = { _mm256_load_ps(c.x + i), _mm256_load_ps(c.y + i), _mm256_load_ps(c.z + i) };
+		__m256 vt, vu, vv;
+		const int mask = TriangleAVX(o, d, va, vb, vc, limit, vt, vu, vv);
+		_mm256_storeu_ps(t + i, vt);
+		_mm256_storeu_ps(u + i, vu);
+		_mm256_storeu_ps(v + i, vv);
+		hit[i / 32] |= (uint32_t)mask << (i % 32);
+	}
+}
+
+MATH_TARGET_AVX inline void Intersection::RaysTriangleAVX(const Vector3Stream& origins, const Vector3Stream& directions,
+	const Vector3& a, const Vector3& b, const Vector3& c, const float* t_max,
+	size_t count, uint32_t* hit, float* t, float* u, float* v) {
+	const __m256 va[3] = { _mm256_set1_ps(a.x), _mm256_set1_ps(a.y), _mm256_set1_ps(a.z) };
+	const __m256 vb[3] = { _mm256_set1_ps(b.x), _mm256_set1_ps(b.y), _mm256_set1_ps(b.z) };
+	const __m256 vc[3] = { _mm256_set1_ps(c.x), _mm256_set1_ps(c.y), _mm256_set1_ps(c.z) };
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 o[3] = { _mm256_load_ps(origins.x + i), _mm256_load_ps(origins.y + i), _mm256_load_ps(origins.z + i) };
+		const __m256 d[3] = { _mm256_load_ps(directions.x + i), _mm256_load_ps(directions.y + i), _mm256_load_ps(directions.z + i) };
+		__m256 vt, vu, vv;
+		const int mask = TriangleAVX(o, d, va, vb, vc, _mm256_loadu_ps(t_max + i), vt, vu, vv);
+		_mm256_storeu_ps(t + i, vt);
+		_mm256_storeu_ps(u + i, vu);
+		_mm256_storeu_ps(v + i, vv);
+		hit[i / 32] |= (uint32_t)mask << (i % 32);
+	}
+}
+
+MATH_TARGET_AVX inline void Intersection::RayBoxesAVX(const Vector3& origin, const Vector3& direction, const AABB3Stream& boxes,
+	float t_max, size_t count, uint32_t* hit, float* t) {
+	const __m256 o[3] = { _mm256_set1_ps(origin.x), _mm256_set1_ps(origin.y), _mm256_set1_ps(origin.z) };
+	const __m256 inverse[3] = {
+		_mm256_set1_ps(1.0f / direction.x), _mm256_set1_ps(1.0f / direction.y), _mm256_set1_ps(1.0f / direction.z)
+	};
+	const __m256 limit = _mm256_set1_ps(t_max);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 low[3] = { _mm256_load_ps(boxes.min.x + i), _mm256_load_ps(boxes.min.y + i), _mm256_load_ps(boxes.min.z + i) };
+		const __m256 high[3] = { _mm256_load_ps(boxes.max.x + i), _mm256_load_ps(boxes.max.y + i), _mm256_load_ps(boxes.max.z + i) };
+		__m256 vt;
+		const int mask = BoxAVX(o, inverse, low, high, limit, vt);
+		_mm256_storeu_ps(t + i, vt);
+		hit[i / 32] |= (uint32_t)mask << (i % 32);
+	}
+}
+
+MATH_TARGET_AVX inline void Intersection::RaysBoxAVX(const Vector3Stream& origins, const Vector3Stream& directions, const AABB3& box,
+	const float* t_max, size_t count, uint32_t* hit, float* t) {
+	const __m256 low[3] = { _mm256_set1_ps(box.min.x), _mm256_set1_ps(box.min.y), _mm256_set1_ps(box.min.z) };
+	const __m256 high[3] = { _mm256_set1_ps(box.max.x), _mm256_set1_ps(box.max.y), _mm256_set1_ps(box.max.z) };
+	const __m256 one = _mm256_set1_ps(1.0f);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 o[3] = { _mm256_load_ps(origins.x + i), _mm256_load_ps(origins.y + i), _mm256_load_ps(origins.z + i) };
+		const __m256 inverse[3] = {
+			_mm256_div_ps(one, _mm256_load_ps(directions.x + i)),
+			_mm256_div_ps(one, _mm256_load_ps(directions.y + i)),
+			_mm256_div_ps(one, _mm256_load_ps(directions.z + i))
+		};
+		__m256 vt;
+		const int mask = BoxAVX(o, inverse, low, high, _mm256_loadu_ps(t_max + i), vt);
+		_mm256_storeu_ps(t + i, vt);
+		hit[i / 32] |= (uint32_t)mask << (i % 32);
+	}
+}
+#endif
+
+#endif
@@ -1,20 +1,201 @@
 #ifndef __MATHUTILS_H__
 #define __MATHUTILS_H__ 1
 
+#include <stddef.h>
+#include "simd.h"
+
+// Scalar helpers and their array forms over float spans. The scalar forms
+// are branchless: the clamps are maxss and minss on x86 and the same
+// selects elsewhere. The array forms give the same bits 8 floats at a time
+// with AVX, and their out may be any of the inputs.
 class MathUtils {
 	public:
-		static float MathUtils::Clamp(float value, float minVal, float maxVal);
+		// value limited to [minVal, maxVal]; a NaN value gives minVal.
+		static constexpr float Clamp(float value, float minVal, float maxVal);
+		// Clamp(value, 0, 1).
+		static constexpr float Saturate(float value);
+		// a + (b - a) * t, with t saturated first.
+		static constexpr float Lerp(float a, float b, float t);
+		static constexpr float LerpUnclamped(float a, float b, float t);
+		// Hermite 3t^2 - 2t^3 of t = Saturate((x - edge0) / (edge1 - edge0)).
+		// edge0 must differ from edge1.
+		static constexpr float SmoothStep(float edge0, float edge1, float x);
+		// value mapped linearly from [from_min, from_max] to [to_min, to_max],
+		// not clamped. from_min must differ from from_max.
+		static constexpr float Remap(float value, float from_min, float from_max, float to_min, float to_max);
+
+		static void Clamp(const float* values, float minVal, float maxVal, float* out, size_t n);
+		static void Saturate(const float* values, float* out, size_t n);
+		// out[i] = Lerp(a[i], b[i], t[i]).
+		static void Lerp(const float* a, const float* b, const float* t, float* out, size_t n);
+		static void SmoothStep(float edge0, float edge1, const float* x, float* out, size_t n);
+		static void Remap(const float* values, float from_min, float from_max, float to_min, float to_max,
+			float* out, size_t n);
 
 	private:
 		MathUtils();
 		MathUtils(const MathUtils& copy);
 		~MathUtils();
+
+		// The scale of Remap, computed once for a whole array.
+		static constexpr float RemapScale(float from_min, float from_max, float to_min, float to_max);
+
+#ifdef MATH_SIMD_X86
+		// Whole blocks of 8 only; count is a multiple of 8.
+		MATH_TARGET_AVX static __m256 ClampAVX(__m256 value, __m256 low, __m256 high);
+		MATH_TARGET_AVX static void ClampAVX(const float* values, float minVal, float maxVal, float* out, size_t count);
+		MATH_TARGET_AVX static void LerpAVX(const float* a, const float* b, const float* t, float* out, size_t count);
+		MATH_TARGET_AVX static void SmoothStepAVX(float edge0, float edge1, const float* x, float* out, size_t count);
+		MATH_TARGET_AVX static void RemapAVX(const float* values, float from_min, float scale, float to_min,
+			float* out, size_t count);
+#endif
 };
 inline MathUtils::MathUtils() {}
 inline MathUtils::MathUtils(const MathUtils& copy) {}
 inline MathUtils::~MathUtils(){}
 
-inline float MathUtils::Clamp(float value, float minVal, float maxVal) {
-	return 0.0f;
+constexpr float MathUtils::Clamp(float value, float minVal, float maxVal) {
+#ifdef MATH_SIMD_X86
+	// GCC turns the selects below into a jump when a limit is a constant,
+	// as in Saturate, so run time calls use the instructions directly.
+	if (!MATH_CONSTANT_EVALUATED()) {
+		return _mm_cvtss_f32(_mm_min_ss(_mm_max_ss(_mm_set_ss(value), _mm_set_ss(minVal)), _mm_set_ss(maxVal)));
+	}
+#endif
+	// maxss then minss: each returns its second operand when unordered.
+	const float low = value > minVal ? value : minVal;
+	return low < maxVal ? low : maxVal;
+}
+
+constexpr float MathUtils::Saturate(float value) {
+	return Clamp(value, 0.0f, 1.0f);
+}
+
+constexpr float MathUtils::Lerp(float a, float b, float t) {
+	return LerpUnclamped(a, b, Saturate(t));
+}
+
+constexpr float MathUtils::LerpUnclamped(float a, float b, float t) {
+	return a + (b - a) * t;
 }
-#endif
\ No newline at end of file
+
+constexpr float MathUtils::SmoothStep(float edge0, float edge1, float x) {
+	const float t = Saturate((x - edge0) / (edge1 - edge0));
+	return t * t * (3.0f - 2.0f * t);
+}
+
+constexpr float MathUtils::RemapScale(float from_min, float from_max, float to_min, float to_max) {
+	return (to_max - to_min) / (from_max - from_min);
+}
+
+constexpr float MathUtils::Remap(float value, float from_min, float from_max, float to_min, float to_max) {
+	return to_min + (value - from_min) * RemapScale(from_min, from_max, to_min, to_max);
+}
+
+inline void MathUtils::Clamp(const float* values, float minVal, float maxVal, float* out, size_t n) {
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / 8 * 8;
+		ClampAVX(values, minVal, maxVal, out, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = Clamp(values[i], minVal, maxVal);
+	}
+}
+
+inline void MathUtils::Saturate(const float* values, float* out, size_t n) {
+	Clamp(values, 0.0f, 1.0f, out, n);
+}
+
+inline void MathUtils::Lerp(const float* a, const float* b, const float* t, float* out, size_t n) {
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / 8 * 8;
+		LerpAVX(a, b, t, out, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = Lerp(a[i], b[i], t[i]);
+	}
+}
+
+inline void MathUtils::SmoothStep(float edge0, float edge1, const float* x, float* out, size_t n) {
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / 8 * 8;
+		SmoothStepAVX(edge0, edge1, x, out, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = SmoothStep(edge0, edge1, x[i]);
+	}
+}
+
+inline void MathUtils::Remap(const float* values, float from_min, float from_max, float to_min, float to_max,
+	float* out, size_t n) {
+	const float scale = RemapScale(from_min, from_max, to_min, to_max);
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = n / 8 * 8;
+		RemapAVX(values, from_min, scale, to_min, out, i);
+	}
+#endif
+	for (; i < n; i++) {
+		out[i] = to_min + (values[i] - from_min) * scale;
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline __m256 MathUtils::ClampAVX(__m256 value, __m256 low, __m256 high) {
+	// Same operand order as the scalar selects, so NaN handling matches.
+	return _mm256_min_ps(_mm256_max_ps(value, low), high);
+}
+
+MATH_TARGET_AVX inline void MathUtils::ClampAVX(const float* values, float minVal, float maxVal, float* out, size_t count) {
+	const __m256 low = _mm256_set1_ps(minVal);
+	const __m256 high = _mm256_set1_ps(maxVal);
+	for (size_t i = 0; i < count; i += 8) {
+		_mm256_storeu_ps(out + i, ClampAVX(_mm256_loadu_ps(values + i), low, high));
+	}
+}
+
+MATH_TARGET_AVX inline void MathUtils::LerpAVX(const float* a, const float* b, const float* t, float* out, size_t count) {
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	for (size_t i = 0; i < count; i += 8) {
+		const __m256 va = _mm256_loadu_ps(a + i);
+		const __m256 vt = ClampAVX(_mm256_loadu_ps(t + i), zero, one);
+		_mm256_storeu_ps(out + i, _mm256_add_ps(va, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(b + i), va), vt)));
+	}
+}
+
+MATH_TARGET_AVX inline void MathUtils::SmoothStepAVX(float edge0, float edge1, const float* x, float* out, size_t count) {
+	const __m256 start = _mm256_set1_ps(edge0);
+	const __m256 width = _mm256_set1_ps(edge1 - edge0);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 three = _mm256_set1_ps(3.0f);
+	for (size_t i = 0; i < count; i += 8) {
+		const __m256 t = ClampAVX(_mm256_div_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), start), width), zero, one);
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_mul_ps(t, t), _mm256_sub_ps(three, _mm256_mul_ps(two, t))));
+	}
+}
+
+MATH_TARGET_AVX inline void MathUtils::RemapAVX(const float* values, float from_min, float scale, float to_min,
+	float* out, size_t count) {
+	const __m256 start = _mm256_set1_ps(from_min);
+	const __m256 vscale = _mm256_set1_ps(scale);
+	const __m256 offset = _mm256_set1_ps(to_min);
+	for (size_t i = 0; i < count; i += 8) {
+		_mm256_storeu_ps(out + i, _mm256_add_ps(offset, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(values + i), start), vscale)));
+	}
+}
+#endif
+
+#endif
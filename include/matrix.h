@@ -0,0 +1,472 @@
+#ifndef __MATRIX_H__
+#define __MATRIX_H__ 1
+
+#include <assert.h>
+#include <math.h>
+#include <stddef.h>
+#include <initializer_list>
+#include <type_traits>
+#include "elementwise.h"
+#include "vector.h"
+#include "matrix_2.h"
+#include "matrix_3.h"
+#include "matrix_4.h"
+#include "simd.h"
+
+// R lines of C colums of T, row-major like Matrix3x3 and Matix4x4. Vectors
+// are rows multiplied on the left, v * M. Matrix<4, 4, float> runs Multiply
+// and the batch Transform on the Matix4x4 SIMD kernels, with their precision
+// contract; every other shape uses the scalar loops, which for float give
+// the bits of the fixed-size types. The elementwise operators are the ones
+// of elementwise.h, shared with the fixed-size types.
+template<int R, int C, class T>
+class Matrix {
+public:
+	static_assert(R > 0 && C > 0, "Matrix needs at least one element");
+
+	typedef T Element;
+	typedef typename Vector<C, T>::Scalar Scalar;
+
+	Matrix();
+	constexpr explicit Matrix(Scalar value);
+	constexpr explicit Matrix(const T* values);
+	// Exactly R * C values, line by line.
+	constexpr Matrix(std::initializer_list<Scalar> values);
+	template<class U>
+	constexpr explicit Matrix(const Matrix<R, C, U>& other);
+
+	static constexpr Matrix Identity();
+
+	template<int K>
+	constexpr Matrix<R, K, T> Multiply(const Matrix<C, K, T>& other) const;
+	constexpr Matrix<C, R, T> Transpose() const;
+
+	constexpr Vector<C, T> GetLine(int line) const;
+	constexpr Vector<R, T> GetColum(int colum) const;
+
+	constexpr Vector<C, T> Transform(const Vector<R, T>& vector) const;
+	// in and out may be the same array when R == C.
+	void Transform(const Vector<R, T>* in, Vector<C, T>* out, size_t n) const;
+
+	constexpr Matrix operator+(const Matrix& other) const;
+	constexpr Matrix& operator+=(const Matrix& other);
+	constexpr Matrix operator+(Scalar value) const;
+	constexpr Matrix& operator+=(Scalar value);
+	constexpr Matrix operator-(const Matrix& other) const;
+	constexpr Matrix& operator-=(const Matrix& other);
+	constexpr Matrix operator-(Scalar value) const;
+	constexpr Matrix& operator-=(Scalar value);
+	constexpr Matrix operator*(Scalar value) const;
+	constexpr Matrix& operator*=(Scalar value);
+	constexpr Matrix operator/(Scalar value) const;
+	constexpr Matrix& operator/=(Scalar value);
+	constexpr bool operator==(const Matrix& other) const;
+	constexpr bool operator!=(const Matrix& other) const;
+
+	T m[R * C];
+};
+
+static_assert(std::is_trivially_copyable<Matrix<4, 4, float> >::value, "Matrix must be trivially copyable");
+static_assert(std::is_standard_layout<Matrix<4, 4, float> >::value, "Matrix must be standard layout");
+static_assert(sizeof(Matrix<4, 4, float>) == sizeof(Matix4x4), "Matrix<4, 4, float> must match Matix4x4");
+
+template<int R, int C, class T>
+struct ElementTraits<Matrix<R, C, T> > {
+	typedef T Element;
+	typedef typename Matrix<R, C, T>::Scalar Scalar;
+	static const int kSize = R * C;
+	static const bool kPacked = std::is_same<T, float>::value;
+	static constexpr Scalar Get(const Matrix<R, C, T>& value, int i) { return Scalar(value.m[i]); }
+	static constexpr Matrix<R, C, T> Make(const Scalar* values) {
+		Matrix<R, C, T> out(Scalar(0));
+		for (int i = 0; i < R * C; i++) {
+			out.m[i] = T(values[i]);
+		}
+		return out;
+	}
+};
+
+// Double precision transforms, laid out like Matix4x4.
+typedef Matrix<4, 4, double> Matrix4d;
+
+// The Matix4x4 transform builders and inverses for Matrix4d, with the same
+// layout and operation order, so world transforms can be composed and
+// inverted in double before CameraRelative::Rebase rounds them to float.
+// The angles go through the libm double sin and cos.
+constexpr Matrix4d Translate(const Vector3d& distance);
+constexpr Matrix4d Scale(const Vector3d& scale);
+// Translate * RotateX * RotateY * RotateZ * Scale, as Matix4x4::GetTransform.
+Matrix4d GetTransform(const Vector3d& translate, const Vector3d& scale,
+	double rotateX, double rotateY, double rotateZ);
+// For matrices whose last colum is (0, 0, 0, 1). GetInverseAffine returns
+// false and leaves out untouched when the upper 3x3 is singular; the rigid
+// form needs it to be a pure rotation. out may be m.
+constexpr bool GetInverseAffine(const Matrix4d& m, Matrix4d& out);
+constexpr void GetInverseRigid(const Matrix4d& m, Matrix4d& out);
+constexpr Vector3d TransformPoint(const Matrix4d& m, const Vector3d& point);
+
+template<int R, int C, class T>
+inline Matrix<R, C, T>::Matrix() {}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>::Matrix(Scalar value) : m() {
+	for (int i = 0; i < R * C; i++) {
+		m[i] = T(value);
+	}
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>::Matrix(const T* values) : m() {
+	for (int i = 0; i < R * C; i++) {
+		m[i] = values[i];
+	}
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>::Matrix(std::initializer_list<Scalar> values) : m() {
+	assert(values.size() == R * C && "Wrong number of values");
+	int i = 0;
+	for (Scalar value : values) {
+		m[i++] = T(value);
+	}
+}
+
+template<int R, int C, class T>
+template<class U>
+constexpr Matrix<R, C, T>::Matrix(const Matrix<R, C, U>& other) : m() {
+	for (int i = 0; i < R * C; i++) {
+		m[i] = T(typename Matrix<R, C, U>::Scalar(other.m[i]));
+	}
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::Identity() {
+	static_assert(R == C, "Identity needs a square matrix");
+	Matrix out(Scalar(0));
+	for (int i = 0; i < R; i++) {
+		out.m[i * C + i] = T(Scalar(1));
+	}
+	return out;
+}
+
+template<int R, int C, class T>
+template<int K>
+constexpr Matrix<R, K, T> Matrix<R, C, T>::Multiply(const Matrix<C, K, T>& other) const {
+#ifdef MATH_SIMD_X86
+	if constexpr (R == 4 && C == 4 && K == 4 && std::is_same<T, float>::value) {
+		if (!MATH_CONSTANT_EVALUATED()) {
+			Matrix<R, K, T> out;
+			switch (Simd::Active()) {
+				case Simd::kAVX2:
+					Matix4x4::MultiplyAVX2(m, other.m, out.m);
+					return out;
+				case Simd::kSSE41:
+					Matix4x4::MultiplySSE41(m, other.m, out.m);
+					return out;
+				default:
+					Matix4x4::MultiplyScalar(m, other.m, out.m);
+					return out;
+			}
+		}
+	}
+#endif
+	Matrix<R, K, T> out(Scalar(0));
+	for (int i = 0; i < R; i++) {
+		for (int j = 0; j < K; j++) {
+			Scalar sum = Scalar(m[i * C]) * Scalar(other.m[j]);
+			for (int k = 1; k < C; k++) {
+				sum = sum + Scalar(m[i * C + k]) * Scalar(other.m[k * K + j]);
+			}
+			out.m[i * K + j] = T(sum);
+		}
+	}
+	return out;
+}
+
+template<int R, int C, class T>
+constexpr Matrix<C, R, T> Matrix<R, C, T>::Transpose() const {
+	Matrix<C, R, T> out(Scalar(0));
+	for (int i = 0; i < R; i++) {
+		for (int j = 0; j < C; j++) {
+			out.m[j * R + i] = m[i * C + j];
+		}
+	}
+	return out;
+}
+
+template<int R, int C, class T>
+constexpr Vector<C, T> Matrix<R, C, T>::GetLine(int line) const {
+	assert(line >= 0 && line < R && "Line out of range");
+	return Vector<C, T>(m + line * C);
+}
+
+template<int R, int C, class T>
+constexpr Vector<R, T> Matrix<R, C, T>::GetColum(int colum) const {
+	assert(colum >= 0 && colum < C && "Colum out of range");
+	Vector<R, T> out(Scalar(0));
+	for (int i = 0; i < R; i++) {
+		out.v[i] = m[i * C + colum];
+	}
+	return out;
+}
+
+template<int R, int C, class T>
+constexpr Vector<C, T> Matrix<R, C, T>::Transform(const Vector<R, T>& vector) const {
+	Vector<C, T> out(Scalar(0));
+	for (int j = 0; j < C; j++) {
+		Scalar sum = Scalar(vector.v[0]) * Scalar(m[j]);
+		for (int i = 1; i < R; i++) {
+			sum = sum + Scalar(vector.v[i]) * Scalar(m[i * C + j]);
+		}
+		out.v[j] = T(sum);
+	}
+	return out;
+}
+
+template<int R, int C, class T>
+inline void Matrix<R, C, T>::Transform(const Vector<R, T>* in, Vector<C, T>* out, size_t n) const {
+#ifdef MATH_SIMD_X86
+	if constexpr (R == 4 && C == 4 && std::is_same<T, float>::value) {
+		switch (Simd::Active()) {
+			case Simd::kAVX2:
+				Matix4x4::TransformVector4AVX2(m, in->v, out->v, n);
+				return;
+			case Simd::kSSE41:
+				Matix4x4::TransformVector4SSE41(m, in->v, out->v, n);
+				return;
+			default:
+				Matix4x4::TransformVector4Scalar(m, in->v, out->v, n);
+				return;
+		}
+	}
+#endif
+	for (size_t i = 0; i < n; i++) {
+		out[i] = Transform(in[i]);
+	}
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::operator+(const Matrix& other) const {
+	return Elementwise<Matrix<R, C, T> >::Add(*this, other);
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>& Matrix<R, C, T>::operator+=(const Matrix& other) {
+	*this = Elementwise<Matrix<R, C, T> >::Add(*this, other);
+	return *this;
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::operator+(Scalar value) const {
+	return Elementwise<Matrix<R, C, T> >::Add(*this, value);
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>& Matrix<R, C, T>::operator+=(Scalar value) {
+	*this = Elementwise<Matrix<R, C, T> >::Add(*this, value);
+	return *this;
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::operator-(const Matrix& other) const {
+	return Elementwise<Matrix<R, C, T> >::Subtract(*this, other);
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>& Matrix<R, C, T>::operator-=(const Matrix& other) {
+	*this = Elementwise<Matrix<R, C, T> >::Subtract(*this, other);
+	return *this;
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::operator-(Scalar value) const {
+	return Elementwise<Matrix<R, C, T> >::Subtract(*this, value);
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>& Matrix<R, C, T>::operator-=(Scalar value) {
+	*this = Elementwise<Matrix<R, C, T> >::Subtract(*this, value);
+	return *this;
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::operator*(Scalar value) const {
+	return Elementwise<Matrix<R, C, T> >::Multiply(*this, value);
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>& Matrix<R, C, T>::operator*=(Scalar value) {
+	*this = Elementwise<Matrix<R, C, T> >::Multiply(*this, value);
+	return *this;
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T> Matrix<R, C, T>::operator/(Scalar value) const {
+	return Elementwise<Matrix<R, C, T> >::Divide(*this, value);
+}
+
+template<int R, int C, class T>
+constexpr Matrix<R, C, T>& Matrix<R, C, T>::operator/=(Scalar value) {
+	*this = Elementwise<Matrix<R, C, T> >::Divide(*this, value);
+	return *this;
+}
+
+template<int R, int C, class T>
+constexpr bool Matrix<R, C, T>::operator==(const Matrix& other) const {
+	return Elementwise<Matrix<R, C, T> >::Equal(*this, other);
+}
+
+template<int R, int C, class T>
+constexpr bool Matrix<R, C, T>::operator!=(const Matrix& other) const {
+	return !(*this == other);
+}
+
+template<int R, int C, class T>
+constexpr Vector<C, T> operator*(const Vector<R, T>& vector, const Matrix<R, C, T>& matrix) {
+	return matrix.Transform(vector);
+}
+
+template<int R, int C, int K, class T>
+constexpr Matrix<R, K, T> operator*(const Matrix<R, C, T>& a, const Matrix<C, K, T>& b) {
+	return a.Multiply(b);
+}
+
+constexpr Matrix4d Translate(const Vector3d& distance) {
+	Matrix4d out = Matrix4d::Identity();
+	out.m[12] = distance.v[0];
+	out.m[13] = distance.v[1];
+	out.m[14] = distance.v[2];
+	return out;
+}
+
+constexpr Matrix4d Scale(const Vector3d& scale) {
+	Matrix4d out = Matrix4d::Identity();
+	out.m[0] = scale.v[0];
+	out.m[5] = scale.v[1];
+	out.m[10] = scale.v[2];
+	return out;
+}
+
+inline Matrix4d GetTransform(const Vector3d& translate, const Vector3d& scale,
+	double rotateX, double rotateY, double rotateZ) {
+	// Same terms as Matix4x4::ComposeTransform.
+	const double sin_x = sin(rotateX), cos_x = cos(rotateX);
+	const double sin_y = sin(rotateY), cos_y = cos(rotateY);
+	const double sin_z = sin(rotateZ), cos_z = cos(rotateZ);
+	const double sx_sy = sin_x * sin_y;
+	const double cx_sy = cos_x * sin_y;
+	const double r00 = cos_y * cos_z * scale.v[0];
+	const double r01 = -cos_y * sin_z * scale.v[1];
+	const double r02 = sin_y * scale.v[2];
+	const double r10 = (sx_sy * cos_z + cos_x * sin_z) * scale.v[0];
+	const double r11 = (-sx_sy * sin_z + cos_x * cos_z) * scale.v[1];
+	const double r12 = -sin_x * cos_y * scale.v[2];
+	const double r20 = (-cx_sy * cos_z + sin_x * sin_z) * scale.v[0];
+	const double r21 = (cx_sy * sin_z + sin_x * cos_z) * scale.v[1];
+	const double r22 = cos_x * cos_y * scale.v[2];
+	const double tx = translate.v[0], ty = translate.v[1], tz = translate.v[2];
+
+	return Matrix4d({
+		r00, r01, r02, 0.0,
+		r10, r11, r12, 0.0,
+		r20, r21, r22, 0.0,
+		tx * r00 + ty * r10 + tz * r20,
+		tx * r01 + ty * r11 + tz * r21,
+		tx * r02 + ty * r12 + tz * r22, 1.0 });
+}
+
+constexpr bool GetInverseAffine(const Matrix4d& m, Matrix4d& out) {
+	//|inv(R)     0|
+	//|-t*inv(R)  1|
+	const double r00 = m.m[0], r01 = m.m[1], r02 = m.m[2];
+	const double r10 = m.m[4], r11 = m.m[5], r12 = m.m[6];
+	const double r20 = m.m[8], r21 = m.m[9], r22 = m.m[10];
+	const double tx = m.m[12], ty = m.m[13], tz = m.m[14];
+
+	const double c00 = r11 * r22 - r21 * r12;
+	const double c01 = r21 * r02 - r01 * r22;
+	const double c02 = r01 * r12 - r11 * r02;
+	const double determinant = r00 * c00 + r10 * c01 + r20 * c02;
+	if (determinant == 0.0) {
+		return false;
+	}
+	const double inverse = 1.0 / determinant;
+
+	const double i00 = c00 * inverse;
+	const double i01 = c01 * inverse;
+	const double i02 = c02 * inverse;
+	const double i10 = (r20 * r12 - r10 * r22) * inverse;
+	const double i11 = (r00 * r22 - r20 * r02) * inverse;
+	const double i12 = (r10 * r02 - r00 * r12) * inverse;
+	const double i20 = (r10 * r21 - r20 * r11) * inverse;
+	const double i21 = (r20 * r01 - r00 * r21) * inverse;
+	const double i22 = (r00 * r11 - r10 * r01) * inverse;
+
+	out.m[0] = i00; out.m[1] = i01; out.m[2] = i02; out.m[3] = 0.0;
+	out.m[4] = i10; out.m[5] = i11; out.m[6] = i12; out.m[7] = 0.0;
+	out.m[8] = i20; out.m[9] = i21; out.m[10] = i22; out.m[11] = 0.0;
+	out.m[12] = -(tx * i00 + ty * i10 + tz * i20);
+	out.m[13] = -(tx * i01 + ty * i11 + tz * i21);
+	out.m[14] = -(tx * i02 + ty * i12 + tz * i22);
+	out.m[15] = 1.0;
+	return true;
+}
+
+constexpr void GetInverseRigid(const Matrix4d& m, Matrix4d& out) {
+	//|R  0|        |R^T      0|
+	//|t  1|  --->  |-t*R^T   1|
+	const double r00 = m.m[0], r01 = m.m[1], r02 = m.m[2];
+	const double r10 = m.m[4], r11 = m.m[5], r12 = m.m[6];
+	const double r20 = m.m[8], r21 = m.m[9], r22 = m.m[10];
+	const double tx = m.m[12], ty = m.m[13], tz = m.m[14];
+
+	out.m[0] = r00; out.m[1] = r10; out.m[2] = r20; out.m[3] = 0.0;
+	out.m[4] = r01; out.m[5] = r11; out.m[6] = r21; out.m[7] = 0.0;
+	out.m[8] = r02; out.m[9] = r12; out.m[10] = r22; out.m[11] = 0.0;
+	out.m[12] = -(tx * r00 + ty * r01 + tz * r02);
+	out.m[13] = -(tx * r10 + ty * r11 + tz * r12);
+	out.m[14] = -(tx * r20 + ty * r21 + tz * r22);
+	out.m[15] = 1.0;
+}
+
+constexpr Vector3d TransformPoint(const Matrix4d& m, const Vector3d& point) {
+	const double x = point.v[0], y = point.v[1], z = point.v[2];
+	return Vector3d({
+		x * m.m[0] + y * m.m[4] + z * m.m[8] + m.m[12],
+		x * m.m[1] + y * m.m[5] + z * m.m[9] + m.m[13],
+		x * m.m[2] + y * m.m[6] + z * m.m[10] + m.m[14] });
+}
+
+inline Matrix<2, 2, float> ToMatrix(const Matrix2x2& value) {
+	return Matrix<2, 2, float>(value.m);
+}
+
+constexpr Matrix<3, 3, float> ToMatrix(const Matrix3x3& value) {
+	return Matrix<3, 3, float>(value.m);
+}
+
+constexpr Matrix<4, 4, float> ToMatrix(const Matix4x4& value) {
+	return Matrix<4, 4, float>(value.m);
+}
+
+inline Matrix2x2 ToMatrix2x2(const Matrix<2, 2, float>& value) {
+	Matrix2x2 out;
+	for (int i = 0; i < 4; i++) {
+		out.m[i] = value.m[i];
+	}
+	return out;
+}
+
+constexpr Matrix3x3 ToMatrix3x3(const Matrix<3, 3, float>& value) {
+	Matrix3x3 out(0.0f);
+	for (int i = 0; i < 9; i++) {
+		out.m[i] = value.m[i];
+	}
+	return out;
+}
+
+constexpr Matix4x4 ToMatix4x4(const Matrix<4, 4, float>& value) {
+	return Matix4x4(value.m);
+}
+
+#endif
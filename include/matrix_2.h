@@ -3,238 +3,449 @@
 #ifndef __MATRIX2_H__
 #define __MATRIX2_H__ 1
 
+#include <stddef.h>
 #include "vector_2.h"
-
+#include "simd.h"
+#include <type_traits>
+#include "elementwise.h"
+
+// A 2x2 matrix is 4 floats, exactly one SSE register, so the batch kernels
+// keep one matrix per 128-bit register and two per AVX register, 4 at a
+// time. Every kernel gives the same bits as the scalar code. The members
+// stay scalar: for one matrix the dispatch costs more than the arithmetic.
 class Matrix2x2 {
 public:
 
 	Matrix2x2();
-	Matrix2x2(float a[4]);
-	Matrix2x2(float value);
-	Matrix2x2(const Vector2& a, const Vector2& b); 
-	Matrix2x2(const Matrix2x2& copy);
-	~Matrix2x2();
-	Matrix2x2 Identity() const;
-	Matrix2x2 Multiply(const Matrix2x2& other) const;
-	float Determinant() const;
-	Matrix2x2 Adjoint() const;
-	Vector2 GetLine(int line) const;
-	Vector2 GetColum(int line) const;
-
-	Matrix2x2 Inverse() const;
-	Matrix2x2 Transpose() const;
-
-	inline Matrix2x2 operator+(const Matrix2x2& other) const;
-	inline void operator+=(const Matrix2x2& other);
-	inline Matrix2x2 operator+(float value) const;
-	inline void operator+=(float value);
-	inline Matrix2x2 operator-(const Matrix2x2& other) const;
-	inline void operator-=(const Matrix2x2& other);
-	inline Matrix2x2 operator-(float value) const;
-	inline void operator-=(float value);
-
-	inline Matrix2x2 operator*(float value) const;
-	inline void operator*=(float value);
-	inline Matrix2x2 operator/(float value) const;
-	inline void operator/=(float value);
-
-	bool operator==(const Matrix2x2& other) const;
-	bool operator!=(const Matrix2x2& other) const;
-	inline void operator=(const Matrix2x2& other);
+	constexpr Matrix2x2(float a[4]);
+	constexpr Matrix2x2(float value);
+	constexpr Matrix2x2(const Vector2& a, const Vector2& b);
+	constexpr Matrix2x2 Identity() const;
+	constexpr Matrix2x2 Multiply(const Matrix2x2& other) const;
+	// out[i] = a[i] * b[i]. out may be a or b.
+	static void Multiply(const Matrix2x2* a, const Matrix2x2* b, Matrix2x2* out, size_t n);
+	constexpr float Determinant() const;
+	// Matrix of cofactors, like Matrix3x3::Adjoint; the inverse is its
+	// transpose over the determinant.
+	constexpr Matrix2x2 Adjoint() const;
+	constexpr Vector2 GetLine(int line) const;
+	constexpr Vector2 GetColum(int colum) const;
+
+	// A singular matrix gives infinite or NaN elements.
+	constexpr Matrix2x2 Inverse() const;
+	// out[i] = in[i].Inverse(). out may be in.
+	static void Inverse(const Matrix2x2* in, Matrix2x2* out, size_t n);
+	constexpr Matrix2x2 Transpose() const;
+
+	// Vectors are rows multiplied on the left, v * M, like Matix4x4.
+	constexpr Vector2 Transform(const Vector2& vector) const;
+	// out[i] = m[i].Transform(in[i]). out may be in.
+	static void Transform(const Matrix2x2* m, const Vector2* in, Vector2* out, size_t n);
+
+	// Batch kernels on packed float[4] matrices and xy vectors.
+	static constexpr void MultiplyScalar(const float* a, const float* b, float* out, size_t n);
+	static constexpr void InverseScalar(const float* in, float* out, size_t n);
+	static constexpr void TransformScalar(const float* m, const float* in, float* out, size_t n);
+#ifdef MATH_SIMD_X86
+	MATH_TARGET_SSE41 static void MultiplySSE41(const float* a, const float* b, float* out, size_t n);
+	MATH_TARGET_SSE41 static void InverseSSE41(const float* in, float* out, size_t n);
+	MATH_TARGET_SSE41 static void TransformSSE41(const float* m, const float* in, float* out, size_t n);
+	// Whole blocks of 4 only; count is a multiple of 4.
+	MATH_TARGET_AVX static void MultiplyAVX(const float* a, const float* b, float* out, size_t count);
+	MATH_TARGET_AVX static void InverseAVX(const float* in, float* out, size_t count);
+	MATH_TARGET_AVX static void TransformAVX(const float* m, const float* in, float* out, size_t count);
+#endif
+
+	constexpr Matrix2x2 operator+(const Matrix2x2& other) const;
+	constexpr Matrix2x2& operator+=(const Matrix2x2& other);
+	constexpr Matrix2x2 operator+(float value) const;
+	constexpr Matrix2x2& operator+=(float value);
+	constexpr Matrix2x2 operator-(const Matrix2x2& other) const;
+	constexpr Matrix2x2& operator-=(const Matrix2x2& other);
+	constexpr Matrix2x2 operator-(float value) const;
+	constexpr Matrix2x2& operator-=(float value);
+
+	constexpr Matrix2x2 operator*(float value) const;
+	constexpr Matrix2x2& operator*=(float value);
+	constexpr Matrix2x2 operator/(float value) const;
+	constexpr Matrix2x2& operator/=(float value);
+
+	constexpr bool operator==(const Matrix2x2& other) const;
+	constexpr bool operator!=(const Matrix2x2& other) const;
 
 	float m[4];
+
+private:
+#ifdef MATH_SIMD_X86
+	// The 2x2 algebra on one matrix per 128-bit lane.
+	MATH_TARGET_SSE41 static __m128 MultiplyLanes(__m128 a, __m128 b);
+	MATH_TARGET_SSE41 static __m128 InverseLanes(__m128 m);
+	MATH_TARGET_AVX static __m256 MultiplyLanes(__m256 a, __m256 b);
+	MATH_TARGET_AVX static __m256 InverseLanes(__m256 m);
+#endif
 };
 
+static_assert(std::is_trivially_copyable<Matrix2x2>::value, "Matrix2x2 must be trivially copyable");
+static_assert(std::is_standard_layout<Matrix2x2>::value, "Matrix2x2 must be standard layout");
+
+template<> struct ElementTraits<Matrix2x2> {
+	typedef float Element;
+	typedef float Scalar;
+	static const int kSize = 4;
+	static const bool kPacked = true;
+	static constexpr float Get(const Matrix2x2& value, int i) { return value.m[i]; }
+	static constexpr Matrix2x2 Make(const float* values) {
+		Matrix2x2 out(0.0f);
+		for (int i = 0; i < kSize; i++) {
+			out.m[i] = values[i];
+		}
+		return out;
+	}
+};
 
 inline Matrix2x2::Matrix2x2() {
 }
 
-inline Matrix2x2::Matrix2x2(float a[4]) {
+constexpr Matrix2x2::Matrix2x2(float a[4]) : m() {
 	m[0] = a[0];
 	m[1] = a[1];
 	m[2] = a[2];
 	m[3] = a[3];
 }
 
-inline Matrix2x2::Matrix2x2(float a) {
+constexpr Matrix2x2::Matrix2x2(float a) : m() {
 	m[0] = a;
 	m[1] = a;
 	m[2] = a;
 	m[3] = a;
 }
 
-inline Matrix2x2::Matrix2x2(const Vector2& a, const Vector2& b) {
+constexpr Matrix2x2::Matrix2x2(const Vector2& a, const Vector2& b) : m() {
 	m[0] = a.x;
 	m[1] = a.y;
 	m[2] = b.x;
 	m[3] = b.y;
 }
 
-inline Matrix2x2::Matrix2x2(const Matrix2x2& copy) {
-	m[0] = copy.m[0];
-	m[1] = copy.m[1];
-	m[2] = copy.m[2];
-	m[3] = copy.m[3];
+constexpr Matrix2x2 Matrix2x2::operator+(const Matrix2x2& other) const {
+	return Elementwise<Matrix2x2>::Add(*this, other);
 }
 
-inline Matrix2x2::~Matrix2x2() {
+constexpr Matrix2x2& Matrix2x2::operator+=(const Matrix2x2& other) {
+	*this = Elementwise<Matrix2x2>::Add(*this, other);
+	return *this;
+}
 
+constexpr Matrix2x2 Matrix2x2::operator+(float value) const {
+	return Elementwise<Matrix2x2>::Add(*this, value);
 }
 
-inline Matrix2x2 Matrix2x2::operator+(const Matrix2x2& other) const {
-	Matrix2x2 out;
-	out.m[0] += other.m[0];
-	out.m[1] += other.m[1];
-	out.m[2] += other.m[2];
-	out.m[3] += other.m[3];
-	return out;
+constexpr Matrix2x2& Matrix2x2::operator+=(float value) {
+	*this = Elementwise<Matrix2x2>::Add(*this, value);
+	return *this;
 }
 
-inline void Matrix2x2::operator+=(const Matrix2x2& other) {
-	m[0] + other.m[0];
-	m[1] + other.m[1];
-	m[2] + other.m[2];
-	m[3] + other.m[3];
+constexpr Matrix2x2 Matrix2x2::operator-(const Matrix2x2& other) const {
+	return Elementwise<Matrix2x2>::Subtract(*this, other);
 }
 
-inline Matrix2x2 Matrix2x2::operator+(float value) const {
-	Matrix2x2 out;
-	out.m[0] + value;
-	out.m[1] + value;
-	out.m[2] + value;
-	out.m[3] + value;
-	return out;
+constexpr Matrix2x2& Matrix2x2::operator-=(const Matrix2x2& other) {
+	*this = Elementwise<Matrix2x2>::Subtract(*this, other);
+	return *this;
 }
 
-inline void Matrix2x2::operator+=(float value) {
-	m[0] += value;
-	m[1] += value;
-	m[2] += value;
-	m[3] += value;
+constexpr Matrix2x2 Matrix2x2::operator-(float value) const {
+	return Elementwise<Matrix2x2>::Subtract(*this, value);
 }
 
-inline Matrix2x2 Matrix2x2::operator-(const Matrix2x2& other) const {
-	Matrix2x2 out;
-	out.m[0] -= other.m[0];
-	out.m[1] -= other.m[1];
-	out.m[2] -= other.m[2];
-	out.m[3] -= other.m[3];
-	return out;
+constexpr Matrix2x2& Matrix2x2::operator-=(float value) {
+	*this = Elementwise<Matrix2x2>::Subtract(*this, value);
+	return *this;
 }
 
-inline void Matrix2x2::operator-=(const Matrix2x2& other) {
-	m[0] - other.m[0];
-	m[1] - other.m[1];
-	m[2] - other.m[2];
-	m[3] - other.m[3];
+constexpr Matrix2x2 Matrix2x2::operator*(float value) const {
+	return Elementwise<Matrix2x2>::Multiply(*this, value);
 }
 
-inline Matrix2x2 Matrix2x2::operator-(float value) const {	
-	Matrix2x2 out;
-	out.m[0] -= value;
-	out.m[1] -= value;
-	out.m[2] -= value;
-	out.m[3] -= value;
-	return out;
+constexpr Matrix2x2& Matrix2x2::operator*=(float value) {
+	*this = Elementwise<Matrix2x2>::Multiply(*this, value);
+	return *this;
 }
 
-inline void Matrix2x2::operator-=(float value) {
-	m[0] -= value;
-	m[1] -= value;
-	m[2] -= value;
-	m[3] -= value;
+constexpr Matrix2x2 Matrix2x2::operator/(float value) const {
+	return Elementwise<Matrix2x2>::Divide(*this, value);
 }
 
+constexpr Matrix2x2& Matrix2x2::operator/=(float value) {
+	*this = Elementwise<Matrix2x2>::Divide(*this, value);
+	return *this;
+}
+
+constexpr bool Matrix2x2::operator==(const Matrix2x2& other) const {
+	return Elementwise<Matrix2x2>::Equal(*this, other);
+}
+
+constexpr bool Matrix2x2::operator!=(const Matrix2x2& other) const {
+	return !(*this == other);
+}
+
+constexpr Matrix2x2 Matrix2x2::Identity() const {
+	return Matrix2x2(Vector2(1.0f, 0.0f), Vector2(0.0f, 1.0f));
+}
 
-inline Matrix2x2 Matrix2x2::operator*(float value) const {
-	Matrix2x2 out;
-	out.m[0] *= value;
-	out.m[1] *= value;
-	out.m[2] *= value;
-	out.m[3] *= value;
+constexpr float Matrix2x2::Determinant() const {
+	// |m[0]  m[1]|
+	// |m[2]  m[3]|
+	return m[0] * m[3] - m[1] * m[2];
+}
+
+constexpr Matrix2x2 Matrix2x2::Adjoint() const {
+	// |+m[3]  -m[2]|
+	// |-m[1]  +m[0]|
+	Matrix2x2 out(0.0f);
+	out.m[0] = m[3];
+	out.m[1] = -m[2];
+	out.m[2] = -m[1];
+	out.m[3] = m[0];
 	return out;
 }
 
-inline void Matrix2x2::operator*=(float value) {
-	m[0] *= value;
-	m[1] *= value;
-	m[2] *= value;
-	m[3] *= value;
+constexpr Matrix2x2 Matrix2x2::Transpose() const {
+	Matrix2x2 out(0.0f);
+	out.m[0] = m[0];
+	out.m[1] = m[2];
+	out.m[2] = m[1];
+	out.m[3] = m[3];
+	return out;
+}
+
+constexpr Vector2 Matrix2x2::GetLine(int line) const {
+	return Vector2(m[0 + 2 * line], m[1 + 2 * line]);
+}
+
+constexpr Vector2 Matrix2x2::GetColum(int colum) const {
+	return Vector2(m[0 + colum], m[2 + colum]);
 }
 
-inline Matrix2x2 Matrix2x2::operator/(float value) const {
-	Matrix2x2 out;
-	out.m[0] /= value;
-	out.m[1] /= value;
-	out.m[2] /= value;
-	out.m[3] /= value;
+constexpr Matrix2x2 Matrix2x2::Multiply(const Matrix2x2& other) const {
+	Matrix2x2 out(0.0f);
+	MultiplyScalar(m, other.m, out.m, 1);
 	return out;
 }
 
-inline void Matrix2x2::operator/=(float value) {
-	m[0] /= value;
-	m[1] /= value;
-	m[2] /= value;
-	m[3] /= value;
+constexpr Matrix2x2 Matrix2x2::Inverse() const {
+	Matrix2x2 out(0.0f);
+	InverseScalar(m, out.m, 1);
+	return out;
+}
+
+constexpr Vector2 Matrix2x2::Transform(const Vector2& vector) const {
+	// Local arrays rather than &vector.x, which constant evaluation does not
+	// allow to index past x.
+	const float in[2] = { vector.x, vector.y };
+	float out[2] = { 0.0f, 0.0f };
+	TransformScalar(m, in, out, 1);
+	return Vector2(out[0], out[1]);
+}
+
+constexpr void Matrix2x2::MultiplyScalar(const float* a, const float* b, float* out, size_t n) {
+	// |a[0]  a[1]|   |b[0]  b[1]|
+	// |a[2]  a[3]| * |b[2]  b[3]|
+	for (size_t i = 0; i < 4 * n; i += 4) {
+		const float a0 = a[i], a1 = a[i + 1], a2 = a[i + 2], a3 = a[i + 3];
+		const float b0 = b[i], b1 = b[i + 1], b2 = b[i + 2], b3 = b[i + 3];
+		out[i + 0] = a0 * b0 + a1 * b2;
+		out[i + 1] = a0 * b1 + a1 * b3;
+		out[i + 2] = a2 * b0 + a3 * b2;
+		out[i + 3] = a2 * b1 + a3 * b3;
+	}
 }
 
-inline bool Matrix2x2::operator==(const Matrix2x2& other) const {
-	bool res = true;
-	for (int i = 0; i < 4; i++) {
-		if (m[i] != other.m[i]) {
-			res = false;
+constexpr void Matrix2x2::InverseScalar(const float* in, float* out, size_t n) {
+	for (size_t i = 0; i < 4 * n; i += 4) {
+		const float m0 = in[i], m1 = in[i + 1], m2 = in[i + 2], m3 = in[i + 3];
+		const float inverted = 1.0f / (m0 * m3 - m1 * m2);
+		out[i + 0] = m3 * inverted;
+		out[i + 1] = -m1 * inverted;
+		out[i + 2] = -m2 * inverted;
+		out[i + 3] = m0 * inverted;
+	}
+}
+
+constexpr void Matrix2x2::TransformScalar(const float* m, const float* in, float* out, size_t n) {
+	//          |m[0]  m[1]|
+	// |x  y| * |m[2]  m[3]|
+	for (size_t i = 0; i < n; i++) {
+		const float* matrix = m + 4 * i;
+		const float x = in[2 * i + 0];
+		const float y = in[2 * i + 1];
+		out[2 * i + 0] = x * matrix[0] + y * matrix[2];
+		out[2 * i + 1] = x * matrix[1] + y * matrix[3];
+	}
+}
+
+inline void Matrix2x2::Multiply(const Matrix2x2* a, const Matrix2x2* b, Matrix2x2* out, size_t n) {
+	if (n == 0) {
+		return;
+	}
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2: {
+			const size_t count = n / 4 * 4;
+			MultiplyAVX(a->m, b->m, out->m, count);
+			MultiplySSE41(a->m + 4 * count, b->m + 4 * count, out->m + 4 * count, n - count);
+			return;
 		}
+		case Simd::kSSE41:
+			MultiplySSE41(a->m, b->m, out->m, n);
+			return;
+		default:
+			break;
 	}
-	return res;
+#endif
+	MultiplyScalar(a->m, b->m, out->m, n);
 }
 
-inline bool Matrix2x2::operator!=(const Matrix2x2& other) const {
-	bool res = false;
-	for (int i = 0; i < 4; i++) {
-		if (m[i] != other.m[i]) {
-			res = true;
+inline void Matrix2x2::Inverse(const Matrix2x2* in, Matrix2x2* out, size_t n) {
+	if (n == 0) {
+		return;
+	}
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2: {
+			const size_t count = n / 4 * 4;
+			InverseAVX(in->m, out->m, count);
+			InverseSSE41(in->m + 4 * count, out->m + 4 * count, n - count);
+			return;
 		}
+		case Simd::kSSE41:
+			InverseSSE41(in->m, out->m, n);
+			return;
+		default:
+			break;
 	}
-	return res;
+#endif
+	InverseScalar(in->m, out->m, n);
 }
 
-inline void Matrix2x2::operator=(const Matrix2x2& other) {
-	for (int i = 0; i < 4; i++) {
-		m[i] = other.m[i];
+inline void Matrix2x2::Transform(const Matrix2x2* m, const Vector2* in, Vector2* out, size_t n) {
+	if (n == 0) {
+		return;
+	}
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2: {
+			const size_t count = n / 4 * 4;
+			TransformAVX(m->m, &in->x, &out->x, count);
+			TransformSSE41(m->m + 4 * count, &in->x + 2 * count, &out->x + 2 * count, n - count);
+			return;
+		}
+		case Simd::kSSE41:
+			TransformSSE41(m->m, &in->x, &out->x, n);
+			return;
+		default:
+			break;
 	}
+#endif
+	TransformScalar(m->m, &in->x, &out->x, n);
 }
 
-inline Matrix2x2 Matrix2x2::Identity() const {
-	return Matrix2x2();
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline __m128 Matrix2x2::MultiplyLanes(__m128 a, __m128 b) {
+	// (a0 a0 a2 a2) * (b0 b1 b0 b1) + (a1 a1 a3 a3) * (b2 b3 b2 b3), the
+	// products and sums of MultiplyScalar.
+	const __m128 a_even = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 0, 0));
+	const __m128 a_odd = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 1, 1));
+	const __m128 b_line0 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 1, 0));
+	const __m128 b_line1 = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 2, 3, 2));
+	return _mm_add_ps(_mm_mul_ps(a_even, b_line0), _mm_mul_ps(a_odd, b_line1));
 }
 
-inline float Matrix2x2::Determinant() const {
-	return 0.0f;
+MATH_TARGET_SSE41 inline __m128 Matrix2x2::InverseLanes(__m128 m) {
+	// m * (m3 m2 m1 m0) holds m0 * m3 and m1 * m2; their difference is the
+	// determinant, broadcast before the one division.
+	const __m128 products = _mm_mul_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 1, 2, 3)));
+	const __m128 determinant = _mm_sub_ps(_mm_shuffle_ps(products, products, _MM_SHUFFLE(0, 0, 0, 0)),
+		_mm_shuffle_ps(products, products, _MM_SHUFFLE(1, 1, 1, 1)));
+	const __m128 inverted = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+	const __m128 sign = _mm_setr_ps(0.0f, -0.0f, -0.0f, 0.0f);
+	const __m128 adjugate = _mm_xor_ps(_mm_shuffle_ps(m, m, _MM_SHUFFLE(0, 2, 1, 3)), sign);
+	return _mm_mul_ps(adjugate, inverted);
 }
 
-inline Matrix2x2 Matrix2x2::Inverse() const {
-	return Matrix2x2();
+MATH_TARGET_AVX inline __m256 Matrix2x2::MultiplyLanes(__m256 a, __m256 b) {
+	const __m256 a_even = _mm256_permute_ps(a, _MM_SHUFFLE(2, 2, 0, 0));
+	const __m256 a_odd = _mm256_permute_ps(a, _MM_SHUFFLE(3, 3, 1, 1));
+	const __m256 b_line0 = _mm256_permute_ps(b, _MM_SHUFFLE(1, 0, 1, 0));
+	const __m256 b_line1 = _mm256_permute_ps(b, _MM_SHUFFLE(3, 2, 3, 2));
+	return _mm256_add_ps(_mm256_mul_ps(a_even, b_line0), _mm256_mul_ps(a_odd, b_line1));
 }
 
-inline Matrix2x2 Matrix2x2::Multiply(const Matrix2x2& other) const {
-	return Matrix2x2();
+MATH_TARGET_AVX inline __m256 Matrix2x2::InverseLanes(__m256 m) {
+	const __m256 products = _mm256_mul_ps(m, _mm256_permute_ps(m, _MM_SHUFFLE(0, 1, 2, 3)));
+	const __m256 determinant = _mm256_sub_ps(_mm256_permute_ps(products, _MM_SHUFFLE(0, 0, 0, 0)),
+		_mm256_permute_ps(products, _MM_SHUFFLE(1, 1, 1, 1)));
+	const __m256 inverted = _mm256_div_ps(_mm256_set1_ps(1.0f), determinant);
+	const __m256 sign = _mm256_setr_ps(0.0f, -0.0f, -0.0f, 0.0f, 0.0f, -0.0f, -0.0f, 0.0f);
+	const __m256 adjugate = _mm256_xor_ps(_mm256_permute_ps(m, _MM_SHUFFLE(0, 2, 1, 3)), sign);
+	return _mm256_mul_ps(adjugate, inverted);
+}
+
+MATH_TARGET_SSE41 inline void Matrix2x2::MultiplySSE41(const float* a, const float* b, float* out, size_t n) {
+	for (size_t i = 0; i < 4 * n; i += 4) {
+		_mm_storeu_ps(out + i, MultiplyLanes(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+	}
 }
 
-inline Matrix2x2 Matrix2x2::Adjoint() const {
-	return Matrix2x2();
+MATH_TARGET_SSE41 inline void Matrix2x2::InverseSSE41(const float* in, float* out, size_t n) {
+	for (size_t i = 0; i < 4 * n; i += 4) {
+		_mm_storeu_ps(out + i, InverseLanes(_mm_loadu_ps(in + i)));
+	}
 }
 
-inline Matrix2x2 Matrix2x2::Transpose() const {
-	return Matrix2x2();
+MATH_TARGET_SSE41 inline void Matrix2x2::TransformSSE41(const float* m, const float* in, float* out, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		// (x x y y) * (m0 m1 m2 m3), then the upper pair added to the lower.
+		const __m128 xy = _mm_castpd_ps(_mm_load_sd((const double*)(in + 2 * i)));
+		const __m128 products = _mm_mul_ps(_mm_shuffle_ps(xy, xy, _MM_SHUFFLE(1, 1, 0, 0)), _mm_loadu_ps(m + 4 * i));
+		_mm_storel_pi((__m64*)(out + 2 * i), _mm_add_ps(products, _mm_movehl_ps(products, products)));
+	}
 }
 
-inline Vector2 Matrix2x2::GetLine(int line) const {
-	return Vector2();
+MATH_TARGET_AVX inline void Matrix2x2::MultiplyAVX(const float* a, const float* b, float* out, size_t count) {
+	for (size_t i = 0; i < 4 * count; i += 16) {
+		const __m256 product01 = MultiplyLanes(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+		const __m256 product23 = MultiplyLanes(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8));
+		_mm256_storeu_ps(out + i, product01);
+		_mm256_storeu_ps(out + i + 8, product23);
+	}
 }
 
-inline Vector2 Matrix2x2::GetColum(int line) const {	
-	return Vector2();
+MATH_TARGET_AVX inline void Matrix2x2::InverseAVX(const float* in, float* out, size_t count) {
+	for (size_t i = 0; i < 4 * count; i += 16) {
+		const __m256 inverse01 = InverseLanes(_mm256_loadu_ps(in + i));
+		const __m256 inverse23 = InverseLanes(_mm256_loadu_ps(in + i + 8));
+		_mm256_storeu_ps(out + i, inverse01);
+		_mm256_storeu_ps(out + i + 8, inverse23);
+	}
 }
 
+MATH_TARGET_AVX inline void Matrix2x2::TransformAVX(const float* m, const float* in, float* out, size_t count) {
+	for (size_t i = 0; i < count; i += 4) {
+		// Matrices 0 and 2 in one register and 1 and 3 in the other, so the
+		// two results of each land in the order of the vectors.
+		const float* matrix = m + 4 * i;
+		const __m256 m02 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(matrix)), _mm_loadu_ps(matrix + 8), 1);
+		const __m256 m13 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(matrix + 4)), _mm_loadu_ps(matrix + 12), 1);
+		// (x0 y0 x1 y1 | x2 y2 x3 y3)
+		const __m256 xy = _mm256_loadu_ps(in + 2 * i);
+		const __m256 products02 = _mm256_mul_ps(_mm256_permute_ps(xy, _MM_SHUFFLE(1, 1, 0, 0)), m02);
+		const __m256 products13 = _mm256_mul_ps(_mm256_permute_ps(xy, _MM_SHUFFLE(3, 3, 2, 2)), m13);
+		const __m256 result02 = _mm256_add_ps(products02, _mm256_permute_ps(products02, _MM_SHUFFLE(3, 2, 3, 2)));
+		const __m256 result13 = _mm256_add_ps(products13, _mm256_permute_ps(products13, _MM_SHUFFLE(3, 2, 3, 2)));
+		_mm256_storeu_ps(out + 2 * i, _mm256_shuffle_ps(result02, result13, _MM_SHUFFLE(1, 0, 1, 0)));
+	}
+}
+#endif
 
 #endif
@@ -5,72 +5,89 @@
 
 #include "vector_2.h"
 #include "vector_3.h"
+#include <type_traits>
+#include "elementwise.h"
 
 class Matrix3x3 {
 public:
 
 	Matrix3x3();
-	Matrix3x3(float *values_array);
-	Matrix3x3(float value);
-	Matrix3x3(Vector3 a, Vector3 b, Vector3 c);
+	constexpr Matrix3x3(float *values_array);
+	constexpr Matrix3x3(float value);
+	constexpr Matrix3x3(Vector3 a, Vector3 b, Vector3 c);
 
-	Matrix3x3(const Matrix3x3& copy);
-	~Matrix3x3();
 
-	static Matrix3x3 Identity();
+	static constexpr Matrix3x3 Identity();
 
-	Matrix3x3 Multiply(const Matrix3x3& other) const;
+	constexpr Matrix3x3 Multiply(const Matrix3x3& other) const;
 
-	float Determinant() const;
+	constexpr float Determinant() const;
 
-	Matrix3x3 Adjoint() const;
-	bool GetInverse(Matrix3x3& out) const;
-	bool Inverse();
+	constexpr Matrix3x3 Adjoint() const;
+	constexpr bool GetInverse(Matrix3x3& out) const;
+	constexpr bool Inverse();
 
-	Matrix3x3 Transpose() const;
+	constexpr Matrix3x3 Transpose() const;
 
-	static Matrix3x3 Translate(const Vector2& position);
-	static Matrix3x3 Translate(float x, float y);
+	static constexpr Matrix3x3 Translate(const Vector2& position);
+	static constexpr Matrix3x3 Translate(float x, float y);
 
-	Vector3 GetColum(int colum) const;
-	Vector3 GetLine(int line) const;
+	constexpr Vector3 GetColum(int colum) const;
+	constexpr Vector3 GetLine(int line) const;
 
-	inline Matrix3x3 operator+(const Matrix3x3& other) const;
-	inline Matrix3x3& operator+=(const Matrix3x3& other);
-	inline Matrix3x3 operator+(float value) const;
-	inline Matrix3x3& operator+=(float value);
-	inline Matrix3x3 operator-(const Matrix3x3& other) const;
-	inline Matrix3x3& operator-=(const Matrix3x3& other);
-	inline Matrix3x3 operator-(float value) const;
-	inline Matrix3x3& operator-=(float value);
-	inline Matrix3x3 operator*(float value) const;
-	inline Matrix3x3& operator*=(float value);
-	inline Matrix3x3 operator/(float value) const;
-	inline Matrix3x3& operator/=(float value);
-	bool operator==(const Matrix3x3& other) const;
-	bool operator!=(const Matrix3x3& other) const;
-	inline void operator=(const Matrix3x3& other);
+	constexpr Matrix3x3 operator+(const Matrix3x3& other) const;
+	constexpr Matrix3x3& operator+=(const Matrix3x3& other);
+	constexpr Matrix3x3 operator+(float value) const;
+	constexpr Matrix3x3& operator+=(float value);
+	constexpr Matrix3x3 operator-(const Matrix3x3& other) const;
+	constexpr Matrix3x3& operator-=(const Matrix3x3& other);
+	constexpr Matrix3x3 operator-(float value) const;
+	constexpr Matrix3x3& operator-=(float value);
+	constexpr Matrix3x3 operator*(float value) const;
+	constexpr Matrix3x3& operator*=(float value);
+	constexpr Matrix3x3 operator/(float value) const;
+	constexpr Matrix3x3& operator/=(float value);
+	constexpr bool operator==(const Matrix3x3& other) const;
+	constexpr bool operator!=(const Matrix3x3& other) const;
 
 	float m[9];
 };
 
+static_assert(std::is_trivially_copyable<Matrix3x3>::value, "Matrix3x3 must be trivially copyable");
+static_assert(std::is_standard_layout<Matrix3x3>::value, "Matrix3x3 must be standard layout");
+
+template<> struct ElementTraits<Matrix3x3> {
+	typedef float Element;
+	typedef float Scalar;
+	static const int kSize = 9;
+	static const bool kPacked = true;
+	static constexpr float Get(const Matrix3x3& value, int i) { return value.m[i]; }
+	static constexpr Matrix3x3 Make(const float* values) {
+		Matrix3x3 out(0.0f);
+		for (int i = 0; i < kSize; i++) {
+			out.m[i] = values[i];
+		}
+		return out;
+	}
+};
+
 
 inline Matrix3x3::Matrix3x3() {
 }
 
-inline Matrix3x3::Matrix3x3(float value) {
+constexpr Matrix3x3::Matrix3x3(float value) : m() {
 	for (int i = 0; i < 9; i++) {
 		m[i] = value;
 	}
 }
 
-inline Matrix3x3::Matrix3x3(float *values_array) {
+constexpr Matrix3x3::Matrix3x3(float *values_array) : m() {
 	for (int i = 0; i < 9; i++) {
 		m[i] = values_array[i];
 	}
 }
 
-inline Matrix3x3::Matrix3x3(Vector3 a, Vector3 b, Vector3 c) {
+constexpr Matrix3x3::Matrix3x3(Vector3 a, Vector3 b, Vector3 c) : m() {
 	m[0] = a.x;
 	m[1] = a.y;
 	m[2] = a.z;
@@ -82,137 +99,73 @@ inline Matrix3x3::Matrix3x3(Vector3 a, Vector3 b, Vector3 c) {
 	m[8] = c.z;
 }
 
-inline Matrix3x3::Matrix3x3(const Matrix3x3& copy) {
-	for (int i = 0; i < 9; i++) {
-		this->m[i] = copy.m[i];
-	}
-}
-
-inline Matrix3x3::~Matrix3x3() {
-
-}
-
-inline Matrix3x3 Matrix3x3::operator+(const Matrix3x3& other) const {
-	Matrix3x3 out;
-	for (int i = 0; i < 9; i++) {
-		out.m[i] = m[i] + other.m[i];
-	}
-	return out;
+constexpr Matrix3x3 Matrix3x3::operator+(const Matrix3x3& other) const {
+	return Elementwise<Matrix3x3>::Add(*this, other);
 }
 
-inline Matrix3x3& Matrix3x3::operator+=(const Matrix3x3& other) {
-	for (int i = 0; i < 9; i++) {
-		m[i] =m[i] + other.m[i];
-	}
+constexpr Matrix3x3& Matrix3x3::operator+=(const Matrix3x3& other) {
+	*this = Elementwise<Matrix3x3>::Add(*this, other);
 	return *this;
 }
 
-inline Matrix3x3 Matrix3x3::operator+(float value) const {
-	Matrix3x3 out;
-	for (int i = 0; i < 9; i++) {
-		out.m[i] += value;
-	}
-	return out;
+constexpr Matrix3x3 Matrix3x3::operator+(float value) const {
+	return Elementwise<Matrix3x3>::Add(*this, value);
 }
 
-inline Matrix3x3& Matrix3x3::operator+=(float value) {
-	for (int i = 0; i < 9; i++) {
-		m[i] += value;
-	}
+constexpr Matrix3x3& Matrix3x3::operator+=(float value) {
+	*this = Elementwise<Matrix3x3>::Add(*this, value);
 	return *this;
 }
 
-inline Matrix3x3 Matrix3x3::operator-(const Matrix3x3& other) const {
-	Matrix3x3 out;
-	for (int i = 0; i < 9; i++) {
-		out.m[i] = m[i] - other.m[i];
-	}
-	return out;
+constexpr Matrix3x3 Matrix3x3::operator-(const Matrix3x3& other) const {
+	return Elementwise<Matrix3x3>::Subtract(*this, other);
 }
 
-inline Matrix3x3& Matrix3x3::operator-=(const Matrix3x3& other) {
-	for (int i = 0; i < 9; i++) {
-		m[i] = m[i] - other.m[i];
-	}
+constexpr Matrix3x3& Matrix3x3::operator-=(const Matrix3x3& other) {
+	*this = Elementwise<Matrix3x3>::Subtract(*this, other);
 	return *this;
 }
 
-inline Matrix3x3 Matrix3x3::operator-(float value) const {
-	Matrix3x3 out;
-	for (int i = 0; i < 9; i++) {
-		out.m[i] -= value;
-	}
-	return out;
+constexpr Matrix3x3 Matrix3x3::operator-(float value) const {
+	return Elementwise<Matrix3x3>::Subtract(*this, value);
 }
 
-inline Matrix3x3& Matrix3x3::operator-=(float value) {
-	for (int i = 0; i < 9; i++) {
-		m[i] -= value;
-	}
+constexpr Matrix3x3& Matrix3x3::operator-=(float value) {
+	*this = Elementwise<Matrix3x3>::Subtract(*this, value);
 	return *this;
 }
 
-inline Matrix3x3 Matrix3x3::operator*(float value) const {
-	Matrix3x3 out;
-	for (int i = 0; i < 9; i++) {
-		out.m[i] *= value;
-	}
-	return out;
+constexpr Matrix3x3 Matrix3x3::operator*(float value) const {
+	return Elementwise<Matrix3x3>::Multiply(*this, value);
 }
 
-inline Matrix3x3& Matrix3x3::operator*=(float value) {
-	for (int i = 0; i < 9; i++) {
-		m[i] *= value;
-	}
+constexpr Matrix3x3& Matrix3x3::operator*=(float value) {
+	*this = Elementwise<Matrix3x3>::Multiply(*this, value);
 	return *this;
 }
 
-inline Matrix3x3 Matrix3x3::operator/(float value) const {
-	Matrix3x3 out;
-	for (int i = 0; i < 9; i++) {
-		out.m[i] = m[i] / value;
-	}
-	return out;
+constexpr Matrix3x3 Matrix3x3::operator/(float value) const {
+	return Elementwise<Matrix3x3>::Divide(*this, value);
 }
 
-inline Matrix3x3& Matrix3x3::operator/=(float value) {
-	for (int i = 0; i < 9; i++) {
-		m[i] /= value;
-	}
+constexpr Matrix3x3& Matrix3x3::operator/=(float value) {
+	*this = Elementwise<Matrix3x3>::Divide(*this, value);
 	return *this;
 }
 
-inline bool Matrix3x3::operator==(const Matrix3x3& other) const {
-	bool res = true;
-	for (int i = 0; i < 9; i++) {
-		if (m[i] != other.m[i]) {
-			res = false;
-		}
-	}
-	return res;
-}
-
-inline bool Matrix3x3::operator!=(const Matrix3x3& other) const {
-	bool res = false;
-	for (int i = 0; i < 9; i++) {
-		if (m[i] != other.m[i]) { 
-			res = true;
-		}
-	}
-	return res;
+constexpr bool Matrix3x3::operator==(const Matrix3x3& other) const {
+	return Elementwise<Matrix3x3>::Equal(*this, other);
 }
 
-inline void Matrix3x3::operator=(const Matrix3x3& other) {
-	for (int i = 0; i < 9; i++) {
-		m[i] = other.m[i];
-	}
+constexpr bool Matrix3x3::operator!=(const Matrix3x3& other) const {
+	return !(*this == other);
 }
 
-inline Matrix3x3 Matrix3x3::Identity(){
+constexpr Matrix3x3 Matrix3x3::Identity(){
 	return Matrix3x3(Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(0.0f, 0.0f, 1.0f));
 }
 
-inline float Matrix3x3::Determinant() const {
+constexpr float Matrix3x3::Determinant() const {
 	// |m[0]  m[1]  m[2]|
 	// |m[3]  m[4]  m[5]|
 	// |m[6]  m[7]  m[8]|
@@ -224,7 +177,7 @@ inline float Matrix3x3::Determinant() const {
 	return m[0] * m[4] * m[8] + m[3] * m[7] * m[2] + m[1] * m[5] * m[6] - (m[6] * m[4] * m[2] + m[7] * m[5] * m[0] + m[3] * m[1] * m[8]);
 }
 
-inline bool Matrix3x3::GetInverse(Matrix3x3& out) const {
+constexpr bool Matrix3x3::GetInverse(Matrix3x3& out) const {
 	float determinant = Determinant();
 	if (determinant == 0.0f) {
 		return false;
@@ -233,12 +186,12 @@ inline bool Matrix3x3::GetInverse(Matrix3x3& out) const {
 	return true;
 }
 
-inline bool Matrix3x3::Inverse() {	
+constexpr bool Matrix3x3::Inverse() {	
 	return GetInverse(*this);
 }
 
-inline Matrix3x3 Matrix3x3::Translate(const Vector2& mov_vector) {	
-	Matrix3x3 out;
+constexpr Matrix3x3 Matrix3x3::Translate(const Vector2& mov_vector) {	
+	Matrix3x3 out(0.0f);
 	out.m[0] = 1.0f;
 	out.m[1] = 0.0f;
 	out.m[2] = mov_vector.x;
@@ -251,8 +204,8 @@ inline Matrix3x3 Matrix3x3::Translate(const Vector2& mov_vector) {
 	return out;
 }
 
-inline Matrix3x3 Matrix3x3::Translate(float x, float y) {
-	Matrix3x3 out;
+constexpr Matrix3x3 Matrix3x3::Translate(float x, float y) {
+	Matrix3x3 out(0.0f);
 	out.m[0] = 1.0f;
 	out.m[1] = 0.0f;
 	out.m[2] = x;
@@ -265,8 +218,8 @@ inline Matrix3x3 Matrix3x3::Translate(float x, float y) {
 	return out;
 }
 
-inline Matrix3x3 Matrix3x3::Multiply(const Matrix3x3& other) const {
-	Matrix3x3 out;
+constexpr Matrix3x3 Matrix3x3::Multiply(const Matrix3x3& other) const {
+	Matrix3x3 out(0.0f);
 	// |m[0]  m[1]  m[2]|       |other.m[0]  other.m[1]  other.m[2]|
 	// |m[3]  m[4]  m[5]|   *   |other.m[3]  other.m[4]  other.m[5]|
 	// |m[6]  m[7]  m[8]|       |other.m[6]  other.m[7]  other.m[8]|
@@ -286,7 +239,7 @@ inline Matrix3x3 Matrix3x3::Multiply(const Matrix3x3& other) const {
 	return out;
 }
 
-inline Matrix3x3 Matrix3x3::Adjoint() const {
+constexpr Matrix3x3 Matrix3x3::Adjoint() const {
 	// |m[0]  m[1]  m[2]|       | + - + |
 	// |m[3]  m[4]  m[5]|       | - + - |
 	// |m[6]  m[7]  m[8]|       | + - + |
@@ -294,7 +247,7 @@ inline Matrix3x3 Matrix3x3::Adjoint() const {
 	// |+(m[4] * m[8] - (m[7] * m[5]))   -(m[3] * m[8] - (m[6] * m[5]))   +(m[3] * m[7] - (m[6] * m[4]))|
 	// |-(m[1] * m[8] - (m[7] * m[2]))   +(m[0] * m[8] - (m[6] * m[2]))   -(m[0] * m[7] - (m[6] * m[1]))|
 	// |+(m[1] * m[5] - (m[4] * m[2]))   -(m[0] * m[5] - (m[3] * m[2]))   +(m[0] * m[4] - (m[3] * m[1]))|
-	Matrix3x3 out;
+	Matrix3x3 out(0.0f);
 	out.m[0] = +(m[4] * m[8] - (m[7] * m[5]));
 	out.m[1] = -(m[3] * m[8] - (m[6] * m[5]));
 	out.m[2] = +(m[3] * m[7] - (m[6] * m[4]));
@@ -307,8 +260,8 @@ inline Matrix3x3 Matrix3x3::Adjoint() const {
 	return out;
 }
 
-inline Matrix3x3 Matrix3x3::Transpose() const {
-	Matrix3x3 out;
+constexpr Matrix3x3 Matrix3x3::Transpose() const {
+	Matrix3x3 out(0.0f);
 	out.m[0] = m[0];
 	out.m[1] = m[3];
 	out.m[2] = m[6];
@@ -321,11 +274,11 @@ inline Matrix3x3 Matrix3x3::Transpose() const {
 	return out;
 }
 
-inline Vector3 Matrix3x3::GetColum(int colum) const {
+constexpr Vector3 Matrix3x3::GetColum(int colum) const {
 	return Vector3(m[0 + colum], m[3 + colum], m[6 + colum]);
 }
 
-inline Vector3 Matrix3x3::GetLine(int line) const {
+constexpr Vector3 Matrix3x3::GetLine(int line) const {
 	// |m[0]  m[1]  m[2]|       
 	// |m[3]  m[4]  m[5]|       
 	// |m[6]  m[7]  m[8]|       
@@ -6,112 +6,210 @@
 #include "vector_3.h"
 #include "vector_4.h"
 #include "matrix_3.h"
+#include "simd.h"
+#include "fast_math.h"
+#include "aligned.h"
+#include "vector_3_stream.h"
+#include <stddef.h>
+#include <type_traits>
+#include "elementwise.h"
 
 class Matix4x4{
  public:
 
   Matix4x4();
-  Matix4x4(float a[16]);
-	Matix4x4(const float a[16]);
-  Matix4x4(float value);
-  Matix4x4(const Matix4x4& copy);
-  ~Matix4x4();
-
-  Matix4x4 Identity() const;
-  Matix4x4 Multiply(const Matix4x4& other) const;
+  constexpr Matix4x4(float a[16]);
+	constexpr Matix4x4(const float a[16]);
+  constexpr Matix4x4(float value);
+
+  constexpr Matix4x4 Identity() const;
+  constexpr Matix4x4 Multiply(const Matix4x4& other) const;
+
+  // out = a * b on row-major float[16]. out must not alias a or b for the
+  // scalar kernel. The SSE4.1 kernel is bit-identical to the scalar one, the
+  // AVX2 kernel uses FMA (see Multiply for its error bound).
+  static constexpr void MultiplyScalar(const float* a, const float* b, float* out);
+#ifdef MATH_SIMD_X86
+  MATH_TARGET_SSE41 static void MultiplySSE41(const float* a, const float* b, float* out);
+  MATH_TARGET_AVX2 static void MultiplyAVX2(const float* a, const float* b, float* out);
+#endif
+  // out[i] = a[i] * b[i] with the Multiply kernel picked once for the batch.
+  // out may be a or b.
+  static void Multiply(const Matix4x4* a, const Matix4x4* b, Matix4x4* out, size_t n);
+
+  constexpr float Determinant() const;
+  constexpr Matix4x4 Adjoint() const;
+  constexpr bool GetInverse(Matix4x4& out) const;
+  constexpr bool Inverse();
+
+  // For matrices whose last colum is (0, 0, 0, 1), like the ones Translate,
+  // Scale, Rotate* and GetTransform build. The rigid form further needs the
+  // upper 3x3 to be a pure rotation and just transposes it.
+  constexpr bool GetInverseAffine(Matix4x4& out) const;
+  constexpr bool InverseAffine();
+  constexpr void GetInverseRigid(Matix4x4& out) const;
+  constexpr void InverseRigid();
+
+  // General inverse from shared 2x2 sub-determinants. out may be m. Both
+  // return false and leave out untouched when the matrix is singular.
+  static constexpr bool InverseScalar(const float* m, float* out);
+#ifdef MATH_SIMD_X86
+  MATH_TARGET_SSE41 static bool InverseSSE41(const float* m, float* out);
+#endif
 
-  float Determinant() const;
-  Matix4x4 Adjoint() const;
-  bool GetInverse(Matix4x4& out) const;
-  bool Inverse();
+  constexpr Matix4x4 Transpose() const;
 
-  Matix4x4 Transpose() const;
 
+  static constexpr Matix4x4 Translate(const Vector3& distance);
+  static constexpr Matix4x4 Translate(float x, float y, float z);
 
-  static Matix4x4 Translate(const Vector3& distance);
-  static Matix4x4 Translate(float x, float y, float z);
+  static constexpr Matix4x4 Scale(const Vector3& scale);
+  static constexpr Matix4x4 Scale(float x, float y, float z);
 
-  static Matix4x4 Scale(const Vector3& scale);
-  static Matix4x4 Scale(float x, float y, float z);
+  static Matix4x4 RotateX(float radians, FastMath::Precision precision = FastMath::kDefault);
+  static Matix4x4 RotateY(float radians, FastMath::Precision precision = FastMath::kDefault);
+  static Matix4x4 RotateZ(float radians, FastMath::Precision precision = FastMath::kDefault);
 
-  static Matix4x4 RotateX(float radians);
-  static Matix4x4 RotateY(float radians);
-  static Matix4x4 RotateZ(float radians);
+  // Rotate* for n angles, with the sines and cosines taken a chunk at a
+  // time; kFast takes them 8 at a time with AVX. Same bits as the single
+  // forms.
+  static void RotateX(const float* radians, Matix4x4* out, size_t n, FastMath::Precision precision = FastMath::kDefault);
+  static void RotateY(const float* radians, Matix4x4* out, size_t n, FastMath::Precision precision = FastMath::kDefault);
+  static void RotateZ(const float* radians, Matix4x4* out, size_t n, FastMath::Precision precision = FastMath::kDefault);
 
   static Matix4x4 GetTransform(const Vector3& translate, const Vector3& scale,
-                      float rotateX, float rotateY, float rotateZ);
+                      float rotateX, float rotateY, float rotateZ,
+                      FastMath::Precision precision = FastMath::kDefault);
 
   static Matix4x4 GetTransform(float trans_x, float trans_y, float trans_z,
                       float scale_x, float scale_y, float scale_Z,
-                      float rotateX, float rotateY, float rotateZ);
+                      float rotateX, float rotateY, float rotateZ,
+                      FastMath::Precision precision = FastMath::kDefault);
+
+  // GetTransform for n nodes from SoA inputs; rotate holds the X/Y/Z angles.
+  static void GetTransforms(const Vector3Stream& translate, const Vector3Stream& scale,
+                      const Vector3Stream& rotate, Matix4x4* out,
+                      FastMath::Precision precision = FastMath::kDefault);
+  // RotateX * RotateY * RotateZ for n nodes, as GetTransforms with no
+  // translation and unit scale.
+  static void GetRotations(const Vector3Stream& rotate, Matix4x4* out,
+                      FastMath::Precision precision = FastMath::kDefault);
+
+  // Writes Translate * RotateX * RotateY * RotateZ * Scale from precomputed
+  // sines and cosines of the three angles.
+  static constexpr void ComposeTransform(float trans_x, float trans_y, float trans_z,
+                      float scale_x, float scale_y, float scale_z,
+                      float sin_x, float cos_x, float sin_y, float cos_y,
+                      float sin_z, float cos_z, float* out);
 
   Matix4x4 PerspectiveMatrix(float fov, float aspect,
-	  float near, float far) const;
+	  float near, float far, FastMath::Precision precision = FastMath::kDefault) const;
 
-  Matix4x4 OrthoMatrix(float right, float left, float top, float valueottom,
+  constexpr Matix4x4 OrthoMatrix(float right, float left, float top, float valueottom,
 	  float near, float far) const;
 
-  Vector4 GetColum(int colum) const;
-  Vector4 GetLine(int line) const;
-
-  Matix4x4 operator+(const Matix4x4& other) const;
-  Matix4x4& operator+=(const Matix4x4& other);
-  Matix4x4 operator+(float value) const;
-  Matix4x4& operator+=(float value);
-  Matix4x4 operator-(const Matix4x4& other) const;
-  Matix4x4& operator-=(const Matix4x4& other);
-  Matix4x4 operator-(float value) const;
-  Matix4x4& operator-=(float value);
-  Matix4x4& operator*=(float value);
-  Matix4x4 operator*(float value) const;
-  Matix4x4& operator/=(float value);
-  Matix4x4 operator/(float value) const;
-  bool operator==(const Matix4x4& other);
-  bool operator!=(const Matix4x4& other);
-  void operator=(const Matix4x4& other);
+  constexpr Vector4 GetColum(int colum) const;
+  constexpr Vector4 GetLine(int line) const;
+
+  // Vectors are rows multiplied on the left, v * M, so Translate() moves
+  // points through m[12..14]. Points use w = 1 and directions w = 0; the
+  // last colum is ignored for both. in and out may be the same array.
+  constexpr Vector3 TransformPoint(const Vector3& point) const;
+  constexpr Vector3 TransformDirection(const Vector3& direction) const;
+  constexpr Vector4 Transform(const Vector4& vector) const;
+  void TransformPoints(const Vector3* in, Vector3* out, size_t n) const;
+  void TransformDirections(const Vector3* in, Vector3* out, size_t n) const;
+  void TransformVectors(const Vector4* in, Vector4* out, size_t n) const;
+
+  // Batch kernels on packed xyz / xyzw floats. Same precision contract as
+  // the Multiply kernels.
+  static constexpr void TransformVector3Scalar(const float* m, const float* in, float* out, size_t n, float w);
+  static constexpr void TransformVector4Scalar(const float* m, const float* in, float* out, size_t n);
+#ifdef MATH_SIMD_X86
+  MATH_TARGET_SSE41 static void TransformVector3SSE41(const float* m, const float* in, float* out, size_t n, float w);
+  MATH_TARGET_SSE41 static void TransformVector4SSE41(const float* m, const float* in, float* out, size_t n);
+  MATH_TARGET_AVX2 static void TransformVector3AVX2(const float* m, const float* in, float* out, size_t n, float w);
+  MATH_TARGET_AVX2 static void TransformVector4AVX2(const float* m, const float* in, float* out, size_t n);
+#endif
+
+  constexpr Matix4x4 operator+(const Matix4x4& other) const;
+  constexpr Matix4x4& operator+=(const Matix4x4& other);
+  constexpr Matix4x4 operator+(float value) const;
+  constexpr Matix4x4& operator+=(float value);
+  constexpr Matix4x4 operator-(const Matix4x4& other) const;
+  constexpr Matix4x4& operator-=(const Matix4x4& other);
+  constexpr Matix4x4 operator-(float value) const;
+  constexpr Matix4x4& operator-=(float value);
+  constexpr Matix4x4& operator*=(float value);
+  constexpr Matix4x4 operator*(float value) const;
+  constexpr Matix4x4& operator/=(float value);
+  constexpr Matix4x4 operator/(float value) const;
+  constexpr bool operator==(const Matix4x4& other) const;
+  constexpr bool operator!=(const Matix4x4& other) const;
 
   float m[16];
+
+private:
+  static const size_t kAngleChunk = 64;
+
+  // sinf and cosf, or FastMath::SinCos, of one or n angles.
+  static void SinCos(float radians, float& sin, float& cos, FastMath::Precision precision);
+  static void SinCos(const float* radians, float* sin, float* cos, size_t n, FastMath::Precision precision);
+  static Matix4x4 RotationX(float sin, float cos);
+  static Matix4x4 RotationY(float sin, float cos);
+  static Matix4x4 RotationZ(float sin, float cos);
+  static void Rotations(Matix4x4 (*rotation)(float, float), const float* radians, Matix4x4* out,
+                      size_t n, FastMath::Precision precision);
+};
+
+static_assert(std::is_trivially_copyable<Matix4x4>::value, "Matix4x4 must be trivially copyable");
+static_assert(std::is_standard_layout<Matix4x4>::value, "Matix4x4 must be standard layout");
+
+template<> struct ElementTraits<Matix4x4> {
+	typedef float Element;
+	typedef float Scalar;
+	static const int kSize = 16;
+	static const bool kPacked = true;
+	static constexpr float Get(const Matix4x4& value, int i) { return value.m[i]; }
+	static constexpr Matix4x4 Make(const float* values) { return Matix4x4(values); }
 };
 
+// Matix4x4 on 16, 32 and 64-byte boundaries: lines in SSE registers, line
+// pairs in AVX registers, and the whole matrix in one cache line.
+typedef Aligned<Matix4x4, 16> Matix4x4A16;
+typedef Aligned<Matix4x4, 32> Matix4x4A32;
+typedef Aligned<Matix4x4, 64> Matix4x4A64;
+static_assert(sizeof(Matix4x4A64) == sizeof(Matix4x4), "Matix4x4A64 must not be padded");
+
 
 inline Matix4x4::Matix4x4() {
 
 }
 
-inline Matix4x4::Matix4x4(float array[16]) {
+constexpr Matix4x4::Matix4x4(float array[16]) : m() {
 	for (int i = 0; i < 16; i++) {
 		m[i] = array[i];
 	}
 }
 
-inline Matix4x4::Matix4x4(const float array[16]) {
+constexpr Matix4x4::Matix4x4(const float array[16]) : m() {
 	for (int i = 0; i < 16; i++) {
 		m[i] = array[i];
 	}
 }
 
-inline Matix4x4::Matix4x4(float value) {
+constexpr Matix4x4::Matix4x4(float value) : m() {
 	for (int i = 0; i < 16; i++) {
 		m[i] = value;
 	}
 }
 
-inline Matix4x4::Matix4x4(const Matix4x4& copy) {
-	for (int i = 0; i < 16; i++) {
-		m[i] = copy.m[i];
-	}
-}
-
-inline Matix4x4::~Matix4x4() {
-
-}
-
-inline Matix4x4 Matix4x4::Identity() const {
+constexpr Matix4x4 Matix4x4::Identity() const {
 	//|m[0]   m[1]   m[2]   m[3]|
 	//|m[4]   m[5]   m[6]   m[7]|
 	//|m[8]   m[9]   m[10]  m[11]|
 	//|m[12]  m[13]  m[14]  m[15]|
-	Matix4x4 out;
+	Matix4x4 out(0.0f);
 	out.m[0] = 1.0f;
 	out.m[1] = 0.0f;
 	out.m[2] = 0.0f;
@@ -131,33 +229,120 @@ inline Matix4x4 Matix4x4::Identity() const {
 	return out;
 }
 
-inline Matix4x4 Matix4x4::Multiply(const Matix4x4& other)const  {
-//|m[0]   m[1]   m[2]    m[3]|		 |other.m[0]   other.m[1]   other.m[2]   other.m[3]|
-//|m[4]   m[5]   m[6]    m[7]|		 |other.m[4]   other.m[5]   other.m[6]   other.m[7]|
-//|m[8]   m[9]   m[10]  m[11]|	*  |other.m[8]   other.m[9]   other.m[10]  other.m[11]|
-//|m[12]  m[13]  m[14]  m[15]|		 |other.m[12]  other.m[13]  other.m[14]  other.m[15]|
-	Matix4x4 out;
-	out.m[0] = m[0] * other.m[0] + m[1] * other.m[4] + m[2] * other.m[8] + m[3] * other.m[12];
-	out.m[1] = m[0] * other.m[1] + m[1] * other.m[5] + m[2] * other.m[9] + m[3] * other.m[13];
-	out.m[2] = m[0] * other.m[2] + m[1] * other.m[6] + m[2] * other.m[10] + m[3] * other.m[14];
-	out.m[3] = m[0] * other.m[3] + m[1] * other.m[7] + m[2] * other.m[11] + m[3] * other.m[15];
-	out.m[4] = m[4] * other.m[0] + m[5] * other.m[4] + m[6] * other.m[8] + m[7] * other.m[12];
-	out.m[5] = m[4] * other.m[1] + m[5] * other.m[5] + m[6] * other.m[9] + m[7] * other.m[13];
-	out.m[6] = m[4] * other.m[2] + m[5] * other.m[6] + m[6] * other.m[10] + m[7] * other.m[14];
-	out.m[7] = m[4] * other.m[3] + m[5] * other.m[7] + m[6] * other.m[11] + m[7] * other.m[15];
-	out.m[8] = m[8] * other.m[0] + m[9] * other.m[4] + m[10] * other.m[8] + m[11] * other.m[12];
-	out.m[9] = m[8] * other.m[1] + m[9] * other.m[5] + m[10] * other.m[9] + m[11] * other.m[13];
-	out.m[10] = m[8] * other.m[2] + m[9] * other.m[6] + m[10] * other.m[10] + m[11] * other.m[14];
-	out.m[11] = m[8] * other.m[3] + m[9] * other.m[7] + m[10] * other.m[11] + m[11] * other.m[15];
-	out.m[12] = m[12] * other.m[0] + m[13] * other.m[4] + m[14] * other.m[8] + m[15] * other.m[12];
-	out.m[13] = m[12] * other.m[1] + m[13] * other.m[5] + m[14] * other.m[9] + m[15] * other.m[13];
-	out.m[14] = m[12] * other.m[2] + m[13] * other.m[6] + m[14] * other.m[10] + m[15] * other.m[14];
-	out.m[15] = m[12] * other.m[3] + m[13] * other.m[7] + m[14] * other.m[11] + m[15] * other.m[15];
+constexpr Matix4x4 Matix4x4::Multiply(const Matix4x4& other)const  {
+	// SSE4.1 gives the same bits as the scalar path. AVX2 fuses the last three
+	// multiply-adds of every element, so an element can differ from the scalar
+	// result by up to 3 ULP of sum(|a[i][k] * b[k][j]|); relative to a result
+	// that cancels to near zero that is many ULP (benchmark/matrix_4_multiply.cc).
+#ifdef MATH_SIMD_X86
+	if (!MATH_CONSTANT_EVALUATED()) {
+		// The kernels write every element, so out can stay uninitialized.
+		Matix4x4 out;
+		switch (Simd::Active()) {
+			case Simd::kAVX2:
+				MultiplyAVX2(m, other.m, out.m);
+				return out;
+			case Simd::kSSE41:
+				MultiplySSE41(m, other.m, out.m);
+				return out;
+			default:
+				MultiplyScalar(m, other.m, out.m);
+				return out;
+		}
+	}
+#endif
+	Matix4x4 out(0.0f);
+	MultiplyScalar(m, other.m, out.m);
 	return out;
 }
 
+inline void Matix4x4::Multiply(const Matix4x4* a, const Matix4x4* b, Matix4x4* out, size_t n) {
+	// The kernels need out apart from a and b, so each result goes through
+	// a local first.
+	Matix4x4 result;
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			for (size_t i = 0; i < n; i++) {
+				MultiplyAVX2(a[i].m, b[i].m, result.m);
+				out[i] = result;
+			}
+			return;
+		case Simd::kSSE41:
+			for (size_t i = 0; i < n; i++) {
+				MultiplySSE41(a[i].m, b[i].m, result.m);
+				out[i] = result;
+			}
+			return;
+		default:
+			break;
+	}
+#endif
+	for (size_t i = 0; i < n; i++) {
+		MultiplyScalar(a[i].m, b[i].m, result.m);
+		out[i] = result;
+	}
+}
+
+constexpr void Matix4x4::MultiplyScalar(const float* a, const float* b, float* out) {
+//|a[0]   a[1]   a[2]    a[3]|		 |b[0]   b[1]   b[2]   b[3]|
+//|a[4]   a[5]   a[6]    a[7]|		 |b[4]   b[5]   b[6]   b[7]|
+//|a[8]   a[9]   a[10]  a[11]|	*  |b[8]   b[9]   b[10]  b[11]|
+//|a[12]  a[13]  a[14]  a[15]|		 |b[12]  b[13]  b[14]  b[15]|
+	out[0] = a[0] * b[0] + a[1] * b[4] + a[2] * b[8] + a[3] * b[12];
+	out[1] = a[0] * b[1] + a[1] * b[5] + a[2] * b[9] + a[3] * b[13];
+	out[2] = a[0] * b[2] + a[1] * b[6] + a[2] * b[10] + a[3] * b[14];
+	out[3] = a[0] * b[3] + a[1] * b[7] + a[2] * b[11] + a[3] * b[15];
+	out[4] = a[4] * b[0] + a[5] * b[4] + a[6] * b[8] + a[7] * b[12];
+	out[5] = a[4] * b[1] + a[5] * b[5] + a[6] * b[9] + a[7] * b[13];
+	out[6] = a[4] * b[2] + a[5] * b[6] + a[6] * b[10] + a[7] * b[14];
+	out[7] = a[4] * b[3] + a[5] * b[7] + a[6] * b[11] + a[7] * b[15];
+	out[8] = a[8] * b[0] + a[9] * b[4] + a[10] * b[8] + a[11] * b[12];
+	out[9] = a[8] * b[1] + a[9] * b[5] + a[10] * b[9] + a[11] * b[13];
+	out[10] = a[8] * b[2] + a[9] * b[6] + a[10] * b[10] + a[11] * b[14];
+	out[11] = a[8] * b[3] + a[9] * b[7] + a[10] * b[11] + a[11] * b[15];
+	out[12] = a[12] * b[0] + a[13] * b[4] + a[14] * b[8] + a[15] * b[12];
+	out[13] = a[12] * b[1] + a[13] * b[5] + a[14] * b[9] + a[15] * b[13];
+	out[14] = a[12] * b[2] + a[13] * b[6] + a[14] * b[10] + a[15] * b[14];
+	out[15] = a[12] * b[3] + a[13] * b[7] + a[14] * b[11] + a[15] * b[15];
+}
 
-inline float Matix4x4::Determinant() const {
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Matix4x4::MultiplySSE41(const float* a, const float* b, float* out) {
+	// Every output line is a linear combination of the lines of b, added in
+	// the same order as the scalar kernel.
+	const __m128 line0 = _mm_loadu_ps(b + 0);
+	const __m128 line1 = _mm_loadu_ps(b + 4);
+	const __m128 line2 = _mm_loadu_ps(b + 8);
+	const __m128 line3 = _mm_loadu_ps(b + 12);
+	for (int i = 0; i < 16; i += 4) {
+		__m128 res = _mm_mul_ps(_mm_set1_ps(a[i + 0]), line0);
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(a[i + 1]), line1));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(a[i + 2]), line2));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(a[i + 3]), line3));
+		_mm_storeu_ps(out + i, res);
+	}
+}
+
+MATH_TARGET_AVX2 inline void Matix4x4::MultiplyAVX2(const float* a, const float* b, float* out) {
+	// Two output lines per register: the lines of b are broadcast to both
+	// halves and the coefficients of a are splat inside each half.
+	const __m256 line0 = _mm256_broadcast_ps((const __m128*)(b + 0));
+	const __m256 line1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+	const __m256 line2 = _mm256_broadcast_ps((const __m128*)(b + 8));
+	const __m256 line3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+	for (int i = 0; i < 16; i += 8) {
+		const __m256 lines = _mm256_loadu_ps(a + i);
+		__m256 res = _mm256_mul_ps(_mm256_shuffle_ps(lines, lines, 0x00), line0);
+		res = _mm256_fmadd_ps(_mm256_shuffle_ps(lines, lines, 0x55), line1, res);
+		res = _mm256_fmadd_ps(_mm256_shuffle_ps(lines, lines, 0xAA), line2, res);
+		res = _mm256_fmadd_ps(_mm256_shuffle_ps(lines, lines, 0xFF), line3, res);
+		_mm256_storeu_ps(out + i, res);
+	}
+}
+#endif
+
+constexpr float Matix4x4::Determinant() const {
 	//|m[0]   m[1]   m[2]    m[3]|      |+ - + -|
 	//|m[4]   m[5]   m[6]    m[7]|      |- + - +|
 	//|m[8]   m[9]   m[10]  m[11]|      |+ - + -|
@@ -179,12 +364,12 @@ inline float Matix4x4::Determinant() const {
 }
 
 
-inline Matix4x4 Matix4x4::Adjoint() const {
+constexpr Matix4x4 Matix4x4::Adjoint() const {
 	//|m[0]   m[1]   m[2]    m[3]|      |+ - + -|
 	//|m[4]   m[5]   m[6]    m[7]|      |- + - +|
 	//|m[8]   m[9]   m[10]  m[11]|      |+ - + -|
 	//|m[12]  m[13]  m[14]  m[15]|      |- + - +|
-	Matix4x4 result;
+	Matix4x4 result(0.0f);
 	result.m[0] = +(m[5] * m[10] * m[15] + m[6] * m[11] * m[13] + m[9] * m[14] * m[7] -
 								 (m[13] * m[10] * m[7] + m[9] * m[6] * m[15] + m[14] * m[11] * m[5]));
 
@@ -239,23 +424,207 @@ inline Matix4x4 Matix4x4::Adjoint() const {
 	return result;
 }
 
-inline bool Matix4x4::Inverse() {
+constexpr bool Matix4x4::Inverse() {
 
 	return GetInverse(*this);
 }
 
-inline bool Matix4x4::GetInverse(Matix4x4& out) const {
-	float determinant = Determinant();
+constexpr bool Matix4x4::GetInverse(Matix4x4& out) const {
+#ifdef MATH_SIMD_X86
+	if (!MATH_CONSTANT_EVALUATED() && Simd::Active() >= Simd::kSSE41) {
+		return InverseSSE41(m, out.m);
+	}
+#endif
+	return InverseScalar(m, out.m);
+}
+
+constexpr bool Matix4x4::InverseScalar(const float* m, float* out) {
+	//|a00  a01  a02  a03|
+	//|a10  a11  a12  a13|
+	//|a20  a21  a22  a23|
+	//|a30  a31  a32  a33|
+	// Every 3x3 cofactor is expanded over the 2x2 determinants of the upper
+	// two lines (s*) or the lower two lines (c*), so each is computed once.
+	const float a00 = m[0], a01 = m[1], a02 = m[2], a03 = m[3];
+	const float a10 = m[4], a11 = m[5], a12 = m[6], a13 = m[7];
+	const float a20 = m[8], a21 = m[9], a22 = m[10], a23 = m[11];
+	const float a30 = m[12], a31 = m[13], a32 = m[14], a33 = m[15];
+
+	const float s0 = a00 * a11 - a10 * a01;
+	const float s1 = a00 * a12 - a10 * a02;
+	const float s2 = a00 * a13 - a10 * a03;
+	const float s3 = a01 * a12 - a11 * a02;
+	const float s4 = a01 * a13 - a11 * a03;
+	const float s5 = a02 * a13 - a12 * a03;
+
+	const float c0 = a20 * a31 - a30 * a21;
+	const float c1 = a20 * a32 - a30 * a22;
+	const float c2 = a20 * a33 - a30 * a23;
+	const float c3 = a21 * a32 - a31 * a22;
+	const float c4 = a21 * a33 - a31 * a23;
+	const float c5 = a22 * a33 - a32 * a23;
+
+	const float determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	if (determinant == 0.0f) {
+		return false;
+	}
+	const float inverse = 1.0f / determinant;
+
+	out[0] = (a11 * c5 - a12 * c4 + a13 * c3) * inverse;
+	out[1] = (-a01 * c5 + a02 * c4 - a03 * c3) * inverse;
+	out[2] = (a31 * s5 - a32 * s4 + a33 * s3) * inverse;
+	out[3] = (-a21 * s5 + a22 * s4 - a23 * s3) * inverse;
+
+	out[4] = (-a10 * c5 + a12 * c2 - a13 * c1) * inverse;
+	out[5] = (a00 * c5 - a02 * c2 + a03 * c1) * inverse;
+	out[6] = (-a30 * s5 + a32 * s2 - a33 * s1) * inverse;
+	out[7] = (a20 * s5 - a22 * s2 + a23 * s1) * inverse;
+
+	out[8] = (a10 * c4 - a11 * c2 + a13 * c0) * inverse;
+	out[9] = (-a00 * c4 + a01 * c2 - a03 * c0) * inverse;
+	out[10] = (a30 * s4 - a31 * s2 + a33 * s0) * inverse;
+	out[11] = (-a20 * s4 + a21 * s2 - a23 * s0) * inverse;
+
+	out[12] = (-a10 * c3 + a11 * c1 - a12 * c0) * inverse;
+	out[13] = (a00 * c3 - a01 * c1 + a02 * c0) * inverse;
+	out[14] = (-a30 * s3 + a31 * s1 - a32 * s0) * inverse;
+	out[15] = (a20 * s3 - a21 * s1 + a22 * s0) * inverse;
+	return true;
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline bool Matix4x4::InverseSSE41(const float* m, float* out) {
+	// Block form of Cramer's rule. With M = |A B| split in 2x2 blocks and X#
+	//                                       |C D|
+	// the adjugate of X, the inverse is 1/|M| * |(|D|A - B(D#C))#  (|B|C - D(A#B)#)#|
+	//                                           |(|C|B - A(D#C)#)#  (|A|D - C(A#B))# |
+	// and |M| = |A||D| + |B||C| - tr((A#B)(D#C)). Every 2x2 block is one
+	// register holding (x00, x01, x10, x11).
+	const __m128 line0 = _mm_loadu_ps(m + 0);
+	const __m128 line1 = _mm_loadu_ps(m + 4);
+	const __m128 line2 = _mm_loadu_ps(m + 8);
+	const __m128 line3 = _mm_loadu_ps(m + 12);
+
+	const __m128 A = _mm_movelh_ps(line0, line1);
+	const __m128 B = _mm_movehl_ps(line1, line0);
+	const __m128 C = _mm_movelh_ps(line2, line3);
+	const __m128 D = _mm_movehl_ps(line3, line2);
+
+	// (|A|, |B|, |C|, |D|)
+	const __m128 sub_determinants = _mm_sub_ps(
+		_mm_mul_ps(_mm_shuffle_ps(line0, line2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(line1, line3, _MM_SHUFFLE(3, 1, 3, 1))),
+		_mm_mul_ps(_mm_shuffle_ps(line0, line2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(line1, line3, _MM_SHUFFLE(2, 0, 2, 0))));
+	const __m128 det_a = _mm_shuffle_ps(sub_determinants, sub_determinants, _MM_SHUFFLE(0, 0, 0, 0));
+	const __m128 det_b = _mm_shuffle_ps(sub_determinants, sub_determinants, _MM_SHUFFLE(1, 1, 1, 1));
+	const __m128 det_c = _mm_shuffle_ps(sub_determinants, sub_determinants, _MM_SHUFFLE(2, 2, 2, 2));
+	const __m128 det_d = _mm_shuffle_ps(sub_determinants, sub_determinants, _MM_SHUFFLE(3, 3, 3, 3));
+
+	// X#Y, X*Y and X*Y# on 2x2 blocks.
+#define MATH_MAT2_ADJ_MUL(x, y) _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(0, 0, 3, 3)), y), \
+	_mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 0, 3, 2))))
+#define MATH_MAT2_MUL(x, y) _mm_add_ps(_mm_mul_ps(x, _mm_shuffle_ps(y, y, _MM_SHUFFLE(3, 0, 3, 0))), \
+	_mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 2, 1, 2))))
+#define MATH_MAT2_MUL_ADJ(x, y) _mm_sub_ps(_mm_mul_ps(x, _mm_shuffle_ps(y, y, _MM_SHUFFLE(0, 3, 0, 3))), \
+	_mm_mul_ps(_mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(y, y, _MM_SHUFFLE(1, 2, 1, 2))))
+	const __m128 DC = MATH_MAT2_ADJ_MUL(D, C);
+	const __m128 AB = MATH_MAT2_ADJ_MUL(A, B);
+	__m128 X = _mm_sub_ps(_mm_mul_ps(det_d, A), MATH_MAT2_MUL(B, DC));
+	__m128 W = _mm_sub_ps(_mm_mul_ps(det_a, D), MATH_MAT2_MUL(C, AB));
+	__m128 Y = _mm_sub_ps(_mm_mul_ps(det_b, C), MATH_MAT2_MUL_ADJ(D, AB));
+	__m128 Z = _mm_sub_ps(_mm_mul_ps(det_c, B), MATH_MAT2_MUL_ADJ(A, DC));
+#undef MATH_MAT2_ADJ_MUL
+#undef MATH_MAT2_MUL
+#undef MATH_MAT2_MUL_ADJ
+
+	__m128 trace = _mm_mul_ps(AB, _mm_shuffle_ps(DC, DC, _MM_SHUFFLE(3, 1, 2, 0)));
+	trace = _mm_hadd_ps(trace, trace);
+	trace = _mm_hadd_ps(trace, trace);
+	const __m128 determinant = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), trace);
+	if (_mm_cvtss_f32(determinant) == 0.0f) {
+		return false;
+	}
+
+	// The sign pattern applies the outer adjugate, the shuffles below move
+	// its diagonal and store the blocks as lines.
+	const __m128 inverse = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), determinant);
+	X = _mm_mul_ps(X, inverse);
+	Y = _mm_mul_ps(Y, inverse);
+	Z = _mm_mul_ps(Z, inverse);
+	W = _mm_mul_ps(W, inverse);
+	_mm_storeu_ps(out + 0, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(out + 4, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(out + 8, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(out + 12, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+	return true;
+}
+#endif
+
+constexpr bool Matix4x4::InverseAffine() {
+	return GetInverseAffine(*this);
+}
+
+constexpr bool Matix4x4::GetInverseAffine(Matix4x4& out) const {
+	//|m[0]   m[1]   m[2]   0|        |inv(R)     0|
+	//|m[4]   m[5]   m[6]   0|  --->  |           0|
+	//|m[8]   m[9]   m[10]  0|        |           0|
+	//|m[12]  m[13]  m[14]  1|        |-t*inv(R)  1|
+	const float r00 = m[0], r01 = m[1], r02 = m[2];
+	const float r10 = m[4], r11 = m[5], r12 = m[6];
+	const float r20 = m[8], r21 = m[9], r22 = m[10];
+	const float tx = m[12], ty = m[13], tz = m[14];
+
+	const float c00 = r11 * r22 - r21 * r12;
+	const float c01 = r21 * r02 - r01 * r22;
+	const float c02 = r01 * r12 - r11 * r02;
+	const float determinant = r00 * c00 + r10 * c01 + r20 * c02;
 	if (determinant == 0.0f) {
 		return false;
 	}
-	out = Adjoint().Transpose() / Determinant();
+	const float inverse = 1.0f / determinant;
+
+	const float i00 = c00 * inverse;
+	const float i01 = c01 * inverse;
+	const float i02 = c02 * inverse;
+	const float i10 = (r20 * r12 - r10 * r22) * inverse;
+	const float i11 = (r00 * r22 - r20 * r02) * inverse;
+	const float i12 = (r10 * r02 - r00 * r12) * inverse;
+	const float i20 = (r10 * r21 - r20 * r11) * inverse;
+	const float i21 = (r20 * r01 - r00 * r21) * inverse;
+	const float i22 = (r00 * r11 - r10 * r01) * inverse;
+
+	out.m[0] = i00; out.m[1] = i01; out.m[2] = i02; out.m[3] = 0.0f;
+	out.m[4] = i10; out.m[5] = i11; out.m[6] = i12; out.m[7] = 0.0f;
+	out.m[8] = i20; out.m[9] = i21; out.m[10] = i22; out.m[11] = 0.0f;
+	out.m[12] = -(tx * i00 + ty * i10 + tz * i20);
+	out.m[13] = -(tx * i01 + ty * i11 + tz * i21);
+	out.m[14] = -(tx * i02 + ty * i12 + tz * i22);
+	out.m[15] = 1.0f;
 	return true;
+}
 
+constexpr void Matix4x4::InverseRigid() {
+	GetInverseRigid(*this);
 }
 
-inline Matix4x4 Matix4x4::Transpose() const {
-	Matix4x4 out;
+constexpr void Matix4x4::GetInverseRigid(Matix4x4& out) const {
+	//|R  0|        |R^T      0|
+	//|t  1|  --->  |-t*R^T   1|
+	const float r00 = m[0], r01 = m[1], r02 = m[2];
+	const float r10 = m[4], r11 = m[5], r12 = m[6];
+	const float r20 = m[8], r21 = m[9], r22 = m[10];
+	const float tx = m[12], ty = m[13], tz = m[14];
+
+	out.m[0] = r00; out.m[1] = r10; out.m[2] = r20; out.m[3] = 0.0f;
+	out.m[4] = r01; out.m[5] = r11; out.m[6] = r21; out.m[7] = 0.0f;
+	out.m[8] = r02; out.m[9] = r12; out.m[10] = r22; out.m[11] = 0.0f;
+	out.m[12] = -(tx * r00 + ty * r01 + tz * r02);
+	out.m[13] = -(tx * r10 + ty * r11 + tz * r12);
+	out.m[14] = -(tx * r20 + ty * r21 + tz * r22);
+	out.m[15] = 1.0f;
+}
+
+constexpr Matix4x4 Matix4x4::Transpose() const {
+	Matix4x4 out(0.0f);
 	out.m[0] = m[0];
 	out.m[1] = m[4];
 	out.m[2] = m[8];
@@ -279,8 +648,8 @@ inline Matix4x4 Matix4x4::Transpose() const {
 	return out;
 }
 
-inline Matix4x4 Matix4x4::Translate(const Vector3& distance){
-	Matix4x4 out;
+constexpr Matix4x4 Matix4x4::Translate(const Vector3& distance){
+	Matix4x4 out(0.0f);
 	out.m[0] = 1.0f;
 	out.m[1] = 0.0f;
 	out.m[2] = 0.0f;
@@ -303,8 +672,8 @@ inline Matix4x4 Matix4x4::Translate(const Vector3& distance){
 	return out;
 }
 
-inline Matix4x4 Matix4x4::Translate(float x, float y, float z){
-	Matix4x4 out;
+constexpr Matix4x4 Matix4x4::Translate(float x, float y, float z){
+	Matix4x4 out(0.0f);
 	out.m[0] = 1.0f;
 	out.m[1] = 0.0f;
 	out.m[2] = 0.0f;
@@ -327,8 +696,8 @@ inline Matix4x4 Matix4x4::Translate(float x, float y, float z){
 	return out;
 }
 
-inline Matix4x4 Matix4x4::Scale(const Vector3& scale){
-	Matix4x4 out;
+constexpr Matix4x4 Matix4x4::Scale(const Vector3& scale){
+	Matix4x4 out(0.0f);
 	out.m[0] = scale.x;
 	out.m[1] = 0.0f;
 	out.m[2] = 0.0f;
@@ -351,8 +720,8 @@ inline Matix4x4 Matix4x4::Scale(const Vector3& scale){
 	return out;
 }
 
-inline Matix4x4 Matix4x4::Scale(float x, float y, float z){
-	Matix4x4 out;
+constexpr Matix4x4 Matix4x4::Scale(float x, float y, float z){
+	Matix4x4 out(0.0f);
 	out.m[0] = x;
 	out.m[1] = 0.0f;
 	out.m[2] = 0.0f;
@@ -375,10 +744,18 @@ inline Matix4x4 Matix4x4::Scale(float x, float y, float z){
 	return out;
 }
 
-inline Matix4x4 Matix4x4::RotateX(float radians){
+inline Matix4x4 Matix4x4::RotateX(float radians, FastMath::Precision precision) {
+	float sin, cos;
+	SinCos(radians, sin, cos, precision);
+	return RotationX(sin, cos);
+}
+
+inline void Matix4x4::RotateX(const float* radians, Matix4x4* out, size_t n, FastMath::Precision precision) {
+	Rotations(RotationX, radians, out, n, precision);
+}
+
+inline Matix4x4 Matix4x4::RotationX(float sin, float cos) {
 	Matix4x4 out;
-	float cos = cosf(radians);
-	float sin = sinf(radians);
 	out.m[0] = 1.0f;
 	out.m[1] = 0.0f;
 	out.m[2] = 0.0f;
@@ -402,10 +779,18 @@ inline Matix4x4 Matix4x4::RotateX(float radians){
 	return out;
 }
 
-inline Matix4x4 Matix4x4::RotateY(float radians){
+inline Matix4x4 Matix4x4::RotateY(float radians, FastMath::Precision precision) {
+	float sin, cos;
+	SinCos(radians, sin, cos, precision);
+	return RotationY(sin, cos);
+}
+
+inline void Matix4x4::RotateY(const float* radians, Matix4x4* out, size_t n, FastMath::Precision precision) {
+	Rotations(RotationY, radians, out, n, precision);
+}
+
+inline Matix4x4 Matix4x4::RotationY(float sin, float cos) {
 	Matix4x4 out;
-	float cos = cosf(radians);
-	float sin = sinf(radians);
 	out.m[0] = cos;
 	out.m[1] = 0.0f;
 	out.m[2] = sin;
@@ -429,10 +814,18 @@ inline Matix4x4 Matix4x4::RotateY(float radians){
 	return out;
 }
 
-inline Matix4x4 Matix4x4::RotateZ(float radians) {
+inline Matix4x4 Matix4x4::RotateZ(float radians, FastMath::Precision precision) {
+	float sin, cos;
+	SinCos(radians, sin, cos, precision);
+	return RotationZ(sin, cos);
+}
+
+inline void Matix4x4::RotateZ(const float* radians, Matix4x4* out, size_t n, FastMath::Precision precision) {
+	Rotations(RotationZ, radians, out, n, precision);
+}
+
+inline Matix4x4 Matix4x4::RotationZ(float sin, float cos) {
 	Matix4x4 out;
-	float cos = cosf(radians);
-	float sin = sinf(radians);
 	out.m[0] = cos;
 	out.m[1] = -sin;
 	out.m[2] = 0.0f;
@@ -456,35 +849,127 @@ inline Matix4x4 Matix4x4::RotateZ(float radians) {
 	return out;
 }
 
+inline void Matix4x4::SinCos(float radians, float& sin, float& cos, FastMath::Precision precision) {
+	if (precision == FastMath::kFast) {
+		FastMath::SinCos(radians, sin, cos);
+	} else {
+		sin = sinf(radians);
+		cos = cosf(radians);
+	}
+}
+
+inline void Matix4x4::SinCos(const float* radians, float* sin, float* cos, size_t n, FastMath::Precision precision) {
+	if (precision == FastMath::kFast) {
+		FastMath::SinCos(radians, sin, cos, n);
+		return;
+	}
+	for (size_t i = 0; i < n; i++) {
+		sin[i] = sinf(radians[i]);
+		cos[i] = cosf(radians[i]);
+	}
+}
+
+inline void Matix4x4::Rotations(Matix4x4 (*rotation)(float, float), const float* radians, Matix4x4* out,
+	size_t n, FastMath::Precision precision) {
+	float sin[kAngleChunk], cos[kAngleChunk];
+	for (size_t begin = 0; begin < n; begin += kAngleChunk) {
+		const size_t count = n - begin < kAngleChunk ? n - begin : kAngleChunk;
+		SinCos(radians + begin, sin, cos, count, precision);
+		for (size_t i = 0; i < count; i++) {
+			out[begin + i] = rotation(sin[i], cos[i]);
+		}
+	}
+}
+
 inline Matix4x4 Matix4x4::GetTransform(const Vector3& translate,
 								const Vector3& scale,
 								float rotateX, float rotateY,
-								float rotateZ)   {
-	Matix4x4 out;
-	out = out.Identity();
-	out = out.Multiply(out.Translate(translate));
-	out = out.Multiply(out.RotateX(rotateX));
-	out = out.Multiply(out.RotateY(rotateY));
-	out = out.Multiply(out.RotateZ(rotateZ));
-	out = out.Multiply(out.Scale(scale));
-	return out;
+								float rotateZ, FastMath::Precision precision)   {
+	return GetTransform(translate.x, translate.y, translate.z,
+		scale.x, scale.y, scale.z, rotateX, rotateY, rotateZ, precision);
 }
 
 inline Matix4x4 Matix4x4::GetTransform(float trans_x, float trans_y, float trans_z,
 	float scale_x, float scale_y, float scale_Z,
-	float rotateX, float rotateY, float rotateZ)  {
-	
+	float rotateX, float rotateY, float rotateZ, FastMath::Precision precision)  {
+	float sin_x, cos_x, sin_y, cos_y, sin_z, cos_z;
+	SinCos(rotateX, sin_x, cos_x, precision);
+	SinCos(rotateY, sin_y, cos_y, precision);
+	SinCos(rotateZ, sin_z, cos_z, precision);
 	Matix4x4 out;
-	out = out.Identity();
-	out = out.Multiply(out.Translate(trans_x, trans_y, trans_z));
-	out = out.Multiply(out.RotateX(rotateX));
-	out = out.Multiply(out.RotateY(rotateY));
-	out = out.Multiply(out.RotateZ(rotateZ));
-	out = out.Multiply(out.Scale(scale_x, scale_y, scale_Z));
+	ComposeTransform(trans_x, trans_y, trans_z, scale_x, scale_y, scale_Z,
+		sin_x, cos_x, sin_y, cos_y, sin_z, cos_z, out.m);
 	return out;
 }
 
-inline Vector4 Matix4x4::GetColum(int colum) const {
+inline void Matix4x4::GetTransforms(const Vector3Stream& translate, const Vector3Stream& scale,
+	const Vector3Stream& rotate, Matix4x4* out, FastMath::Precision precision) {
+	assert(translate.Size() == scale.Size() && translate.Size() == rotate.Size() && "Streams differ in size");
+	// The sines and cosines of a chunk are taken first so that the compose
+	// loop runs on plain arithmetic.
+	float sin_x[kAngleChunk], cos_x[kAngleChunk], sin_y[kAngleChunk], cos_y[kAngleChunk], sin_z[kAngleChunk], cos_z[kAngleChunk];
+	const size_t n = translate.Size();
+	for (size_t begin = 0; begin < n; begin += kAngleChunk) {
+		const size_t count = n - begin < kAngleChunk ? n - begin : kAngleChunk;
+		SinCos(rotate.x + begin, sin_x, cos_x, count, precision);
+		SinCos(rotate.y + begin, sin_y, cos_y, count, precision);
+		SinCos(rotate.z + begin, sin_z, cos_z, count, precision);
+		for (size_t i = 0; i < count; i++) {
+			const size_t node = begin + i;
+			ComposeTransform(translate.x[node], translate.y[node], translate.z[node],
+				scale.x[node], scale.y[node], scale.z[node],
+				sin_x[i], cos_x[i], sin_y[i], cos_y[i], sin_z[i], cos_z[i], out[node].m);
+		}
+	}
+}
+
+inline void Matix4x4::GetRotations(const Vector3Stream& rotate, Matix4x4* out, FastMath::Precision precision) {
+	float sin_x[kAngleChunk], cos_x[kAngleChunk], sin_y[kAngleChunk], cos_y[kAngleChunk], sin_z[kAngleChunk], cos_z[kAngleChunk];
+	const size_t n = rotate.Size();
+	for (size_t begin = 0; begin < n; begin += kAngleChunk) {
+		const size_t count = n - begin < kAngleChunk ? n - begin : kAngleChunk;
+		SinCos(rotate.x + begin, sin_x, cos_x, count, precision);
+		SinCos(rotate.y + begin, sin_y, cos_y, count, precision);
+		SinCos(rotate.z + begin, sin_z, cos_z, count, precision);
+		for (size_t i = 0; i < count; i++) {
+			ComposeTransform(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f,
+				sin_x[i], cos_x[i], sin_y[i], cos_y[i], sin_z[i], cos_z[i], out[begin + i].m);
+		}
+	}
+}
+
+constexpr void Matix4x4::ComposeTransform(float trans_x, float trans_y, float trans_z,
+	float scale_x, float scale_y, float scale_z,
+	float sin_x, float cos_x, float sin_y, float cos_y,
+	float sin_z, float cos_z, float* out) {
+	// RotateX * RotateY * RotateZ:
+	//|cy*cz                 -cy*sz                 sy    |
+	//|sx*sy*cz + cx*sz      -sx*sy*sz + cx*cz      -sx*cy|
+	//|-cx*sy*cz + sx*sz     cx*sy*sz + sx*cz       cx*cy |
+	// times Scale scales the colums, and Translate on the left makes the last
+	// line the translation times the upper 3x3.
+	const float sx_sy = sin_x * sin_y;
+	const float cx_sy = cos_x * sin_y;
+	const float r00 = cos_y * cos_z * scale_x;
+	const float r01 = -cos_y * sin_z * scale_y;
+	const float r02 = sin_y * scale_z;
+	const float r10 = (sx_sy * cos_z + cos_x * sin_z) * scale_x;
+	const float r11 = (-sx_sy * sin_z + cos_x * cos_z) * scale_y;
+	const float r12 = -sin_x * cos_y * scale_z;
+	const float r20 = (-cx_sy * cos_z + sin_x * sin_z) * scale_x;
+	const float r21 = (cx_sy * sin_z + sin_x * cos_z) * scale_y;
+	const float r22 = cos_x * cos_y * scale_z;
+
+	out[0] = r00; out[1] = r01; out[2] = r02; out[3] = 0.0f;
+	out[4] = r10; out[5] = r11; out[6] = r12; out[7] = 0.0f;
+	out[8] = r20; out[9] = r21; out[10] = r22; out[11] = 0.0f;
+	out[12] = trans_x * r00 + trans_y * r10 + trans_z * r20;
+	out[13] = trans_x * r01 + trans_y * r11 + trans_z * r21;
+	out[14] = trans_x * r02 + trans_y * r12 + trans_z * r22;
+	out[15] = 1.0f;
+}
+
+constexpr Vector4 Matix4x4::GetColum(int colum) const {
 	return Vector4(m[0 + colum], m[4 + colum], m[8 + colum], m[12 + colum]);
 	//|m[0]   m[1]   m[2]    m[3]|
 	//|m[4]   m[5]   m[6]    m[7]|
@@ -492,23 +977,201 @@ inline Vector4 Matix4x4::GetColum(int colum) const {
 	//|m[12]  m[13]  m[14]  m[15]|
 }
 
-inline Vector4 Matix4x4::GetLine(int line) const {
+constexpr Vector4 Matix4x4::GetLine(int line) const {
 	return Vector4(m[0 + 4 * line], m[1 + 4 * line], m[2 + 4 * line], m[3 + 4 * line]);
 }
 
+constexpr Vector3 Matix4x4::TransformPoint(const Vector3& point) const {
+	// Local arrays rather than &point.x, which constant evaluation does not
+	// allow to index past x.
+	const float in[3] = { point.x, point.y, point.z };
+	float out[3] = { 0.0f, 0.0f, 0.0f };
+	TransformVector3Scalar(m, in, out, 1, 1.0f);
+	return Vector3(out[0], out[1], out[2]);
+}
+
+constexpr Vector3 Matix4x4::TransformDirection(const Vector3& direction) const {
+	const float in[3] = { direction.x, direction.y, direction.z };
+	float out[3] = { 0.0f, 0.0f, 0.0f };
+	TransformVector3Scalar(m, in, out, 1, 0.0f);
+	return Vector3(out[0], out[1], out[2]);
+}
+
+constexpr Vector4 Matix4x4::Transform(const Vector4& vector) const {
+	const float in[4] = { vector.x, vector.y, vector.z, vector.w };
+	float out[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	TransformVector4Scalar(m, in, out, 1);
+	return Vector4(out[0], out[1], out[2], out[3]);
+}
+
+inline void Matix4x4::TransformPoints(const Vector3* in, Vector3* out, size_t n) const {
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			TransformVector3AVX2(m, &in->x, &out->x, n, 1.0f);
+			return;
+		case Simd::kSSE41:
+			TransformVector3SSE41(m, &in->x, &out->x, n, 1.0f);
+			return;
+		default:
+			break;
+	}
+#endif
+	TransformVector3Scalar(m, &in->x, &out->x, n, 1.0f);
+}
+
+inline void Matix4x4::TransformDirections(const Vector3* in, Vector3* out, size_t n) const {
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			TransformVector3AVX2(m, &in->x, &out->x, n, 0.0f);
+			return;
+		case Simd::kSSE41:
+			TransformVector3SSE41(m, &in->x, &out->x, n, 0.0f);
+			return;
+		default:
+			break;
+	}
+#endif
+	TransformVector3Scalar(m, &in->x, &out->x, n, 0.0f);
+}
+
+inline void Matix4x4::TransformVectors(const Vector4* in, Vector4* out, size_t n) const {
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			TransformVector4AVX2(m, &in->x, &out->x, n);
+			return;
+		case Simd::kSSE41:
+			TransformVector4SSE41(m, &in->x, &out->x, n);
+			return;
+		default:
+			break;
+	}
+#endif
+	TransformVector4Scalar(m, &in->x, &out->x, n);
+}
+
+constexpr void Matix4x4::TransformVector3Scalar(const float* m, const float* in, float* out, size_t n, float w) {
+	//                |m[0]   m[1]   m[2]    m[3]|
+	//                |m[4]   m[5]   m[6]    m[7]|
+	// |x  y  z  w| * |m[8]   m[9]   m[10]  m[11]|
+	//                |m[12]  m[13]  m[14]  m[15]|
+	const float tx = w * m[12];
+	const float ty = w * m[13];
+	const float tz = w * m[14];
+	for (size_t i = 0; i < n; i++) {
+		const float x = in[3 * i + 0];
+		const float y = in[3 * i + 1];
+		const float z = in[3 * i + 2];
+		out[3 * i + 0] = x * m[0] + y * m[4] + z * m[8] + tx;
+		out[3 * i + 1] = x * m[1] + y * m[5] + z * m[9] + ty;
+		out[3 * i + 2] = x * m[2] + y * m[6] + z * m[10] + tz;
+	}
+}
+
+constexpr void Matix4x4::TransformVector4Scalar(const float* m, const float* in, float* out, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		const float x = in[4 * i + 0];
+		const float y = in[4 * i + 1];
+		const float z = in[4 * i + 2];
+		const float w = in[4 * i + 3];
+		out[4 * i + 0] = x * m[0] + y * m[4] + z * m[8] + w * m[12];
+		out[4 * i + 1] = x * m[1] + y * m[5] + z * m[9] + w * m[13];
+		out[4 * i + 2] = x * m[2] + y * m[6] + z * m[10] + w * m[14];
+		out[4 * i + 3] = x * m[3] + y * m[7] + z * m[11] + w * m[15];
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Matix4x4::TransformVector3SSE41(const float* m, const float* in, float* out, size_t n, float w) {
+	// Four points per iteration, transformed as separate x, y and z registers
+	// against splat matrix elements.
+	const __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+	const __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+	const __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+	const __m128 tx = _mm_set1_ps(w * m[12]), ty = _mm_set1_ps(w * m[13]), tz = _mm_set1_ps(w * m[14]);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 x, y, z;
+		Simd::LoadXYZ(in + 3 * i, x, y, z);
+
+		const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m0), _mm_mul_ps(y, m4)), _mm_mul_ps(z, m8)), tx);
+		const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m1), _mm_mul_ps(y, m5)), _mm_mul_ps(z, m9)), ty);
+		const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, m2), _mm_mul_ps(y, m6)), _mm_mul_ps(z, m10)), tz);
+
+		Simd::StoreXYZ(out + 3 * i, rx, ry, rz);
+	}
+	TransformVector3Scalar(m, in + 3 * i, out + 3 * i, n - i, w);
+}
+
+MATH_TARGET_SSE41 inline void Matix4x4::TransformVector4SSE41(const float* m, const float* in, float* out, size_t n) {
+	const __m128 line0 = _mm_loadu_ps(m + 0);
+	const __m128 line1 = _mm_loadu_ps(m + 4);
+	const __m128 line2 = _mm_loadu_ps(m + 8);
+	const __m128 line3 = _mm_loadu_ps(m + 12);
+	for (size_t i = 0; i < n; i++) {
+		const __m128 v = _mm_loadu_ps(in + 4 * i);
+		__m128 res = _mm_mul_ps(_mm_shuffle_ps(v, v, 0x00), line0);
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(v, v, 0x55), line1));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(v, v, 0xAA), line2));
+		res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(v, v, 0xFF), line3));
+		_mm_storeu_ps(out + 4 * i, res);
+	}
+}
+
+MATH_TARGET_AVX2 inline void Matix4x4::TransformVector3AVX2(const float* m, const float* in, float* out, size_t n, float w) {
+	// Eight points per iteration.
+	const __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+	const __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+	const __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+	const __m256 tx = _mm256_set1_ps(w * m[12]), ty = _mm256_set1_ps(w * m[13]), tz = _mm256_set1_ps(w * m[14]);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 x, y, z;
+		Simd::LoadXYZ(in + 3 * i, x, y, z);
+
+		const __m256 rx = _mm256_add_ps(_mm256_fmadd_ps(z, m8, _mm256_fmadd_ps(y, m4, _mm256_mul_ps(x, m0))), tx);
+		const __m256 ry = _mm256_add_ps(_mm256_fmadd_ps(z, m9, _mm256_fmadd_ps(y, m5, _mm256_mul_ps(x, m1))), ty);
+		const __m256 rz = _mm256_add_ps(_mm256_fmadd_ps(z, m10, _mm256_fmadd_ps(y, m6, _mm256_mul_ps(x, m2))), tz);
+
+		Simd::StoreXYZ(out + 3 * i, rx, ry, rz);
+	}
+	TransformVector3Scalar(m, in + 3 * i, out + 3 * i, n - i, w);
+}
+
+MATH_TARGET_AVX2 inline void Matix4x4::TransformVector4AVX2(const float* m, const float* in, float* out, size_t n) {
+	const __m256 line0 = _mm256_broadcast_ps((const __m128*)(m + 0));
+	const __m256 line1 = _mm256_broadcast_ps((const __m128*)(m + 4));
+	const __m256 line2 = _mm256_broadcast_ps((const __m128*)(m + 8));
+	const __m256 line3 = _mm256_broadcast_ps((const __m128*)(m + 12));
+	size_t i = 0;
+	for (; i + 2 <= n; i += 2) {
+		const __m256 v = _mm256_loadu_ps(in + 4 * i);
+		__m256 res = _mm256_mul_ps(_mm256_shuffle_ps(v, v, 0x00), line0);
+		res = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, 0x55), line1, res);
+		res = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, 0xAA), line2, res);
+		res = _mm256_fmadd_ps(_mm256_shuffle_ps(v, v, 0xFF), line3, res);
+		_mm256_storeu_ps(out + 4 * i, res);
+	}
+	TransformVector4Scalar(m, in + 4 * i, out + 4 * i, n - i);
+}
+#endif
+
 inline Matix4x4 Matix4x4::PerspectiveMatrix(float fov, float aspect,
-	float near, float far) const {
+	float near, float far, FastMath::Precision precision) const {
+	const float tangent = precision == FastMath::kFast ? FastMath::Tan(fov * 0.5f) : tanf(fov * 0.5);
 	Matix4x4 out;
-		out.m[0] = 1 / (aspect * tanf(fov * 0.5)); out.m[1] = 0; out.m[2] = 0; out.m[3] = 0;
-		out.m[4] = 0; out.m[5] = 1 / (tanf(fov * 0.5)); out.m[6] = 0; out.m[7] = 0;
+		out.m[0] = 1 / (aspect * tangent); out.m[1] = 0; out.m[2] = 0; out.m[3] = 0;
+		out.m[4] = 0; out.m[5] = 1 / (tangent); out.m[6] = 0; out.m[7] = 0;
 		out.m[8] = 0; out.m[9] = 0; out.m[10] = -(far + near)/(far - near); out.m[11] = -(2 * far * near)/(far - near);
 		out.m[12] = 0; out.m[13] = 0; out.m[14] = -1; out.m[15] = 0;
 	return out;
 }
 
-inline Matix4x4 Matix4x4::OrthoMatrix(float right, float left, float top, float valueottom,
+constexpr Matix4x4 Matix4x4::OrthoMatrix(float right, float left, float top, float valueottom,
 	float near, float far) const {
-	Matix4x4 out;
+	Matix4x4 out(0.0f);
 	out.m[0] = 2 /(right - left); out.m[1] = 0; out.m[2] = 0; out.m[3] = -(right + left)/(right - left);
 	out.m[4] = 0; out.m[5] = 2/(top - valueottom); out.m[6] = 0; out.m[7] = -(top + valueottom)/(top - valueottom);
 	out.m[8] = 0; out.m[9] = 0; out.m[10] = -2/(far - near); out.m[11] = -(far + near)/(far - near);
@@ -518,121 +1181,67 @@ inline Matix4x4 Matix4x4::OrthoMatrix(float right, float left, float top, float
 
 
 
-inline Matix4x4 Matix4x4::operator+(const Matix4x4& other) const {
-	Matix4x4 out;
-	for (int i = 0; i < 16; i++) {
-		out.m[i] = m[i] + other.m[i];
-	}
-	return out;
+constexpr Matix4x4 Matix4x4::operator+(const Matix4x4& other) const {
+	return Elementwise<Matix4x4>::Add(*this, other);
 }
 
-inline Matix4x4& Matix4x4::operator+=(const Matix4x4& other) {
-	for (int i = 0; i < 16; i++) {
-		m[i] = m[i] + other.m[i];
-	}
+constexpr Matix4x4& Matix4x4::operator+=(const Matix4x4& other) {
+	*this = Elementwise<Matix4x4>::Add(*this, other);
 	return *this;
 }
 
-inline Matix4x4 Matix4x4::operator+(float value) const {
-	Matix4x4 out;
-	for (int i = 0; i < 16; i++) {
-		out.m[i] += value;
-	}
-	return out;
+constexpr Matix4x4 Matix4x4::operator+(float value) const {
+	return Elementwise<Matix4x4>::Add(*this, value);
 }
 
-inline Matix4x4& Matix4x4::operator+=(float value) {	
-	for (int i = 0; i < 16; i++) {
-		m[i] += value;
-	}
+constexpr Matix4x4& Matix4x4::operator+=(float value) {
+	*this = Elementwise<Matix4x4>::Add(*this, value);
 	return *this;
 }
 
 
-inline Matix4x4 Matix4x4::operator-(const Matix4x4& other) const  {
-	Matix4x4 out;
-	for (int i = 0; i < 16; i++) {
-		out.m[i] = m[i] - other.m[i];
-	}
-	return out;
+constexpr Matix4x4 Matix4x4::operator-(const Matix4x4& other) const  {
+	return Elementwise<Matix4x4>::Subtract(*this, other);
 }
 
-inline Matix4x4& Matix4x4::operator-=(const Matix4x4& other) {
-	for (int i = 0; i < 16; i++) {
-		m[i] = m[i] - other.m[i];
-	}
+constexpr Matix4x4& Matix4x4::operator-=(const Matix4x4& other) {
+	*this = Elementwise<Matix4x4>::Subtract(*this, other);
 	return *this;
 }
 
-inline Matix4x4 Matix4x4::operator-(float value) const  {
-	Matix4x4 out;
-	for (int i = 0; i < 16; i++) {
-		out.m[i] -= value;
-	}
-	return out;
+constexpr Matix4x4 Matix4x4::operator-(float value) const  {
+	return Elementwise<Matix4x4>::Subtract(*this, value);
 }
 
-inline Matix4x4& Matix4x4::operator-=(float value) {
-	for (int i = 0; i < 16; i++) {
-		m[i] -= value;
-	}
+constexpr Matix4x4& Matix4x4::operator-=(float value) {
+	*this = Elementwise<Matix4x4>::Subtract(*this, value);
 	return *this;
 }
 
-inline Matix4x4& Matix4x4::operator*=(float value) {
-	for (int i = 0; i < 16; i++) {
-		m[i] *= value;
-	}
+constexpr Matix4x4& Matix4x4::operator*=(float value) {
+	*this = Elementwise<Matix4x4>::Multiply(*this, value);
 	return *this;
 }
 
-inline Matix4x4 Matix4x4::operator*(float value) const  {
-	Matix4x4 out;
-	for (int i = 0; i < 16; i++) {
-		out.m[i] *= value;
-	}
-	return out;
+constexpr Matix4x4 Matix4x4::operator*(float value) const  {
+	return Elementwise<Matix4x4>::Multiply(*this, value);
 }
 
-inline Matix4x4& Matix4x4::operator/=(float value) {
-	for (int i = 0; i < 16; i++) {
-		m[i] /= value;
-	}
+constexpr Matix4x4& Matix4x4::operator/=(float value) {
+	*this = Elementwise<Matix4x4>::Divide(*this, value);
 	return *this;
 }
 
-inline Matix4x4 Matix4x4::operator/(float value) const {
-	Matix4x4 out;
-	for (int i = 0; i < 16; i++) {
-		out.m[i] = m[i] / value;
-	}
-	return out;
+constexpr Matix4x4 Matix4x4::operator/(float value) const {
+	return Elementwise<Matix4x4>::Divide(*this, value);
 }
 
-inline bool Matix4x4::operator==(const Matix4x4& other) {
-	bool res = true;
-	for (int i = 0; i < 16; i++) {
-		if (m[i] != other.m[i]) {
-			res = false;
-		}
-	}
-	return res;
+constexpr bool Matix4x4::operator==(const Matix4x4& other) const {
+	return Elementwise<Matix4x4>::Equal(*this, other);
 }
 
-inline bool Matix4x4::operator!=(const Matix4x4& other) {
-	bool res = false;
-	for (int i = 0; i < 16; i++) {
-		if (m[i] != other.m[i]) { 
-			res = true;
-		}
-	}
-	return res;
-}
-
-inline void Matix4x4::operator=(const Matix4x4& other) {
-	for (int i = 0; i < 16; i++) {
-		m[i] = other.m[i];
-	}
+constexpr bool Matix4x4::operator!=(const Matix4x4& other) const {
+	return !(*this == other);
 }
 
 #endif
@@ -0,0 +1,387 @@
+#ifndef __QUATERNION_H__
+#define __QUATERNION_H__ 1
+
+#include <math.h>
+#include <assert.h>
+#include <stddef.h>
+#include <type_traits>
+#include "vector_3.h"
+#include "matrix_4.h"
+#include "simd.h"
+
+// Unit quaternion rotation, stored as x, y, z, w in 16 bytes so one fits a
+// 128-bit register and an array of them loads as packed xyzw.
+//
+// Conversions follow Matix4x4: ToMatrix(AngleAxis(Vector3(1, 0, 0), a)) is
+// RotateX(a), and a * b converts to a.ToMatrix().Multiply(b.ToMatrix()).
+// Since vectors are rows multiplied on the left, Rotate(v) equals
+// ToMatrix().TransformDirection(v) and (a * b).Rotate(v) is
+// b.Rotate(a.Rotate(v)).
+class Quaternion {
+public:
+	Quaternion();
+	constexpr Quaternion(float x, float y, float z, float w);
+
+	static constexpr Quaternion Identity();
+	static Quaternion AngleAxis(const Vector3& axis, float radians);
+	// Same rotation as RotateX(rotateX) * RotateY(rotateY) * RotateZ(rotateZ).
+	static Quaternion Euler(float rotateX, float rotateY, float rotateZ);
+	// The upper 3x3 of matrix has to be a pure rotation.
+	static Quaternion FromMatrix(const Matix4x4& matrix);
+
+	constexpr Matix4x4 ToMatrix() const;
+	// out[i] = in[i].ToMatrix(). Every SIMD level gives the scalar bits.
+	static void ToMatrices(const Quaternion* in, Matix4x4* out, size_t n);
+
+	constexpr Quaternion Multiply(const Quaternion& other) const;
+	Vector3 Rotate(const Vector3& vector) const;
+
+	constexpr Quaternion Conjugate() const;
+	Quaternion Inverse() const;
+	float Magnitude() const;
+	constexpr float SqrMagnitude() const;
+	Quaternion Normalized() const;
+	void Normalize();
+
+	static constexpr float DotProduct(const Quaternion& a, const Quaternion& b);
+	// Both take the shorter arc and clamp t to [0, 1] like Vector3::Lerp.
+	// Nlerp is cheaper but its angular speed is not constant.
+	static Quaternion Nlerp(const Quaternion& a, const Quaternion& b, float t);
+	static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+
+	// Batch kernels on packed xyzw quaternions and row-major float[16].
+	static constexpr void ToMatricesScalar(const float* in, float* out, size_t n);
+#ifdef MATH_SIMD_X86
+	MATH_TARGET_SSE41 static void ToMatricesSSE41(const float* in, float* out, size_t n);
+	MATH_TARGET_AVX static void ToMatricesAVX(const float* in, float* out, size_t n);
+#endif
+
+	constexpr Quaternion operator*(const Quaternion& other) const;
+	constexpr Quaternion& operator*=(const Quaternion& other);
+	constexpr Quaternion operator*(float value) const;
+	constexpr Quaternion operator+(const Quaternion& other) const;
+	constexpr Quaternion operator-(const Quaternion& other) const;
+	constexpr Quaternion operator-() const;
+	constexpr bool operator==(const Quaternion& other) const;
+	constexpr bool operator!=(const Quaternion& other) const;
+
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+static_assert(std::is_trivially_copyable<Quaternion>::value, "Quaternion must be trivially copyable");
+static_assert(std::is_standard_layout<Quaternion>::value, "Quaternion must be standard layout");
+
+inline Quaternion::Quaternion() {}
+
+constexpr Quaternion::Quaternion(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+
+constexpr Quaternion Quaternion::Identity() {
+	return Quaternion(0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+inline Quaternion Quaternion::AngleAxis(const Vector3& axis, float radians) {
+	const Vector3 unit = axis.Normalized();
+	const float sin = sinf(radians * 0.5f);
+	return Quaternion(unit.x * sin, unit.y * sin, unit.z * sin, cosf(radians * 0.5f));
+}
+
+inline Quaternion Quaternion::Euler(float rotateX, float rotateY, float rotateZ) {
+	const float sin_x = sinf(rotateX * 0.5f), cos_x = cosf(rotateX * 0.5f);
+	const float sin_y = sinf(rotateY * 0.5f), cos_y = cosf(rotateY * 0.5f);
+	const float sin_z = sinf(rotateZ * 0.5f), cos_z = cosf(rotateZ * 0.5f);
+	// (sin_x, 0, 0, cos_x) * (0, sin_y, 0, cos_y) * (0, 0, sin_z, cos_z)
+	return Quaternion(sin_x * cos_y * cos_z + cos_x * sin_y * sin_z,
+		cos_x * sin_y * cos_z - sin_x * cos_y * sin_z,
+		cos_x * cos_y * sin_z + sin_x * sin_y * cos_z,
+		cos_x * cos_y * cos_z - sin_x * sin_y * sin_z);
+}
+
+inline Quaternion Quaternion::FromMatrix(const Matix4x4& matrix) {
+	// Reads the diagonal element that keeps the square root away from zero.
+	const float* m = matrix.m;
+	const float trace = m[0] + m[5] + m[10];
+	if (trace > 0.0f) {
+		const float s = sqrtf(trace + 1.0f) * 2.0f;
+		return Quaternion((m[9] - m[6]) / s, (m[2] - m[8]) / s, (m[4] - m[1]) / s, 0.25f * s);
+	}
+	if (m[0] > m[5] && m[0] > m[10]) {
+		const float s = sqrtf(1.0f + m[0] - m[5] - m[10]) * 2.0f;
+		return Quaternion(0.25f * s, (m[1] + m[4]) / s, (m[2] + m[8]) / s, (m[9] - m[6]) / s);
+	}
+	if (m[5] > m[10]) {
+		const float s = sqrtf(1.0f + m[5] - m[0] - m[10]) * 2.0f;
+		return Quaternion((m[1] + m[4]) / s, 0.25f * s, (m[6] + m[9]) / s, (m[2] - m[8]) / s);
+	}
+	const float s = sqrtf(1.0f + m[10] - m[0] - m[5]) * 2.0f;
+	return Quaternion((m[2] + m[8]) / s, (m[6] + m[9]) / s, 0.25f * s, (m[4] - m[1]) / s);
+}
+
+constexpr Matix4x4 Quaternion::ToMatrix() const {
+	const float in[4] = { x, y, z, w };
+	Matix4x4 out(0.0f);
+	ToMatricesScalar(in, out.m, 1);
+	return out;
+}
+
+inline void Quaternion::ToMatrices(const Quaternion* in, Matix4x4* out, size_t n) {
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			ToMatricesAVX(&in->x, out->m, n);
+			return;
+		case Simd::kSSE41:
+			ToMatricesSSE41(&in->x, out->m, n);
+			return;
+		default:
+			break;
+	}
+#endif
+	ToMatricesScalar(&in->x, out->m, n);
+}
+
+constexpr void Quaternion::ToMatricesScalar(const float* in, float* out, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		const float x = in[4 * i + 0];
+		const float y = in[4 * i + 1];
+		const float z = in[4 * i + 2];
+		const float w = in[4 * i + 3];
+		const float xx = x * x, yy = y * y, zz = z * z;
+		const float xy = x * y, xz = x * z, yz = y * z;
+		const float wx = w * x, wy = w * y, wz = w * z;
+		float* m = out + 16 * i;
+		m[0] = 1.0f - 2.0f * (yy + zz);
+		m[1] = 2.0f * (xy - wz);
+		m[2] = 2.0f * (xz + wy);
+		m[3] = 0.0f;
+		m[4] = 2.0f * (xy + wz);
+		m[5] = 1.0f - 2.0f * (xx + zz);
+		m[6] = 2.0f * (yz - wx);
+		m[7] = 0.0f;
+		m[8] = 2.0f * (xz - wy);
+		m[9] = 2.0f * (yz + wx);
+		m[10] = 1.0f - 2.0f * (xx + yy);
+		m[11] = 0.0f;
+		m[12] = 0.0f;
+		m[13] = 0.0f;
+		m[14] = 0.0f;
+		m[15] = 1.0f;
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Quaternion::ToMatricesSSE41(const float* in, float* out, size_t n) {
+	// Four quaternions per iteration: transpose them to x, y, z and w
+	// registers, build the nine rotation terms, transpose back into lines.
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 last = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 x = _mm_loadu_ps(in + 4 * i + 0);
+		__m128 y = _mm_loadu_ps(in + 4 * i + 4);
+		__m128 z = _mm_loadu_ps(in + 4 * i + 8);
+		__m128 w = _mm_loadu_ps(in + 4 * i + 12);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		const __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		const __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		const __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+		__m128 m0 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)));
+		__m128 m1 = _mm_mul_ps(two, _mm_sub_ps(xy, wz));
+		__m128 m2 = _mm_mul_ps(two, _mm_add_ps(xz, wy));
+		__m128 m3 = zero;
+		__m128 m4 = _mm_mul_ps(two, _mm_add_ps(xy, wz));
+		__m128 m5 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)));
+		__m128 m6 = _mm_mul_ps(two, _mm_sub_ps(yz, wx));
+		__m128 m7 = zero;
+		__m128 m8 = _mm_mul_ps(two, _mm_sub_ps(xz, wy));
+		__m128 m9 = _mm_mul_ps(two, _mm_add_ps(yz, wx));
+		__m128 m10 = _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)));
+		__m128 m11 = zero;
+		_MM_TRANSPOSE4_PS(m0, m1, m2, m3);
+		_MM_TRANSPOSE4_PS(m4, m5, m6, m7);
+		_MM_TRANSPOSE4_PS(m8, m9, m10, m11);
+
+		float* matrix = out + 16 * i;
+		_mm_storeu_ps(matrix + 0, m0);
+		_mm_storeu_ps(matrix + 4, m4);
+		_mm_storeu_ps(matrix + 8, m8);
+		_mm_storeu_ps(matrix + 12, last);
+		_mm_storeu_ps(matrix + 16, m1);
+		_mm_storeu_ps(matrix + 20, m5);
+		_mm_storeu_ps(matrix + 24, m9);
+		_mm_storeu_ps(matrix + 28, last);
+		_mm_storeu_ps(matrix + 32, m2);
+		_mm_storeu_ps(matrix + 36, m6);
+		_mm_storeu_ps(matrix + 40, m10);
+		_mm_storeu_ps(matrix + 44, last);
+		_mm_storeu_ps(matrix + 48, m3);
+		_mm_storeu_ps(matrix + 52, m7);
+		_mm_storeu_ps(matrix + 56, m11);
+		_mm_storeu_ps(matrix + 60, last);
+	}
+	ToMatricesScalar(in + 4 * i, out + 16 * i, n - i);
+}
+
+MATH_TARGET_AVX inline void Quaternion::ToMatricesAVX(const float* in, float* out, size_t n) {
+	// Same as the SSE4.1 kernel on eight quaternions. The low 128-bit halves
+	// hold quaternions 0, 2, 4, 6 and the high halves 1, 3, 5, 7.
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m128 last = _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 x = _mm256_loadu_ps(in + 4 * i + 0);
+		__m256 y = _mm256_loadu_ps(in + 4 * i + 8);
+		__m256 z = _mm256_loadu_ps(in + 4 * i + 16);
+		__m256 w = _mm256_loadu_ps(in + 4 * i + 24);
+		Simd::Transpose4(x, y, z, w);
+
+		const __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+		const __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+		const __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+		__m256 lines[12];
+		lines[0] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz)));
+		lines[1] = _mm256_mul_ps(two, _mm256_sub_ps(xy, wz));
+		lines[2] = _mm256_mul_ps(two, _mm256_add_ps(xz, wy));
+		lines[3] = zero;
+		lines[4] = _mm256_mul_ps(two, _mm256_add_ps(xy, wz));
+		lines[5] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz)));
+		lines[6] = _mm256_mul_ps(two, _mm256_sub_ps(yz, wx));
+		lines[7] = zero;
+		lines[8] = _mm256_mul_ps(two, _mm256_sub_ps(xz, wy));
+		lines[9] = _mm256_mul_ps(two, _mm256_add_ps(yz, wx));
+		lines[10] = _mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy)));
+		lines[11] = zero;
+		Simd::Transpose4(lines[0], lines[1], lines[2], lines[3]);
+		Simd::Transpose4(lines[4], lines[5], lines[6], lines[7]);
+		Simd::Transpose4(lines[8], lines[9], lines[10], lines[11]);
+
+		// lines[4 * row + k] holds that row of quaternions 2k and 2k + 1.
+		for (int k = 0; k < 4; k++) {
+			float* even = out + 16 * (i + 2 * k);
+			float* odd = even + 16;
+			for (int row = 0; row < 3; row++) {
+				_mm_storeu_ps(even + 4 * row, _mm256_castps256_ps128(lines[4 * row + k]));
+				_mm_storeu_ps(odd + 4 * row, _mm256_extractf128_ps(lines[4 * row + k], 1));
+			}
+			_mm_storeu_ps(even + 12, last);
+			_mm_storeu_ps(odd + 12, last);
+		}
+	}
+	ToMatricesScalar(in + 4 * i, out + 16 * i, n - i);
+}
+#endif
+
+constexpr Quaternion Quaternion::Multiply(const Quaternion& other) const {
+	return Quaternion(w * other.x + x * other.w + y * other.z - z * other.y,
+		w * other.y - x * other.z + y * other.w + z * other.x,
+		w * other.z + x * other.y - y * other.x + z * other.w,
+		w * other.w - x * other.x - y * other.y - z * other.z);
+}
+
+inline Vector3 Quaternion::Rotate(const Vector3& vector) const {
+	// Conjugate(q) * v * q without building the matrix:
+	// v + 2w(v x u) + 2u x (u x v), u = (x, y, z).
+	const Vector3 u(x, y, z);
+	const Vector3 t = Vector3::CrossProduct(vector, u) * 2.0f;
+	return vector + t * w + Vector3::CrossProduct(t, u);
+}
+
+constexpr Quaternion Quaternion::Conjugate() const {
+	return Quaternion(-x, -y, -z, w);
+}
+
+inline Quaternion Quaternion::Inverse() const {
+	const float sqr_magnitude = SqrMagnitude();
+	assert(sqr_magnitude != 0 && "Magnitude is 0");
+	const float inverted = 1 / sqr_magnitude;
+	return Quaternion(-x * inverted, -y * inverted, -z * inverted, w * inverted);
+}
+
+inline float Quaternion::Magnitude() const {
+	return sqrtf(x*x + y*y + z*z + w*w);
+}
+
+constexpr float Quaternion::SqrMagnitude() const {
+	return x*x + y*y + z*z + w*w;
+}
+
+inline Quaternion Quaternion::Normalized() const {
+	assert(Magnitude() != 0 && "Magnitude is 0");
+	float invertedMagnitude = 1 / Magnitude();
+	return Quaternion(x * invertedMagnitude, y * invertedMagnitude, z * invertedMagnitude, w * invertedMagnitude);
+}
+
+inline void Quaternion::Normalize() {
+	*this = Normalized();
+}
+
+constexpr float Quaternion::DotProduct(const Quaternion& a, const Quaternion& b) {
+	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+
+inline Quaternion Quaternion::Nlerp(const Quaternion& a, const Quaternion& b, float t) {
+	t = MathUtils::Saturate(t);
+	// q and -q are the same rotation; flip b onto a's hemisphere.
+	const Quaternion end = DotProduct(a, b) < 0.0f ? -b : b;
+	return Quaternion(a.x + (end.x - a.x) * t, a.y + (end.y - a.y) * t,
+		a.z + (end.z - a.z) * t, a.w + (end.w - a.w) * t).Normalized();
+}
+
+inline Quaternion Quaternion::Slerp(const Quaternion& a, const Quaternion& b, float t) {
+	t = MathUtils::Saturate(t);
+	float cos = DotProduct(a, b);
+	const Quaternion end = cos < 0.0f ? -b : b;
+	if (cos < 0.0f) { cos = -cos; }
+	// Nearly parallel: sin(angle) is too small to divide by and the arc is
+	// a straight line anyway.
+	if (cos > 0.9995f) {
+		return Nlerp(a, end, t);
+	}
+	const float angle = acosf(cos);
+	const float inverted_sin = 1 / sinf(angle);
+	const float weight_a = sinf((1.0f - t) * angle) * inverted_sin;
+	const float weight_b = sinf(t * angle) * inverted_sin;
+	return a * weight_a + end * weight_b;
+}
+
+constexpr Quaternion Quaternion::operator*(const Quaternion& other) const {
+	return Multiply(other);
+}
+
+constexpr Quaternion& Quaternion::operator*=(const Quaternion& other) {
+	*this = Multiply(other);
+	return *this;
+}
+
+constexpr Quaternion Quaternion::operator*(float value) const {
+	return Quaternion(x * value, y * value, z * value, w * value);
+}
+
+constexpr Quaternion Quaternion::operator+(const Quaternion& other) const {
+	return Quaternion(x + other.x, y + other.y, z + other.z, w + other.w);
+}
+
+constexpr Quaternion Quaternion::operator-(const Quaternion& other) const {
+	return Quaternion(x - other.x, y - other.y, z - other.z, w - other.w);
+}
+
+constexpr Quaternion Quaternion::operator-() const {
+	return Quaternion(-x, -y, -z, -w);
+}
+
+constexpr bool Quaternion::operator==(const Quaternion& other) const {
+	return x == other.x && y == other.y && z == other.z && w == other.w;
+}
+
+constexpr bool Quaternion::operator!=(const Quaternion& other) const {
+	return !(*this == other);
+}
+
+#endif
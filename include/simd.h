@@ -0,0 +1,219 @@
+#ifndef __SIMD_H__
+#define __SIMD_H__ 1
+
+// Runtime selection of the SIMD code paths used by the math types.
+// Define MATH_NO_SIMD to compile the scalar paths only.
+
+#if !defined(MATH_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define MATH_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// GCC and Clang need the instruction set enabled per function so that the
+// library can be built without -mavx2 and still dispatch to AVX2 at runtime.
+// MATH_TARGET_AVX is for 8-wide kernels that must not be contracted to FMA
+// and so keep the bits of the scalar code; they still run at Simd::kAVX2.
+#if defined(__GNUC__) || defined(__clang__)
+#define MATH_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define MATH_TARGET_AVX __attribute__((target("avx")))
+#define MATH_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define MATH_TARGET_SSE41
+#define MATH_TARGET_AVX
+#define MATH_TARGET_AVX2
+#endif
+#endif
+
+// True while a constexpr function runs at compile time, where it has to skip
+// the runtime dispatch. Without the builtin the dispatching functions are
+// still constexpr but only usable at run time.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define MATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(MATH_CONSTANT_EVALUATED) && ((defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define MATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#if !defined(MATH_CONSTANT_EVALUATED)
+#define MATH_CONSTANT_EVALUATED() false
+#endif
+
+class Simd {
+public:
+	enum Level {
+		kScalar = 0,
+		kSSE41 = 1,
+		kAVX2 = 2
+	};
+
+	// Best level the CPU and OS support.
+	static Level Supported();
+	// Level the dispatching functions use. Defaults to Supported().
+	static Level Active();
+	// Forces a lower level, e.g. to compare paths. Clamped to Supported().
+	static void SetActive(Level level);
+	static const char* Name(Level level);
+
+#ifdef MATH_SIMD_X86
+	// Packed xyz triples <-> separate x, y and z registers. The 4-wide forms
+	// read or write 12 floats, the 8-wide forms 24.
+	MATH_TARGET_SSE41 static void LoadXYZ(const float* src, __m128& x, __m128& y, __m128& z);
+	MATH_TARGET_SSE41 static void StoreXYZ(float* dst, __m128 x, __m128 y, __m128 z);
+	MATH_TARGET_AVX static void LoadXYZ(const float* src, __m256& x, __m256& y, __m256& z);
+	MATH_TARGET_AVX static void StoreXYZ(float* dst, __m256 x, __m256 y, __m256 z);
+	// 4x4 transpose inside each 128-bit half of a, b, c and d.
+	MATH_TARGET_AVX static void Transpose4(__m256& a, __m256& b, __m256& c, __m256& d);
+#endif
+
+private:
+	Simd();
+	Simd(const Simd& copy);
+	~Simd();
+
+	static Level Detect();
+	static Level& ActiveLevel();
+};
+
+inline Simd::Level Simd::Detect() {
+#ifdef MATH_SIMD_X86
+	unsigned int regs[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	unsigned int max_leaf = info[0];
+	__cpuid(info, 1);
+	regs[2] = info[2];
+#else
+	unsigned int max_leaf = __get_cpuid_max(0, 0);
+	__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	const bool sse41 = (regs[2] & (1u << 19)) != 0;
+	const bool fma = (regs[2] & (1u << 12)) != 0;
+	const bool osxsave = (regs[2] & (1u << 27)) != 0;
+	if (!sse41) {
+		return kScalar;
+	}
+	if (!fma || !osxsave || max_leaf < 7) {
+		return kSSE41;
+	}
+
+	// The OS has to save the YMM registers on context switch (XCR0 bits 1 and 2).
+#if defined(_MSC_VER)
+	unsigned long long xcr0 = _xgetbv(0);
+#else
+	unsigned int xcr0_lo, xcr0_hi;
+	__asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	unsigned long long xcr0 = ((unsigned long long)xcr0_hi << 32) | xcr0_lo;
+#endif
+	if ((xcr0 & 0x6) != 0x6) {
+		return kSSE41;
+	}
+
+#if defined(_MSC_VER)
+	__cpuidex(info, 7, 0);
+	regs[1] = info[1];
+#else
+	__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	const bool avx2 = (regs[1] & (1u << 5)) != 0;
+	return avx2 ? kAVX2 : kSSE41;
+#else
+	return kScalar;
+#endif
+}
+
+inline Simd::Level Simd::Supported() {
+	static const Level level = Detect();
+	return level;
+}
+
+inline Simd::Level& Simd::ActiveLevel() {
+	static Level level = Supported();
+	return level;
+}
+
+inline Simd::Level Simd::Active() {
+	return ActiveLevel();
+}
+
+inline void Simd::SetActive(Level level) {
+	ActiveLevel() = level > Supported() ? Supported() : level;
+}
+
+inline const char* Simd::Name(Level level) {
+	switch (level) {
+		case kAVX2: return "avx2+fma";
+		case kSSE41: return "sse4.1";
+		default: return "scalar";
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Simd::LoadXYZ(const float* src, __m128& x, __m128& y, __m128& z) {
+	const __m128 xyzx = _mm_loadu_ps(src + 0);
+	const __m128 yzxy = _mm_loadu_ps(src + 4);
+	const __m128 zxyz = _mm_loadu_ps(src + 8);
+	const __m128 xy = _mm_shuffle_ps(yzxy, zxyz, _MM_SHUFFLE(2, 1, 3, 2));
+	const __m128 yz = _mm_shuffle_ps(xyzx, yzxy, _MM_SHUFFLE(1, 0, 2, 1));
+	x = _mm_shuffle_ps(xyzx, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm_shuffle_ps(yz, zxyz, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+MATH_TARGET_SSE41 inline void Simd::StoreXYZ(float* dst, __m128 x, __m128 y, __m128 z) {
+	const __m128 xy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	const __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	_mm_storeu_ps(dst + 0, _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(dst + 4, _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+	_mm_storeu_ps(dst + 8, _mm_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+MATH_TARGET_AVX inline void Simd::LoadXYZ(const float* src, __m256& x, __m256& y, __m256& z) {
+	// Same shuffles as the 4-wide form, in both 128-bit halves at once.
+	__m256 xyzx = _mm256_castps128_ps256(_mm_loadu_ps(src + 0));
+	__m256 yzxy = _mm256_castps128_ps256(_mm_loadu_ps(src + 4));
+	__m256 zxyz = _mm256_castps128_ps256(_mm_loadu_ps(src + 8));
+	xyzx = _mm256_insertf128_ps(xyzx, _mm_loadu_ps(src + 12), 1);
+	yzxy = _mm256_insertf128_ps(yzxy, _mm_loadu_ps(src + 16), 1);
+	zxyz = _mm256_insertf128_ps(zxyz, _mm_loadu_ps(src + 20), 1);
+	const __m256 xy = _mm256_shuffle_ps(yzxy, zxyz, _MM_SHUFFLE(2, 1, 3, 2));
+	const __m256 yz = _mm256_shuffle_ps(xyzx, yzxy, _MM_SHUFFLE(1, 0, 2, 1));
+	x = _mm256_shuffle_ps(xyzx, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm256_shuffle_ps(yz, zxyz, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+MATH_TARGET_AVX inline void Simd::StoreXYZ(float* dst, __m256 x, __m256 y, __m256 z) {
+	const __m256 xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	const __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256 r0 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m256 r1 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256 r2 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm_storeu_ps(dst + 0, _mm256_castps256_ps128(r0));
+	_mm_storeu_ps(dst + 4, _mm256_castps256_ps128(r1));
+	_mm_storeu_ps(dst + 8, _mm256_castps256_ps128(r2));
+	_mm_storeu_ps(dst + 12, _mm256_extractf128_ps(r0, 1));
+	_mm_storeu_ps(dst + 16, _mm256_extractf128_ps(r1, 1));
+	_mm_storeu_ps(dst + 20, _mm256_extractf128_ps(r2, 1));
+}
+
+MATH_TARGET_AVX inline void Simd::Transpose4(__m256& a, __m256& b, __m256& c, __m256& d) {
+	const __m256 ab_low = _mm256_unpacklo_ps(a, b);
+	const __m256 cd_low = _mm256_unpacklo_ps(c, d);
+	const __m256 ab_high = _mm256_unpackhi_ps(a, b);
+	const __m256 cd_high = _mm256_unpackhi_ps(c, d);
+	a = _mm256_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(1, 0, 1, 0));
+	b = _mm256_shuffle_ps(ab_low, cd_low, _MM_SHUFFLE(3, 2, 3, 2));
+	c = _mm256_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(1, 0, 1, 0));
+	d = _mm256_shuffle_ps(ab_high, cd_high, _MM_SHUFFLE(3, 2, 3, 2));
+}
+#endif
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef __SKINNING_H__
+#define __SKINNING_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix_4.h"
+#include "simd.h"
+#include "thread_pool.h"
+#include "vector_3_stream.h"
+
+// Linear blend skinning of SoA meshes against a bone palette. Every vertex
+// has kInfluences bone indices and weights, packed per vertex: indices and
+// weights hold kInfluences * positions.Size() elements, vertex i at
+// [kInfluences * i, kInfluences * i + kInfluences). Unused influences need
+// weight 0 and any valid index. Weights are used as given, not normalized.
+//
+// The blended matrix of a vertex is
+//   M = w[0] * palette[index[0]] + ... + w[3] * palette[index[3]]
+// summed in that order, and positions_out[i] = M.TransformPoint(positions[i])
+// bit for bit. Normals go through the upper 3x3 of M and are not
+// renormalized; follow with Vector3Stream::Normalize when bones scale, or
+// when the blend of rotations shortens them.
+class Skinning {
+public:
+	static const int kInfluences = 4;
+
+	// palette has bones matrices, and every index is below bones. normals
+	// may be empty to skin positions only; otherwise it has as many
+	// elements as positions. The outputs are resized to match and may be
+	// the inputs.
+	static void Skin(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+		const Vector3Stream& positions, const Vector3Stream& normals,
+		Vector3Stream& positions_out, Vector3Stream& normals_out);
+	// Skin split across the pool in ranges of kChunk vertices. Same bits as
+	// the single threaded form.
+	static void Skin(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+		const Vector3Stream& positions, const Vector3Stream& normals,
+		Vector3Stream& positions_out, Vector3Stream& normals_out, ThreadPool& pool);
+
+private:
+	Skinning();
+	Skinning(const Skinning& copy);
+	~Skinning();
+
+	// Vertices per task. Smaller meshes run on the calling thread.
+	static const size_t kChunk = 4096;
+	// Vertices per iteration of the AVX kernel.
+	static const size_t kBlock = 4;
+
+	static void Prepare(const Vector3Stream& positions, const Vector3Stream& normals,
+		Vector3Stream& positions_out, Vector3Stream& normals_out);
+	static void SkinRange(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+		const Vector3Stream& positions, const Vector3Stream& normals,
+		Vector3Stream& positions_out, Vector3Stream& normals_out, size_t begin, size_t end);
+	static void SkinScalar(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+		const Vector3Stream& positions, const Vector3Stream& normals,
+		Vector3Stream& positions_out, Vector3Stream& normals_out, size_t begin, size_t end);
+	// The first three colums of the blended matrix of one vertex; m[3],
+	// m[7], m[11] and m[15] are left unset.
+	static void Blend(const Matix4x4* palette, size_t bones, const uint16_t* index, const float* weight, float* m);
+
+#ifdef MATH_SIMD_X86
+	// Blends each vertex's matrix as two lines per register, then
+	// transforms the block of four and transposes the results back to SoA.
+	// Whole blocks only; end - begin is a multiple of kBlock.
+	MATH_TARGET_AVX static void SkinAVX(const Matix4x4* palette, size_t bones, const uint16_t* indices,
+		const float* weights, const Vector3Stream& positions, const Vector3Stream& normals,
+		Vector3Stream& positions_out, Vector3Stream& normals_out, size_t begin, size_t end);
+#endif
+};
+
+inline Skinning::Skinning() {}
+inline Skinning::Skinning(const Skinning&) {}
+inline Skinning::~Skinning() {}
+
+inline void Skinning::Skin(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+	const Vector3Stream& positions, const Vector3Stream& normals,
+	Vector3Stream& positions_out, Vector3Stream& normals_out) {
+	Prepare(positions, normals, positions_out, normals_out);
+	SkinRange(palette, bones, indices, weights, positions, normals, positions_out, normals_out, 0, positions.Size());
+}
+
+inline void Skinning::Skin(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+	const Vector3Stream& positions, const Vector3Stream& normals,
+	Vector3Stream& positions_out, Vector3Stream& normals_out, ThreadPool& pool) {
+	Prepare(positions, normals, positions_out, normals_out);
+	const size_t n = positions.Size();
+	if (n < 2 * kChunk) {
+		SkinRange(palette, bones, indices, weights, positions, normals, positions_out, normals_out, 0, n);
+		return;
+	}
+	pool.ParallelFor(n, kChunk, [&](size_t begin, size_t end) {
+		SkinRange(palette, bones, indices, weights, positions, normals, positions_out, normals_out, begin, end);
+	});
+}
+
+inline void Skinning::Prepare(const Vector3Stream& positions, const Vector3Stream& normals,
+	Vector3Stream& positions_out, Vector3Stream& normals_out) {
+	assert((normals.Size() == 0 || normals.Size() == positions.Size()) && "Streams differ in size");
+	// Resizing to the same size keeps the buffers, so outputs that are the
+	// inputs stay valid.
+	positions_out.Resize(positions.Size());
+	if (normals.Size() != 0) {
+		normals_out.Resize(normals.Size());
+	}
+}
+
+inline void Skinning::SkinRange(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+	const Vector3Stream& positions, const Vector3Stream& normals,
+	Vector3Stream& positions_out, Vector3Stream& normals_out, size_t begin, size_t end) {
+	size_t i = begin;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = begin + (end - begin) / kBlock * kBlock;
+		SkinAVX(palette, bones, indices, weights, positions, normals, positions_out, normals_out, begin, i);
+	}
+#endif
+	SkinScalar(palette, bones, indices, weights, positions, normals, positions_out, normals_out, i, end);
+}
+
+inline void Skinning::Blend(const Matix4x4* palette, size_t bones, const uint16_t* index, const float* weight, float* m) {
+	// Only the asserts read bones.
+	(void)bones;
+	for (int k = 0; k < kInfluences; k++) {
+		assert(index[k] < bones && "Bone index out of range");
+	}
+	const float* m0 = palette[index[0]].m;
+	const float* m1 = palette[index[1]].m;
+	const float* m2 = palette[index[2]].m;
+	const float* m3 = palette[index[3]].m;
+	for (int line = 0; line < 4; line++) {
+		for (int colum = 0; colum < 3; colum++) {
+			const int j = 4 * line + colum;
+			m[j] = weight[0] * m0[j] + weight[1] * m1[j] + weight[2] * m2[j] + weight[3] * m3[j];
+		}
+	}
+}
+
+inline void Skinning::SkinScalar(const Matix4x4* palette, size_t bones, const uint16_t* indices, const float* weights,
+	const Vector3Stream& positions, const Vector3Stream& normals,
+	Vector3Stream& positions_out, Vector3Stream& normals_out, size_t begin, size_t end) {
+	const bool skin_normals = normals.Size() != 0;
+	for (size_t i = begin; i < end; i++) {
+		float m[16];
+		Blend(palette, bones, indices + kInfluences * i, weights + kInfluences * i, m);
+		const float x = positions.x[i];
+		const float y = positions.y[i];
+		const float z = positions.z[i];
+		positions_out.x[i] = x * m[0] + y * m[4] + z * m[8] + m[12];
+		positions_out.y[i] = x * m[1] + y * m[5] + z * m[9] + m[13];
+		positions_out.z[i] = x * m[2] + y * m[6] + z * m[10] + m[14];
+		if (skin_normals) {
+			const float nx = normals.x[i];
+			const float ny = normals.y[i];
+			const float nz = normals.z[i];
+			normals_out.x[i] = nx * m[0] + ny * m[4] + nz * m[8];
+			normals_out.y[i] = nx * m[1] + ny * m[5] + nz * m[9];
+			normals_out.z[i] = nx * m[2] + ny * m[6] + nz * m[10];
+		}
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_AVX inline void Skinning::SkinAVX(const Matix4x4* palette, size_t bones, const uint16_t* indices,
+	const float* weights, const Vector3Stream& positions, const Vector3Stream& normals,
+	Vector3Stream& positions_out, Vector3Stream& normals_out, size_t begin, size_t end) {
+	(void)bones;
+	const bool skin_normals = normals.Size() != 0;
+	for (size_t i = begin; i < end; i += kBlock) {
+		// Loaded before any store, so the outputs may be the inputs.
+		const __m128 x = _mm_loadu_ps(positions.x + i);
+		const __m128 y = _mm_loadu_ps(positions.y + i);
+		const __m128 z = _mm_loadu_ps(positions.z + i);
+		__m128 nx = _mm_setzero_ps(), ny = _mm_setzero_ps(), nz = _mm_setzero_ps();
+		if (skin_normals) {
+			nx = _mm_loadu_ps(normals.x + i);
+			ny = _mm_loadu_ps(normals.y + i);
+			nz = _mm_loadu_ps(normals.z + i);
+		}
+
+		__m128 point[kBlock];
+		__m128 normal[kBlock];
+		for (size_t k = 0; k < kBlock; k++) {
+			const uint16_t* index = indices + kInfluences * (i + k);
+			const float* weight = weights + kInfluences * (i + k);
+			// Lines 0 and 1 in one register, 2 and 3 in the other, summed in
+			// the order of Blend.
+			__m256 lines01 = _mm256_setzero_ps();
+			__m256 lines23 = _mm256_setzero_ps();
+			for (int b = 0; b < kInfluences; b++) {
+				assert(index[b] < bones && "Bone index out of range");
+				const float* m = palette[index[b]].m;
+				const __m256 w = _mm256_broadcast_ss(weight + b);
+				const __m256 weighted01 = _mm256_mul_ps(w, _mm256_loadu_ps(m));
+				const __m256 weighted23 = _mm256_mul_ps(w, _mm256_loadu_ps(m + 8));
+				lines01 = b == 0 ? weighted01 : _mm256_add_ps(lines01, weighted01);
+				lines23 = b == 0 ? weighted23 : _mm256_add_ps(lines23, weighted23);
+			}
+			const __m128 line0 = _mm256_castps256_ps128(lines01);
+			const __m128 line1 = _mm256_extractf128_ps(lines01, 1);
+			const __m128 line2 = _mm256_castps256_ps128(lines23);
+			const __m128 line3 = _mm256_extractf128_ps(lines23, 1);
+
+			const __m128i lane = _mm_set1_epi32((int)k);
+			__m128 p = _mm_add_ps(_mm_mul_ps(_mm_permutevar_ps(x, lane), line0),
+				_mm_mul_ps(_mm_permutevar_ps(y, lane), line1));
+			p = _mm_add_ps(p, _mm_mul_ps(_mm_permutevar_ps(z, lane), line2));
+			point[k] = _mm_add_ps(p, line3);
+			if (skin_normals) {
+				const __m128 n = _mm_add_ps(_mm_mul_ps(_mm_permutevar_ps(nx, lane), line0),
+					_mm_mul_ps(_mm_permutevar_ps(ny, lane), line1));
+				normal[k] = _mm_add_ps(n, _mm_mul_ps(_mm_permutevar_ps(nz, lane), line2));
+			}
+		}
+
+		// Vertex per register to x, y, z per register; the fourth is the
+		// unused w.
+		_MM_TRANSPOSE4_PS(point[0], point[1], point[2], point[3]);
+		_mm_storeu_ps(positions_out.x + i, point[0]);
+		_mm_storeu_ps(positions_out.y + i, point[1]);
+		_mm_storeu_ps(positions_out.z + i, point[2]);
+		if (skin_normals) {
+			_MM_TRANSPOSE4_PS(normal[0], normal[1], normal[2], normal[3]);
+			_mm_storeu_ps(normals_out.x + i, normal[0]);
+			_mm_storeu_ps(normals_out.y + i, normal[1]);
+			_mm_storeu_ps(normals_out.z + i, normal[2]);
+		}
+	}
+}
+#endif
+
+#endif
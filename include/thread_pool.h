@@ -0,0 +1,189 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__ 1
+
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. ParallelFor gives
+// every thread a contiguous slice of the range; a thread that finishes its
+// slice steals chunks from the others, so uneven chunks still balance.
+// The calling thread takes part, and one ParallelFor runs at a time: bodies
+// must not call back into the same pool.
+class ThreadPool {
+public:
+	// threads counts the calling thread, so ThreadPool(1) runs everything
+	// inline. 0 uses one thread per hardware thread.
+	explicit ThreadPool(int threads = 0);
+	~ThreadPool();
+
+	int Size() const;
+
+	// Calls body(begin, end) on chunks of at most grain indices that cover
+	// [0, n) once, and returns when all of them have run.
+	template<class F>
+	void ParallelFor(size_t n, size_t grain, const F& body);
+
+private:
+	ThreadPool(const ThreadPool& copy);
+	ThreadPool& operator=(const ThreadPool& copy);
+
+	typedef void (*Body)(const void* context, size_t begin, size_t end);
+
+	// One per thread, on its own cache line.
+	struct alignas(64) Slice {
+		std::atomic<size_t> next;
+		size_t end;
+	};
+
+	template<class F>
+	static void Call(const void* context, size_t begin, size_t end);
+
+	void Run(Body body, const void* context, size_t n, size_t grain);
+	void Work(int index);
+	void WorkerLoop(int index);
+
+	int size_;
+	std::vector<std::thread> workers_;
+	std::unique_ptr<Slice[]> slices_;
+
+	std::mutex mutex_;
+	std::condition_variable start_;
+	std::condition_variable done_;
+	unsigned int generation_;
+	int pending_;
+	bool stop_;
+
+	Body body_;
+	const void* context_;
+	size_t grain_;
+};
+
+inline ThreadPool::ThreadPool(int threads)
+	: size_(threads), generation_(0), pending_(0), stop_(false), body_(0), context_(0), grain_(1) {
+	if (size_ <= 0) {
+		size_ = (int)std::thread::hardware_concurrency();
+		if (size_ <= 0) {
+			size_ = 1;
+		}
+	}
+	slices_.reset(new Slice[size_]);
+	for (int i = 0; i < size_; i++) {
+		slices_[i].next.store(0, std::memory_order_relaxed);
+		slices_[i].end = 0;
+	}
+	// Thread 0 is the caller of ParallelFor.
+	for (int i = 1; i < size_; i++) {
+		workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+	}
+}
+
+inline ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	start_.notify_all();
+	for (size_t i = 0; i < workers_.size(); i++) {
+		workers_[i].join();
+	}
+}
+
+inline int ThreadPool::Size() const {
+	return size_;
+}
+
+template<class F>
+inline void ThreadPool::ParallelFor(size_t n, size_t grain, const F& body) {
+	Run(&Call<F>, &body, n, grain);
+}
+
+template<class F>
+inline void ThreadPool::Call(const void* context, size_t begin, size_t end) {
+	(*static_cast<const F*>(context))(begin, end);
+}
+
+inline void ThreadPool::Run(Body body, const void* context, size_t n, size_t grain) {
+	if (grain == 0) {
+		grain = 1;
+	}
+	if (n == 0) {
+		return;
+	}
+	if (size_ == 1 || n <= grain) {
+		for (size_t begin = 0; begin < n; begin += grain) {
+			body(context, begin, n - begin < grain ? n : begin + grain);
+		}
+		return;
+	}
+
+	// Slices start on chunk boundaries so that chunks never straddle two.
+	const size_t chunks = (n + grain - 1) / grain;
+	for (int i = 0; i < size_; i++) {
+		const size_t first = chunks * i / size_ * grain;
+		const size_t last = chunks * (i + 1) / size_ * grain;
+		slices_[i].next.store(first < n ? first : n, std::memory_order_relaxed);
+		slices_[i].end = last < n ? last : n;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		body_ = body;
+		context_ = context;
+		grain_ = grain;
+		pending_ = size_ - 1;
+		generation_++;
+	}
+	start_.notify_all();
+
+	Work(0);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this] { return pending_ == 0; });
+}
+
+inline void ThreadPool::Work(int index) {
+	// Own slice first, then the others in turn.
+	for (int k = 0; k < size_; k++) {
+		Slice& slice = slices_[(index + k) % size_];
+		for (;;) {
+			const size_t begin = slice.next.fetch_add(grain_, std::memory_order_relaxed);
+			if (begin >= slice.end) {
+				break;
+			}
+			const size_t end = slice.end - begin < grain_ ? slice.end : begin + grain_;
+			body_(context_, begin, end);
+		}
+	}
+}
+
+inline void ThreadPool::WorkerLoop(int index) {
+	unsigned int seen = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			start_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+			if (stop_) {
+				return;
+			}
+			seen = generation_;
+		}
+
+		Work(index);
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			last = --pending_ == 0;
+		}
+		if (last) {
+			done_.notify_one();
+		}
+	}
+}
+
+#endif
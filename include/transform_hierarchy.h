@@ -0,0 +1,173 @@
+#ifndef __TRANSFORM_HIERARCHY_H__
+#define __TRANSFORM_HIERARCHY_H__ 1
+
+#include <assert.h>
+#include <stddef.h>
+#include <vector>
+#include "matrix_4.h"
+#include "simd.h"
+#include "thread_pool.h"
+
+// Parent indices of a scene graph, sorted into levels once so that world
+// transforms can be resolved level by level: every node of a level only
+// reads world matrices of the levels before it, so a level can be split
+// across threads freely.
+class TransformHierarchy {
+public:
+	// parent[i] is the index of node i's parent, or -1 for a root. Parents
+	// may come after their children; cycles are not allowed. Both a parent
+	// index of n or more and a cycle assert; with asserts off, that node
+	// becomes a root, cutting a cycle at the node that closes it.
+	TransformHierarchy(const int* parent, size_t n);
+
+	size_t Size() const;
+	size_t LevelCount() const;
+
+	// world[i] = local[i] * world[parent[i]] and world[root] = local[root],
+	// so v * world applies the node's own transform first, like
+	// Matix4x4::Multiply. world must not alias local.
+	void Resolve(const Matix4x4* local, Matix4x4* world) const;
+	void Resolve(const Matix4x4* local, Matix4x4* world, ThreadPool& pool) const;
+
+	// Matix4x4::Multiply(a, b, out, n) split across the pool.
+	static void Multiply(const Matix4x4* a, const Matix4x4* b, Matix4x4* out, size_t n, ThreadPool& pool);
+
+private:
+	typedef void (*Kernel)(const float* a, const float* b, float* out);
+
+	// Matrices per task. A level smaller than two chunks runs on the
+	// calling thread, where waking the pool would cost more than it saves.
+	static const size_t kChunk = 1024;
+
+	static Kernel ActiveKernel();
+	static void ResolveRange(Kernel kernel, const int* parent, const int* order,
+		const Matix4x4* local, Matix4x4* world, size_t begin, size_t end);
+
+	std::vector<int> parent_;
+	// Node indices grouped by level, roots first, in index order inside a
+	// level; level l is order_[level_begin_[l], level_begin_[l + 1]).
+	std::vector<int> order_;
+	std::vector<size_t> level_begin_;
+};
+
+inline TransformHierarchy::TransformHierarchy(const int* parent, size_t n) : parent_(parent, parent + n) {
+	// Depth of every node, walking up until a node with a known depth.
+	// Nodes on the current walk are marked, so reaching one again is a
+	// cycle.
+	const int kUnknown = -1;
+	const int kWalking = -2;
+	std::vector<int> depth(n, kUnknown);
+	std::vector<int> path;
+	int max_depth = -1;
+	for (size_t i = 0; i < n; i++) {
+		int node = (int)i;
+		while (node >= 0 && depth[node] == kUnknown) {
+			depth[node] = kWalking;
+			path.push_back(node);
+			const bool in_range = parent_[node] < (int)n;
+			assert(in_range && "Parent index out of range");
+			if (!in_range) {
+				parent_[node] = -1;
+			}
+			node = parent_[node];
+		}
+		const bool cycle = node >= 0 && depth[node] == kWalking;
+		assert(!cycle && "Cycle in the hierarchy");
+		if (cycle) {
+			parent_[path.back()] = -1;
+			node = -1;
+		}
+		int d = node < 0 ? -1 : depth[node];
+		while (!path.empty()) {
+			depth[path.back()] = ++d;
+			path.pop_back();
+		}
+		if (d > max_depth) {
+			max_depth = d;
+		}
+	}
+
+	// Counting sort by depth keeps index order inside each level.
+	level_begin_.assign(max_depth + 2, 0);
+	for (size_t i = 0; i < n; i++) {
+		level_begin_[depth[i] + 1]++;
+	}
+	for (size_t l = 1; l < level_begin_.size(); l++) {
+		level_begin_[l] += level_begin_[l - 1];
+	}
+	order_.resize(n);
+	std::vector<size_t> next(level_begin_.begin(), level_begin_.end() - 1);
+	for (size_t i = 0; i < n; i++) {
+		order_[next[depth[i]]++] = (int)i;
+	}
+}
+
+inline size_t TransformHierarchy::Size() const {
+	return parent_.size();
+}
+
+inline size_t TransformHierarchy::LevelCount() const {
+	return level_begin_.size() - 1;
+}
+
+inline TransformHierarchy::Kernel TransformHierarchy::ActiveKernel() {
+#ifdef MATH_SIMD_X86
+	switch (Simd::Active()) {
+		case Simd::kAVX2:
+			return &Matix4x4::MultiplyAVX2;
+		case Simd::kSSE41:
+			return &Matix4x4::MultiplySSE41;
+		default:
+			break;
+	}
+#endif
+	return &Matix4x4::MultiplyScalar;
+}
+
+inline void TransformHierarchy::ResolveRange(Kernel kernel, const int* parent, const int* order,
+	const Matix4x4* local, Matix4x4* world, size_t begin, size_t end) {
+	for (size_t i = begin; i < end; i++) {
+		const int node = order[i];
+		if (parent[node] < 0) {
+			world[node] = local[node];
+		} else {
+			kernel(local[node].m, world[parent[node]].m, world[node].m);
+		}
+	}
+}
+
+inline void TransformHierarchy::Resolve(const Matix4x4* local, Matix4x4* world) const {
+	if (order_.empty()) {
+		return;
+	}
+	// Levels are in order, so one pass over order_ sees every parent first.
+	ResolveRange(ActiveKernel(), &parent_[0], &order_[0], local, world, 0, order_.size());
+}
+
+inline void TransformHierarchy::Resolve(const Matix4x4* local, Matix4x4* world, ThreadPool& pool) const {
+	if (order_.empty()) {
+		return;
+	}
+	const Kernel kernel = ActiveKernel();
+	const int* parent = &parent_[0];
+	const int* order = &order_[0];
+	for (size_t l = 0; l + 1 < level_begin_.size(); l++) {
+		const size_t first = level_begin_[l];
+		const size_t count = level_begin_[l + 1] - first;
+		if (count < 2 * kChunk) {
+			ResolveRange(kernel, parent, order, local, world, first, first + count);
+			continue;
+		}
+		pool.ParallelFor(count, kChunk, [=](size_t begin, size_t end) {
+			ResolveRange(kernel, parent, order, local, world, first + begin, first + end);
+		});
+	}
+}
+
+inline void TransformHierarchy::Multiply(const Matix4x4* a, const Matix4x4* b, Matix4x4* out, size_t n, ThreadPool& pool) {
+	pool.ParallelFor(n, kChunk, [=](size_t begin, size_t end) {
+		Matix4x4::Multiply(a + begin, b + begin, out + begin, end - begin);
+	});
+}
+
+#endif
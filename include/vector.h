@@ -0,0 +1,328 @@
+#ifndef __VECTOR_H__
+#define __VECTOR_H__ 1
+
+#include <assert.h>
+#include <math.h>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include "elementwise.h"
+#include "half.h"
+#include "vector_2.h"
+#include "vector_3.h"
+#include "vector_4.h"
+
+// N elements of T, for T = float, double, Half or BFloat16. Every operation
+// runs in Scalar (float for the 16-bit types) and rounds once into T, so
+// Vector<N, float> gives the same bits as Vector2/3/4 for the same math.
+// The elementwise operators are the ones of elementwise.h, shared with the
+// fixed-size types; Vector<N, float> with N a multiple of 4 runs them on SSE
+// registers like Vector4.
+// ToVector and ToVector2/3/4 convert to and from the fixed-size types.
+template<int N, class T>
+class Vector {
+public:
+	static_assert(N > 0, "Vector needs at least one element");
+
+	typedef T Element;
+	typedef decltype(std::declval<T>() + std::declval<T>()) Scalar;
+
+	Vector();
+	constexpr explicit Vector(Scalar value);
+	constexpr explicit Vector(const T* values);
+	// Exactly N values.
+	constexpr Vector(std::initializer_list<Scalar> values);
+	// Element-wise conversion, e.g. from Vector<N, double> to Vector<N, float>.
+	template<class U>
+	constexpr explicit Vector(const Vector<N, U>& other);
+
+	constexpr T& operator[](int i);
+	constexpr const T& operator[](int i) const;
+
+	constexpr Vector operator+(const Vector& other) const;
+	constexpr Vector operator+(Scalar value) const;
+	constexpr Vector& operator+=(const Vector& other);
+	constexpr Vector& operator+=(Scalar value);
+	constexpr Vector operator-(const Vector& other) const;
+	constexpr Vector operator-(Scalar value) const;
+	constexpr Vector operator-() const;
+	constexpr Vector& operator-=(const Vector& other);
+	constexpr Vector& operator-=(Scalar value);
+	constexpr Vector operator*(Scalar value) const;
+	constexpr Vector& operator*=(Scalar value);
+	constexpr Vector operator/(Scalar value) const;
+	constexpr Vector& operator/=(Scalar value);
+	constexpr bool operator==(const Vector& other) const;
+	constexpr bool operator!=(const Vector& other) const;
+
+	Scalar Magnitude() const;
+	constexpr Scalar SqrMagnitude() const;
+	void Normalize();
+	Vector Normalized() const;
+	constexpr void Scale(const Vector& scale);
+
+	static constexpr Scalar DotProduct(const Vector& a, const Vector& b);
+	static Scalar Distance(const Vector& a, const Vector& b);
+	static constexpr Vector Lerp(const Vector& a, const Vector& b, Scalar t);
+	static constexpr Vector LerpUnclamped(const Vector& a, const Vector& b, Scalar t);
+
+	T v[N];
+};
+
+static_assert(std::is_trivially_copyable<Vector<3, float> >::value, "Vector must be trivially copyable");
+static_assert(std::is_standard_layout<Vector<3, float> >::value, "Vector must be standard layout");
+static_assert(sizeof(Vector<4, float>) == sizeof(Vector4), "Vector<4, float> must match Vector4");
+static_assert(sizeof(Vector<4, Half>) == 8, "Vector<4, Half> must be packed");
+
+template<int N, class T>
+struct ElementTraits<Vector<N, T> > {
+	typedef T Element;
+	typedef typename Vector<N, T>::Scalar Scalar;
+	static const int kSize = N;
+	static const bool kPacked = std::is_same<T, float>::value;
+	static constexpr Scalar Get(const Vector<N, T>& value, int i) { return Scalar(value.v[i]); }
+	static constexpr Vector<N, T> Make(const Scalar* values) {
+		Vector<N, T> out(Scalar(0));
+		for (int i = 0; i < N; i++) {
+			out.v[i] = T(values[i]);
+		}
+		return out;
+	}
+};
+
+// Double precision positions, e.g. world coordinates far from the origin.
+typedef Vector<3, double> Vector3d;
+
+template<int N, class T>
+inline Vector<N, T>::Vector() {}
+
+template<int N, class T>
+constexpr Vector<N, T>::Vector(Scalar value) : v() {
+	for (int i = 0; i < N; i++) {
+		v[i] = T(value);
+	}
+}
+
+template<int N, class T>
+constexpr Vector<N, T>::Vector(const T* values) : v() {
+	for (int i = 0; i < N; i++) {
+		v[i] = values[i];
+	}
+}
+
+template<int N, class T>
+constexpr Vector<N, T>::Vector(std::initializer_list<Scalar> values) : v() {
+	assert(values.size() == N && "Wrong number of values");
+	int i = 0;
+	for (Scalar value : values) {
+		v[i++] = T(value);
+	}
+}
+
+template<int N, class T>
+template<class U>
+constexpr Vector<N, T>::Vector(const Vector<N, U>& other) : v() {
+	for (int i = 0; i < N; i++) {
+		v[i] = T(typename Vector<N, U>::Scalar(other.v[i]));
+	}
+}
+
+template<int N, class T>
+constexpr T& Vector<N, T>::operator[](int i) {
+	assert(i >= 0 && i < N && "Index out of range");
+	return v[i];
+}
+
+template<int N, class T>
+constexpr const T& Vector<N, T>::operator[](int i) const {
+	assert(i >= 0 && i < N && "Index out of range");
+	return v[i];
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator+(const Vector& other) const {
+	return Elementwise<Vector<N, T> >::Add(*this, other);
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator+(Scalar value) const {
+	return Elementwise<Vector<N, T> >::Add(*this, value);
+}
+
+template<int N, class T>
+constexpr Vector<N, T>& Vector<N, T>::operator+=(const Vector& other) {
+	*this = Elementwise<Vector<N, T> >::Add(*this, other);
+	return *this;
+}
+
+template<int N, class T>
+constexpr Vector<N, T>& Vector<N, T>::operator+=(Scalar value) {
+	*this = Elementwise<Vector<N, T> >::Add(*this, value);
+	return *this;
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator-(const Vector& other) const {
+	return Elementwise<Vector<N, T> >::Subtract(*this, other);
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator-(Scalar value) const {
+	return Elementwise<Vector<N, T> >::Subtract(*this, value);
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator-() const {
+	return Elementwise<Vector<N, T> >::Negate(*this);
+}
+
+template<int N, class T>
+constexpr Vector<N, T>& Vector<N, T>::operator-=(const Vector& other) {
+	*this = Elementwise<Vector<N, T> >::Subtract(*this, other);
+	return *this;
+}
+
+template<int N, class T>
+constexpr Vector<N, T>& Vector<N, T>::operator-=(Scalar value) {
+	*this = Elementwise<Vector<N, T> >::Subtract(*this, value);
+	return *this;
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator*(Scalar value) const {
+	return Elementwise<Vector<N, T> >::Multiply(*this, value);
+}
+
+template<int N, class T>
+constexpr Vector<N, T>& Vector<N, T>::operator*=(Scalar value) {
+	*this = Elementwise<Vector<N, T> >::Multiply(*this, value);
+	return *this;
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::operator/(Scalar value) const {
+	return Elementwise<Vector<N, T> >::Divide(*this, value);
+}
+
+template<int N, class T>
+constexpr Vector<N, T>& Vector<N, T>::operator/=(Scalar value) {
+	*this = Elementwise<Vector<N, T> >::Divide(*this, value);
+	return *this;
+}
+
+template<int N, class T>
+constexpr bool Vector<N, T>::operator==(const Vector& other) const {
+	return Elementwise<Vector<N, T> >::Equal(*this, other);
+}
+
+template<int N, class T>
+constexpr bool Vector<N, T>::operator!=(const Vector& other) const {
+	return !(*this == other);
+}
+
+template<int N, class T>
+inline typename Vector<N, T>::Scalar Vector<N, T>::Magnitude() const {
+	return sqrt(SqrMagnitude());
+}
+
+template<int N, class T>
+constexpr typename Vector<N, T>::Scalar Vector<N, T>::SqrMagnitude() const {
+	return DotProduct(*this, *this);
+}
+
+template<int N, class T>
+inline void Vector<N, T>::Normalize() {
+	*this = Normalized();
+}
+
+template<int N, class T>
+inline Vector<N, T> Vector<N, T>::Normalized() const {
+	assert(Magnitude() != 0 && "Magnitude is 0");
+	const Scalar invertedMagnitude = Scalar(1) / Magnitude();
+	return *this * invertedMagnitude;
+}
+
+template<int N, class T>
+constexpr void Vector<N, T>::Scale(const Vector& scale) {
+	*this = Elementwise<Vector<N, T> >::Multiply(*this, scale);
+}
+
+template<int N, class T>
+constexpr typename Vector<N, T>::Scalar Vector<N, T>::DotProduct(const Vector& a, const Vector& b) {
+	// Left to right from the first product, like the fixed-size types.
+	Scalar sum = Scalar(a.v[0]) * Scalar(b.v[0]);
+	for (int i = 1; i < N; i++) {
+		sum = sum + Scalar(a.v[i]) * Scalar(b.v[i]);
+	}
+	return sum;
+}
+
+template<int N, class T>
+inline typename Vector<N, T>::Scalar Vector<N, T>::Distance(const Vector& a, const Vector& b) {
+	Scalar sum = (Scalar(a.v[0]) - Scalar(b.v[0])) * (Scalar(a.v[0]) - Scalar(b.v[0]));
+	for (int i = 1; i < N; i++) {
+		sum = sum + (Scalar(a.v[i]) - Scalar(b.v[i])) * (Scalar(a.v[i]) - Scalar(b.v[i]));
+	}
+	return sqrt(sum);
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::Lerp(const Vector& a, const Vector& b, Scalar t) {
+	if constexpr (std::is_same<Scalar, float>::value) {
+		t = MathUtils::Saturate(t);
+	} else {
+		// The selects of MathUtils::Clamp, so NaN gives 0 as for float.
+		const Scalar low = t > Scalar(0) ? t : Scalar(0);
+		t = low < Scalar(1) ? low : Scalar(1);
+	}
+	return LerpUnclamped(a, b, t);
+}
+
+template<int N, class T>
+constexpr Vector<N, T> Vector<N, T>::LerpUnclamped(const Vector& a, const Vector& b, Scalar t) {
+	Vector out(Scalar(0));
+	for (int i = 0; i < N; i++) {
+		out.v[i] = T(Scalar(a.v[i]) + (Scalar(b.v[i]) - Scalar(a.v[i])) * t);
+	}
+	return out;
+}
+
+template<int N, class T>
+constexpr Vector<N, T> operator*(typename Vector<N, T>::Scalar value, const Vector<N, T>& vector) {
+	return vector * value;
+}
+
+template<class T>
+constexpr Vector<3, T> CrossProduct(const Vector<3, T>& a, const Vector<3, T>& b) {
+	typedef typename Vector<3, T>::Scalar Scalar;
+	const Scalar ax = a.v[0], ay = a.v[1], az = a.v[2];
+	const Scalar bx = b.v[0], by = b.v[1], bz = b.v[2];
+	// Same expressions as Vector3::CrossProduct, down to the sign of zero.
+	return Vector<3, T>({ ay * bz - az * by, -(ax * bz - bx * az), ax * by - bx * ay });
+}
+
+constexpr Vector<2, float> ToVector(const Vector2& value) {
+	return Vector<2, float>({ value.x, value.y });
+}
+
+constexpr Vector<3, float> ToVector(const Vector3& value) {
+	return Vector<3, float>({ value.x, value.y, value.z });
+}
+
+constexpr Vector<4, float> ToVector(const Vector4& value) {
+	return Vector<4, float>({ value.x, value.y, value.z, value.w });
+}
+
+constexpr Vector2 ToVector2(const Vector<2, float>& value) {
+	return Vector2(value.v[0], value.v[1]);
+}
+
+constexpr Vector3 ToVector3(const Vector<3, float>& value) {
+	return Vector3(value.v[0], value.v[1], value.v[2]);
+}
+
+constexpr Vector4 ToVector4(const Vector<4, float>& value) {
+	return Vector4(value.v[0], value.v[1], value.v[2], value.v[3]);
+}
+
+#endif
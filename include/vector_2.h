@@ -4,46 +4,46 @@
 #define __VECTOR2_H__ 1
 #include <math.h>
 #include <assert.h>
+#include <type_traits>
+#include "elementwise.h"
+#include "math_utils.h"
 
 class Vector2 {
  public:
 
   Vector2();
-  Vector2(float x, float y);
-  Vector2(const Vector2& copy);
-  ~Vector2();
-
-  Vector2 operator+(const Vector2& other) const;
-  Vector2 operator+(float value);
-  Vector2& operator+=(const Vector2& other);
-  Vector2& operator+=(float value);
-  Vector2 operator-(const Vector2& other) const;
-  Vector2 operator-(float value) const;
-  Vector2& operator-();
-  Vector2& operator-=(const Vector2& other);
-  Vector2& operator-=(float value);
-  bool operator==(const Vector2& other) const;
-  bool operator!=(const Vector2& other) const;
-  void operator=(const Vector2& other);
-  void operator=(float value);
-  Vector2 operator*(float value) const;
-  Vector2& operator*=(float value);
-  Vector2 operator/(float value) const;
-  Vector2& operator/=(float value);
+  constexpr Vector2(float x, float y);
+
+  constexpr Vector2 operator+(const Vector2& other) const;
+  constexpr Vector2 operator+(float value) const;
+  constexpr Vector2& operator+=(const Vector2& other);
+  constexpr Vector2& operator+=(float value);
+  constexpr Vector2 operator-(const Vector2& other) const;
+  constexpr Vector2 operator-(float value) const;
+  constexpr Vector2 operator-() const;
+  constexpr Vector2& operator-=(const Vector2& other);
+  constexpr Vector2& operator-=(float value);
+  constexpr bool operator==(const Vector2& other) const;
+  constexpr bool operator!=(const Vector2& other) const;
+  constexpr void operator=(float value);
+  constexpr Vector2 operator*(float value) const;
+  constexpr Vector2& operator*=(float value);
+  constexpr Vector2 operator/(float value) const;
+  constexpr Vector2& operator/=(float value);
 
   float Magnitude() const;
   void Normalize();
   Vector2 Normalized() const;
 
-  void Scale(const Vector2 scale);
+  constexpr void Scale(const Vector2 scale);
 
-  float SqrMagnitude() const;
+  constexpr float SqrMagnitude() const;
   static float Distance(const Vector2 a, const Vector2 b);
 
-  static float DotProduct(Vector2 a, Vector2 b);
+  static constexpr float DotProduct(Vector2 a, Vector2 b);
 
-  static Vector2 Lerp(const Vector2 a, const Vector2 b, float t);
-  static Vector2 LerpUnclamped(const Vector2 a, const Vector2 b, float t);
+  static constexpr Vector2 Lerp(const Vector2 a, const Vector2 b, float t);
+  static constexpr Vector2 LerpUnclamped(const Vector2 a, const Vector2 b, float t);
 
   static const Vector2 up;
   static const Vector2 down;
@@ -56,102 +56,91 @@ class Vector2 {
   float y;
 };
 
-inline Vector2::Vector2() {}
+static_assert(std::is_trivially_copyable<Vector2>::value, "Vector2 must be trivially copyable");
+static_assert(std::is_standard_layout<Vector2>::value, "Vector2 must be standard layout");
 
-inline Vector2::Vector2(float x, float y) {
-	this->x = x;
-	this->y = y;
-}
+template<> struct ElementTraits<Vector2> {
+	typedef float Element;
+	typedef float Scalar;
+	static const int kSize = 2;
+	static const bool kPacked = false;
+	static constexpr float Get(const Vector2& value, int i) { return i == 0 ? value.x : value.y; }
+	static constexpr Vector2 Make(const float* values) { return Vector2(values[0], values[1]); }
+};
 
-inline Vector2::Vector2(const Vector2& other) {
-	x = other.x;
-	y = other.y;
-}
+inline Vector2::Vector2() {}
 
-inline Vector2::~Vector2() {}
+constexpr Vector2::Vector2(float x, float y) : x(x), y(y) {}
 
-inline Vector2 Vector2::operator+(const Vector2& other) const {
-  return Vector2(x + other.x, y + other.y);
+constexpr Vector2 Vector2::operator+(const Vector2& other) const {
+	return Elementwise<Vector2>::Add(*this, other);
 }
 
-inline Vector2 Vector2::operator+(float value) {
-  return Vector2(x + value, y + value);
+constexpr Vector2 Vector2::operator+(float value) const {
+	return Elementwise<Vector2>::Add(*this, value);
 }
 
-inline Vector2& Vector2::operator+=(const Vector2& other){
-	x += other.x;
-	y += other.y;
+constexpr Vector2& Vector2::operator+=(const Vector2& other){
+	*this = Elementwise<Vector2>::Add(*this, other);
 	return *this;
 }
 
-inline Vector2& Vector2::operator+=(float value){
-	x += value;
-	y += value;
+constexpr Vector2& Vector2::operator+=(float value){
+	*this = Elementwise<Vector2>::Add(*this, value);
 	return *this;
 }
 
-inline Vector2 Vector2::operator-(const Vector2& other) const {
-	return Vector2(x - other.x, y - other.y);
+constexpr Vector2 Vector2::operator-(const Vector2& other) const {
+	return Elementwise<Vector2>::Subtract(*this, other);
 }
 
-inline Vector2 Vector2::operator-(float value) const {
-	return Vector2(x - value, y - value);
+constexpr Vector2 Vector2::operator-(float value) const {
+	return Elementwise<Vector2>::Subtract(*this, value);
 }
 
-inline Vector2& Vector2::operator-() {
-	x = -x;
-	y = -y;
-	return *this;
+constexpr Vector2 Vector2::operator-() const {
+	return Elementwise<Vector2>::Negate(*this);
 }
 
-inline Vector2& Vector2::operator-=(const Vector2& other) {
-	x -= other.x;
-	y -= other.y;
+constexpr Vector2& Vector2::operator-=(const Vector2& other) {
+	*this = Elementwise<Vector2>::Subtract(*this, other);
 	return *this;
 }
 
-inline Vector2& Vector2::operator-=(float value){
-	x -= value;
-	y -= value;
+constexpr Vector2& Vector2::operator-=(float value){
+	*this = Elementwise<Vector2>::Subtract(*this, value);
 	return *this;
 }
 
-inline bool Vector2::operator==(const Vector2& value) const { 
-	return x == value.x && y == value.y;
+constexpr bool Vector2::operator==(const Vector2& value) const {
+	return Elementwise<Vector2>::Equal(*this, value);
 }
 
-inline bool Vector2::operator!=(const Vector2& value) const {
-	return x != value.x && y != value.y;
+constexpr bool Vector2::operator!=(const Vector2& value) const {
+	return !(*this == value);
 }
 
 
-inline void Vector2::operator=(const Vector2& other) {
-	x = other.x;
-	y = other.y;
-}
-
-inline void Vector2::operator=(float value) {
+constexpr void Vector2::operator=(float value) {
 	x = value;
 	y = value;
 }
 
-inline Vector2 Vector2::operator*(float value) const {
-	return Vector2(x * value, y * value);
+constexpr Vector2 Vector2::operator*(float value) const {
+	return Elementwise<Vector2>::Multiply(*this, value);
 }
 
-inline Vector2& Vector2::operator*=(float value) {  
-	x *= value;
-	y *= value;
+constexpr Vector2& Vector2::operator*=(float value) {
+	*this = Elementwise<Vector2>::Multiply(*this, value);
 	return *this;
 }
 
-inline Vector2 Vector2::operator/(float value) const {
-	return Vector2(x / value, y / value);
+constexpr Vector2 Vector2::operator/(float value) const {
+	return Elementwise<Vector2>::Divide(*this, value);
 }
 
-inline Vector2& Vector2::operator/=(float value) {
-	x /= value;
-	y /= value;
+constexpr Vector2& Vector2::operator/=(float value) {
+	*this = Elementwise<Vector2>::Divide(*this, value);
 	return *this;
 }
 
@@ -172,12 +161,11 @@ inline Vector2 Vector2::Normalized() const {
 	return Vector2(x * inverseMagnitude, y * inverseMagnitude);
 }
 
-inline void Vector2::Scale(const Vector2 scale){
-	x *= scale.x;
-	y *= scale.y;
+constexpr void Vector2::Scale(const Vector2 scale){
+	*this = Elementwise<Vector2>::Multiply(*this, scale);
 }
 
-inline float Vector2::SqrMagnitude() const {
+constexpr float Vector2::SqrMagnitude() const {
 	return x*x + y*y;
 }
 
@@ -186,18 +174,24 @@ inline float Vector2::Distance(const Vector2 a, const Vector2 b) {
   return sqrtf((b.x - a.x)*(b.x - a.x) + (b.y - a.y)*(b.y - a.y));
 }
 
-inline Vector2 Vector2::Lerp(const Vector2 a, const Vector2 b, float t) {
-	assert(t >= 0 && t <= 1 && "Not valid t value"); // a + (b - a) * t
-	return Vector2(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+constexpr Vector2 Vector2::Lerp(const Vector2 a, const Vector2 b, float t) {
+	return LerpUnclamped(a, b, MathUtils::Saturate(t));
 }
 
-inline Vector2 Vector2::LerpUnclamped(const Vector2 a, const Vector2 b, float t) {
+constexpr Vector2 Vector2::LerpUnclamped(const Vector2 a, const Vector2 b, float t) {
 	return Vector2(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
 }
 
 
-inline float Vector2::DotProduct(Vector2 a, Vector2 b) {
+constexpr float Vector2::DotProduct(Vector2 a, Vector2 b) {
 	return a.x * b.x + a.y * b.y;
 }
 
+inline constexpr Vector2 Vector2::up = Vector2(0.0f, 1.0f);
+inline constexpr Vector2 Vector2::down = Vector2(0.0f, -1.0f);
+inline constexpr Vector2 Vector2::right = Vector2(1.0f, 0.0f);
+inline constexpr Vector2 Vector2::left = Vector2(-1.0f, 0.0f);
+inline constexpr Vector2 Vector2::zero = Vector2(0.0f, 0.0f);
+inline constexpr Vector2 Vector2::one = Vector2(1.0f, 1.0f);
+
 #endif 
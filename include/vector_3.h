@@ -4,47 +4,49 @@
 #define __VECTOR3_H__ 1
 #include <math.h>
 #include <assert.h>
+#include <type_traits>
+#include "elementwise.h"
 #include "math_utils.h"
+#include "fast_math.h"
 
 class Vector3 {
 
 public:
 	Vector3();
-	Vector3(float value);
-	Vector3(float x, float y, float z);
-	Vector3(const float* values_array);
-	Vector3(const Vector3& other);
-	~Vector3();
-
-	Vector3 operator+(const Vector3& other) const;
-	Vector3 operator+(float value) const;
-	Vector3& operator+=(const Vector3& other);
-	Vector3& operator+=(float value);
-	Vector3 operator-(const Vector3& other) const;
-	Vector3 operator-(float value) const;
-	Vector3& operator-=(const Vector3& other);
-	Vector3& operator-=(float value);
-	bool operator==(const Vector3& other) const;
-	bool operator!=(const Vector3& other) const;
-	void operator=(const Vector3& other);
-	void operator=(float value);
-	Vector3 operator*(float value) const;
-	Vector3& operator*=(float value);
-	Vector3 operator/(float value) const;
-	Vector3& operator/=(float value);
-
-	float Magnitude() const;
-	Vector3 Normalized() const;
-	void Normalize();
-	float SqrMagnitude() const;
-	void Scale(const Vector3& other);
-
-	static Vector3 Lerp(const Vector3& a, const Vector3& b, float t);
-	static Vector3 LerpUnclamped(const Vector3& a, const Vector3& b, float t);
-	static float DotProduct(const Vector3& a, const Vector3& b);
-	static float Angle(const Vector3& a, const Vector3& b);
-	static Vector3 CrossProduct(const Vector3& a,const Vector3& b);	
-	static float Distance(const Vector3& a, const Vector3& b);
+	constexpr Vector3(float value);
+	constexpr Vector3(float x, float y, float z);
+	constexpr Vector3(const float* values_array);
+
+	constexpr Vector3 operator+(const Vector3& other) const;
+	constexpr Vector3 operator+(float value) const;
+	constexpr Vector3& operator+=(const Vector3& other);
+	constexpr Vector3& operator+=(float value);
+	constexpr Vector3 operator-(const Vector3& other) const;
+	constexpr Vector3 operator-(float value) const;
+	constexpr Vector3& operator-=(const Vector3& other);
+	constexpr Vector3& operator-=(float value);
+	constexpr bool operator==(const Vector3& other) const;
+	constexpr bool operator!=(const Vector3& other) const;
+	constexpr void operator=(float value);
+	constexpr Vector3 operator*(float value) const;
+	constexpr Vector3& operator*=(float value);
+	constexpr Vector3 operator/(float value) const;
+	constexpr Vector3& operator/=(float value);
+
+	// The Precision overloads trade libm accuracy for FastMath, see
+	// fast_math.h for the bounds.
+	float Magnitude(FastMath::Precision precision = FastMath::kDefault) const;
+	Vector3 Normalized(FastMath::Precision precision = FastMath::kDefault) const;
+	void Normalize(FastMath::Precision precision = FastMath::kDefault);
+	constexpr float SqrMagnitude() const;
+	constexpr void Scale(const Vector3& other);
+
+	static constexpr Vector3 Lerp(const Vector3& a, const Vector3& b, float t);
+	static constexpr Vector3 LerpUnclamped(const Vector3& a, const Vector3& b, float t);
+	static constexpr float DotProduct(const Vector3& a, const Vector3& b);
+	static float Angle(const Vector3& a, const Vector3& b, FastMath::Precision precision = FastMath::kDefault);
+	static constexpr Vector3 CrossProduct(const Vector3& a,const Vector3& b);	
+	static float Distance(const Vector3& a, const Vector3& b, FastMath::Precision precision = FastMath::kDefault);
 	static Vector3 Reflect(const Vector3& direction, const Vector3& normal);
 
 	static const Vector3 up;
@@ -60,59 +62,62 @@ public:
 	float y;
 	float z;
 };
-inline Vector3::Vector3() {}
 
-inline Vector3::Vector3(float x, float y, float z) {
-	this->x = x;
-	this->y = y;
-	this->z = z;
-}
+static_assert(std::is_trivially_copyable<Vector3>::value, "Vector3 must be trivially copyable");
+static_assert(std::is_standard_layout<Vector3>::value, "Vector3 must be standard layout");
 
-inline Vector3::Vector3(const float * values_array) {
-	x = values_array[0];
-  y = values_array[1];
-	z = values_array[2];
-}
+template<> struct ElementTraits<Vector3> {
+	typedef float Element;
+	typedef float Scalar;
+	static const int kSize = 3;
+	static const bool kPacked = false;
+	static constexpr float Get(const Vector3& value, int i) { return i == 0 ? value.x : (i == 1 ? value.y : value.z); }
+	static constexpr Vector3 Make(const float* values) { return Vector3(values[0], values[1], values[2]); }
+};
 
-inline Vector3::Vector3(float value) {
-	x = value;
-	y = value;
-	z = value;
-}
+inline Vector3::Vector3() {}
 
-inline Vector3::Vector3(const Vector3& other) {
-	x = other.x;
-	y = other.y;
-	z = other.z;
-}
+constexpr Vector3::Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
 
-inline Vector3::~Vector3() {}
+constexpr Vector3::Vector3(const float * values_array)
+	: x(values_array[0]), y(values_array[1]), z(values_array[2]) {}
 
-inline float Vector3::Magnitude() const {
-	return sqrtf(x*x + y*y + z*z);
+constexpr Vector3::Vector3(float value) : x(value), y(value), z(value) {}
+
+inline float Vector3::Magnitude(FastMath::Precision precision) const {
+	const float sqr_magnitude = x*x + y*y + z*z;
+	return precision == FastMath::kFast ? FastMath::Sqrt(sqr_magnitude) : sqrtf(sqr_magnitude);
 }
 
-inline void Vector3::Normalize() {	
-	assert(Magnitude() != 0 && "Magnitude is 0");
-	float invertedMagnitude = 1 / Magnitude();
-	*this *= invertedMagnitude;
+inline void Vector3::Normalize(FastMath::Precision precision) {	
+	*this = Normalized(precision);
 }
 
-inline Vector3 Vector3::Normalized() const {
-	assert(Magnitude() != 0 && "Magnitude is 0");
-	float invertedMagnitude = 1 / Magnitude();
+inline Vector3 Vector3::Normalized(FastMath::Precision precision) const {
+	// One square root instead of one for the assert and one for the scale.
+	const float sqr_magnitude = SqrMagnitude();
+	assert(sqr_magnitude != 0 && "Magnitude is 0");
+	// kFast skips the errno check of sqrtf but not the division: for one
+	// vector FastMath::Rsqrt is no faster and less accurate.
+	float invertedMagnitude = precision == FastMath::kFast ? 1 / FastMath::Sqrt(sqr_magnitude) : 1 / sqrtf(sqr_magnitude);
 	return Vector3(x * invertedMagnitude, y * invertedMagnitude , z * invertedMagnitude);
 }
 
-inline float Vector3::DotProduct(const Vector3& a, const Vector3& other)  {
+constexpr float Vector3::DotProduct(const Vector3& a, const Vector3& other)  {
 	return a.x * other.x + a.y * other.y + a.z * other.z;
 }
 
-inline float Vector3::Angle(const Vector3& a, const Vector3& other)  {
-		return acosf(DotProduct(a, other) / (a.Magnitude() * other.Magnitude()));
+inline float Vector3::Angle(const Vector3& a, const Vector3& other, FastMath::Precision precision)  {
+	if (precision == FastMath::kFast) {
+		// Rounding can push the cosine of parallel vectors just past 1.
+		float cosine = DotProduct(a, other) * FastMath::Rsqrt(a.SqrMagnitude()) * FastMath::Rsqrt(other.SqrMagnitude());
+		cosine = cosine > 1.0f ? 1.0f : (cosine < -1.0f ? -1.0f : cosine);
+		return FastMath::Acos(cosine);
+	}
+	return acosf(DotProduct(a, other) / (a.Magnitude(FastMath::kExact) * other.Magnitude(FastMath::kExact)));
 }
 
-inline Vector3 Vector3::CrossProduct(const Vector3& a, const Vector3& other)  {
+constexpr Vector3 Vector3::CrossProduct(const Vector3& a, const Vector3& other)  {
 	// |i        j        k      |
 	// |a.x      a.y      a.z		 |
 	// |other.x  other.y  other.z|
@@ -125,119 +130,107 @@ inline Vector3 Vector3::CrossProduct(const Vector3& a, const Vector3& other)  {
 	return Vector3(a.y * other.z - (a.z * other.y), -(a.x * other.z - other.x * a.z), (a.x * other.y - other.x * a.y));
 }
 
-inline float Vector3::SqrMagnitude() const {
+constexpr float Vector3::SqrMagnitude() const {
 	return (x*x + y * y + z * z);
 }
 
-inline void Vector3::Scale(const Vector3& other) {
-	x = x * other.x;
-	y = y * other.y;
-	z = z * other.z;
+constexpr void Vector3::Scale(const Vector3& other) {
+	*this = Elementwise<Vector3>::Multiply(*this, other);
 }
 
-inline Vector3 Vector3::Lerp(const Vector3& a, const Vector3& b, float t) {
-	if (t > 1) { t = 1; }
-	if (t < 0) { t = 0; }
-	return Vector3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
+constexpr Vector3 Vector3::Lerp(const Vector3& a, const Vector3& b, float t) {
+	return LerpUnclamped(a, b, MathUtils::Saturate(t));
 }
 
-inline Vector3 Vector3::LerpUnclamped(const Vector3& a, const Vector3& b, float t) {
+constexpr Vector3 Vector3::LerpUnclamped(const Vector3& a, const Vector3& b, float t) {
 	return Vector3(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t);
 }
 
-inline float Vector3::Distance(const Vector3& a, const Vector3& b) {
-	return sqrtf((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+inline float Vector3::Distance(const Vector3& a, const Vector3& b, FastMath::Precision precision) {
+	const float sqr_distance = (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z);
+	return precision == FastMath::kFast ? FastMath::Sqrt(sqr_distance) : sqrtf(sqr_distance);
 }
 
 inline Vector3 Vector3::Reflect(const Vector3& direction, const Vector3& normal) {
-	normal.Normalized();
-	return direction - normal * 2.0f * DotProduct(direction, normal);
+	const Vector3 unit = normal.Normalized();
+	return direction - unit * 2.0f * DotProduct(direction, unit);
 }
 
-inline Vector3 Vector3::operator+(const Vector3& other) const {
-	return Vector3(x + other.x, y + other.y, z + other.z);
+constexpr Vector3 Vector3::operator+(const Vector3& other) const {
+	return Elementwise<Vector3>::Add(*this, other);
 }
 
-inline Vector3 Vector3::operator+(float value) const {
-	return Vector3(x + value, y + value, z + value);
+constexpr Vector3 Vector3::operator+(float value) const {
+	return Elementwise<Vector3>::Add(*this, value);
 }
 
-inline Vector3& Vector3::operator+=(const Vector3& other) {
-	x += other.x;
-	y += other.y;
-	z += other.z;
+constexpr Vector3& Vector3::operator+=(const Vector3& other) {
+	*this = Elementwise<Vector3>::Add(*this, other);
 	return *this;
 }
 
-inline Vector3& Vector3::operator+=(float value) {
-	x += value;
-	y += value;
-	z += value;
+constexpr Vector3& Vector3::operator+=(float value) {
+	*this = Elementwise<Vector3>::Add(*this, value);
 	return *this;
 }
 
-inline Vector3 Vector3::operator-(const Vector3& other) const {
-	return Vector3(x - other.x, y - other.y, z - other.z);
+constexpr Vector3 Vector3::operator-(const Vector3& other) const {
+	return Elementwise<Vector3>::Subtract(*this, other);
 }
 
-inline Vector3 Vector3::operator-(float value) const {
-	return Vector3(x - value, y - value, z - value);
+constexpr Vector3 Vector3::operator-(float value) const {
+	return Elementwise<Vector3>::Subtract(*this, value);
 }
 
-inline Vector3& Vector3::operator-=(const Vector3& other) {
-	x -= other.x;
-	y -= other.y;
-	z -= other.z;
+constexpr Vector3& Vector3::operator-=(const Vector3& other) {
+	*this = Elementwise<Vector3>::Subtract(*this, other);
 	return *this;
 }
 
-inline Vector3& Vector3::operator-=(float value) {
-	x -= value;
-	y -= value;
-	z -= value;
+constexpr Vector3& Vector3::operator-=(float value) {
+	*this = Elementwise<Vector3>::Subtract(*this, value);
 	return *this;
 }
 
-inline bool Vector3::operator==(const Vector3& other) const {
-	return x == other.x && y == other.y && z == other.z;
+constexpr bool Vector3::operator==(const Vector3& other) const {
+	return Elementwise<Vector3>::Equal(*this, other);
 }
 
-inline bool Vector3::operator!=(const Vector3& other) const {
-	return x != other.x && y != other.y && z != other.z;
+constexpr bool Vector3::operator!=(const Vector3& other) const {
+	return !(*this == other);
 }
 
-inline void Vector3::operator=(const Vector3& other) {
-	x = other.x;
-	y = other.y;
-	z = other.z;
-}
-
-inline void Vector3::operator=(float value) {
+constexpr void Vector3::operator=(float value) {
 	x = value;
 	y = value;
 	z = value;
 }
 
-inline Vector3 Vector3::operator*(float value) const {
-	return Vector3(x * value, y * value, z * value);
+constexpr Vector3 Vector3::operator*(float value) const {
+	return Elementwise<Vector3>::Multiply(*this, value);
 }
 
-inline Vector3& Vector3::operator*=(float value) {	
-	x *= value;
-	y *= value;
-	z *= value;
+constexpr Vector3& Vector3::operator*=(float value) {
+	*this = Elementwise<Vector3>::Multiply(*this, value);
 	return *this;
 }
 
-inline Vector3 Vector3::operator/(float value) const {
-	return Vector3(x / value, y / value, z / value);
+constexpr Vector3 Vector3::operator/(float value) const {
+	return Elementwise<Vector3>::Divide(*this, value);
 }
 
-inline Vector3& Vector3::operator/=(float value) {
-	x /= value;
-	y /= value;
-	z /= value;
+constexpr Vector3& Vector3::operator/=(float value) {
+	*this = Elementwise<Vector3>::Divide(*this, value);
 	return *this;
 }
 
+inline constexpr Vector3 Vector3::up = Vector3(0.0f, 1.0f, 0.0f);
+inline constexpr Vector3 Vector3::down = Vector3(0.0f, -1.0f, 0.0f);
+inline constexpr Vector3 Vector3::right = Vector3(1.0f, 0.0f, 0.0f);
+inline constexpr Vector3 Vector3::left = Vector3(-1.0f, 0.0f, 0.0f);
+inline constexpr Vector3 Vector3::forward = Vector3(0.0f, 0.0f, 1.0f);
+inline constexpr Vector3 Vector3::back = Vector3(0.0f, 0.0f, -1.0f);
+inline constexpr Vector3 Vector3::zero = Vector3(0.0f, 0.0f, 0.0f);
+inline constexpr Vector3 Vector3::unit = Vector3(1.0f, 1.0f, 1.0f);
+
 #endif 
@@ -0,0 +1,380 @@
+#ifndef __VECTOR3_STREAM_H__
+#define __VECTOR3_STREAM_H__ 1
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include "vector_3.h"
+#include "aligned.h"
+#include "simd.h"
+
+// Structure-of-arrays storage for many Vector3. x, y and z live in separate
+// 32-byte aligned lanes padded to a multiple of 8 floats, so the stream
+// operations use aligned 8-wide AVX loads. They do the same float math in
+// the same order as the Vector3 ones and give the same bits.
+class Vector3Stream {
+public:
+	Vector3Stream();
+	Vector3Stream(size_t size);
+	Vector3Stream(const Vector3* values, size_t size);
+	Vector3Stream(const Vector3Stream& copy);
+	~Vector3Stream();
+
+	Vector3Stream& operator=(const Vector3Stream& other);
+
+	size_t Size() const;
+	// Keeps the first min(Size(), size) elements, new ones are zero.
+	void Resize(size_t size);
+
+	Vector3 Get(size_t index) const;
+	void Set(size_t index, const Vector3& value);
+
+	void FromArray(const Vector3* values, size_t size);
+	void ToArray(Vector3* values) const;
+
+	// kFast scales by FastMath::Rsqrt, which over a whole stream is faster
+	// than the division of Vector3::Normalized; the AVX kernel gives the
+	// same bits as the scalar tail on the same CPU.
+	void Normalize(FastMath::Precision precision = FastMath::kDefault);
+
+	// out may be a or b. The float outputs need Size() elements.
+	static void DotProduct(const Vector3Stream& a, const Vector3Stream& b, float* out);
+	static void CrossProduct(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out);
+	static void Distance(const Vector3Stream& a, const Vector3Stream& b, float* out);
+	static void Lerp(const Vector3Stream& a, const Vector3Stream& b, float t, Vector3Stream& out);
+
+	float* x;
+	float* y;
+	float* z;
+
+private:
+	static const size_t kBlock = 8;
+
+	void Allocate(size_t capacity);
+	void Release();
+	size_t Padded() const;
+
+#ifdef MATH_SIMD_X86
+	// Whole blocks only; count is a multiple of 4 (SSE4.1) or kBlock (AVX).
+	MATH_TARGET_SSE41 static void FromArraySSE41(const float* src, Vector3Stream& out, size_t count);
+	MATH_TARGET_SSE41 static void ToArraySSE41(const Vector3Stream& in, float* dst, size_t count);
+	MATH_TARGET_AVX static void NormalizeAVX(Vector3Stream& stream, size_t count);
+	MATH_TARGET_AVX static void NormalizeFastAVX(Vector3Stream& stream, size_t count);
+	MATH_TARGET_AVX static void DotProductAVX(const Vector3Stream& a, const Vector3Stream& b, float* out, size_t count);
+	MATH_TARGET_AVX static void CrossProductAVX(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out, size_t count);
+	MATH_TARGET_AVX static void DistanceAVX(const Vector3Stream& a, const Vector3Stream& b, float* out, size_t count);
+	MATH_TARGET_AVX static void LerpAVX(const Vector3Stream& a, const Vector3Stream& b, float t, Vector3Stream& out, size_t count);
+#endif
+
+	size_t size_;
+	size_t capacity_;
+};
+
+inline Vector3Stream::Vector3Stream() : x(0), y(0), z(0), size_(0), capacity_(0) {}
+
+inline Vector3Stream::Vector3Stream(size_t size) : x(0), y(0), z(0), size_(0), capacity_(0) {
+	Resize(size);
+}
+
+inline Vector3Stream::Vector3Stream(const Vector3* values, size_t size) : x(0), y(0), z(0), size_(0), capacity_(0) {
+	FromArray(values, size);
+}
+
+inline Vector3Stream::Vector3Stream(const Vector3Stream& copy) : x(0), y(0), z(0), size_(0), capacity_(0) {
+	*this = copy;
+}
+
+inline Vector3Stream::~Vector3Stream() {
+	Release();
+}
+
+inline Vector3Stream& Vector3Stream::operator=(const Vector3Stream& other) {
+	if (this == &other) {
+		return *this;
+	}
+	Resize(other.size_);
+	const size_t padded = Padded();
+	memcpy(x, other.x, padded * sizeof(float));
+	memcpy(y, other.y, padded * sizeof(float));
+	memcpy(z, other.z, padded * sizeof(float));
+	return *this;
+}
+
+inline size_t Vector3Stream::Size() const {
+	return size_;
+}
+
+inline size_t Vector3Stream::Padded() const {
+	return (size_ + kBlock - 1) / kBlock * kBlock;
+}
+
+inline void Vector3Stream::Allocate(size_t capacity) {
+	// One block for the three lanes. On failure AlignedMemory throws and
+	// the stream keeps its old lanes.
+	if (capacity > (size_t)-1 / (3 * sizeof(float))) {
+		throw std::bad_alloc();
+	}
+	x = (float*)AlignedMemory::Allocate(3 * capacity * sizeof(float), kBlock * sizeof(float));
+	y = x + capacity;
+	z = y + capacity;
+	capacity_ = capacity;
+}
+
+inline void Vector3Stream::Release() {
+	AlignedMemory::Free(x);
+	x = y = z = 0;
+	capacity_ = 0;
+}
+
+inline void Vector3Stream::Resize(size_t size) {
+	const size_t padded = (size + kBlock - 1) / kBlock * kBlock;
+	if (padded > capacity_) {
+		float* old_x = x;
+		float* old_y = y;
+		float* old_z = z;
+		Allocate(padded);
+		if (size_ > 0) {
+			memcpy(x, old_x, size_ * sizeof(float));
+			memcpy(y, old_y, size_ * sizeof(float));
+			memcpy(z, old_z, size_ * sizeof(float));
+		}
+		AlignedMemory::Free(old_x);
+	}
+	if (size > size_) {
+		memset(x + size_, 0, (padded - size_) * sizeof(float));
+		memset(y + size_, 0, (padded - size_) * sizeof(float));
+		memset(z + size_, 0, (padded - size_) * sizeof(float));
+	}
+	size_ = size;
+}
+
+inline Vector3 Vector3Stream::Get(size_t index) const {
+	assert(index < size_ && "Index out of range");
+	return Vector3(x[index], y[index], z[index]);
+}
+
+inline void Vector3Stream::Set(size_t index, const Vector3& value) {
+	assert(index < size_ && "Index out of range");
+	x[index] = value.x;
+	y[index] = value.y;
+	z[index] = value.z;
+}
+
+inline void Vector3Stream::FromArray(const Vector3* values, size_t size) {
+	Resize(size);
+	const float* src = &values->x;
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() >= Simd::kSSE41) {
+		i = size / 4 * 4;
+		FromArraySSE41(src, *this, i);
+	}
+#endif
+	for (; i < size; i++) {
+		x[i] = src[3 * i + 0];
+		y[i] = src[3 * i + 1];
+		z[i] = src[3 * i + 2];
+	}
+}
+
+inline void Vector3Stream::ToArray(Vector3* values) const {
+	float* dst = &values->x;
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() >= Simd::kSSE41) {
+		i = size_ / 4 * 4;
+		ToArraySSE41(*this, dst, i);
+	}
+#endif
+	for (; i < size_; i++) {
+		dst[3 * i + 0] = x[i];
+		dst[3 * i + 1] = y[i];
+		dst[3 * i + 2] = z[i];
+	}
+}
+
+inline void Vector3Stream::Normalize(FastMath::Precision precision) {
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = size_ / kBlock * kBlock;
+		if (precision == FastMath::kFast) {
+			NormalizeFastAVX(*this, i);
+		} else {
+			NormalizeAVX(*this, i);
+		}
+	}
+#endif
+	for (; i < size_; i++) {
+		const float sqr_magnitude = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+		assert(sqr_magnitude != 0 && "Magnitude is 0");
+		const float inverse = precision == FastMath::kFast ? FastMath::Rsqrt(sqr_magnitude) : 1 / sqrtf(sqr_magnitude);
+		x[i] *= inverse;
+		y[i] *= inverse;
+		z[i] *= inverse;
+	}
+}
+
+inline void Vector3Stream::DotProduct(const Vector3Stream& a, const Vector3Stream& b, float* out) {
+	assert(a.size_ == b.size_ && "Streams differ in size");
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = a.size_ / kBlock * kBlock;
+		DotProductAVX(a, b, out, i);
+	}
+#endif
+	for (; i < a.size_; i++) {
+		out[i] = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i];
+	}
+}
+
+inline void Vector3Stream::CrossProduct(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out) {
+	assert(a.size_ == b.size_ && "Streams differ in size");
+	out.Resize(a.size_);
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = a.size_ / kBlock * kBlock;
+		CrossProductAVX(a, b, out, i);
+	}
+#endif
+	for (; i < a.size_; i++) {
+		const float ax = a.x[i], ay = a.y[i], az = a.z[i];
+		const float bx = b.x[i], by = b.y[i], bz = b.z[i];
+		out.x[i] = ay * bz - (az * by);
+		out.y[i] = -(ax * bz - bx * az);
+		out.z[i] = ax * by - bx * ay;
+	}
+}
+
+inline void Vector3Stream::Distance(const Vector3Stream& a, const Vector3Stream& b, float* out) {
+	assert(a.size_ == b.size_ && "Streams differ in size");
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = a.size_ / kBlock * kBlock;
+		DistanceAVX(a, b, out, i);
+	}
+#endif
+	for (; i < a.size_; i++) {
+		const float dx = a.x[i] - b.x[i];
+		const float dy = a.y[i] - b.y[i];
+		const float dz = a.z[i] - b.z[i];
+		out[i] = sqrtf(dx * dx + dy * dy + dz * dz);
+	}
+}
+
+inline void Vector3Stream::Lerp(const Vector3Stream& a, const Vector3Stream& b, float t, Vector3Stream& out) {
+	assert(a.size_ == b.size_ && "Streams differ in size");
+	t = MathUtils::Saturate(t);
+	out.Resize(a.size_);
+	size_t i = 0;
+#ifdef MATH_SIMD_X86
+	if (Simd::Active() == Simd::kAVX2) {
+		i = a.size_ / kBlock * kBlock;
+		LerpAVX(a, b, t, out, i);
+	}
+#endif
+	for (; i < a.size_; i++) {
+		out.x[i] = a.x[i] + (b.x[i] - a.x[i]) * t;
+		out.y[i] = a.y[i] + (b.y[i] - a.y[i]) * t;
+		out.z[i] = a.z[i] + (b.z[i] - a.z[i]) * t;
+	}
+}
+
+#ifdef MATH_SIMD_X86
+MATH_TARGET_SSE41 inline void Vector3Stream::FromArraySSE41(const float* src, Vector3Stream& out, size_t count) {
+	for (size_t i = 0; i < count; i += 4) {
+		__m128 vx, vy, vz;
+		Simd::LoadXYZ(src + 3 * i, vx, vy, vz);
+		_mm_store_ps(out.x + i, vx);
+		_mm_store_ps(out.y + i, vy);
+		_mm_store_ps(out.z + i, vz);
+	}
+}
+
+MATH_TARGET_SSE41 inline void Vector3Stream::ToArraySSE41(const Vector3Stream& in, float* dst, size_t count) {
+	for (size_t i = 0; i < count; i += 4) {
+		Simd::StoreXYZ(dst + 3 * i, _mm_load_ps(in.x + i), _mm_load_ps(in.y + i), _mm_load_ps(in.z + i));
+	}
+}
+
+MATH_TARGET_AVX inline void Vector3Stream::NormalizeAVX(Vector3Stream& stream, size_t count) {
+	const __m256 one = _mm256_set1_ps(1.0f);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 vx = _mm256_load_ps(stream.x + i);
+		const __m256 vy = _mm256_load_ps(stream.y + i);
+		const __m256 vz = _mm256_load_ps(stream.z + i);
+		const __m256 sqr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+		const __m256 inverse = _mm256_div_ps(one, _mm256_sqrt_ps(sqr));
+		_mm256_store_ps(stream.x + i, _mm256_mul_ps(vx, inverse));
+		_mm256_store_ps(stream.y + i, _mm256_mul_ps(vy, inverse));
+		_mm256_store_ps(stream.z + i, _mm256_mul_ps(vz, inverse));
+	}
+}
+
+MATH_TARGET_AVX inline void Vector3Stream::NormalizeFastAVX(Vector3Stream& stream, size_t count) {
+	// FastMath::Rsqrt: the vrsqrtps estimate is the rsqrtss one per lane,
+	// followed by the same Newton step.
+	const __m256 half = _mm256_set1_ps(0.5f);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 vx = _mm256_load_ps(stream.x + i);
+		const __m256 vy = _mm256_load_ps(stream.y + i);
+		const __m256 vz = _mm256_load_ps(stream.z + i);
+		const __m256 sqr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+		const __m256 estimate = _mm256_rsqrt_ps(sqr);
+		const __m256 half_sqr = _mm256_mul_ps(half, sqr);
+		const __m256 step = _mm256_sub_ps(half, _mm256_mul_ps(_mm256_mul_ps(half_sqr, estimate), estimate));
+		const __m256 inverse = _mm256_add_ps(estimate, _mm256_mul_ps(estimate, step));
+		_mm256_store_ps(stream.x + i, _mm256_mul_ps(vx, inverse));
+		_mm256_store_ps(stream.y + i, _mm256_mul_ps(vy, inverse));
+		_mm256_store_ps(stream.z + i, _mm256_mul_ps(vz, inverse));
+	}
+}
+
+MATH_TARGET_AVX inline void Vector3Stream::DotProductAVX(const Vector3Stream& a, const Vector3Stream& b, float* out, size_t count) {
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 xx = _mm256_mul_ps(_mm256_load_ps(a.x + i), _mm256_load_ps(b.x + i));
+		const __m256 yy = _mm256_mul_ps(_mm256_load_ps(a.y + i), _mm256_load_ps(b.y + i));
+		const __m256 zz = _mm256_mul_ps(_mm256_load_ps(a.z + i), _mm256_load_ps(b.z + i));
+		_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_add_ps(xx, yy), zz));
+	}
+}
+
+MATH_TARGET_AVX inline void Vector3Stream::CrossProductAVX(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out, size_t count) {
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 ax = _mm256_load_ps(a.x + i), ay = _mm256_load_ps(a.y + i), az = _mm256_load_ps(a.z + i);
+		const __m256 bx = _mm256_load_ps(b.x + i), by = _mm256_load_ps(b.y + i), bz = _mm256_load_ps(b.z + i);
+		const __m256 cx = _mm256_sub_ps(_mm256_mul_ps(ay, bz), _mm256_mul_ps(az, by));
+		const __m256 cy = _mm256_xor_ps(_mm256_sub_ps(_mm256_mul_ps(ax, bz), _mm256_mul_ps(bx, az)), sign);
+		const __m256 cz = _mm256_sub_ps(_mm256_mul_ps(ax, by), _mm256_mul_ps(bx, ay));
+		_mm256_store_ps(out.x + i, cx);
+		_mm256_store_ps(out.y + i, cy);
+		_mm256_store_ps(out.z + i, cz);
+	}
+}
+
+MATH_TARGET_AVX inline void Vector3Stream::DistanceAVX(const Vector3Stream& a, const Vector3Stream& b, float* out, size_t count) {
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 dx = _mm256_sub_ps(_mm256_load_ps(a.x + i), _mm256_load_ps(b.x + i));
+		const __m256 dy = _mm256_sub_ps(_mm256_load_ps(a.y + i), _mm256_load_ps(b.y + i));
+		const __m256 dz = _mm256_sub_ps(_mm256_load_ps(a.z + i), _mm256_load_ps(b.z + i));
+		const __m256 sqr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		_mm256_storeu_ps(out + i, _mm256_sqrt_ps(sqr));
+	}
+}
+
+MATH_TARGET_AVX inline void Vector3Stream::LerpAVX(const Vector3Stream& a, const Vector3Stream& b, float t, Vector3Stream& out, size_t count) {
+	const __m256 vt = _mm256_set1_ps(t);
+	for (size_t i = 0; i < count; i += kBlock) {
+		const __m256 ax = _mm256_load_ps(a.x + i), ay = _mm256_load_ps(a.y + i), az = _mm256_load_ps(a.z + i);
+		_mm256_store_ps(out.x + i, _mm256_add_ps(ax, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(b.x + i), ax), vt)));
+		_mm256_store_ps(out.y + i, _mm256_add_ps(ay, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(b.y + i), ay), vt)));
+		_mm256_store_ps(out.z + i, _mm256_add_ps(az, _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(b.z + i), az), vt)));
+	}
+}
+#endif
+
+#endif
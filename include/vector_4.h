@@ -5,44 +5,44 @@
 
 #include "vector_3.h"
 #include "matrix_3.h"
+#include "aligned.h"
+#include <type_traits>
+#include "elementwise.h"
 
 class Vector4 {
 public:
 
 	Vector4();
-	Vector4(float x, float y, float z, float w);
-	Vector4(Vector3 a, float w);
-	Vector4(float a);
-	Vector4(float* values_array);
-	Vector4(const Vector4& other);
-	~Vector4();
+	constexpr Vector4(float x, float y, float z, float w);
+	constexpr Vector4(Vector3 a, float w);
+	constexpr Vector4(float a);
+	constexpr Vector4(float* values_array);
 	
-	Vector4 operator+(const Vector4& other) const;
-	Vector4 operator+(float value) const;
-	void operator+=(const Vector4& other);
-	void operator+=(float value);
-	Vector4 operator-(const Vector4& other) const;
-	Vector4 operator-(float value) const;
-	void operator -=(const Vector4& other);
-	void operator -=(float value);
-
-	Vector4 operator*(float value) const;
-	void operator*=(float value);
-	Vector4 operator/(float value) const;
-	void operator/=(float value);
-	bool operator==(const Vector4& other);
-	bool operator!=(const Vector4& other);
-	void operator=(const Vector4& other);
+	constexpr Vector4 operator+(const Vector4& other) const;
+	constexpr Vector4 operator+(float value) const;
+	constexpr Vector4& operator+=(const Vector4& other);
+	constexpr Vector4& operator+=(float value);
+	constexpr Vector4 operator-(const Vector4& other) const;
+	constexpr Vector4 operator-(float value) const;
+	constexpr Vector4& operator-=(const Vector4& other);
+	constexpr Vector4& operator-=(float value);
+
+	constexpr Vector4 operator*(float value) const;
+	constexpr Vector4& operator*=(float value);
+	constexpr Vector4 operator/(float value) const;
+	constexpr Vector4& operator/=(float value);
+	constexpr bool operator==(const Vector4& other) const;
+	constexpr bool operator!=(const Vector4& other) const;
 
 	float Magnitude() const;
 	void Normalize();
 	Vector4 Normalized() const;
-	void Scale(Vector4 scale);
-	float SqrMagnitude() const;
+	constexpr void Scale(Vector4 scale);
+	constexpr float SqrMagnitude() const;
 
 	static float Distance(const Vector4& a, const Vector4& b);
-	static float DotProduct(Vector4 a, Vector4 b);
-	static Vector4 Lerp(const Vector4& a, const Vector4& b, float index);	
+	static constexpr float DotProduct(Vector4 a, Vector4 b);
+	static constexpr Vector4 Lerp(const Vector4& a, const Vector4& b, float index);	
 
 	static const Vector4 one;
 	static const Vector4 zero;
@@ -54,44 +54,34 @@ public:
 
 };
 
-inline Vector4::Vector4() { }
+static_assert(std::is_trivially_copyable<Vector4>::value, "Vector4 must be trivially copyable");
+static_assert(std::is_standard_layout<Vector4>::value, "Vector4 must be standard layout");
+
+template<> struct ElementTraits<Vector4> {
+	typedef float Element;
+	typedef float Scalar;
+	static const int kSize = 4;
+	static const bool kPacked = true;
+	static constexpr float Get(const Vector4& value, int i) {
+		return i == 0 ? value.x : (i == 1 ? value.y : (i == 2 ? value.z : value.w));
+	}
+	static constexpr Vector4 Make(const float* values) { return Vector4(values[0], values[1], values[2], values[3]); }
+};
 
-inline Vector4::Vector4(float x, float y, float z, float w) {
-	this->x = x;
-	this->y = y;
-	this->z = z;
-	this->w = w;
-}
+// Vector4 on a 16-byte boundary, one SSE register.
+typedef Aligned<Vector4, 16> Vector4A16;
+static_assert(sizeof(Vector4A16) == sizeof(Vector4), "Vector4A16 must not be padded");
 
-inline Vector4::Vector4(Vector3 a, float w) {
-	this->x = a.x;
-	this->y = a.y;
-	this->z = a.z;
-	this->w = w;
-}
+inline Vector4::Vector4() { }
 
-inline Vector4::Vector4(float a) {
-	x = a;
-	y = a;
-	z = a;
-	w = a;
-}
+constexpr Vector4::Vector4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
 
-inline Vector4::Vector4(float* values_array) {
-	x = values_array[0];
-	y = values_array[1];
-	z = values_array[2];
-	w = values_array[3];
-}
+constexpr Vector4::Vector4(Vector3 a, float w) : x(a.x), y(a.y), z(a.z), w(w) {}
 
-inline Vector4::Vector4(const Vector4& other) {
-	x = other.x;
-	y = other.y;
-	z = other.z;
-	w = other.w;
-}
+constexpr Vector4::Vector4(float a) : x(a), y(a), z(a), w(a) {}
 
-inline Vector4::~Vector4() { }
+constexpr Vector4::Vector4(float* values_array)
+	: x(values_array[0]), y(values_array[1]), z(values_array[2]), w(values_array[3]) {}
 
 inline float Vector4::Magnitude() const{
 	return sqrtf(x*x + y*y + z*z + w*w);
@@ -109,14 +99,11 @@ inline Vector4 Vector4::Normalized() const {
 	return Vector4(x * invertedMagnitude, y * invertedMagnitude, z * invertedMagnitude, w * invertedMagnitude);
 }
 
-inline void Vector4::Scale(Vector4 scale) {	
-	x = x * scale.x;
-	y = y * scale.y;
-	z = z * scale.z;
-	w = w * scale.w;
+constexpr void Vector4::Scale(Vector4 scale) {
+	*this = Elementwise<Vector4>::Multiply(*this, scale);
 }
 
-inline float Vector4::SqrMagnitude() const {
+constexpr float Vector4::SqrMagnitude() const {
 	return (x*x + y * y + z * z + w * w);
 }
 
@@ -124,93 +111,76 @@ inline float Vector4::Distance(const Vector4& a, const Vector4& b) {
 	return sqrtf((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z) + (a.w - b.w) * (a.w - b.w));
 }
 
-inline float Vector4::DotProduct(Vector4 a, Vector4 b) {
+constexpr float Vector4::DotProduct(Vector4 a, Vector4 b) {
 	return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
 }
 
-inline Vector4 Vector4::Lerp(const Vector4& a, const Vector4& b, float index) {	
-	if (index > 1) { index = 1; }
-	if (index < 0) { index = 0; }
+constexpr Vector4 Vector4::Lerp(const Vector4& a, const Vector4& b, float index) {	
+	index = MathUtils::Saturate(index);
 	return Vector4(a.x + (b.x - a.x) * index, a.y + (b.y - a.y) * index, a.z + (b.z - a.z) * index, a.w + (b.w - a.w) * index);
 }
 
-inline Vector4 Vector4::operator+(const Vector4& other) const{
-	return Vector4(x + other.x, y + other.y, z + other.z, w + other.w);
+constexpr Vector4 Vector4::operator+(const Vector4& other) const{
+	return Elementwise<Vector4>::Add(*this, other);
 }
 
-inline Vector4 Vector4::operator+(float value) const{
-	return Vector4(x + value, y + value, z + value, w + value);
+constexpr Vector4 Vector4::operator+(float value) const{
+	return Elementwise<Vector4>::Add(*this, value);
 }
 
-inline void Vector4::operator+=(const Vector4& other) {
-	x += other.x;
-	y += other.y;
-	z += other.z;
-	w += other.w;
+constexpr Vector4& Vector4::operator+=(const Vector4& other) {
+	*this = Elementwise<Vector4>::Add(*this, other);
+	return *this;
 }
 
-inline void Vector4::operator+=(float value) {
-	x += value;
-	y += value;
-	z += value;
-	w += value;
+constexpr Vector4& Vector4::operator+=(float value) {
+	*this = Elementwise<Vector4>::Add(*this, value);
+	return *this;
 }
 
-inline Vector4 Vector4::operator-(const Vector4& other) const{
-	return Vector4(x - other.x, y - other.y, z - other.z, w - other.w);
+constexpr Vector4 Vector4::operator-(const Vector4& other) const{
+	return Elementwise<Vector4>::Subtract(*this, other);
 }
 
-inline Vector4 Vector4::operator-(float value) const{
-	return Vector4(x - value, y - value, z - value, w - value);
+constexpr Vector4 Vector4::operator-(float value) const{
+	return Elementwise<Vector4>::Subtract(*this, value);
 }
 
-inline void Vector4::operator -=(const Vector4& other) {	
-	x -= other.x;
-	y -= other.y;
-	z -= other.z;
-	w -= other.w;
+constexpr Vector4& Vector4::operator-=(const Vector4& other) {
+	*this = Elementwise<Vector4>::Subtract(*this, other);
+	return *this;
 }
 
-inline void Vector4::operator -=(float value) {
-	x -= value;
-	y -= value;
-	z -= value;
-	w -= value;
+constexpr Vector4& Vector4::operator-=(float value) {
+	*this = Elementwise<Vector4>::Subtract(*this, value);
+	return *this;
 }
 
-inline Vector4 Vector4::operator*(float value) const{
-	return Vector4(x * value, y * value, z * value, w * value);
+constexpr Vector4 Vector4::operator*(float value) const{
+	return Elementwise<Vector4>::Multiply(*this, value);
 }
 
-inline void Vector4::operator*=(float value) {
-	x *= value;
-	y *= value;
-	z *= value;
-	w *= value;
+constexpr Vector4& Vector4::operator*=(float value) {
+	*this = Elementwise<Vector4>::Multiply(*this, value);
+	return *this;
 }
 
-inline Vector4 Vector4::operator/(float value) const{
-	return Vector4(x / value, y / value, z / value, w / value);
+constexpr Vector4 Vector4::operator/(float value) const{
+	return Elementwise<Vector4>::Divide(*this, value);
 }
 
-inline void Vector4::operator/=(float value) {
-	x /= value;
-	y /= value;
-	z /= value;
-	w /= value;
+constexpr Vector4& Vector4::operator/=(float value) {
+	*this = Elementwise<Vector4>::Divide(*this, value);
+	return *this;
 }
 
-inline bool Vector4::operator==(const Vector4& other) {
-	return x == other.x && y == other.y && z == other.z && w == other.w;
-}
-inline bool Vector4::operator!=(const Vector4& other) {
-	return x != other.x && y != other.y && z != other.z && w != other.w;
+constexpr bool Vector4::operator==(const Vector4& other) const {
+	return Elementwise<Vector4>::Equal(*this, other);
 }
-inline void Vector4::operator=(const Vector4& other) {
-	x = other.x;
-	y = other.y;
-	z = other.z;
-	w = other.w;
+constexpr bool Vector4::operator!=(const Vector4& other) const {
+	return !(*this == other);
 }
+inline constexpr Vector4 Vector4::one = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+inline constexpr Vector4 Vector4::zero = Vector4(0.0f, 0.0f, 0.0f, 0.0f);
 
 #endif 
@@ -1,4 +0,0 @@
-#include "../include/vector_4.h"
-
-const Vector4 Vector4::one = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
-const Vector4 Vector4::zero = Vector4(0.0f, 0.0f, 0.0f, 0.0f);
\ No newline at end of file